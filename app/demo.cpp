@@ -8,6 +8,7 @@
 
 #include <zing/audio/audio.h>
 #include <zing/audio/audio_analysis.h>
+#include <zing/audio/audio_block_dsp.h>
 #include <zing/audio/midi.h>
 
 #include <config_zing_app.h>
@@ -26,9 +27,9 @@ namespace
 std::atomic<bool> playingNote = false;
 std::atomic<bool> playNote = false;
 milliseconds noteStartTime = 0ms;
-sp_osc* osc = nullptr;
 sp_ftbl* ft = nullptr;
-sp_phaser* phs = nullptr;
+BlockOsc osc;
+BlockPhaser phaser;
 
 bool showMidiWindow = true;
 bool showAudioSettings = true;
@@ -37,6 +38,9 @@ bool showProfiler = true;
 bool showDebugSettings = false;
 bool showDemoWindow = false;
 
+// Length of a trace capture, from the profiler window or F9
+float traceSeconds = 10.0f;
+
 std::future<void> fontLoaderFuture;
 std::future<std::shared_ptr<libremidi::reader>> midiReaderFuture;
 
@@ -51,17 +55,14 @@ void demo_synth_note(float* pOut, uint32_t samples)
     if (playNote)
     {
         // Create a wavetable and an an oscillator
-        if (!osc)
+        if (!ft)
         {
             sp_ftbl_create(ctx.pSP, &ft, 8192);
-            sp_osc_create(&osc);
-
             sp_gen_triangle(ctx.pSP, ft);
-            sp_osc_init(ctx.pSP, osc, ft, 0);
-            osc->freq = 500;
 
-            sp_phaser_create(&phs);
-            sp_phaser_init(ctx.pSP, phs);
+            block_osc_init(osc, ft, 1);
+            block_osc_set(osc, 500.0f, 0.2f);
+            block_phaser_init(phaser, ctx.pSP);
         }
 
         playNote = false;
@@ -85,16 +86,26 @@ void demo_synth_note(float* pOut, uint32_t samples)
         return;
     }
 
-    for (uint32_t i = 0; i < samples; i++)
+    // A block at a time; the mono oscillator feeds both sides of the phaser
+    constexpr uint32_t ChunkFrames = 256;
+    float mono[ChunkFrames];
+    float stereo[ChunkFrames * 2];
+    for (uint32_t start = 0; start < samples; start += ChunkFrames)
     {
-        float out[2] = {0.0f, 0.0f};
-
-        sp_osc_compute(ctx.pSP, osc, &out[0], &out[0]);
-        sp_phaser_compute(ctx.pSP, phs, &out[0], &out[0], &out[0], &out[1]);
+        const auto count = std::min(ChunkFrames, samples - start);
+        block_osc_process(osc, mono, count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            stereo[i * 2] = stereo[i * 2 + 1] = mono[i];
+        }
+        block_phaser_process(phaser, stereo, stereo, count, 2);
 
-        for (uint32_t ch = 0; ch < ctx.outputState.channelCount; ch++)
+        for (uint32_t i = 0; i < count; i++)
         {
-            *pOut++ += out[ch];
+            for (uint32_t ch = 0; ch < ctx.outputState.channelCount; ch++)
+            {
+                *pOut++ += stereo[i * 2 + ch];
+            }
         }
     }
 }
@@ -102,6 +113,7 @@ void demo_synth_note(float* pOut, uint32_t samples)
 auto demo_load_example_midi()
 {
     midiReaderFuture = std::async([]() {
+        TRACE_NAME_THREAD(MidiLoader);
         auto midiFile = file_read(Zest::runtree_find_path("samples/midi/demo-1.mid"));
         auto pReader = std::make_shared<libremidi::reader>();
         auto midiRes = pReader->parse((uint8_t*)midiFile.c_str(), midiFile.size());
@@ -120,6 +132,7 @@ auto demo_load_example_midi()
 void demo_load_gm_sound_font()
 {
     fontLoaderFuture = std::async([]() {
+        TRACE_NAME_THREAD(FontLoader);
         auto& ctx = GetAudioContext();
 
         // Put a nicer/bigger soundfont here to hear a better rendition.
@@ -152,6 +165,9 @@ void demo_init()
     // Lock the ticker to avoid loading conflicts (we unlock when fonts are loaded)
     ctx.audioTickEnableMutex.lock();
 
+    // Share the soundfont voices with some of the other cores
+    samples_set_render_workers(ctx.m_samples, std::max(1u, std::thread::hardware_concurrency() / 2) - 1);
+
     demo_register_windows();
 
     // Sound font contains a range of instruments, live sampled
@@ -175,7 +191,16 @@ void demo_tick()
 
     layout_manager_update();
 
-    if (is_future_ready(fontLoaderFuture) && is_future_ready(midiReaderFuture))
+    if (fontLoaderFuture.valid() && is_future_ready(fontLoaderFuture))
+    {
+        fontLoaderFuture.get();
+
+        // Unlock the audio; the font is indexed, and the audio thread picks it up when its samples are decoded
+        ctx.audioTickEnableMutex.unlock();
+    }
+
+    // Hold the midi back until there is something to play it
+    if (!fontLoaderFuture.valid() && midiReaderFuture.valid() && is_future_ready(midiReaderFuture) && samples_loaded(ctx.m_samples))
     {
         auto pReader = midiReaderFuture.get();
         if (pReader)
@@ -195,9 +220,6 @@ void demo_tick()
                 }
             }
         }
-
-        // Unlock the audio, since we are fully loaded now.
-        ctx.audioTickEnableMutex.unlock();
     }
 }
 
@@ -219,12 +241,17 @@ void demo_draw_menu()
 
 void demo_draw()
 {
-    PROFILE_SCOPE(demo_draw)
+    TRACE_SCOPE(demo_draw);
 
     auto& ctx = GetAudioContext();
 
     demo_draw_menu();
 
+    if (ImGui::IsKeyPressed(ImGuiKey_F9, false) && !trace_capturing())
+    {
+        trace_capture(trace_default_path(), traceSeconds);
+    }
+
     if (showDemoWindow)
     {
         ImGui::ShowDemoWindow(&showDemoWindow);
@@ -241,6 +268,26 @@ void demo_draw()
     {
         if (ImGui::Begin("Profiler", &showProfiler))
         {
+            // Capture all threads to a Chrome trace file, for chrome://tracing or ui.perfetto.dev
+            ImGui::BeginDisabled(trace_capturing());
+            if (ImGui::Button("Capture Trace (F9)"))
+            {
+                trace_capture(trace_default_path(), traceSeconds);
+            }
+            ImGui::EndDisabled();
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(150.0f);
+            ImGui::SliderFloat("Seconds##trace", &traceSeconds, 1.0f, 60.0f, "%.0f");
+            ImGui::SameLine();
+            if (trace_capturing())
+            {
+                ImGui::TextUnformatted("Capturing...");
+            }
+            else
+            {
+                ImGui::TextUnformatted(trace_last_file().string().c_str());
+            }
+
             Zest::Profiler::ShowProfile();
         }
         ImGui::End();
@@ -311,6 +358,9 @@ void demo_cleanup()
 {
     layout_manager_save();
 
+    // Writes any capture still running
+    trace_stop();
+
     // Get the settings
     audio_destroy();
 }
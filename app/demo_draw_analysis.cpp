@@ -15,7 +15,7 @@ using namespace libremidi;
 
 void demo_draw_analysis()
 {
-    PROFILE_SCOPE(demo_draw_analysis)
+    TRACE_SCOPE(demo_draw_analysis);
     auto& ctx = GetAudioContext();
 
     const size_t bufferWidth = 512;   // default width if no data
@@ -52,7 +52,7 @@ void demo_draw_midi_init()
 // This is just for debug/temporary.  A nice visualization will be forthcoming.
 void demo_draw_midi()
 {
-    PROFILE_SCOPE(demo_draw_midi);
+    TRACE_SCOPE(demo_draw_midi);
 
     auto& ctx = GetAudioContext();
     auto time = timer_to_ms(timer_get_elapsed(ctx.m_masterClock));
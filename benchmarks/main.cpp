@@ -0,0 +1,700 @@
+#include <zing/pch.h>
+
+#include <fstream>
+#include <random>
+
+#include <zing/audio/audio.h>
+#include <zing/audio/audio_analysis.h>
+#include <zing/audio/audio_analysis_settings.h>
+#include <zing/audio/audio_analysis_stages.h>
+#include <zing/audio/audio_pitch.h>
+#include <zing/audio/audio_samples.h>
+#include <zing/audio/waterfall.h>
+
+#include <wavetable/wavetable.h>
+#include <wavetable/wavetable_bank.h>
+
+#include <config_zing_app.h>
+
+// Times the DSP on the audio and analysis paths, without a device, and writes the results as JSON.
+// The layout follows Google Benchmark's, so its compare.py can diff the files from two commits:
+//   Zing_Benchmarks --out before.json ... Zing_Benchmarks --out after.json
+//   compare.py benchmarks before.json after.json
+// Options: --out <file> (default stdout), --filter <text>, --list, --sf2 <soundfont>,
+//          --min-time <seconds per repetition>, --repetitions <n>
+
+using namespace Zing;
+using namespace AudioUtils;
+using namespace std::chrono;
+
+namespace
+{
+
+constexpr uint32_t BenchSampleRate = 48000;
+
+struct BenchOptions
+{
+    std::string filter;
+    fs::path outPath;
+    fs::path sf2Path;
+    double minSeconds = 0.05;
+    uint32_t repetitions = 9;
+    bool list = false;
+};
+
+struct BenchResult
+{
+    std::string name;
+    uint64_t iterations = 0; // Per repetition
+    uint32_t repetitions = 0;
+    double medianNs = 0.0; // Per iteration
+    double minNs = 0.0;
+    double maxNs = 0.0;
+    double cpuNs = 0.0;
+    double itemsPerIteration = 0.0; // Samples, frames, bins; 0 if there's no natural unit
+    std::vector<std::pair<std::string, double>> counters;
+};
+
+struct Bench
+{
+    BenchOptions options;
+    std::vector<BenchResult> results;
+    std::vector<std::pair<std::string, std::string>> skipped;
+};
+
+using fnBenchIteration = std::function<void()>;
+
+// True if the benchmark should run; with --list, prints the name instead
+bool bench_begin(Bench& bench, const std::string& name)
+{
+    if (!bench.options.filter.empty() && name.find(bench.options.filter) == std::string::npos)
+    {
+        return false;
+    }
+
+    if (bench.options.list)
+    {
+        fmt::print("{}\n", name);
+        return false;
+    }
+    return true;
+}
+
+void bench_skip(Bench& bench, const std::string& name, const std::string& reason)
+{
+    if (bench_begin(bench, name))
+    {
+        fmt::print(stderr, "{:<48} skipped: {}\n", name, reason);
+        bench.skipped.emplace_back(name, reason);
+    }
+}
+
+// Seconds for 'iterations' runs. fnPrepare, if given, runs before each iteration outside the timing;
+// each iteration is then timed on its own, so keep it to bodies of a few microseconds or more.
+double bench_time(uint64_t iterations, const fnBenchIteration& fnIteration, const fnBenchIteration& fnPrepare)
+{
+    if (!fnPrepare)
+    {
+        const auto start = steady_clock::now();
+        for (uint64_t i = 0; i < iterations; i++)
+        {
+            fnIteration();
+        }
+        return duration<double>(steady_clock::now() - start).count();
+    }
+
+    double seconds = 0.0;
+    for (uint64_t i = 0; i < iterations; i++)
+    {
+        fnPrepare();
+        const auto start = steady_clock::now();
+        fnIteration();
+        seconds += duration<double>(steady_clock::now() - start).count();
+    }
+    return seconds;
+}
+
+// Finds an iteration count filling the minimum time, then takes the median of the repetitions
+BenchResult& bench_run(Bench& bench, const std::string& name, double itemsPerIteration, const fnBenchIteration& fnIteration, const fnBenchIteration& fnPrepare = nullptr)
+{
+    const auto minSeconds = bench.options.minSeconds;
+
+    // Warm the caches and any lazy setup
+    bench_time(1, fnIteration, fnPrepare);
+
+    uint64_t iterations = 1;
+    for (;;)
+    {
+        const auto seconds = bench_time(iterations, fnIteration, fnPrepare);
+        if (seconds >= minSeconds || iterations >= (uint64_t(1) << 30))
+        {
+            break;
+        }
+        const auto scale = seconds > 0.0 ? (minSeconds * 1.2) / seconds : 10.0;
+        iterations = std::max(iterations * 2, uint64_t(double(iterations) * std::min(scale, 10.0)));
+    }
+
+    std::vector<double> perIterationNs;
+    const auto cpuStart = std::clock();
+    for (uint32_t repetition = 0; repetition < bench.options.repetitions; repetition++)
+    {
+        perIterationNs.push_back(bench_time(iterations, fnIteration, fnPrepare) * 1e9 / double(iterations));
+    }
+    const auto cpuSeconds = double(std::clock() - cpuStart) / CLOCKS_PER_SEC;
+    std::sort(perIterationNs.begin(), perIterationNs.end());
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.repetitions = uint32_t(perIterationNs.size());
+    result.medianNs = perIterationNs[perIterationNs.size() / 2];
+    result.minNs = perIterationNs.front();
+    result.maxNs = perIterationNs.back();
+    result.cpuNs = cpuSeconds * 1e9 / double(iterations * perIterationNs.size());
+    result.itemsPerIteration = itemsPerIteration;
+
+    fmt::print(stderr, "{:<48} {:>12.1f} ns {:>12.1f} min {:>12.1f} max {:>10} its\n", name, result.medianNs, result.minNs, result.maxNs, iterations);
+
+    bench.results.push_back(result);
+    return bench.results.back();
+}
+
+// A test signal with some structure for the analysis to find: a slow sweep, a fixed tone and a little noise
+std::vector<float> bench_signal(uint32_t frames, uint32_t channels, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> noise(-0.05f, 0.05f);
+
+    std::vector<float> signal(size_t(frames) * channels);
+    double phase = 0.0;
+    for (uint32_t frame = 0; frame < frames; frame++)
+    {
+        const auto sweepHz = 100.0 + 4000.0 * double(frame) / double(frames);
+        phase += 2.0 * glm::pi<double>() * sweepHz / BenchSampleRate;
+        const auto tone = std::sin(2.0 * glm::pi<double>() * 440.0 * frame / BenchSampleRate);
+        const auto value = float(0.4 * std::sin(phase) + 0.3 * tone) + noise(rng);
+        for (uint32_t channel = 0; channel < channels; channel++)
+        {
+            signal[size_t(frame) * channels + channel] = value;
+        }
+    }
+    return signal;
+}
+
+void bench_set_output(uint32_t channels)
+{
+    auto& ctx = GetAudioContext();
+    ctx.outputState.channelCount = channels;
+    ctx.outputState.sampleRate = BenchSampleRate;
+    ctx.outputState.deltaTime = 1.0 / double(BenchSampleRate);
+    ctx.inputState = ctx.outputState;
+}
+
+void bench_analysis(Bench& bench)
+{
+    auto& ctx = GetAudioContext();
+
+    // As the app runs it: the built in feature stages, pitch, onsets and the waterfall
+    static std::once_flag builtinStages;
+    std::call_once(builtinStages, audio_analysis_add_builtin_stages);
+
+    const uint32_t hop = 256;
+    const auto signal = bench_signal(hop, 1, 1);
+
+    for (uint32_t frames : { 256u, 512u, 1024u, 2048u, 4096u })
+    {
+        const auto name = fmt::format("audio_analysis_update/frames:{}", frames);
+        if (!bench_begin(bench, name))
+        {
+            continue;
+        }
+
+        ctx.audioAnalysisSettings = AudioAnalysisSettings{};
+        ctx.audioAnalysisSettings.frames = frames;
+        audio_analysis_validate_settings(ctx.audioAnalysisSettings);
+
+        AudioAnalysis analysis;
+        analysis.channel = ctx.inputState;
+        analysis.thisChannel = audio_to_channel_id(Channel_In, 0);
+        for (int i = 0; i < 3; i++)
+        {
+            analysis.analysisDataCache.enqueue(std::make_shared<AudioAnalysisData>());
+        }
+
+        AudioBundle bundle;
+        bundle.channel = analysis.thisChannel;
+        bundle.data = signal;
+
+        bench_run(bench, name, hop, [&]() {
+            audio_analysis_update(analysis, bundle);
+
+            // Hand the result straight back, as the UI would eventually
+            std::shared_ptr<AudioAnalysisData> spData;
+            while (analysis.analysisData.try_dequeue(spData))
+            {
+                analysis.analysisDataCache.enqueue(spData);
+            }
+        });
+
+        if (analysis.cfg)
+        {
+            kiss_fftr_free(analysis.cfg);
+        }
+        pitch_tracker_destroy(analysis.pitchTracker);
+    }
+
+    ctx.audioAnalysisSettings = AudioAnalysisSettings{};
+}
+
+void bench_compressor(Bench& bench)
+{
+    auto& ctx = GetAudioContext();
+    const uint32_t channels = 2;
+
+    for (uint32_t frames : { 256u, 1024u })
+    {
+        const auto name = fmt::format("apply_output_compressor/frames:{}", frames);
+        if (!bench_begin(bench, name))
+        {
+            continue;
+        }
+
+        ctx.audioAnalysisSettings.compEnabled = true;
+        const auto source = bench_signal(frames, channels, 2);
+        auto buffer = source;
+
+        // The copy back keeps the input level steady; it is small beside the compressor
+        bench_run(bench, name, frames, [&]() {
+            memcpy(buffer.data(), source.data(), source.size() * sizeof(float));
+            apply_output_compressor(buffer.data(), frames, channels);
+        });
+    }
+}
+
+// Loads the soundfont once, for the midi and voice benchmarks
+bool bench_load_font(Bench& bench)
+{
+    static int loaded = -1;
+    if (loaded != -1)
+    {
+        return loaded == 1;
+    }
+
+    auto& ctx = GetAudioContext();
+    loaded = 0;
+    if (bench.options.sf2Path.empty() || !fs::exists(bench.options.sf2Path))
+    {
+        return false;
+    }
+
+    ctx.m_samples.maxVoices = 512;
+    if (!samples_add(ctx.m_samples, "Bench", bench.options.sf2Path))
+    {
+        return false;
+    }
+
+    while (!samples_loaded(ctx.m_samples))
+    {
+        std::this_thread::sleep_for(milliseconds(10));
+    }
+
+    std::lock_guard<std::mutex> lock(ctx.m_samples.sampleMutex);
+    loaded = ctx.m_samples.fonts.empty() ? 0 : 1;
+    return loaded == 1;
+}
+
+// Silences every font, and sets a program on the first few channels
+void bench_reset_fonts(uint32_t channels, int program)
+{
+    auto& ctx = GetAudioContext();
+    for (auto pFont : ctx.m_samples.fonts)
+    {
+        tsf_reset(pFont);
+    }
+
+    for (uint32_t channel = 1; channel <= channels; channel++)
+    {
+        samples_program_change(ctx.m_samples, int(channel), program, false);
+    }
+}
+
+void bench_midi(Bench& bench)
+{
+    auto& ctx = GetAudioContext();
+    const uint32_t frames = 512;
+    const uint32_t channels = 8;
+
+    for (uint32_t events : { 16u, 64u, 256u })
+    {
+        const auto name = fmt::format("audio_process_midi/events:{}", events);
+        if (!bench_begin(bench, name))
+        {
+            continue;
+        }
+
+        if (!bench_load_font(bench))
+        {
+            bench_skip(bench, name, "no soundfont; pass --sf2");
+            continue;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(ctx.m_samples.sampleMutex);
+            bench_reset_fonts(channels, 0);
+        }
+        ctx.settings.enableMidi = true;
+
+        // Each block gets a burst of short notes across the channels, all due now; the tick handles
+        // at most one message a frame, so up to 'frames' events per block
+        std::vector<float> buffer(size_t(frames) * ctx.outputState.channelCount);
+        uint32_t note = 0;
+        auto& result = bench_run(bench, name, frames, [&]() { audio_process_midi(buffer.data(), frames); }, [&]() {
+            std::fill(buffer.begin(), buffer.end(), 0.0f);
+            for (uint32_t event = 0; event < events; event += 2, note++)
+            {
+                const auto channel = uint8_t(1 + (note % channels));
+                const auto key = uint8_t(36 + (note * 7) % 60);
+                auto on = libremidi::channel_events::note_on(channel, key, 100);
+                auto off = libremidi::channel_events::note_off(channel, key, 0);
+                on.timestamp = 0;
+                off.timestamp = 0;
+                audio_add_midi_event(on);
+                audio_add_midi_event(off);
+            }
+        });
+        result.counters.emplace_back("active_voices", double(ctx.m_samples.governor.activeVoices.load()));
+
+        // Drain anything the last block didn't reach
+        libremidi::message msg;
+        while (ctx.midi.try_dequeue(msg))
+        {
+        }
+    }
+}
+
+void bench_samples_render(Bench& bench)
+{
+    auto& ctx = GetAudioContext();
+    const uint32_t frames = 256;
+    const uint32_t channels = 8;
+
+    // On the audio thread alone, then sharing the voices with helpers as the demo does
+    std::vector<uint32_t> workerCounts = { 0 };
+    if (const auto helpers = std::max(1u, std::thread::hardware_concurrency() / 2) - 1; helpers > 0)
+    {
+        workerCounts.push_back(helpers);
+    }
+
+    for (auto workers : workerCounts)
+    {
+        for (uint32_t voices : { 8u, 32u, 128u, 256u })
+        {
+            const auto name = fmt::format("samples_render/voices:{}/workers:{}", voices, workers);
+            if (!bench_begin(bench, name))
+            {
+                continue;
+            }
+
+            if (!bench_load_font(bench))
+            {
+                bench_skip(bench, name, "no soundfont; pass --sf2");
+                continue;
+            }
+
+            samples_set_render_workers(ctx.m_samples, workers);
+
+            std::lock_guard<std::mutex> lock(ctx.m_samples.sampleMutex);
+
+            // Strings, so the voices hold at their sustain level for the whole run
+            bench_reset_fonts(channels, 48);
+            uint32_t active = 0;
+            for (uint32_t note = 0; note < 1024 && active < voices; note++)
+            {
+                const auto channel = int(1 + (note % channels));
+                if (auto pFont = samples_channel_font(ctx.m_samples, channel))
+                {
+                    tsf_channel_note_on(pFont, channel, int(36 + (note / channels) % 60), 0.8f);
+                }
+
+                active = 0;
+                for (auto pFont : ctx.m_samples.fonts)
+                {
+                    active += uint32_t(tsf_active_voice_count(pFont));
+                }
+            }
+
+            std::vector<float> buffer(size_t(frames) * ctx.outputState.channelCount);
+            auto& result = bench_run(bench, name, frames, [&]() {
+                samples_render(ctx.m_samples, buffer.data(), frames);
+            });
+            result.counters.emplace_back("voices", double(active));
+
+            bench_reset_fonts(channels, 0);
+        }
+    }
+
+    samples_set_render_workers(ctx.m_samples, 0);
+}
+
+void bench_waterfall(Bench& bench)
+{
+    const int spectrumCount = 2049;
+    const int rows = 50;
+
+    // A spectrum with a slope and some peaks, as magnitudes and as power
+    std::vector<float> magnitude(spectrumCount);
+    std::vector<float> power(spectrumCount);
+    for (int i = 0; i < spectrumCount; i++)
+    {
+        magnitude[i] = 1e-3f / (1.0f + float(i) * 0.01f) + ((i % 97) == 0 ? 0.1f : 0.0f);
+        power[i] = magnitude[i] * magnitude[i];
+    }
+
+    for (int bins : { 512, 2048 })
+    {
+        auto name = fmt::format("Waterfall_AccumulateMag/bins:{}", bins);
+        if (bench_begin(bench, name))
+        {
+            Waterfall wf;
+            Waterfall_Init(wf, bins, rows);
+            bench_run(bench, name, bins, [&]() {
+                Waterfall_AccumulateMag(wf, magnitude.data(), spectrumCount);
+            });
+        }
+
+        name = fmt::format("Waterfall_AccumulatePower/bins:{}", bins);
+        if (bench_begin(bench, name))
+        {
+            Waterfall wf;
+            Waterfall_Init(wf, bins, rows);
+            bench_run(bench, name, bins, [&]() {
+                Waterfall_AccumulatePower(wf, power.data(), spectrumCount);
+            });
+        }
+    }
+
+    const std::pair<WaterfallStorage, const char*> storages[] = {
+        { WaterfallStorage::Float32, "float32" },
+        { WaterfallStorage::UInt16, "uint16" },
+        { WaterfallStorage::UInt8, "uint8" }
+    };
+    for (auto& [storage, pStorageName] : storages)
+    {
+        const auto name = fmt::format("Waterfall_BuildUpload/storage:{}", pStorageName);
+        if (!bench_begin(bench, name))
+        {
+            continue;
+        }
+
+        Waterfall wf;
+        Waterfall_Init(wf, 512, rows);
+        Waterfall_SetStorage(wf, storage);
+        for (int i = 0; i < rows * wf.accumulateN; i++)
+        {
+            Waterfall_AccumulateMag(wf, magnitude.data(), spectrumCount);
+        }
+
+        // The upload is skipped when nothing changed, so mark the ring as changed, as a new row would
+        bench_run(bench, name, double(rows) * wf.bins, [&]() {
+            wf.commits++;
+            Waterfall_BuildUpload(wf);
+        });
+    }
+}
+
+void bench_wavetable(Bench& bench)
+{
+    for (uint32_t size : { 2048u, 8192u })
+    {
+        for (auto [type, pTypeName] : { std::pair{ WaveTableType::Sine, "sine" }, std::pair{ WaveTableType::Sawtooth, "sawtooth" } })
+        {
+            const auto name = fmt::format("wave_table_create/{}/size:{}", pTypeName, size);
+            if (!bench_begin(bench, name))
+            {
+                continue;
+            }
+
+            WaveTable table;
+            bench_run(bench, name, size, [&]() {
+                wave_table_create(table, type, 0.0f, size);
+            });
+        }
+    }
+
+    // Band limited mips for every shape; a new bank each time, so nothing is cached
+    std::vector<std::pair<WaveTableType, uint32_t>> shapes;
+    for (auto type = uint32_t(WaveTableType::Sine); type < uint32_t(WaveTableType::Zero); type++)
+    {
+        shapes.emplace_back(WaveTableType(type), 2048);
+    }
+
+    for (uint32_t threads : { 1u, 0u })
+    {
+        const auto name = fmt::format("wave_table_bank_prepare/shapes:{}/threads:{}", shapes.size(), threads == 0 ? std::string("all") : std::to_string(threads));
+        if (!bench_begin(bench, name))
+        {
+            continue;
+        }
+
+        bench_run(bench, name, double(shapes.size()), [&]() {
+            auto spBank = std::make_unique<WaveTableBank>();
+            wave_table_bank_prepare(*spBank, shapes, threads);
+            wave_table_bank_destroy(*spBank);
+        });
+    }
+}
+
+void bench_escape(std::string& out, const std::string& text)
+{
+    for (auto c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        out += c;
+    }
+}
+
+std::string bench_json(const Bench& bench, const char* pExecutable)
+{
+    char date[64];
+    auto now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+
+    std::string json = "{\n  \"context\": {\n";
+    json += fmt::format("    \"date\": \"{}\",\n", date);
+    json += "    \"executable\": \"";
+    bench_escape(json, pExecutable);
+    json += "\",\n";
+    json += fmt::format("    \"num_cpus\": {},\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+    json += "    \"library_build_type\": \"release\",\n";
+#else
+    json += "    \"library_build_type\": \"debug\",\n";
+#endif
+    json += fmt::format("    \"sample_rate\": {},\n", BenchSampleRate);
+    json += fmt::format("    \"repetitions\": {},\n", bench.options.repetitions);
+    json += fmt::format("    \"min_time\": {}\n", bench.options.minSeconds);
+    json += "  },\n  \"benchmarks\": [";
+
+    for (size_t index = 0; index < bench.results.size(); index++)
+    {
+        const auto& result = bench.results[index];
+        json += index == 0 ? "\n" : ",\n";
+        json += fmt::format("    {{\"name\": \"{0}\", \"run_name\": \"{0}\", \"run_type\": \"iteration\", \"repetitions\": {1}, \"iterations\": {2}, "
+                            "\"real_time\": {3:.3f}, \"cpu_time\": {4:.3f}, \"time_unit\": \"ns\", \"min_time_ns\": {5:.3f}, \"max_time_ns\": {6:.3f}",
+            result.name, result.repetitions, result.iterations, result.medianNs, result.cpuNs, result.minNs, result.maxNs);
+        if (result.itemsPerIteration > 0.0 && result.medianNs > 0.0)
+        {
+            json += fmt::format(", \"items_per_second\": {:.1f}", result.itemsPerIteration * 1e9 / result.medianNs);
+        }
+        for (auto& [counter, value] : result.counters)
+        {
+            json += fmt::format(", \"{}\": {}", counter, value);
+        }
+        json += "}";
+    }
+    json += "\n  ],\n  \"skipped\": [";
+
+    for (size_t index = 0; index < bench.skipped.size(); index++)
+    {
+        json += index == 0 ? "\n" : ",\n";
+        json += fmt::format("    {{\"name\": \"{}\", \"reason\": \"{}\"}}", bench.skipped[index].first, bench.skipped[index].second);
+    }
+    json += "\n  ]\n}\n";
+    return json;
+}
+
+bool bench_parse(BenchOptions& options, int argc, char** argv)
+{
+    for (int arg = 1; arg < argc; arg++)
+    {
+        const std::string option = argv[arg];
+        const bool hasValue = arg + 1 < argc;
+        if (option == "--list")
+        {
+            options.list = true;
+        }
+        else if (option == "--out" && hasValue)
+        {
+            options.outPath = argv[++arg];
+        }
+        else if (option == "--filter" && hasValue)
+        {
+            options.filter = argv[++arg];
+        }
+        else if (option == "--sf2" && hasValue)
+        {
+            options.sf2Path = argv[++arg];
+        }
+        else if (option == "--min-time" && hasValue)
+        {
+            options.minSeconds = std::max(0.001, std::atof(argv[++arg]));
+        }
+        else if (option == "--repetitions" && hasValue)
+        {
+            options.repetitions = uint32_t(std::max(1, std::atoi(argv[++arg])));
+        }
+        else
+        {
+            fmt::print(stderr, "Usage: {} [--out file] [--filter text] [--list] [--sf2 file] [--min-time seconds] [--repetitions n]\n", argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    Bench bench;
+#ifdef ZING_ROOT
+    bench.options.sf2Path = fs::path(ZING_ROOT) / "run_tree" / "samples" / "sf2" / "233_poprockbank.sf2";
+#endif
+    if (!bench_parse(bench.options, argc, argv))
+    {
+        return 1;
+    }
+
+    // No device; just the state the DSP reads
+    auto& ctx = GetAudioContext();
+    bench_set_output(2);
+    sp_create(&ctx.pSP);
+    ctx.pSP->nchan = ctx.outputState.channelCount;
+    ctx.pSP->sr = ctx.outputState.sampleRate;
+    samples_set_render_workers(ctx.m_samples, 0);
+
+    bench_analysis(bench);
+    bench_compressor(bench);
+    bench_midi(bench);
+    bench_samples_render(bench);
+    bench_waterfall(bench);
+    bench_wavetable(bench);
+
+    samples_destroy(ctx.m_samples);
+    sp_destroy(&ctx.pSP);
+    ctx.pSP = nullptr;
+
+    if (bench.options.list)
+    {
+        return 0;
+    }
+
+    const auto json = bench_json(bench, argv[0]);
+    if (bench.options.outPath.empty())
+    {
+        fmt::print("{}", json);
+        return 0;
+    }
+
+    std::ofstream out(bench.options.outPath, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        fmt::print(stderr, "Failed to write {}\n", bench.options.outPath.string());
+        return 1;
+    }
+    out.write(json.data(), std::streamsize(json.size()));
+    return 0;
+}
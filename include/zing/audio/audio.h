@@ -5,8 +5,12 @@
 #include <zest/thread/thread_utils.h>
 
 #include <zing/audio/audio_analysis_settings.h>
+#include <zing/audio/audio_analysis_stages.h>
+#include <zing/audio/audio_deadline.h>
 #include <zing/audio/audio_device_settings.h>
 #include <zing/audio/audio_samples.h>
+#include <zing/audio/audio_spectrogram.h>
+#include <zing/audio/waterfall.h>
 
 #include <libremidi/libremidi.hpp>
 
@@ -88,6 +92,11 @@ struct AudioAnalysisData
     std::vector<float> audio;
     uint32_t currentBuffer = 0;
     std::vector<float> frameCache;
+
+    // Outputs of the analysis stages; the layout is replaced when the stages change
+    std::vector<AnalysisFeature> features;
+    std::vector<float> featureData;
+    uint32_t featureLayout = 0;
 };
 
 struct SpectrumPartitionSettings
@@ -129,6 +138,16 @@ struct AudioAnalysis
 
     std::atomic<glm::vec4> spectrumBands = glm::vec4(0.0);
 
+    // The registered analysis stages, as built for this channel
+    AnalysisPipeline pipeline;
+
+    // Rows built here at the analysis rate from the power spectrum; the UI only draws them, under the mutex
+    std::mutex waterfallMutex;
+    Waterfall waterfall;
+
+    // On disk history of the spectrum, for inputs when archiving is on
+    std::shared_ptr<SpectrogramArchive> spArchive;
+
     bool fftConfigured = false;
     bool audioActive = false;
     std::atomic_bool quitThread = true;
@@ -151,6 +170,18 @@ struct AudioAnalysis
 
 using fnMidiBroadcast = std::function<void(const libremidi::message&)>;
 
+// Processing run in place on one channel, on the audio thread; the buffer is interleaved, so step by stride.
+// Output stages run after the callback and before the output compressor; input stages run on a copy
+// of the input, before it goes to the callback. Both happen before the channel is sent to analysis.
+using fnAudioStage = std::function<void(float* pBuffer, uint32_t frames, uint32_t stride)>;
+
+struct AudioStage
+{
+    uint32_t id = 0;
+    ChannelId channel;
+    fnAudioStage fnProcess;
+};
+
 #ifdef USE_LINK
 struct LinkData
 {
@@ -181,6 +212,7 @@ struct AudioContext
     // so use system mutex, we don't need to spin
     std::map<ChannelId, std::shared_ptr<AudioAnalysis>> analysisChannels;
     AudioAnalysisSettings audioAnalysisSettings;
+    AnalysisStageRegistry analysisStages;
 
     std::atomic<uint64_t> analysisWriteGeneration = 0;
     std::atomic<uint64_t> analysisReadGeneration = 0;
@@ -238,6 +270,15 @@ struct AudioContext
 
     Zest::spin_mutex audioTickEnableMutex;
 
+    // Per callback timings; filled on the audio thread, collected off it
+    DeadlineMonitor deadline;
+
+    // Per channel stages; edited under stageMutex, which the audio thread only tries for
+    Zest::spin_mutex stageMutex;
+    std::vector<AudioStage> stages;
+    uint32_t nextStageId = 1;
+    std::vector<float> stageInput;
+
     std::vector<float> inputStreamOverride;
     uint32_t inputStreamIndex = 0;
 
@@ -265,8 +306,17 @@ ChannelId audio_to_channel_id(uint32_t type, uint32_t channel);
 
 void audio_add_midi_event(const libremidi::message& msg);
 
+// Returns an id for removing the stage; stages on a channel run in the order they were added
+uint32_t audio_add_stage(ChannelId channel, const fnAudioStage& fnProcess);
+void audio_remove_stage(uint32_t id);
+
 void audio_calculate_midi_timings(std::vector<libremidi::midi_track>& track, float ticksPerBeat);
 
+// Parts of the audio tick; called from it, and on their own by the benchmarks.
+// frameCount must be a multiple of 64; the buffers are interleaved at the output channel count.
+void audio_process_midi(void* pOutput, uint32_t frameCount);
+void apply_output_compressor(float* outputBuffer, uint32_t frames, uint32_t channels);
+
 #define CHECK_NOT_AUDIO_THREAD assert(std::this_thread::get_id() != ctx.threadId);
 
 // Can't currently use this one since audio threads might be in a pool.  TLS?
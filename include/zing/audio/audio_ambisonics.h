@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Zing
+{
+
+struct AudioWorkerPool;
+
+// Higher order Ambisonics, up to 3rd order, in ACN channel order with SN3D normalisation (AmbiX).
+// Directions are in degrees; azimuth is anticlockwise from the front (90 is hard left), elevation is up.
+// The bus is planar, and each step is a dense matrix applied to whole blocks: sources are encoded
+// into the bus, and a single matrix (the decoder times the rotation) takes the bus to the speakers.
+constexpr uint32_t AmbisonicMaxOrder = 3;
+constexpr uint32_t AmbisonicMaxChannels = (AmbisonicMaxOrder + 1) * (AmbisonicMaxOrder + 1);
+
+enum class AmbisonicDecoder
+{
+    Projection, // Max rE weighted beams at each speaker; works for any layout
+    ModeMatching // Least squares re-encoding; needs at least as many speakers as bus channels, well spread
+};
+
+struct AmbisonicSpeaker
+{
+    float azimuth = 0.0f;
+    float elevation = 0.0f;
+    bool lfe = false; // Gets nothing from the bus
+};
+
+struct AmbisonicSource
+{
+    const float* pInput = nullptr;
+    float azimuth = 0.0f;
+    float elevation = 0.0f;
+    float gain = 1.0f;
+};
+
+struct AmbisonicBus
+{
+    uint32_t order = 1;
+    uint32_t channels = 4;
+    uint32_t maxFrames = 0;
+
+    std::vector<float> bus; // channels * maxFrames
+    std::vector<float*> busChannels;
+
+    std::vector<AmbisonicSpeaker> speakers;
+    AmbisonicDecoder decoderType = AmbisonicDecoder::Projection;
+    std::vector<float> decoder; // speakers * channels
+    float rotation[AmbisonicMaxChannels * AmbisonicMaxChannels] = {};
+    std::vector<float> output; // decoder * rotation, rebuilt when either changes
+    bool outputDirty = true;
+
+    std::vector<float> speakerData; // speakers * maxFrames
+    std::vector<float*> speakerChannels;
+
+    std::vector<float> encoder; // scratch for the encode matrix
+    std::vector<const float*> sourceInputs;
+
+    // Optional; blocks of at least 2 * minJobFrames are split over the pool by frame range
+    AudioWorkerPool* pWorkers = nullptr;
+    uint32_t minJobFrames = 256;
+};
+
+// Evaluate the (order + 1)^2 SN3D harmonics for a direction
+void ambisonic_coefficients(uint32_t order, float azimuth, float elevation, float* pCoefficients);
+
+// Speaker directions for a device channel count, in the usual WAVE channel order
+// (1 mono, 2 stereo, 4 quad, 6 is 5.1, 8 is 7.1, anything else an even ring starting at the front)
+std::vector<AmbisonicSpeaker> ambisonic_default_layout(uint32_t channelCount);
+
+void ambisonic_init(AmbisonicBus& bus, uint32_t order, uint32_t maxFrames, uint32_t outputChannels);
+void ambisonic_set_layout(AmbisonicBus& bus, const std::vector<AmbisonicSpeaker>& speakers, AmbisonicDecoder decoder = AmbisonicDecoder::Projection);
+
+// Turns the sound field: roll about the front axis, then pitch about the left axis, then yaw about the
+// vertical. All are right handed, so positive yaw turns left, positive pitch tips the front down and
+// positive roll lifts the left side.
+void ambisonic_set_rotation(AmbisonicBus& bus, float yaw, float pitch, float roll);
+
+void ambisonic_clear(AmbisonicBus& bus, uint32_t frames);
+void ambisonic_encode(AmbisonicBus& bus, const AmbisonicSource* pSources, uint32_t sourceCount, uint32_t frames);
+
+// Adds the decoded speakers into an interleaved device buffer; speakers past channelCount are dropped
+void ambisonic_decode(AmbisonicBus& bus, float* pOutput, uint32_t channelCount, uint32_t frames);
+
+} // namespace Zing
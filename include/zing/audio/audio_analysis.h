@@ -14,6 +14,12 @@ bool audio_analysis_start(AudioAnalysis& analyis, const AudioChannelState& state
 void audio_analysis_stop(AudioAnalysis& analyis);
 void audio_analysis_update(AudioAnalysis& analysis, AudioBundle& bundle);
 
+// Runs the registered stages on the frame just transformed, rebuilding the channel's pipeline if they changed
+void audio_analysis_run_stages(AudioAnalysis& analysis, AudioAnalysisData& analysisData, double hopSeconds);
+
+// A published feature vector by name, or null
+const float* audio_analysis_feature(const AudioAnalysisData& analysisData, const std::string& name, uint32_t* pSize = nullptr);
+
 uint32_t audio_analysis_read_index(AudioAnalysisData& analysis);
 uint32_t audio_analysis_write_index(AudioAnalysisData& analysis);
 
@@ -2,6 +2,7 @@
 
 #include <algorithm>
 #include <cmath>
+#include <string>
 
 #include <zest/file/toml_utils.h>
 #include <zest/common.h>
@@ -30,6 +31,21 @@ struct AudioAnalysisSettings
     glm::uvec4 spectrumFrequencies = glm::uvec4(100, 500, 3000, 10000);
     glm::vec4 spectrumGains = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
     float audioDecibelRange = 110.0f;
+    bool pitchEnabled = true;
+    float pitchMinFrequency = 50.0f;
+    float pitchMaxFrequency = 2000.0f;
+    float pitchThreshold = 0.2f; // Largest YIN dip accepted as pitched
+    bool onsetEnabled = true;
+    float onsetSensitivity = 1.5f; // Multiple of the mean spectral flux that makes an onset
+    float tempoMinBpm = 60.0f;
+    float tempoMaxBpm = 180.0f;
+    bool waterfallEnabled = true;
+    uint32_t waterfallBins = 512; // Columns of each channel's waterfall; the spectrum is averaged down to it
+    bool archiveEnabled = false; // Record each input's spectrogram to disk
+    std::string archivePath; // Folder for the recordings; the temp folder if empty
+    float archiveRowSeconds = 0.1f;
+    float archiveViewSeconds = 600.0f; // Span of the history view
+    uint32_t archiveView = 2; // SpectrogramView: min, mean, max
 };
 
 inline AudioAnalysisSettings audioanalysis_load_settings(const toml::table& settings)
@@ -56,6 +72,21 @@ inline AudioAnalysisSettings audioanalysis_load_settings(const toml::table& sett
         analysisSettings.spectrumFrequencies = toml_read_vec4(settings["spectrum_frequencies"], analysisSettings.spectrumFrequencies);
         analysisSettings.spectrumGains = toml_read_vec4(settings["spectrum_gains"], analysisSettings.spectrumGains);
         analysisSettings.audioDecibelRange = settings["audio_decibels"].value_or(analysisSettings.audioDecibelRange);
+        analysisSettings.pitchEnabled = settings["pitch_enabled"].value_or(analysisSettings.pitchEnabled);
+        analysisSettings.pitchMinFrequency = settings["pitch_min_frequency"].value_or(analysisSettings.pitchMinFrequency);
+        analysisSettings.pitchMaxFrequency = settings["pitch_max_frequency"].value_or(analysisSettings.pitchMaxFrequency);
+        analysisSettings.pitchThreshold = settings["pitch_threshold"].value_or(analysisSettings.pitchThreshold);
+        analysisSettings.onsetEnabled = settings["onset_enabled"].value_or(analysisSettings.onsetEnabled);
+        analysisSettings.onsetSensitivity = settings["onset_sensitivity"].value_or(analysisSettings.onsetSensitivity);
+        analysisSettings.tempoMinBpm = settings["tempo_min_bpm"].value_or(analysisSettings.tempoMinBpm);
+        analysisSettings.tempoMaxBpm = settings["tempo_max_bpm"].value_or(analysisSettings.tempoMaxBpm);
+        analysisSettings.waterfallEnabled = settings["waterfall_enabled"].value_or(analysisSettings.waterfallEnabled);
+        analysisSettings.waterfallBins = settings["waterfall_bins"].value_or(analysisSettings.waterfallBins);
+        analysisSettings.archiveEnabled = settings["archive_enabled"].value_or(analysisSettings.archiveEnabled);
+        analysisSettings.archivePath = settings["archive_path"].value_or(analysisSettings.archivePath);
+        analysisSettings.archiveRowSeconds = settings["archive_row_seconds"].value_or(analysisSettings.archiveRowSeconds);
+        analysisSettings.archiveViewSeconds = settings["archive_view_seconds"].value_or(analysisSettings.archiveViewSeconds);
+        analysisSettings.archiveView = settings["archive_view"].value_or(analysisSettings.archiveView);
     }
     catch (std::exception& ex)
     {
@@ -85,7 +116,22 @@ inline toml::table audioanalysis_save_settings(const AudioAnalysisSettings& sett
         { "comp_release", settings.compRelease },
         { "spectrum_frequencies", toml::array{ freq.x, freq.y, freq.z, freq.w } },
         { "spectrum_gains", toml::array{ gain.x, gain.y, gain.z, gain.w } },
-        { "audio_decibels", settings.audioDecibelRange }
+        { "audio_decibels", settings.audioDecibelRange },
+        { "pitch_enabled", settings.pitchEnabled },
+        { "pitch_min_frequency", settings.pitchMinFrequency },
+        { "pitch_max_frequency", settings.pitchMaxFrequency },
+        { "pitch_threshold", settings.pitchThreshold },
+        { "onset_enabled", settings.onsetEnabled },
+        { "onset_sensitivity", settings.onsetSensitivity },
+        { "tempo_min_bpm", settings.tempoMinBpm },
+        { "tempo_max_bpm", settings.tempoMaxBpm },
+        { "waterfall_enabled", settings.waterfallEnabled },
+        { "waterfall_bins", int(settings.waterfallBins) },
+        { "archive_enabled", settings.archiveEnabled },
+        { "archive_path", settings.archivePath },
+        { "archive_row_seconds", settings.archiveRowSeconds },
+        { "archive_view_seconds", settings.archiveViewSeconds },
+        { "archive_view", int(settings.archiveView) }
     };
 
     return tab;
@@ -109,6 +155,16 @@ inline void audio_analysis_validate_settings(AudioAnalysisSettings& settings)
     settings.spectrumFrequencies.y = std::clamp(settings.spectrumFrequencies.y, settings.spectrumFrequencies.x, glm::uint(22000));
     settings.spectrumFrequencies.z = std::clamp(settings.spectrumFrequencies.z, settings.spectrumFrequencies.y, glm::uint(22000));
     settings.spectrumFrequencies.w = std::clamp(settings.spectrumFrequencies.w, settings.spectrumFrequencies.z, glm::uint(22000));
+    settings.pitchMinFrequency = std::clamp(settings.pitchMinFrequency, 20.0f, 4000.0f);
+    settings.pitchMaxFrequency = std::clamp(settings.pitchMaxFrequency, settings.pitchMinFrequency, 8000.0f);
+    settings.pitchThreshold = std::clamp(settings.pitchThreshold, 0.01f, 1.0f);
+    settings.onsetSensitivity = std::clamp(settings.onsetSensitivity, 1.0f, 10.0f);
+    settings.tempoMinBpm = std::clamp(settings.tempoMinBpm, 30.0f, 300.0f);
+    settings.tempoMaxBpm = std::clamp(settings.tempoMaxBpm, settings.tempoMinBpm * 1.5f, 400.0f);
+    settings.waterfallBins = std::clamp(settings.waterfallBins, 32u, settings.frames / 2);
+    settings.archiveRowSeconds = std::clamp(settings.archiveRowSeconds, 0.01f, 10.0f);
+    settings.archiveViewSeconds = std::clamp(settings.archiveViewSeconds, 10.0f, 7.0f * 24.0f * 3600.0f);
+    settings.archiveView = std::min(settings.archiveView, 2u);
 }
 
 } // namespace Zing
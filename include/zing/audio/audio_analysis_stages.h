@@ -0,0 +1,114 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Zing
+{
+
+// Per channel feature stages run by the analysis threads on every frame.
+// A stage says which views of the frame it needs; the pipeline works out each view once per frame,
+// whatever number of stages share it, runs the stages so that any stage comes after the stages it
+// reads from, and publishes each stage's output as a named feature vector in AudioAnalysisData.
+enum AnalysisInputFlags : uint32_t
+{
+    AnalysisInput_Time = 1 << 0, // The raw frame
+    AnalysisInput_Windowed = 1 << 1, // The frame as it went into the FFT
+    AnalysisInput_Power = 1 << 2, // |X|^2, amplitude normalised
+    AnalysisInput_Magnitude = 1 << 3, // |X|
+    AnalysisInput_Phase = 1 << 4 // arg(X)
+};
+
+struct AnalysisFeature
+{
+    std::string name;
+    uint32_t offset = 0; // Into the feature data
+    uint32_t size = 0;
+};
+
+// What a stage sees of the frame; only the inputs it asked for are guaranteed to be set
+struct AnalysisFrame
+{
+    uint32_t frames = 0;
+    uint32_t bins = 0; // frames / 2 + 1
+    uint32_t sampleRate = 0;
+    double hopSeconds = 0.0; // Time since the last frame
+    bool active = false; // False when the frame is silent
+
+    const float* pTime = nullptr;
+    const float* pWindowed = nullptr;
+    const float* pWindow = nullptr; // The window the frame was shaped with, always set
+    const float* pPower = nullptr;
+    const float* pMagnitude = nullptr;
+    const float* pPhase = nullptr;
+
+    // Features of the stages run so far this frame
+    const std::vector<AnalysisFeature>* pFeatures = nullptr;
+    const float* pFeatureData = nullptr;
+};
+
+// Writes the stage's 'size' floats to pOut
+using fnAnalysisStage = std::function<void(const AnalysisFrame& frame, float* pOut)>;
+
+struct AnalysisStageInfo
+{
+    std::string name; // Also the name of the feature it publishes
+    uint32_t inputs = 0; // AnalysisInputFlags
+    uint32_t size = 1;
+    std::vector<std::string> after; // Stages whose features this one reads
+
+    // Called for each channel when its pipeline is built, with the frame size and rate; the function
+    // returned is called every frame and owns any state it needs
+    std::function<fnAnalysisStage(uint32_t frames, uint32_t sampleRate)> fnCreate;
+};
+
+// The shared list; edited from any thread, picked up by each channel on its next frame
+struct AnalysisStageRegistry
+{
+    std::mutex mutex;
+    std::vector<AnalysisStageInfo> stages;
+    std::atomic<uint32_t> generation = 1;
+};
+
+// A channel's built pipeline
+struct AnalysisPipeline
+{
+    struct Stage
+    {
+        fnAnalysisStage fnProcess;
+        uint32_t offset = 0;
+    };
+
+    uint32_t generation = 0; // Of the registry it was built from
+    uint32_t layout = 0; // Changes with every build
+    uint32_t frames = 0;
+    uint32_t sampleRate = 0;
+    uint32_t inputs = 0;
+    std::vector<Stage> stages;
+    std::vector<AnalysisFeature> features;
+    uint32_t featureFloats = 0;
+
+    std::vector<float> magnitude;
+    std::vector<float> phase;
+};
+
+// Adds a stage, or replaces the one with the same name
+void audio_analysis_add_stage(const AnalysisStageInfo& info);
+void audio_analysis_remove_stage(const std::string& name);
+
+// rms, centroid, rolloff, flatness, chroma, mel, mfcc, lpc, pitch and onset
+std::vector<AnalysisStageInfo> audio_analysis_builtin_stages();
+void audio_analysis_add_builtin_stages();
+
+// The order a pipeline runs the stages in: each after the stages it reads, otherwise as added
+std::vector<const AnalysisStageInfo*> audio_analysis_stage_order(const std::vector<AnalysisStageInfo>& stages);
+
+// A feature by name from the features so far, or null
+const float* audio_analysis_find_feature(const std::vector<AnalysisFeature>& features, const float* pData, const std::string& name, uint32_t* pSize = nullptr);
+const float* audio_analysis_frame_feature(const AnalysisFrame& frame, const std::string& name, uint32_t* pSize = nullptr);
+
+} // namespace Zing
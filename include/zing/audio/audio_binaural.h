@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <kiss_fftr.h>
+
+namespace Zing
+{
+
+// Spatialises many mono sources to a stereo pair through measured head related impulse responses.
+// Work is done in blocks of blockSize (which is also the latency): each source is transformed once,
+// multiplied into a left and right accumulator in the frequency domain, and each ear gets a single
+// inverse transform, however many sources there are. HRIRs longer than a block are uniformly partitioned.
+
+struct BinauralSettings
+{
+    uint32_t blockSize = 256; // Power of 2
+    uint32_t maxSources = 64;
+    uint32_t maxHrirLength = 512; // Longer responses are cut
+    uint32_t neighbours = 3; // Measured directions blended for a source, up to 8
+};
+
+// One measured direction; the spectra are partitions * (blockSize + 1) per ear
+struct BinauralHrir
+{
+    float azimuth = 0.0f;
+    float elevation = 0.0f;
+    glm::vec3 direction;
+    std::vector<kiss_fft_cpx> spectra[2];
+};
+
+struct BinauralSource
+{
+    bool active = false;
+    float gain = 1.0f;
+    float azimuth = 0.0f; // Degrees, clockwise from the front; 90 is hard right
+    float elevation = 0.0f; // Degrees up from the horizontal
+    bool directionChanged = true;
+
+    // The blend of the nearest HRIRs, rebuilt when the direction moves
+    std::vector<kiss_fft_cpx> filter[2];
+
+    std::vector<float> window; // The last 2 blocks of input
+    std::vector<kiss_fft_cpx> spectra; // One per partition, most recent at spectrumIndex
+    uint32_t spectrumIndex = 0;
+    uint32_t silentBlocks = 0;
+};
+
+struct BinauralRenderer
+{
+    BinauralSettings settings;
+    uint32_t sampleRate = 44100;
+    uint32_t partitions = 1;
+
+    kiss_fftr_cfg forward = nullptr;
+    kiss_fftr_cfg inverse = nullptr;
+
+    std::vector<BinauralHrir> hrirs;
+    std::vector<BinauralSource> sources;
+
+    // Block FIFOs; input is per source, output is interleaved stereo
+    std::vector<float> input;
+    std::vector<float> output;
+    uint32_t fill = 0;
+
+    std::vector<kiss_fft_cpx> accumulate[2];
+    std::vector<float> time;
+};
+
+void binaural_init(BinauralRenderer& renderer, uint32_t sampleRate, const BinauralSettings& settings = BinauralSettings{});
+void binaural_destroy(BinauralRenderer& renderer);
+
+// Add a measured pair; it is resampled if the rate differs from the renderer's
+void binaural_add_hrir(BinauralRenderer& renderer, float azimuth, float elevation, const float* pLeft, const float* pRight, uint32_t length, uint32_t sampleRate);
+
+// Loads a folder of WAV files named in the MIT KEMAR style: H<elevation>e<azimuth>a.wav stereo pairs,
+// or L/R<elevation>e<azimuth>a.wav mono ears. A set covering only one side (0 to 180) is mirrored.
+// Returns the number of directions loaded.
+uint32_t binaural_load_hrirs(BinauralRenderer& renderer, const fs::path& folder);
+
+int binaural_add_source(BinauralRenderer& renderer);
+void binaural_remove_source(BinauralRenderer& renderer, int source);
+void binaural_set_source(BinauralRenderer& renderer, int source, float azimuth, float elevation, float gain = 1.0f);
+
+// ppInputs has an entry per source slot (null for silence); pOut is interleaved stereo and is overwritten
+void binaural_process(BinauralRenderer& renderer, const float* const* ppInputs, float* pOut, uint32_t frames);
+
+} // namespace Zing
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+
+namespace Zing
+{
+
+// Block versions of the soundpipe modules used most on the audio thread.
+// Each holds one state per channel and works on interleaved buffers (1 channel is a plain mono buffer);
+// the channels of a frame are processed side by side, 4 to a vector, so stereo and multichannel cost
+// little more than mono. The sums are done in the same order as the scalar modules, so the output
+// matches them to the bit (or within rounding where a module mixes float and double).
+// Parameters are picked up once per block.
+constexpr uint32_t BlockDspMaxChannels = 8;
+
+// sp_osc; each channel is its own oscillator, with its own frequency and amplitude
+struct BlockOsc
+{
+    sp_ftbl* pTable = nullptr;
+    uint32_t channels = 1;
+    float freq[BlockDspMaxChannels] = {};
+    float amp[BlockDspMaxChannels] = {};
+    int32_t phase[BlockDspMaxChannels] = {};
+};
+
+// sp_biquad
+struct BlockBiquad
+{
+    uint32_t channels = 1;
+    float sampleRate = 44100.0f;
+    float cutoff = 500.0f;
+    float res = 0.7f;
+    float b0 = 0.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+    float xnm1[BlockDspMaxChannels] = {};
+    float xnm2[BlockDspMaxChannels] = {};
+    float ynm1[BlockDspMaxChannels] = {};
+    float ynm2[BlockDspMaxChannels] = {};
+};
+
+enum class BlockButterType
+{
+    LowPass,
+    HighPass
+};
+
+// sp_butlp / sp_buthp
+struct BlockButter
+{
+    BlockButterType type = BlockButterType::LowPass;
+    uint32_t channels = 1;
+    float freq = 1000.0f;
+    float pidsr = 0.0f;
+    float lastFreq = 0.0f;
+    float a[6] = {};
+    float z1[BlockDspMaxChannels] = {};
+    float z2[BlockDspMaxChannels] = {};
+};
+
+// sp_moogladder; the tanh stages branch per sample, so the channels run one after the other
+struct BlockMoog
+{
+    uint32_t channels = 1;
+    float sampleRate = 44100.0f;
+    float freq = 1000.0f;
+    float res = 0.4f;
+    float oldFreq = 0.0f;
+    float oldRes = -1.0f;
+    float acr = 0.0f;
+    float tune = 0.0f;
+    float delay[BlockDspMaxChannels][6] = {};
+    float tanhstg[BlockDspMaxChannels][3] = {};
+};
+
+// sp_phaser; a stereo effect, run through the Faust compute a block at a time
+struct BlockPhaser
+{
+    sp_data* pSP = nullptr;
+    sp_phaser* pPhaser = nullptr;
+};
+
+void block_osc_init(BlockOsc& osc, sp_ftbl* pTable, uint32_t channels, float initialPhase = 0.0f);
+void block_osc_set(BlockOsc& osc, float freq, float amp);
+void block_osc_process(BlockOsc& osc, float* pOut, uint32_t frames);
+
+void block_biquad_init(BlockBiquad& biquad, sp_data* pSP, uint32_t channels);
+void block_biquad_set(BlockBiquad& biquad, float cutoff, float res);
+void block_biquad_process(BlockBiquad& biquad, const float* pIn, float* pOut, uint32_t frames);
+
+void block_butter_init(BlockButter& butter, sp_data* pSP, BlockButterType type, uint32_t channels);
+void block_butter_process(BlockButter& butter, const float* pIn, float* pOut, uint32_t frames);
+
+void block_moog_init(BlockMoog& moog, sp_data* pSP, uint32_t channels);
+void block_moog_process(BlockMoog& moog, const float* pIn, float* pOut, uint32_t frames);
+
+void block_phaser_init(BlockPhaser& phaser, sp_data* pSP);
+void block_phaser_destroy(BlockPhaser& phaser);
+
+// In and out have 'channels' interleaved (1 or 2); mono is fed to both sides and the sides are summed back
+void block_phaser_process(BlockPhaser& phaser, const float* pIn, float* pOut, uint32_t frames, uint32_t channels);
+
+} // namespace Zing
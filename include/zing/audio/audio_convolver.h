@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <kiss_fftr.h>
+
+namespace Zing
+{
+
+struct AudioConvolverSettings
+{
+    // Taps convolved directly, sample by sample; also the smallest FFT partition. Powers of 2.
+    uint32_t headSize = 64;
+    // Each FFT level's partitions are this much bigger than the last, up to maxPartition
+    uint32_t growth = 8;
+    uint32_t maxPartition = 4096;
+    float wet = 1.0f;
+    float dry = 0.0f;
+};
+
+enum class ConvolverJobState : uint32_t
+{
+    Idle,
+    Pending,
+    Running,
+    Done
+};
+
+// One uniformly partitioned (overlap save) section of the IR, starting 'offset' taps in.
+// The first level runs on the audio thread as each block of input completes. The later levels
+// start at twice their partition size, so a block has a whole partition of time to be done
+// in the background before its output is due.
+struct ConvolverLevel
+{
+    uint32_t size = 0;
+    uint32_t offset = 0;
+    uint32_t partitions = 0;
+    bool background = false;
+
+    kiss_fftr_cfg forward = nullptr;
+    kiss_fftr_cfg inverse = nullptr;
+
+    std::vector<kiss_fft_cpx> irSpectra;   // partitions * (size + 1), prescaled for the inverse
+    std::vector<kiss_fft_cpx> inputSpectra; // the frequency domain delay line, same layout
+    std::vector<kiss_fft_cpx> accumulate;
+    std::vector<float> window;             // the last 2 blocks of input
+    std::vector<float> time;
+    uint32_t spectrumIndex = 0;
+
+    // Finished blocks alternate between two halves; one is read while the next is made
+    std::vector<float> output;
+
+    uint64_t jobBlock = 0;
+    std::atomic<ConvolverJobState> state = ConvolverJobState::Idle;
+};
+
+// Non uniformly partitioned convolution with no added latency, for long IRs on the audio thread.
+// The short head is done in place; the long tail is done a partition ahead on a worker thread.
+// If the worker has not picked a tail block up by the time its output is due, the audio thread
+// does it itself; it only ever waits for a block the worker is part way through.
+struct AudioConvolver
+{
+    AudioConvolverSettings settings;
+
+    std::vector<float> head;    // The direct taps, reversed
+    std::vector<float> history; // The last headSize inputs, written twice so they can be read in one run
+    uint32_t historyIndex = 0;
+
+    std::vector<float> input; // Ring of recent input, read by the levels
+    uint64_t inputMask = 0;
+    uint64_t time = 0;
+
+    std::vector<std::unique_ptr<ConvolverLevel>> levels;
+
+    std::thread worker;
+    std::atomic<uint32_t> wake = 0;
+    std::atomic_bool quit = false;
+
+    // Tail blocks the audio thread did itself, or had to wait for
+    std::atomic<uint32_t> steals = 0;
+    std::atomic<uint32_t> waits = 0;
+};
+
+bool audio_convolver_init(AudioConvolver& convolver, const float* pImpulse, uint32_t length, const AudioConvolverSettings& settings = AudioConvolverSettings{});
+void audio_convolver_destroy(AudioConvolver& convolver);
+
+// Every 'stride'th sample of the buffers; in and out may be the same
+void audio_convolver_process(AudioConvolver& convolver, const float* pIn, float* pOut, uint32_t frames, uint32_t stride = 1);
+
+} // namespace Zing
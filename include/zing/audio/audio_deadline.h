@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace Zing
+{
+
+// Timing of every audio callback against its deadline (the length of the buffer).
+// The audio thread fills one record per callback in a fixed ring and publishes it with a single atomic
+// store; nothing there locks or allocates. A collector thread drains the ring into histograms, which can
+// be read at any time from any thread, or dumped as text.
+enum class DeadlineStage : uint32_t
+{
+    PreCallback, // Link and metronome
+    Midi, // MIDI events, and the samples and streams they play
+    InputStages,
+    UserCallback,
+    OutputStages,
+    Compressor,
+    SendAnalysis,
+    Count
+};
+
+// As PortAudio's stream callback flags, plus callbacks that were skipped
+enum DeadlineFlags : uint32_t
+{
+    Deadline_InputUnderflow = 1 << 0,
+    Deadline_InputOverflow = 1 << 1,
+    Deadline_OutputUnderflow = 1 << 2,
+    Deadline_OutputOverflow = 1 << 3,
+    Deadline_PrimingOutput = 1 << 4,
+    Deadline_Skipped = 1 << 5 // The tick lock was held; silence was sent
+};
+
+struct DeadlineRecord
+{
+    uint64_t callback = 0;
+    uint32_t frames = 0;
+    uint32_t flags = 0; // DeadlineFlags
+    float budgetUs = 0.0f; // Length of the buffer
+    float totalUs = 0.0f;
+    float leadUs = 0.0f; // Time from the callback starting to the buffer reaching the DAC, if the host says
+    std::array<float, size_t(DeadlineStage::Count)> stageUs = {};
+};
+
+// Times on a log scale, 8 buckets an octave from 1us; anything under a microsecond lands in the first
+struct DeadlineHistogram
+{
+    static constexpr uint32_t BucketsPerOctave = 8;
+    static constexpr uint32_t Buckets = 20 * BucketsPerOctave; // Up to about 1s
+    std::array<uint64_t, Buckets> counts = {};
+    uint64_t count = 0;
+    double sum = 0.0;
+    double max = 0.0;
+};
+
+struct DeadlineStats
+{
+    uint64_t callbacks = 0;
+    uint64_t late = 0; // Took longer than the buffer lasts
+    uint64_t skipped = 0;
+    uint64_t inputUnderflows = 0;
+    uint64_t inputOverflows = 0;
+    uint64_t outputUnderflows = 0;
+    uint64_t outputOverflows = 0;
+    uint64_t lost = 0; // Records overwritten before the collector saw them
+    double budgetUs = 0.0; // Of the latest callback
+    double minSlackUs = 0.0; // Least time left before the DAC needed the buffer
+    bool slackKnown = false; // The host gave DAC times
+
+    DeadlineHistogram total;
+    DeadlineHistogram load; // total / budget, in hundredths of a percent, so the same buckets resolve light loads
+    std::array<DeadlineHistogram, size_t(DeadlineStage::Count)> stages;
+};
+
+struct DeadlineMonitor
+{
+    static constexpr uint32_t RingSize = 1024; // Power of 2; about 10 seconds of 512 frame buffers at 48kHz
+
+    std::array<DeadlineRecord, RingSize> ring;
+    std::atomic<uint64_t> written = 0; // Records published by the audio thread
+    uint64_t read = 0; // Collector only
+
+    // The record being filled; audio thread only
+    DeadlineRecord* pCurrent = nullptr;
+    std::chrono::steady_clock::time_point start;
+
+    std::mutex statsMutex;
+    DeadlineStats stats;
+
+    std::thread thread;
+    std::atomic_bool quitThread = false;
+    std::atomic_bool running = false;
+};
+
+// Times one stage of the current callback; adds to it if the stage runs more than once
+struct DeadlineStageScope
+{
+    DeadlineStageScope(DeadlineMonitor& monitor, DeadlineStage stage);
+    ~DeadlineStageScope();
+
+    DeadlineRecord* pRecord;
+    DeadlineStage stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+void deadline_start(DeadlineMonitor& monitor);
+void deadline_stop(DeadlineMonitor& monitor);
+
+// Audio thread; around each callback. leadSeconds is how long until the buffer is played, or 0 if unknown.
+void deadline_begin(DeadlineMonitor& monitor, uint32_t frames, uint32_t sampleRate, uint32_t flags, double leadSeconds);
+void deadline_end(DeadlineMonitor& monitor, uint32_t flags = 0);
+
+// A copy of the statistics so far; drains anything not yet collected first
+DeadlineStats deadline_stats(DeadlineMonitor& monitor);
+void deadline_reset(DeadlineMonitor& monitor);
+
+// The value below which 'fraction' (0..1) of the samples fall, from the bucket edges
+double deadline_percentile(const DeadlineHistogram& histogram, double fraction);
+
+// A plain text table of the statistics, for logs and headless runs
+std::string deadline_report(const DeadlineStats& stats);
+
+const char* deadline_stage_name(DeadlineStage stage);
+
+} // namespace Zing
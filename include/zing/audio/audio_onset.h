@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace Zing
+{
+
+struct AudioOnset
+{
+    bool onset = false; // An onset peaked in the previous frame
+    float flux = 0.0f; // Onset strength of this frame
+    float bpm = 0.0f; // 0 until a tempo has been found
+    float tempoConfidence = 0.0f; // 0 to 1
+};
+
+// Spectral flux onsets and an autocorrelation tempo, from the analysis power spectrum of each frame.
+// Flux is the rectified rise in compressed magnitude (|X|^0.5) summed over the bins; a frame is an
+// onset when it peaks above the running mean by the sensitivity factor. The flux, less its running
+// mean, is kept for a few seconds and autocorrelated over the tempo range every half second; the
+// strongest lag, weighted towards 120 BPM and helped by its double, sets the tempo.
+struct OnsetDetector
+{
+    double hopSeconds = 0.0; // Time between frames; the history restarts if it changes
+    std::vector<float> previous; // Compressed magnitudes of the last frame
+    bool primed = false;
+
+    // Flux of the last frames for peak picking; [0] is newest
+    float recent[3] = {};
+    float fluxMean = 0.0f;
+    double sinceOnset = 0.0;
+
+    // Onset envelope for the tempo; a ring with a mirrored copy, so any window is contiguous
+    std::vector<float> envelope;
+    uint32_t envelopeSize = 0;
+    uint32_t envelopeIndex = 0;
+    uint32_t envelopeCount = 0;
+    std::vector<float> lagScores;
+    double sinceTempo = 0.0;
+
+    float bpm = 0.0f;
+    float tempoConfidence = 0.0f;
+};
+
+struct OnsetSettings
+{
+    float sensitivity = 1.5f; // Multiple of the running mean flux an onset must reach
+    float minInterval = 0.05f; // Seconds between onsets
+    float minBpm = 60.0f;
+    float maxBpm = 180.0f;
+    float tempoSeconds = 6.0f; // Length of history the tempo is taken from
+};
+
+void onset_detector_reset(OnsetDetector& detector);
+
+// pPower holds bins of |X|^2 for the frame; hopSeconds is the time since the last frame
+AudioOnset onset_detector_update(OnsetDetector& detector, const float* pPower, uint32_t bins, double hopSeconds, const OnsetSettings& settings);
+
+} // namespace Zing
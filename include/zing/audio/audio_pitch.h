@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <kiss_fftr.h>
+
+namespace Zing
+{
+
+struct AudioPitch
+{
+    float frequency = 0.0f; // Hz, 0 when there is no pitch
+    float confidence = 0.0f; // 0 to 1; 1 - the YIN dip at the chosen lag
+};
+
+// YIN, driven from the power spectrum the analysis has already taken (the 'yinfft' form).
+// One inverse transform of the power gives the autocorrelation of the windowed frame, the difference
+// function is 2(r(0) - r(t)), with r(t) divided by the window's autocorrelation to undo the taper
+// (Boersma's correction), and the rest is the usual cumulative mean normalisation and dip search;
+// so a frame costs a single real FFT plus a pass over the lag range.
+struct PitchTracker
+{
+    uint32_t frames = 0; // Size of the transform the power spectrum came from
+    kiss_fftr_cfg inverse = nullptr;
+
+    std::vector<kiss_fft_cpx> spectrum;
+    std::vector<float> correlation;
+    std::vector<float> difference;
+    std::vector<float> windowCorrection;
+};
+
+// pWindow is the window the frames were shaped with before the transform
+void pitch_tracker_init(PitchTracker& tracker, const float* pWindow, uint32_t frames);
+void pitch_tracker_destroy(PitchTracker& tracker);
+
+// pPower holds frames / 2 + 1 bins of |X|^2, at any scale
+AudioPitch pitch_tracker_update(PitchTracker& tracker, const float* pPower, uint32_t sampleRate, float minFrequency, float maxFrequency, float threshold);
+
+} // namespace Zing
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <zest/string/string_utils.h>
+
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace Zing
+{
+
+// Disk streamed sample playback, for libraries too big to keep resident.
+// Each source keeps only a preload head in memory; a voice plays from the head while the I/O thread
+// opens the file and fills the voice's ring buffer from the end of the head onwards.
+// Memory is (sources * head) + (voices * ring), whatever the size of the files.
+
+struct SampleStreamSettings
+{
+    uint32_t voiceCount = 64;
+    uint32_t preloadFrames = 16384; // Must cover the time it takes to open and seek a file
+    uint32_t ringFrames = 32768;
+    uint32_t readFrames = 4096; // Largest single read on the I/O thread
+    uint32_t releaseFrames = 256; // Fade when a voice is released
+};
+
+struct SampleStreamSource
+{
+    fs::path path;
+    uint32_t channels = 0;
+    uint32_t sampleRate = 0;
+    uint64_t frames = 0;
+
+    uint64_t headFrames = 0;
+    std::vector<float> head; // Interleaved
+
+    // Set by the I/O thread when the file can't be read past the head; voices then fade out at the end
+    // of the head, and the file isn't tried again
+    std::atomic_bool failed = false;
+};
+
+enum class SampleStreamVoiceState : uint32_t
+{
+    Free, // Owned by the audio thread
+    Active, // Audio thread reads, I/O thread fills the ring
+    Stopping // Waiting for the I/O thread to close the file
+};
+
+struct SampleStreamVoice
+{
+    std::atomic<SampleStreamVoiceState> state = SampleStreamVoiceState::Free;
+
+    // Set by the audio thread before the voice goes active
+    SampleStreamSource* pSource = nullptr;
+    float gain = 1.0f;
+
+    // Audio thread
+    uint64_t position = 0;
+    uint32_t releaseRemaining = 0;
+    uint32_t releaseLength = 0;
+    bool releasing = false;
+
+    // Frames after the head; written by the I/O thread, consumed by the audio thread
+    std::vector<float> ring;
+    std::atomic<uint64_t> written = 0;
+    std::atomic<uint64_t> consumed = 0;
+
+    // Blocks where the ring had run dry
+    std::atomic<uint32_t> underruns = 0;
+
+    // Set by the I/O thread; nothing more will arrive in the ring
+    std::atomic_bool failed = false;
+
+    // I/O thread
+    void* pDecoder = nullptr;
+};
+
+struct SampleStreamer
+{
+    SampleStreamSettings settings;
+
+    // Guards the sources; the audio thread only ever try_locks it
+    std::mutex sourceMutex;
+    std::unordered_map<Zest::StringId, std::unique_ptr<SampleStreamSource>> sources;
+
+    // Sources replaced by a later add; the I/O thread frees them when no voice is playing them
+    std::vector<std::unique_ptr<SampleStreamSource>> retired;
+
+    std::unique_ptr<SampleStreamVoice[]> voices;
+
+    std::thread ioThread;
+    std::atomic_bool quit = false;
+};
+
+void sample_stream_start(SampleStreamer& streamer, const SampleStreamSettings& settings);
+void sample_stream_stop(SampleStreamer& streamer);
+
+// Reads the header and the preload head; mono and stereo files only
+bool sample_stream_add(SampleStreamer& streamer, Zest::StringId id, const fs::path& path);
+
+// Audio thread; returns the voice index, or -1 if none are free or the sources are being changed
+int sample_stream_play(SampleStreamer& streamer, Zest::StringId id, float gain);
+void sample_stream_release(SampleStreamer& streamer, int voice);
+void sample_stream_release_all(SampleStreamer& streamer);
+void sample_stream_render(SampleStreamer& streamer, float* pOutput, uint32_t frames, uint32_t channels);
+
+uint32_t sample_stream_underruns(const SampleStreamer& streamer, int voice);
+
+} // namespace Zing
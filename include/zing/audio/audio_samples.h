@@ -1,31 +1,170 @@
 #pragma once
 
+#include <array>
+
 #include <zest/string/string_utils.h>
 
+#include <moodycamel/concurrentqueue.h>
+
+#include <zing/audio/audio_sample_stream.h>
+#include <zing/audio/audio_workers.h>
+#include <zing/sf2/sf2_file.h>
+
 #include <tsf/tsf.h>
 
 namespace Zing
 {
 
+// The font file is mapped and indexed in samples_add, so the presets are known straight away.
+// The samples are decoded from the mapping on a loader thread, once, into a float cache file; the font
+// plays straight from a mapping of the cache, so sample data is only paged in as it is played or
+// prefetched. The font is published to the audio thread under the sampleMutex when complete.
 struct SampleContainer
 {
-    union
-    {
-        tsf* soundFont;
-    };
+    tsf* soundFont = nullptr;
+    SF2MappedFile file;
+    SF2MappedFile cache; // Backs the font; empty if no cache could be written and it was decoded to memory
+    SF2Index index;
+    std::future<tsf*> loader;
+};
+
+// Reads in the samples of a preset chosen by a program change before its first note, off the audio thread
+struct SamplePrefetchRequest
+{
+    const SF2MappedFile* pCache = nullptr;
+    const tsf* pFont = nullptr;
+    int presetIndex = -1;
+};
+
+struct SamplePrefetch
+{
+    moodycamel::ConcurrentQueue<SamplePrefetchRequest> requests{ 64 }; // The audio thread never allocates; full drops
+    std::thread thread;
+    std::atomic_bool quit = false;
+};
+
+// Splits the active soundfont voices across a worker pool.
+// Job 0 mixes straight into the output, the other jobs render into their own scratch block
+// which is summed in afterwards.
+struct SampleRenderState
+{
+    AudioWorkerPool workers;
+    uint32_t minVoicesPerJob = 8;
+    uint32_t maxBlockFrames = 1024;
+
+    std::vector<float> scratch;
+    std::vector<uint32_t> activeVoices;
+    std::vector<uint32_t> jobVoices; // Start of each job in activeVoices, plus the end
+
+    // Current job, only valid during samples_render
+    tsf* pFont = nullptr;
+    float* pOutput = nullptr;
+    uint32_t frames = 0;
+    uint32_t scratchStride = 0;
+};
+
+// Scales polyphony to the time left in the audio callback.
+// Over highLoad the cheapest voices to lose are stolen down to a count that should fit, under lowLoad the
+// limit creeps back up; so an overloaded synth thins out instead of dropping buffers.
+struct SampleVoiceGovernor
+{
+    std::atomic_bool enabled = true;
+    std::atomic<float> highLoad = 0.8f;
+    std::atomic<float> lowLoad = 0.5f;
+    uint32_t minVoices = 16;
+    uint32_t raiseStep = 4;
+    uint32_t raiseTicks = 32; // Ticks of headroom before the limit is raised
+
+    // Audio thread
+    float tickLoad = 0.0f; // Tick time / deadline, for the last tick
+    bool newLoad = false;
+    uint32_t headroomTicks = 0;
+
+    // Published for display
+    std::atomic<uint32_t> voiceLimit = 0;
+    std::atomic<uint32_t> activeVoices = 0;
+    std::atomic<uint32_t> stolenVoices = 0;
+    std::atomic<float> load = 0.0f;
 };
 
 struct AudioSamples
 {
+    // Guards the sample map; the audio thread only ever try_locks it
     std::mutex sampleMutex;
     std::unordered_map<Zest::StringId, SampleContainer> samples;
     std::unordered_map<Zest::StringId, Zest::StringId> presetSamples;
+
+    // Loaded fonts in the order they arrived, and the font each midi channel plays through.
+    // Routes are resolved on program change; libremidi channels are 1 based.
+    std::vector<tsf*> fonts;
+    std::vector<const SF2MappedFile*> fontCaches; // The mapping behind each font, or null
+    std::array<tsf*, 17> channelFonts{};
+    uint32_t maxVoices = 256;
+
+    // Where preprocessed fonts are kept for a fast reload; empty for a folder in the temp directory
+    fs::path cacheDirectory;
+
+    SampleRenderState render;
+    SampleVoiceGovernor governor;
+
+    SamplePrefetch prefetch;
+
+    // Disk streamed samples, played alongside the soundfonts
+    SampleStreamer streamer;
 };
 
 bool samples_add(AudioSamples& samples, Zest::StringId id, const fs::path& path);
+bool samples_add_stream(AudioSamples& samples, Zest::StringId id, const fs::path& path);
+bool samples_loaded(AudioSamples& samples);
+void samples_destroy(AudioSamples& samples);
 void samples_stop(AudioSamples& samples);
 void samples_update_rate(AudioSamples& audioSamples);
+
+// The cache file for a font. Fonts of the same name in different folders get their own cache; the name
+// is kept so the cache directory can still be read.
+fs::path samples_cache_path(const fs::path& cacheDirectory, const fs::path& path);
+
+// Stored in the cache and checked on load; changes when the font does
+uint64_t samples_cache_hash(const SF2MappedFile& file, const SF2Index& index);
+
+// The caller must hold the sampleMutex for these
 void samples_render(AudioSamples& audioSamples, float* pOutput, uint32_t numSamples);
-const SampleContainer* samples_find(AudioSamples& audioSamples);
+tsf* samples_channel_font(AudioSamples& audioSamples, int channel);
+void samples_govern(AudioSamples& audioSamples);
+
+// Lower is stolen first. 'age' is the number of notes started on the font since this one.
+float samples_steal_score(float noteGainDb, float envelopeLevel, bool releasing, uint32_t age);
+
+// Ends voices until no more than 'limit' are sounding: releasing voices first, then held notes by gain and age.
+// Returns how many are left.
+uint32_t samples_steal_voices(AudioSamples& audioSamples, uint32_t limit);
+
+// A note on, within the governor's voice limit
+void samples_note_on(AudioSamples& audioSamples, tsf* pFont, int channel, int key, float velocity);
+
+// Report how long the last audio tick took against its deadline
+void samples_governor_tick(AudioSamples& audioSamples, double tickSeconds, double deadlineSeconds);
+void samples_program_change(AudioSamples& audioSamples, int channel, int program, bool drums);
+
+// The font a program change moves a channel to: the first whose fnPresetIndex(font) finds the preset, or -1
+// if none has it and the channel stays where it is. The preset's index in that font goes in presetIndex.
+template <typename FnPresetIndex>
+int samples_route_program(size_t fontCount, const FnPresetIndex& fnPresetIndex, int& presetIndex)
+{
+    for (size_t font = 0; font < fontCount; font++)
+    {
+        presetIndex = fnPresetIndex(font);
+        if (presetIndex >= 0)
+        {
+            return int(font);
+        }
+    }
+    presetIndex = -1;
+    return -1;
+}
+
+// Start threads to render voices in parallel; 0 renders everything on the audio thread.
+// Don't call while the audio tick is running.
+void samples_set_render_workers(AudioSamples& audioSamples, uint32_t threadCount);
 
-} //namespace Zing
\ No newline at end of file
+} //namespace Zing
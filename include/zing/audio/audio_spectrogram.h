@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <moodycamel/concurrentqueue.h>
+
+namespace Zing
+{
+
+// A spectrogram recorder for long sessions, kept in a memory mapped file.
+// Power spectra are pushed from the analysis thread and averaged into rows on the archive's own writer
+// thread. Each row is stored as 8 bit dB codes in tiles of rowsPerTile rows. Every 4 rows of a level
+// make one row of the level above, holding the min, mean (of power) and max of the rows below. So a
+// span of any length can be read at about screen resolution from a handful of tiles.
+// Finished tiles go to the file and never change; the tile being filled at each level stays in memory.
+struct SpectrogramSettings
+{
+    uint32_t bins = 512; // Columns; the spectrum is averaged down to this
+    uint32_t rowsPerTile = 256;
+    uint32_t levels = 6; // Rows of level n span 4^n rows of level 0
+    double rowSeconds = 0.1; // Time per level 0 row
+    float minDb = -160.0f; // Range covered by the codes
+    float maxDb = 20.0f;
+};
+
+enum class SpectrogramView
+{
+    Min,
+    Mean,
+    Max
+};
+
+struct SpectrogramFrame
+{
+    std::vector<float> power;
+    double seconds = 0.0; // Time since the previous frame
+};
+
+struct SpectrogramLevel
+{
+    std::vector<uint64_t> tiles; // File offsets of the finished tiles' codes
+    uint64_t rows = 0; // Rows at this level so far, including those in the partial tile
+    std::vector<uint8_t> partial; // The tile being filled: planes of rowsPerTile x bins codes
+
+    // The next row, gathered from the level below
+    std::vector<float> powerSum;
+    std::vector<float> minDb;
+    std::vector<float> maxDb;
+    uint32_t inputs = 0;
+};
+
+struct SpectrogramArchive
+{
+    std::filesystem::path path;
+    SpectrogramSettings settings;
+    uint32_t sampleRate = 0;
+
+    // The mapped file; remapped larger as tiles are added
+    uint8_t* pData = nullptr;
+    uint64_t mappedSize = 0;
+    uint64_t usedSize = 0;
+#ifdef _WIN32
+    void* hFile = nullptr;
+    void* hMapping = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    // Guards the levels and the mapping; held by readers while they copy rows out
+    std::mutex mutex;
+    std::vector<SpectrogramLevel> levels;
+
+    // Spectra from the analysis thread, and used frames coming back for reuse
+    moodycamel::ConcurrentQueue<std::shared_ptr<SpectrogramFrame>> frames;
+    moodycamel::ConcurrentQueue<std::shared_ptr<SpectrogramFrame>> spareFrames;
+    std::atomic<uint32_t> droppedFrames = 0;
+
+    // The level 0 row being averaged; writer thread only
+    std::vector<float> rowPower;
+    std::vector<float> rowDb;
+    uint32_t rowSpectra = 0;
+    double rowTime = 0.0;
+
+    std::thread thread;
+    std::atomic_bool quitThread = false;
+    std::atomic_bool running = false;
+};
+
+// Creates (or replaces) the file and starts the writer thread
+bool spectrogram_start(SpectrogramArchive& archive, const std::filesystem::path& path, const SpectrogramSettings& settings, uint32_t sampleRate);
+
+// Writes what's left, including partial tiles, and closes the file
+void spectrogram_stop(SpectrogramArchive& archive);
+
+// From the analysis thread; copies the spectrum and returns. Frames are dropped if the writer falls behind.
+void spectrogram_push(SpectrogramArchive& archive, const float* pPower, uint32_t count, double seconds);
+
+// Length of the recording, in seconds
+double spectrogram_duration(SpectrogramArchive& archive);
+
+// Rows covering [startSeconds, endSeconds), newest first, in dB; from the coarsest level giving at least
+// maxRows rows for the span. Returns the row count; pRowSeconds gets the time per row returned.
+uint32_t spectrogram_read(SpectrogramArchive& archive, double startSeconds, double endSeconds, uint32_t maxRows, SpectrogramView view, std::vector<float>& outDb, double* pRowSeconds = nullptr);
+
+} // namespace Zing
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+namespace Zing
+{
+
+// Offline time stretch / pitch shift of a WAV file on all cores.
+// The output timeline is cut into segments; each segment is rendered on its own by a worker, with a
+// run-in so the module has settled before the audible part. Neighbouring segments don't share phase
+// state, so each seam is lined up by cross correlation and the crossfade is shaped by how well they
+// match, to hold the level steady.
+// Input is read per segment and output is written in order as segments complete, so memory is
+// bounded by the segments in flight rather than the length of the file.
+
+enum class StretchMethod
+{
+    PaulStretch, // Extreme stretches; smears transients by design, pitch is ignored
+    Mincer // Phase locked vocoder; stretch and pitch are independent
+};
+
+struct StretchSettings
+{
+    StretchMethod method = StretchMethod::Mincer;
+    float stretch = 1.0f; // Output length / input length
+    float pitch = 1.0f; // Frequency ratio, Mincer only
+    uint32_t windowSize = 2048; // Frames; rounded up to a power of 2 for Mincer
+    bool phaseLock = true; // Mincer only
+
+    uint32_t segmentFrames = 1 << 18; // Output frames per segment
+    uint32_t crossfadeFrames = 4096;
+    uint32_t threads = 0; // 0 for one per core
+};
+
+enum class StretchJobState : uint32_t
+{
+    Idle,
+    Running,
+    Done,
+    Failed,
+    Cancelled
+};
+
+struct StretchJob
+{
+    StretchSettings settings;
+    fs::path input;
+    fs::path output;
+
+    std::thread thread;
+    std::atomic<StretchJobState> state = StretchJobState::Idle;
+    std::atomic_bool cancel = false;
+
+    std::atomic<uint32_t> segments = 0;
+    std::atomic<uint32_t> segmentsWritten = 0;
+    std::string error; // Set before the state goes to Failed
+};
+
+// Starts the job on its own thread; false if a previous job on this object hasn't been waited for
+bool stretch_start(StretchJob& job, const fs::path& input, const fs::path& output, const StretchSettings& settings);
+
+// 0 to 1
+float stretch_progress(const StretchJob& job);
+void stretch_cancel(StretchJob& job);
+
+// Blocks until the job ends; true if the output is complete
+bool stretch_wait(StretchJob& job);
+
+// Start and wait
+bool stretch_file(const fs::path& input, const fs::path& output, const StretchSettings& settings);
+
+} // namespace Zing
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+
+namespace Zing
+{
+
+// Captures a few seconds of profile scopes from every thread into a Chrome trace (JSON) file, which
+// chrome://tracing and ui.perfetto.dev both open. The live profiler only shows the last frames; a
+// capture can be kept, looked at offline, and compared between builds.
+// Each thread records into its own fixed buffer, so scopes never lock or allocate. Outside a capture
+// a scope is a single atomic load.
+struct TraceScope
+{
+    explicit TraceScope(const char* pName);
+    ~TraceScope();
+
+    const char* pName; // A literal; stored as is
+    uint32_t generation;
+    std::chrono::steady_clock::time_point start;
+};
+
+// Names the calling thread in captures; cheap to call repeatedly. Threads that never call this are
+// numbered instead. Buffers are only made for threads known when a capture starts.
+void trace_name_thread(const char* pName);
+
+// Starts a capture which writes itself to 'path' after 'seconds'. Returns false if one is running.
+bool trace_capture(const std::filesystem::path& path, double seconds);
+
+// Ends a running capture now, and writes it
+void trace_stop();
+
+bool trace_capturing();
+
+// The file of the last finished capture, or empty
+std::filesystem::path trace_last_file();
+
+// Captures go to the temp directory, named by the time they started
+std::filesystem::path trace_default_path();
+
+} // namespace Zing
+
+// A profiler scope which also goes to a trace capture; use in place of PROFILE_SCOPE
+#define TRACE_SCOPE(name)  \
+    PROFILE_SCOPE(name);   \
+    Zing::TraceScope traceScope_##name(#name)
+
+// Names the thread for both the profiler and trace captures; use in place of PROFILE_NAME_THREAD
+#define TRACE_NAME_THREAD(name) \
+    PROFILE_NAME_THREAD(name);  \
+    Zing::trace_name_thread(#name)
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace Zing
+{
+
+// Called once per job; 'job' is in [0, jobs) for the current run
+using fnAudioWork = void (*)(void* pUser, uint32_t job);
+
+// A small fork/join pool for splitting realtime work across cores.
+// The thread calling audio_workers_run takes jobs too, and only waits for jobs a worker has
+// already claimed; so a sleeping or descheduled worker never stalls the audio callback.
+// Idle workers spin briefly, then block on the work word until the next run is published.
+// Dispatch does not lock or allocate.
+struct AudioWorkerPool
+{
+    std::vector<std::thread> threads;
+
+    // Generation (32) | Job count (16) | Next job (16)
+    std::atomic<uint64_t> work = 0;
+    std::atomic<uint32_t> jobsDone = 0;
+    std::atomic<fnAudioWork> pfnWork = nullptr;
+    std::atomic<void*> pUser = nullptr;
+    std::atomic_bool quit = false;
+};
+
+void audio_workers_start(AudioWorkerPool& pool, uint32_t threadCount);
+void audio_workers_stop(AudioWorkerPool& pool);
+
+// Worker threads + the calling thread
+uint32_t audio_workers_count(const AudioWorkerPool& pool);
+
+// Run jobs [0, jobs) across the pool and return when all are complete.
+// Only one thread may call this at a time.
+void audio_workers_run(AudioWorkerPool& pool, uint32_t jobs, fnAudioWork pfnWork, void* pUser);
+
+} // namespace Zing
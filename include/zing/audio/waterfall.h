@@ -1,12 +1,32 @@
 // Waterfall.h
 #pragma once
 
+#include <cstdint>
 #include <vector>
 
 // Forward-declare to keep this header light.
 // Include <imgui.h> and <implot.h> in Waterfall.cpp and in any TU that calls Draw().
 struct ImVec2;
 
+// How committed rows are kept. The quantised forms cover [WaterfallStoreMinDb, WaterfallStoreMaxDb];
+// anything quieter reads as the minimum, so floors below it aren't shown faithfully.
+enum class WaterfallStorage
+{
+    Float32,
+    UInt16, // ~0.003 dB steps, half the memory
+    UInt8   // ~0.7 dB steps, a quarter of the memory
+};
+
+// How the noise floor of each committed row is found
+enum class WaterfallNoiseMethod
+{
+    Exact,    // partial sort of the row and of the window
+    Histogram // streaming: 0.5 dB histogram of the row, sorted window kept up to date; O(bins), no sorting
+};
+
+constexpr float WaterfallStoreMinDb = -160.0f;
+constexpr float WaterfallStoreMaxDb = 20.0f;
+
 struct Waterfall
 {
     // ---- Dimensions ----
@@ -33,12 +53,22 @@ struct Waterfall
     float manualFloorDb = -190.0f;
 
     bool enabled = true;
+    uint32_t resetRequests = 0; // bumped by the reset button, so copies made with Waterfall_CopySettings follow
 
     // ---- Buffers (stored as dB values) ----
-    int head = 0;                // next write row (ring)
-    int rowsWritten = 0;         // how many rows have been committed
-    std::vector<float> ringDb;   // rows*bins (ring layout)
-    std::vector<float> uploadDb; // rows*bins (chronological oldest->newest for PlotHeatmap)
+    // The ring is written backwards, so reading forwards from the newest row runs newest->oldest and
+    // the plot can draw straight from it in at most two pieces.
+    WaterfallStorage storage = WaterfallStorage::Float32;
+    int head = 0;                  // next write row (ring)
+    int rowsWritten = 0;           // how many rows have been committed
+    uint64_t commits = 0;          // bumped whenever the ring contents change
+    uint64_t clears = 0;           // bumped whenever the ring is emptied or reallocated
+    std::vector<float> ringDb;     // rows*bins (ring layout), Float32 storage
+    std::vector<uint16_t> ring16;  // rows*bins, UInt16 storage
+    std::vector<uint8_t> ring8;    // rows*bins, UInt8 storage
+    std::vector<float> uploadDb;   // rows*bins (newest first), only built by Waterfall_BuildUpload
+    uint64_t uploadCommits = ~0ull;
+    float uploadFloorDb = 0.0f;
 
     int noiseWindowN = 10; // how many committed rows to use
     int noiseWinHead = 0;
@@ -46,6 +76,11 @@ struct Waterfall
     std::vector<float> noiseWinDb; // size noiseWindowN
     bool useMedianNoise = true;    // median vs mean
 
+    WaterfallNoiseMethod noiseMethod = WaterfallNoiseMethod::Histogram;
+    std::vector<float> noiseWinSorted;    // the counted window values, ascending
+    std::vector<uint32_t> noiseHistCount; // per 0.5 dB bucket, for the histogram method
+    std::vector<float> noiseHistSum;
+
     // ---- Marker (UI) ----
     float markerX = 0.5f; // normalized [0..1] position
     float markerWidthHz = 500.0f;
@@ -55,10 +90,24 @@ struct Waterfall
 void Waterfall_Init(Waterfall& wf, int bins, int rows = 50);
 void Waterfall_Reset(Waterfall& wf);
 
+// Switch how rows are stored; clears the history
+void Waterfall_SetStorage(Waterfall& wf, WaterfallStorage storage);
+
 // Feed one spectrum snapshot (magnitudes). This ACCUMULATES and commits every wf.accumulateN calls.
 void Waterfall_AccumulateMag(Waterfall& wf, const float* spectrumMag, int spectrumCount);
 
-// Build ordered buffer for drawing (oldest at top, newest at bottom)
+// As above from a power spectrum; spectrumCount may exceed wf.bins, in which case neighbouring bins are averaged
+void Waterfall_AccumulatePower(Waterfall& wf, const float* spectrumPower, int spectrumCount);
+
+// Apply the user controls (and marker) of src to dst, keeping dst's history and noise estimate
+void Waterfall_CopySettings(Waterfall& dst, const Waterfall& src);
+
+// Bring dst's ring and noise estimate up to date with src. Only the rows committed since dst was last
+// brought up to date are copied; the whole ring only after a resize, a storage change or a reset.
+void Waterfall_CopyRows(Waterfall& dst, const Waterfall& src);
+
+// Build uploadDb: the rows in float dB, newest first, unwritten rows at the floor.
+// Drawing doesn't need it; it's for readers wanting a flat copy, and does nothing if no row arrived since.
 void Waterfall_BuildUpload(Waterfall& wf);
 
 // Scale helpers (effective display scale)
@@ -69,5 +118,5 @@ float Waterfall_CeilDb(const Waterfall& wf);
 void Waterfall_DrawControls(Waterfall& wf);
 void Waterfall_DrawPlot(Waterfall& wf, const char* plotTitle, float maxHz, ImVec2 plotSize);
 
-// Shared marker access
+// The shared controls and marker; the per channel waterfalls are fed on the analysis threads
 Waterfall& Waterfall_Get();
@@ -24,6 +24,8 @@
 #include <zest/file/file.h>
 #include <zest/file/runtree.h>
 
+#include <zing/audio/audio_trace.h>
+
 #include <glm/gtc/constants.hpp>
 
 #include <zest/include/zest/ui/imgui_extras.h>
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace Zing
+{
+
+// A read only view of a whole file; pages come in from disk as they are touched
+struct SF2MappedFile
+{
+    const uint8_t* pData = nullptr;
+    uint64_t size = 0;
+#ifdef _WIN32
+    void* hFile = nullptr;
+    void* hMapping = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+struct SF2Chunk
+{
+    uint64_t offset = 0; // Of the chunk data, from the start of the file
+    uint64_t size = 0;
+};
+
+struct SF2PresetHeader
+{
+    std::string name;
+    uint16_t preset = 0;
+    uint16_t bank = 0;
+};
+
+// Just enough of the RIFF structure to describe the font without touching the sample data
+struct SF2Index
+{
+    SF2Chunk info;
+    SF2Chunk samples; // smpl, 16 bit mono sample points
+    SF2Chunk samples24; // sm24, optional low bytes
+    SF2Chunk hydra; // pdta, the preset/instrument/zone tables
+    std::vector<SF2PresetHeader> presets;
+};
+
+bool sf2_map_file(const std::filesystem::path& path, SF2MappedFile& file);
+void sf2_unmap_file(SF2MappedFile& file);
+
+enum class SF2Access
+{
+    Normal,
+    Sequential, // Read ahead aggressively, about to stream through the range
+    WillNeed, // Start reading the range in now
+    DontNeed // Finished with the range; the pages can be dropped
+};
+void sf2_advise(const SF2MappedFile& file, const SF2Chunk& range, SF2Access access);
+
+// Walks the chunk headers and reads the preset headers; returns false if this isn't a soundfont
+bool sf2_read_index(const SF2MappedFile& file, SF2Index& index);
+
+} // namespace Zing
@@ -21,6 +21,8 @@
 
 #pragma once
 
+#include <memory>
+
 namespace Earlevel
 {
 
@@ -31,6 +33,7 @@ public:
             mWaveTables[idx].topFreq = 0;
             mWaveTables[idx].waveTableLen = 0;
             mWaveTables[idx].waveTable = 0;
+            mWaveTables[idx].ownsTable = false;
         }
     }
     ~WaveTableOsc(void) {
@@ -38,7 +41,7 @@ public:
         {
             for (int idx = 0; idx < numWaveTableSlots; idx++) {
                 float* temp = mWaveTables[idx].waveTable;
-                if (temp != 0)
+                if (temp != 0 && mWaveTables[idx].ownsTable)
                     delete[] temp;
             }
         }
@@ -55,6 +58,7 @@ public:
         mPhaseOfs = copy.mPhaseOfs;
         mCurWaveTable = copy.mCurWaveTable; 
         mNumWaveTables = copy.mNumWaveTables;
+        mStorage = copy.mStorage;
         mIsClone = true;
     }
 
@@ -164,6 +168,7 @@ public:
             float* waveTable = mWaveTables[mNumWaveTables].waveTable = new float[size_t(len + 1)];
             mWaveTables[mNumWaveTables].waveTableLen = len;
             mWaveTables[mNumWaveTables].topFreq = topFreq;
+            mWaveTables[mNumWaveTables].ownsTable = true;
             ++mNumWaveTables;
 
             // fill in wave
@@ -176,10 +181,33 @@ public:
         return mNumWaveTables;
     };
 
+    //
+    // AddWaveTableShared
+    //
+    // as AddWaveTable, but uses the caller's storage, which must already hold the wraparound
+    // sample at waveTable[len]; hand the storage to SetStorage, or keep it alive for the oscillator
+    //
+    int AddWaveTableShared(int len, float* waveTable, double topFreq) {
+        if (mNumWaveTables < numWaveTableSlots) {
+            mWaveTables[mNumWaveTables].waveTable = waveTable;
+            mWaveTables[mNumWaveTables].waveTableLen = len;
+            mWaveTables[mNumWaveTables].topFreq = topFreq;
+            mWaveTables[mNumWaveTables].ownsTable = false;
+            ++mNumWaveTables;
+            return 0;
+        }
+        return mNumWaveTables;
+    }
+
+    void SetStorage(std::shared_ptr<float[]> storage) {
+        mStorage = std::move(storage);
+    }
+
     struct waveTable {
         double topFreq;
         int waveTableLen;
         float* waveTable;
+        bool ownsTable;
     };
     const waveTable* GetTables() const { return &mWaveTables[0]; }
     int GetNumTables() const { return mNumWaveTables; }
@@ -195,6 +223,7 @@ public:
     int mNumWaveTables = 0;     // number of wavetable slots in use
     static constexpr int numWaveTableSlots = 40;    // simplify allocation with reasonable maximum
     waveTable mWaveTables[numWaveTableSlots];
+    std::shared_ptr<float[]> mStorage;   // shared tables, from AddWaveTableShared
     bool mIsClone = false;
 };
 }
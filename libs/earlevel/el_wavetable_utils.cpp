@@ -22,8 +22,12 @@
 //                          added filleTables2, which allows selection of minimum and maximum frequencies
 //
 
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <map>
 #include <memory>
+#include <thread>
 
 #include "el_wavetable_utils.h"
 
@@ -149,32 +153,19 @@ int fillTables2(WaveTableOsc* osc, double* freqWaveRe, double* freqWaveIm, int n
 }
 
 //
-// example that builds a sawtooth oscillator via frequency domain
+// example that builds a sawtooth oscillator
 //
 std::shared_ptr<WaveTableOsc> sawOsc()
 {
     int tableLen = 2048; // to give full bandwidth from 20 Hz
-    int idx;
-
-    // TODO: Leak
-    double* freqWaveRe = new double[tableLen];
-    double* freqWaveIm = new double[tableLen];
 
-    // make a sawtooth
-    for (idx = 0; idx < tableLen; idx++)
-    {
-        freqWaveIm[idx] = 0.0;
-    }
-    freqWaveRe[0] = freqWaveRe[tableLen >> 1] = 0.0;
-    for (idx = 1; idx < (tableLen >> 1); idx++)
-    {
-        freqWaveRe[idx] = 1.0 / idx; // sawtooth spectrum
-        freqWaveRe[tableLen - idx] = -freqWaveRe[idx]; // mirror
-    }
+    // rising ramp; the spectrum is taken from it, so the band limiting is the same as for any other cycle
+    std::vector<float> wave(tableLen);
+    for (int idx = 0; idx < tableLen; idx++)
+        wave[idx] = -1.0f + 2.0f * float(idx) / float(tableLen);
 
-    // build a wavetable oscillator
     auto osc = std::make_shared<WaveTableOsc>();
-    fillTables(osc.get(), freqWaveRe, freqWaveIm, tableLen);
+    fillTablesReal(osc.get(), wave.data(), tableLen);
 
     return osc;
 }
@@ -184,25 +175,187 @@ std::shared_ptr<WaveTableOsc> sawOsc()
 //
 WaveTableOsc* waveOsc(double* waveSamples, int tableLen)
 {
-    int idx;
-    double* freqWaveRe = new double[tableLen];
-    double* freqWaveIm = new double[tableLen];
-
-    // take FFT
-    for (idx = 0; idx < tableLen; idx++)
-    {
-        freqWaveIm[idx] = waveSamples[idx];
-        freqWaveRe[idx] = 0.0;
-    }
-    fft(tableLen, freqWaveRe, freqWaveIm);
+    std::vector<float> wave(waveSamples, waveSamples + tableLen);
 
     // build a wavetable oscillator
     WaveTableOsc* osc = new WaveTableOsc();
-    fillTables(osc, freqWaveRe, freqWaveIm, tableLen);
+    fillTablesReal(osc, wave.data(), tableLen);
 
     return osc;
 }
 
+//
+// realFftPlan
+//
+// kiss_fftr plans keep scratch space, so they can't be shared between threads; each thread
+// keeps its own, for every size it has used
+//
+namespace
+{
+struct RealFftPlans
+{
+    std::map<std::pair<int, bool>, kiss_fftr_cfg> plans;
+    ~RealFftPlans()
+    {
+        for (auto& entry : plans)
+            kiss_fftr_free(entry.second);
+    }
+};
+
+// Minimum spectrum magnitude to count as a harmonic; -120 dB, the real FFT is not normalized
+double harmonicThreshold(int len)
+{
+    return 0.000001 * len;
+}
+
+template <typename F>
+void parallelFor(size_t count, unsigned int threadCount, F&& fn)
+{
+    std::atomic<size_t> next = 0;
+    auto worker = [&]() {
+        for (size_t idx = next++; idx < count; idx = next++)
+            fn(idx);
+    };
+
+    threadCount = std::min<unsigned int>(threadCount, unsigned(count));
+    std::vector<std::thread> threads;
+    for (unsigned int idx = 1; idx < threadCount; idx++)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+}
+}
+
+kiss_fftr_cfg realFftPlan(int len, bool inverse)
+{
+    thread_local RealFftPlans cache;
+    auto& cfg = cache.plans[std::make_pair(len, inverse)];
+    if (!cfg)
+        cfg = kiss_fftr_alloc(len, inverse ? 1 : 0, nullptr, nullptr);
+    return cfg;
+}
+
+void waveSpectrum(const float* wave, int len, WaveSpectrum& spectrum, bool keepDC)
+{
+    spectrum.len = len;
+    spectrum.bins.resize(size_t(len / 2 + 1));
+    kiss_fftr(realFftPlan(len, false), wave, spectrum.bins.data());
+
+    // zero DC offset and Nyquist
+    if (!keepDC)
+        spectrum.bins[0].r = spectrum.bins[0].i = 0.0f;
+    spectrum.bins[len >> 1].r = spectrum.bins[len >> 1].i = 0.0f;
+
+    // determine maxHarmonic, the highest non-zero harmonic in the wave
+    const double minVal = harmonicThreshold(len);
+    int maxHarmonic = len >> 1;
+    while (maxHarmonic && (fabs(spectrum.bins[maxHarmonic].r) + fabs(spectrum.bins[maxHarmonic].i) < minVal))
+        --maxHarmonic;
+    spectrum.maxHarmonic = maxHarmonic;
+}
+
+int spectrumTableCount(const WaveSpectrum& spectrum)
+{
+    int numTables = 0;
+    for (int maxHarmonic = spectrum.maxHarmonic; maxHarmonic; maxHarmonic >>= 1)
+        numTables++;
+    return std::min(std::max(numTables, 1), int(WaveTableOsc::numWaveTableSlots));
+}
+
+double spectrumTableTop(const WaveSpectrum& spectrum, int table)
+{
+    // as fillTables; alias up to where the aliased harmonic would meet the next octave table
+    if (!spectrum.maxHarmonic)
+        return 0.5;
+    return (2.0 / 3.0 / spectrum.maxHarmonic) * double(1 << table);
+}
+
+float spectrumTable(const WaveSpectrum& spectrum, int table, float scale, float* out, int guard)
+{
+    const int len = spectrum.len;
+    const int maxHarmonic = spectrum.maxHarmonic >> table;
+
+    thread_local std::vector<kiss_fft_cpx> bins;
+    bins.assign(spectrum.bins.begin(), spectrum.bins.end());
+    for (int idx = maxHarmonic + 1; idx <= (len >> 1); idx++)
+        bins[idx].r = bins[idx].i = 0.0f;
+
+    kiss_fftri(realFftPlan(len, true), bins.data(), out);
+
+    if (scale == 0.0f)
+    {
+        float max = 0.0f;
+        for (int idx = 0; idx < len; idx++)
+            max = std::max(max, fabsf(out[idx]));
+        scale = max > 0.0f ? 0.999f / max : 1.0f;
+    }
+    else
+    {
+        // the inverse is not normalized
+        scale /= float(len);
+    }
+
+    for (int idx = 0; idx < len; idx++)
+        out[idx] *= scale;
+    for (int idx = 0; idx < guard; idx++)
+        out[len + idx] = out[idx % len];
+
+    return scale * float(len);
+}
+
+namespace
+{
+// All the tables for one spectrum, laid out one after another
+void buildTables(WaveTableOsc* osc, const WaveSpectrum& spectrum, float* storage)
+{
+    const int numTables = spectrumTableCount(spectrum);
+    float scale = 0.0f;
+    for (int table = 0; table < numTables; table++)
+    {
+        float* out = storage + size_t(table) * size_t(spectrum.len + 1);
+        scale = spectrumTable(spectrum, table, scale, out, 1);
+        osc->AddWaveTableShared(spectrum.len, out, spectrumTableTop(spectrum, table));
+    }
+}
+}
+
+int fillTablesReal(WaveTableOsc* osc, const float* wave, int len)
+{
+    WaveSpectrum spectrum;
+    waveSpectrum(wave, len, spectrum);
+
+    const int numTables = spectrumTableCount(spectrum);
+    std::shared_ptr<float[]> storage(new float[size_t(numTables) * size_t(len + 1)]);
+    buildTables(osc, spectrum, storage.get());
+    osc->SetStorage(std::move(storage));
+    return numTables;
+}
+
+std::shared_ptr<float[]> fillTablesParallel(const std::vector<WaveTableShape>& shapes, unsigned int threadCount)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    // spectra first, so every table can be placed in the one allocation
+    std::vector<WaveSpectrum> spectra(shapes.size());
+    parallelFor(shapes.size(), threadCount, [&](size_t idx) {
+        waveSpectrum(shapes[idx].wave, shapes[idx].len, spectra[idx]);
+    });
+
+    std::vector<size_t> offsets(shapes.size() + 1, 0);
+    for (size_t idx = 0; idx < shapes.size(); idx++)
+        offsets[idx + 1] = offsets[idx] + size_t(spectrumTableCount(spectra[idx])) * size_t(shapes[idx].len + 1);
+
+    std::shared_ptr<float[]> storage(new float[std::max<size_t>(offsets.back(), 1)]);
+    parallelFor(shapes.size(), threadCount, [&](size_t idx) {
+        buildTables(shapes[idx].osc, spectra[idx], storage.get() + offsets[idx]);
+        shapes[idx].osc->SetStorage(storage);
+    });
+
+    return storage;
+}
+
 //
 // if scale is 0, auto-scales
 // returns scaling factor (0.0 if failure), and wavetable in ai array
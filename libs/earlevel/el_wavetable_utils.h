@@ -9,6 +9,9 @@
 
 #include "el_wavetable.h"
 #include <memory>
+#include <vector>
+
+#include <kiss_fftr.h>
 
 namespace Earlevel
 {
@@ -18,6 +21,41 @@ float makeWaveTable(WaveTableOsc* osc, int len, double* ar, double* ai, double s
 
 void fft(int N, double* ar, double* ai);
 
+//
+// Real FFT construction
+//
+// The spectrum of a single cycle is taken once with a real FFT, and each octave table is a single
+// inverse real FFT of the harmonics it keeps. FFT plans are cached per thread and size.
+//
+struct WaveSpectrum
+{
+    int len = 0;
+    int maxHarmonic = 0;
+    std::vector<kiss_fft_cpx> bins; // len / 2 + 1
+};
+
+kiss_fftr_cfg realFftPlan(int len, bool inverse);
+void waveSpectrum(const float* wave, int len, WaveSpectrum& spectrum, bool keepDC = false);
+
+// Tables fillTables would make: one per octave, halving the harmonics each time
+int spectrumTableCount(const WaveSpectrum& spectrum);
+double spectrumTableTop(const WaveSpectrum& spectrum, int table);
+
+// Writes len + guard samples; scale 0 normalizes to a peak of 0.999, as makeWaveTable does. Returns the scale used
+float spectrumTable(const WaveSpectrum& spectrum, int table, float scale, float* out, int guard);
+
+// fillTables for a time domain cycle; all the tables go in one allocation owned by the oscillator
+int fillTablesReal(WaveTableOsc* osc, const float* wave, int len);
+
+// Builds many oscillators across threads (0 = all cores); the tables share a single allocation
+struct WaveTableShape
+{
+    const float* wave = nullptr;
+    int len = 0;
+    WaveTableOsc* osc = nullptr;
+};
+std::shared_ptr<float[]> fillTablesParallel(const std::vector<WaveTableShape>& shapes, unsigned int threadCount = 0);
+
 // examples
 std::shared_ptr<WaveTableOsc> sawOsc(void);
 WaveTableOsc* waveOsc(double* waveSamples, int tableLen);
@@ -365,3 +365,12 @@ int sp_phaser_compute(sp_data *sp, sp_phaser *p,
     computephaser(dsp, 1, faust_in, faust_out);
     return SP_OK;
 }
+
+/* Runs 'count' frames at once; inputs and outputs are the left and right channels */
+int sp_phaser_compute_block(sp_data *sp, sp_phaser *p, int count,
+	SPFLOAT **inputs, SPFLOAT **outputs)
+{
+    phaser *dsp = p->faust;
+    computephaser(dsp, count, inputs, outputs);
+    return SP_OK;
+}
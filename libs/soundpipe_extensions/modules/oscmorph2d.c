@@ -1,7 +1,13 @@
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include "soundpipeextension.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define OSCMORPH2D_SSE2 1
+#include <emmintrin.h>
+#endif
+
 int sp_oscmorph2d_create(sp_oscmorph2d **p)
 {
     *p = malloc(sizeof(sp_oscmorph2d));
@@ -49,6 +55,10 @@ int sp_oscmorph2d_init(sp_data *sp, sp_oscmorph2d *osc, sp_ftbl **ft, int nft, i
     osc->enableBandlimit = 0;
     osc->bandlimitIndexOverride = -1;
 
+    osc->blFreq = -1.0;
+    osc->blIndex = 0;
+    osc->blFrac = 0.0;
+
     return SP_OK;
 }
 
@@ -128,3 +138,174 @@ int sp_oscmorph2d_compute(sp_data *sp, sp_oscmorph2d *osc, SPFLOAT *in, SPFLOAT
     osc->lphs = phs;
     return SP_OK;
 }
+
+/* Pick the bandlimit row for the block, and how far to lean into the next row up.
+ * The lean reaches 1 just as freq gets to the top of the row, where the next row takes over,
+ * so a sweep crossfades between rows instead of stepping. */
+static void sp_oscmorph2d_select_bandlimit(sp_oscmorph2d *osc)
+{
+    int i;
+
+    if (osc->enableBandlimit <= 0) {
+        osc->blIndex = 0;
+        osc->blFrac = 0.0;
+        osc->blFreq = -1.0;
+        return;
+    }
+
+    if (osc->bandlimitIndexOverride >= 0) {
+        osc->blIndex = osc->bandlimitIndexOverride < osc->nbl ? osc->bandlimitIndexOverride : osc->nbl - 1;
+        osc->blFrac = 0.0;
+        osc->blFreq = -1.0;
+        return;
+    }
+
+    if (osc->freq == osc->blFreq) {
+        return;
+    }
+    osc->blFreq = osc->freq;
+
+    /* Above the last frequency, stay on the dullest row */
+    osc->blIndex = osc->nbl - 1;
+    osc->blFrac = 0.0;
+    for(i = 1; i < osc->nbl; i++) {
+        if(osc->freq <= osc->fbl[i]) {
+            SPFLOAT range = osc->fbl[i] - osc->fbl[i - 1];
+            SPFLOAT frac = range > 0 ? (osc->freq - osc->fbl[i - 1]) / range : 0.0;
+            osc->blIndex = i;
+            osc->blFrac = frac < 0 ? 0.0 : (frac > 1 ? 1.0 : frac);
+            break;
+        }
+    }
+}
+
+static void sp_oscmorph2d_render(sp_oscmorph2d *osc, SPFLOAT *out, int frames, int accumulate)
+{
+    sp_ftbl *ftp;
+    const SPFLOAT *t00, *t01, *t10, *t11;
+    SPFLOAT w00, w01, w10, w11, wtfrac, amp, lodiv;
+    int32_t phs, inc, lobits, lomask, sizemask;
+    int bl, bl1, wave, wave1, frame = 0;
+
+    sp_oscmorph2d_select_bandlimit(osc);
+
+    /* Use only the fractional part of the position or 1 */
+    if (osc->wtpos > 1.0) {
+        osc->wtpos -= (int)osc->wtpos;
+    }
+
+    const SPFLOAT fwave = osc->wtpos * (osc->nft - 1);
+    wave = (int)floor(fwave);
+    wtfrac = fwave - wave;
+    wave1 = wave + 1 < osc->nft ? wave + 1 : wave;
+
+    bl = osc->blIndex;
+    bl1 = bl + 1 < osc->nbl ? bl + 1 : bl;
+
+    t00 = osc->tbl[bl * osc->nft + wave]->tbl;
+    t01 = osc->tbl[bl * osc->nft + wave1]->tbl;
+    t10 = osc->tbl[bl1 * osc->nft + wave]->tbl;
+    t11 = osc->tbl[bl1 * osc->nft + wave1]->tbl;
+
+    /* amp folds into the weights */
+    amp = osc->amp;
+    w00 = (1 - wtfrac) * (1 - osc->blFrac) * amp;
+    w01 = wtfrac * (1 - osc->blFrac) * amp;
+    w10 = (1 - wtfrac) * osc->blFrac * amp;
+    w11 = wtfrac * osc->blFrac * amp;
+
+    ftp = osc->tbl[bl * osc->nft + wave];
+    lobits = ftp->lobits;
+    lomask = ftp->lomask;
+    lodiv = ftp->lodiv;
+    sizemask = (int32_t)ftp->size - 1;
+
+    osc->inc = (int32_t)((osc->freq * ftp->sicvt) + .5f);
+    inc = osc->inc;
+    phs = osc->lphs;
+
+#ifdef OSCMORPH2D_SSE2
+    if (sizeof(SPFLOAT) == sizeof(float)) {
+        /* Four frames per vector; no gather in SSE2, so the table reads stay scalar */
+        float *fout = (float *)out;
+        const float *f00 = (const float *)t00, *f01 = (const float *)t01;
+        const float *f10 = (const float *)t10, *f11 = (const float *)t11;
+        const __m128i vLobits = _mm_cvtsi32_si128(lobits);
+        const __m128i vLomask = _mm_set1_epi32(lomask);
+        const __m128i vSizemask = _mm_set1_epi32(sizemask);
+        const __m128i vPhmask = _mm_set1_epi32(SP_FT_PHMASK);
+        const __m128i vOne = _mm_set1_epi32(1);
+        const __m128i vStep = _mm_set1_epi32(inc * 4);
+        const __m128 vLodiv = _mm_set1_ps((float)lodiv);
+        const __m128 vW00 = _mm_set1_ps((float)w00), vW01 = _mm_set1_ps((float)w01);
+        const __m128 vW10 = _mm_set1_ps((float)w10), vW11 = _mm_set1_ps((float)w11);
+        __m128i vPhs = _mm_and_si128(_mm_set_epi32(phs + inc * 3, phs + inc * 2, phs + inc, phs), vPhmask);
+        int32_t pos[4], next[4];
+
+        for (; frame + 4 <= frames; frame += 4) {
+            __m128i vPos = _mm_srl_epi32(vPhs, vLobits);
+            _mm_storeu_si128((__m128i *)pos, vPos);
+            _mm_storeu_si128((__m128i *)next, _mm_and_si128(_mm_add_epi32(vPos, vOne), vSizemask));
+
+            __m128 vFract = _mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(vPhs, vLomask)), vLodiv);
+
+            __m128 v1 = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(vW00, _mm_set_ps(f00[pos[3]], f00[pos[2]], f00[pos[1]], f00[pos[0]])),
+                           _mm_mul_ps(vW01, _mm_set_ps(f01[pos[3]], f01[pos[2]], f01[pos[1]], f01[pos[0]]))),
+                _mm_add_ps(_mm_mul_ps(vW10, _mm_set_ps(f10[pos[3]], f10[pos[2]], f10[pos[1]], f10[pos[0]])),
+                           _mm_mul_ps(vW11, _mm_set_ps(f11[pos[3]], f11[pos[2]], f11[pos[1]], f11[pos[0]]))));
+            __m128 v2 = _mm_add_ps(
+                _mm_add_ps(_mm_mul_ps(vW00, _mm_set_ps(f00[next[3]], f00[next[2]], f00[next[1]], f00[next[0]])),
+                           _mm_mul_ps(vW01, _mm_set_ps(f01[next[3]], f01[next[2]], f01[next[1]], f01[next[0]]))),
+                _mm_add_ps(_mm_mul_ps(vW10, _mm_set_ps(f10[next[3]], f10[next[2]], f10[next[1]], f10[next[0]])),
+                           _mm_mul_ps(vW11, _mm_set_ps(f11[next[3]], f11[next[2]], f11[next[1]], f11[next[0]]))));
+            __m128 v = _mm_add_ps(v1, _mm_mul_ps(_mm_sub_ps(v2, v1), vFract));
+
+            if (accumulate) {
+                v = _mm_add_ps(v, _mm_loadu_ps(fout + frame));
+            }
+            _mm_storeu_ps(fout + frame, v);
+
+            vPhs = _mm_and_si128(_mm_add_epi32(vPhs, vStep), vPhmask);
+        }
+        phs = (phs + inc * frame) & SP_FT_PHMASK;
+    }
+#endif
+
+    for (; frame < frames; frame++) {
+        const int32_t pos = phs >> lobits;
+        const int32_t next = (pos + 1) & sizemask;
+        const SPFLOAT fract = (phs & lomask) * lodiv;
+        const SPFLOAT v1 = w00 * t00[pos] + w01 * t01[pos] + w10 * t10[pos] + w11 * t11[pos];
+        const SPFLOAT v2 = w00 * t00[next] + w01 * t01[next] + w10 * t10[next] + w11 * t11[next];
+        const SPFLOAT v = v1 + (v2 - v1) * fract;
+
+        out[frame] = accumulate ? out[frame] + v : v;
+
+        phs += inc;
+        phs &= SP_FT_PHMASK;
+    }
+
+    osc->lphs = phs;
+}
+
+int sp_oscmorph2d_compute_block(sp_data *sp, sp_oscmorph2d *osc, SPFLOAT *out, int frames)
+{
+    sp_oscmorph2d_render(osc, out, frames, 0);
+    return SP_OK;
+}
+
+int sp_oscmorph2d_compute_voices(sp_data *sp, sp_oscmorph2d **osc, int voices, SPFLOAT *out, int frames)
+{
+    int i;
+    if (voices <= 0) {
+        memset(out, 0, sizeof(SPFLOAT) * frames);
+        return SP_OK;
+    }
+
+    sp_oscmorph2d_render(osc[0], out, frames, 0);
+    for(i = 1; i < voices; i++) {
+        sp_oscmorph2d_render(osc[i], out, frames, 1);
+    }
+    return SP_OK;
+}
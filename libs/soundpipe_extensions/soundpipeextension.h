@@ -15,6 +15,9 @@ typedef struct {
     float *fbl; // array of frequencies per bandlimited waveform
     int enableBandlimit; // if 0 use index 0, if 1 select index based on freq
     int bandlimitIndexOverride; // temporary
+    SPFLOAT blFreq; // frequency the cached bandlimit was picked for
+    int blIndex; // cached bandlimit row, used by the block compute
+    SPFLOAT blFrac; // blend from blIndex towards the next (duller) row
 } sp_oscmorph2d;
 
 int sp_oscmorph2d_create(sp_oscmorph2d **p);
@@ -22,4 +25,12 @@ int sp_oscmorph2d_destroy(sp_oscmorph2d **p);
 int sp_oscmorph2d_init(sp_data *sp, sp_oscmorph2d *osc, sp_ftbl **ft, int nft, int nbl, float *fbls, SPFLOAT iphs);
 int sp_oscmorph2d_compute(sp_data *sp, sp_oscmorph2d *p, SPFLOAT *in, SPFLOAT *out);
 
+// Block versions; freq, amp and wtpos are held for the block, and the bandlimit is only looked up again
+// when freq changes. Four tables (2 waveforms x 2 bandlimits) are blended, so sweeps don't step between rows.
+// Tables must be a power of 2 long.
+int sp_oscmorph2d_compute_block(sp_data *sp, sp_oscmorph2d *p, SPFLOAT *out, int frames);
+
+// Sums a whole array of voices into out (which is overwritten)
+int sp_oscmorph2d_compute_voices(sp_data *sp, sp_oscmorph2d **p, int voices, SPFLOAT *out, int frames);
+
 #endif
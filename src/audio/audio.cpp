@@ -30,10 +30,15 @@ void audio_set_channels_rate(int outputChannels, int inputChannels, uint32_t out
 void audio_enumerate_devices();
 void audio_dump_devices();
 void audio_validate_settings();
+void audio_size_stage_input();
+void audio_fill_spare_bundles();
 
 namespace
 {
 
+// Enough for the bundles in flight to the analysis threads at the start
+constexpr size_t AudioSpareBundles = 64;
+
 std::vector<uint32_t> frameSizes{128, 256, 512, 1024, 2048, 4096};
 std::vector<std::string> frameNames{"128", "256", "512", "1024", "2048", "4096"};
 std::vector<double> sampleRates = {
@@ -98,13 +103,15 @@ void ensure_output_compressor(uint32_t channels, uint32_t sampleRate)
     }
 }
 
+} // namespace
+
 void apply_output_compressor(float* outputBuffer, uint32_t frames, uint32_t channels)
 {
     auto& ctx = audioContext;
     if (!ctx.audioAnalysisSettings.compEnabled || !outputBuffer || channels == 0)
         return;
 
-    PROFILE_SCOPE(apply_output_compressor);
+    TRACE_SCOPE(apply_output_compressor);
 
     double inSum = 0.0;
     double outSum = 0.0;
@@ -155,6 +162,30 @@ void apply_output_compressor(float* outputBuffer, uint32_t frames, uint32_t chan
     ctx.radioCompPowerOut.store(float(outSum / denom), std::memory_order_relaxed);
 }
 
+namespace
+{
+
+bool audio_has_stages(uint32_t type)
+{
+    auto& ctx = audioContext;
+    return std::any_of(ctx.stages.begin(), ctx.stages.end(), [type](const AudioStage& stage) {
+        return stage.channel.first == type;
+    });
+}
+
+void audio_run_stages(uint32_t type, float* pBuffer, uint32_t frames, uint32_t channelCount)
+{
+    auto& ctx = audioContext;
+    TRACE_SCOPE(Stages);
+    for (auto& stage : ctx.stages)
+    {
+        if (stage.channel.first == type && stage.channel.second < channelCount)
+        {
+            stage.fnProcess(pBuffer + stage.channel.second, frames, channelCount);
+        }
+    }
+}
+
 } // namespace
 
 AudioContext& GetAudioContext()
@@ -179,6 +210,39 @@ void audio_retire_bundle(std::shared_ptr<AudioBundle>& pBundle)
     audioContext.spareBundles.enqueue(pBundle);
 }
 
+// Under the stage mutex; big enough for a buffer of every input channel, so the audio thread only copies into it
+void audio_size_stage_input()
+{
+    auto& ctx = audioContext;
+    const auto count = size_t(ctx.audioDeviceSettings.frames) * size_t(std::max(ctx.m_inputParams.channelCount, 1));
+    if (ctx.stageInput.size() < count)
+    {
+        ctx.stageInput.resize(count);
+    }
+}
+
+// Spare bundles sized for the stream, so the audio thread doesn't make or grow one for the first buffers
+void audio_fill_spare_bundles()
+{
+    auto& ctx = audioContext;
+    std::vector<std::shared_ptr<AudioBundle>> bundles;
+    std::shared_ptr<AudioBundle> pBundle;
+    while (bundles.size() < AudioSpareBundles && ctx.spareBundles.try_dequeue(pBundle))
+    {
+        bundles.push_back(pBundle);
+    }
+    while (bundles.size() < AudioSpareBundles)
+    {
+        bundles.push_back(std::make_shared<AudioBundle>());
+    }
+
+    for (auto& pSpare : bundles)
+    {
+        pSpare->data.reserve(ctx.audioDeviceSettings.frames);
+        ctx.spareBundles.enqueue(pSpare);
+    }
+}
+
 void audio_start_playing()
 {
 #ifdef USE_LINK
@@ -215,7 +279,7 @@ LinkData audio_pull_link_data()
 
 void audio_play_metronome(const Link::SessionState sessionState, const double quantum, const std::chrono::microseconds beginHostTime, void* pOutput, const std::size_t numSamples)
 {
-    PROFILE_SCOPE(Metronome);
+    TRACE_SCOPE(Metronome);
 
     auto& ctx = audioContext;
     using namespace std::chrono;
@@ -361,13 +425,26 @@ void audio_process_midi(void* pOutput, uint32_t frameCount)
         }
     };
 
-    auto pContainer = samples_find(ctx.m_samples);
-    if (!pContainer || !pContainer->soundFont)
+    // Fonts are published by their loader threads; skip the block rather than wait
+    std::unique_lock<std::mutex> samplesLock(ctx.m_samples.sampleMutex, std::try_to_lock);
+    if (!samplesLock.owns_lock())
     {
         return;
     }
 
-    auto tsf = pContainer->soundFont;
+    // Streams don't need a font, and aren't driven by midi, so they play whatever the midi setting
+    if (ctx.outputState.channelCount != 0)
+    {
+        sample_stream_render(ctx.m_samples.streamer, pOut, frameCount, ctx.outputState.channelCount);
+    }
+
+    if (ctx.m_samples.fonts.empty())
+    {
+        return;
+    }
+
+    // Fit the polyphony to the time the last tick took
+    samples_govern(ctx.m_samples);
 
     for (uint32_t sample = 0; sample < frameCount; sample++)
     {
@@ -381,23 +458,27 @@ void audio_process_midi(void* pOutput, uint32_t frameCount)
 
         if (pendingMessage && (time_ms >= msg.timestamp))
         {
-            switch (msg.get_message_type())
+            // Messages go to the font the channel is routed to
+            if (auto tsf = samples_channel_font(ctx.m_samples, msg.get_channel()))
             {
-                case libremidi::message_type::PROGRAM_CHANGE: //channel program (preset) change (special handling for 10th MIDI channel with drums)
-                    tsf_channel_set_presetnumber(tsf, msg.get_channel(), msg[1], (msg.get_channel() == 10));
-                    break;
-                case libremidi::message_type::CONTROL_CHANGE: //MIDI controller messages
-                    tsf_channel_midi_control(tsf, msg.get_channel(), msg[1], msg[2]);
-                    break;
-                case libremidi::message_type::NOTE_ON: //play a note
-                    tsf_channel_note_on(tsf, msg.get_channel(), msg[1], msg[2] / 127.0f);
-                    break;
-                case libremidi::message_type::NOTE_OFF: //stop a note
-                    tsf_channel_note_off(tsf, msg.get_channel(), msg[1]);
-                    break;
-                case libremidi::message_type::PITCH_BEND: //pitch wheel modification
-                    tsf_channel_set_pitchwheel(tsf, msg.get_channel(), (uint32_t(msg[1]) | uint32_t(msg[2] << 7)));
-                    break;
+                switch (msg.get_message_type())
+                {
+                    case libremidi::message_type::PROGRAM_CHANGE: //channel program (preset) change (special handling for 10th MIDI channel with drums)
+                        samples_program_change(ctx.m_samples, msg.get_channel(), msg[1], (msg.get_channel() == 10));
+                        break;
+                    case libremidi::message_type::CONTROL_CHANGE: //MIDI controller messages
+                        tsf_channel_midi_control(tsf, msg.get_channel(), msg[1], msg[2]);
+                        break;
+                    case libremidi::message_type::NOTE_ON: //play a note
+                        samples_note_on(ctx.m_samples, tsf, msg.get_channel(), msg[1], msg[2] / 127.0f);
+                        break;
+                    case libremidi::message_type::NOTE_OFF: //stop a note
+                        tsf_channel_note_off(tsf, msg.get_channel(), msg[1]);
+                        break;
+                    case libremidi::message_type::PITCH_BEND: //pitch wheel modification
+                        tsf_channel_set_pitchwheel(tsf, msg.get_channel(), (uint32_t(msg[1]) | uint32_t(msg[2] << 7)));
+                        break;
+                }
             }
             pendingMessage = false;
         }
@@ -421,9 +502,9 @@ int audio_tick(const void* inputBuffer, void* outputBuffer, unsigned long nBuffe
 {
     auto& ctx = audioContext;
     PROFILE_REGION(Audio);
-    PROFILE_NAME_THREAD(Audio);
+    TRACE_NAME_THREAD(Audio);
 
-    PROFILE_SCOPE(Tick);
+    TRACE_SCOPE(Tick);
 
     auto fracSec = (nBufferFrames / (double)ctx.outputState.sampleRate);
     static const uint64_t oneSecondNs = uint64_t(duration_cast<nanoseconds>(seconds(1)).count());
@@ -437,7 +518,39 @@ int audio_tick(const void* inputBuffer, void* outputBuffer, unsigned long nBuffe
         return 0;
     }
 
+    uint32_t deadlineFlags = 0;
+    if (statusFlags & paInputUnderflow)
+    {
+        deadlineFlags |= Deadline_InputUnderflow;
+    }
+    if (statusFlags & paInputOverflow)
+    {
+        deadlineFlags |= Deadline_InputOverflow;
+    }
+    if (statusFlags & paOutputUnderflow)
+    {
+        deadlineFlags |= Deadline_OutputUnderflow;
+    }
+    if (statusFlags & paOutputOverflow)
+    {
+        deadlineFlags |= Deadline_OutputOverflow;
+    }
+    if (statusFlags & paPrimingOutput)
+    {
+        deadlineFlags |= Deadline_PrimingOutput;
+    }
+
+    // Time until this buffer reaches the DAC; some hosts leave it at 0
+    double leadSeconds = 0.0;
+    if (timeInfo && timeInfo->outputBufferDacTime > timeInfo->currentTime)
+    {
+        leadSeconds = timeInfo->outputBufferDacTime - timeInfo->currentTime;
+    }
+    deadline_begin(ctx.deadline, uint32_t(nBufferFrames), ctx.outputState.sampleRate, deadlineFlags, leadSeconds);
+
     auto bLocked = spin_mutex_try(ctx.audioTickEnableMutex, [&]() {
+        const auto tickStart = steady_clock::now();
+
         if (ctx.m_totalFrames == 0)
         {
             ctx.m_frameInitTime = duration_cast<microseconds>(steady_clock::now().time_since_epoch());
@@ -471,12 +584,19 @@ int audio_tick(const void* inputBuffer, void* outputBuffer, unsigned long nBuffe
             }
         }
 
-        audio_pre_callback(hostTimeAtFrame, outputBuffer, nBufferFrames);
+        {
+            DeadlineStageScope deadlineScope(ctx.deadline, DeadlineStage::PreCallback);
+            audio_pre_callback(hostTimeAtFrame, outputBuffer, nBufferFrames);
+        }
 
-        audio_process_midi(outputBuffer, nBufferFrames);
+        {
+            DeadlineStageScope deadlineScope(ctx.deadline, DeadlineStage::Midi);
+            audio_process_midi(outputBuffer, nBufferFrames);
+        }
 
         auto sendAnalysis = [&](auto& state, const float* pBuffer, uint32_t frames, const ChannelId& Id) {
-            PROFILE_SCOPE(SendAnalysis);
+            TRACE_SCOPE(SendAnalysis);
+            DeadlineStageScope deadlineScope(ctx.deadline, DeadlineStage::SendAnalysis);
             auto itrAnalysis = ctx.analysisChannels.find(Id);
             if (itrAnalysis != ctx.analysisChannels.end())
             {
@@ -514,6 +634,22 @@ int audio_tick(const void* inputBuffer, void* outputBuffer, unsigned long nBuffe
         {
             if (inputBuffer)
             {
+                // If the stages are being edited, they are skipped for this buffer
+                spin_mutex_try(ctx.stageMutex, [&]() {
+                    DeadlineStageScope deadlineScope(ctx.deadline, DeadlineStage::InputStages);
+                    if (audio_has_stages(Channel_In))
+                    {
+                        // Sized when the stream opens and when a stage is added; a buffer that doesn't fit skips the stages
+                        const auto count = nBufferFrames * ctx.inputState.channelCount;
+                        if (ctx.stageInput.size() >= count)
+                        {
+                            std::copy((const float*)inputBuffer, (const float*)inputBuffer + count, ctx.stageInput.data());
+                            audio_run_stages(Channel_In, ctx.stageInput.data(), nBufferFrames, ctx.inputState.channelCount);
+                            inputBuffer = ctx.stageInput.data();
+                        }
+                    }
+                });
+
                 for (uint32_t i = 0; i < ctx.inputState.channelCount; i++)
                 {
                     sendAnalysis(ctx.inputState, (const float*)inputBuffer, nBufferFrames, audio_to_channel_id(Channel_In, i));
@@ -524,10 +660,19 @@ int audio_tick(const void* inputBuffer, void* outputBuffer, unsigned long nBuffe
             {
                 if (ctx.m_fnCallback)
                 {
+                    DeadlineStageScope deadlineScope(ctx.deadline, DeadlineStage::UserCallback);
                     ctx.m_fnCallback(bufferBeginAtOutput, inputBuffer, outputBuffer, nBufferFrames);
                 }
 
-                apply_output_compressor((float*)outputBuffer, nBufferFrames, ctx.outputState.channelCount);
+                spin_mutex_try(ctx.stageMutex, [&]() {
+                    DeadlineStageScope deadlineScope(ctx.deadline, DeadlineStage::OutputStages);
+                    audio_run_stages(Channel_Out, (float*)outputBuffer, nBufferFrames, ctx.outputState.channelCount);
+                });
+
+                {
+                    DeadlineStageScope deadlineScope(ctx.deadline, DeadlineStage::Compressor);
+                    apply_output_compressor((float*)outputBuffer, nBufferFrames, ctx.outputState.channelCount);
+                }
 
                 for (uint32_t i = 0; i < ctx.outputState.channelCount; i++)
                 {
@@ -540,6 +685,8 @@ int audio_tick(const void* inputBuffer, void* outputBuffer, unsigned long nBuffe
         ctx.outputState.totalFrames += nBufferFrames;
 
         ctx.m_frameCurrentTime += bufferDuration;
+
+        samples_governor_tick(ctx.m_samples, duration<double>(steady_clock::now() - tickStart).count(), fracSec);
     }); // End of try
 
     if (!bLocked)
@@ -551,6 +698,8 @@ int audio_tick(const void* inputBuffer, void* outputBuffer, unsigned long nBuffe
         }
     }
 
+    deadline_end(ctx.deadline, bLocked ? 0 : Deadline_Skipped);
+
     return 0;
 }
 
@@ -822,6 +971,8 @@ void audio_destroy()
 
     Pa_Terminate();
 
+    deadline_stop(ctx.deadline);
+
     if (ctx.pSP)
     {
         sp_destroy(&ctx.pSP);
@@ -829,6 +980,9 @@ void audio_destroy()
     }
     destroy_output_compressor();
 
+    samples_set_render_workers(ctx.m_samples, 0);
+    samples_destroy(ctx.m_samples);
+
     ctx.audioTickEnableMutex.unlock();
 }
 
@@ -955,6 +1109,8 @@ bool audio_init(const AudioCB& fnCallback)
 
     PaStreamFlags flags = paNoFlag;
 
+    deadline_start(ctx.deadline);
+
     // Link
     //ctx.m_outputLatency.store(std::chrono::microseconds(llround(ctx.m_outputParams.suggestedLatency * 1.0e6)));
 
@@ -967,6 +1123,12 @@ bool audio_init(const AudioCB& fnCallback)
 
     ctx.m_audioValid = true;
 
+    {
+        std::lock_guard<Zest::spin_mutex> lock(ctx.stageMutex);
+        audio_size_stage_input();
+    }
+    audio_fill_spare_bundles();
+
     ret = Pa_StartStream(ctx.m_pStream);
     if (ret != paNoError)
     {
@@ -1317,6 +1479,46 @@ void audio_show_settings_gui()
             {
                 analysisSettings.spectrumGains = gains;
             }
+
+            bool pitchEnabled = analysisSettings.pitchEnabled;
+            if (ImGui::Checkbox("Pitch", &pitchEnabled))
+            {
+                analysisSettings.pitchEnabled = pitchEnabled;
+            }
+
+            float pitchMin = analysisSettings.pitchMinFrequency;
+            float pitchMax = analysisSettings.pitchMaxFrequency;
+            if (ImGui::DragFloatRange2("Pitch Range (Hz)", &pitchMin, &pitchMax, 1.0f, 20.0f, 8000.0f, "%.0f"))
+            {
+                analysisSettings.pitchMinFrequency = pitchMin;
+                analysisSettings.pitchMaxFrequency = pitchMax;
+            }
+
+            float pitchThreshold = analysisSettings.pitchThreshold;
+            if (ImGui::SliderFloat("Pitch Threshold", &pitchThreshold, 0.01f, 1.0f, "%.2f"))
+            {
+                analysisSettings.pitchThreshold = pitchThreshold;
+            }
+
+            bool onsetEnabled = analysisSettings.onsetEnabled;
+            if (ImGui::Checkbox("Onsets", &onsetEnabled))
+            {
+                analysisSettings.onsetEnabled = onsetEnabled;
+            }
+
+            float onsetSensitivity = analysisSettings.onsetSensitivity;
+            if (ImGui::SliderFloat("Onset Sensitivity", &onsetSensitivity, 1.0f, 10.0f, "%.2f"))
+            {
+                analysisSettings.onsetSensitivity = onsetSensitivity;
+            }
+
+            float tempoMin = analysisSettings.tempoMinBpm;
+            float tempoMax = analysisSettings.tempoMaxBpm;
+            if (ImGui::DragFloatRange2("Tempo Range (BPM)", &tempoMin, &tempoMax, 1.0f, 30.0f, 400.0f, "%.0f"))
+            {
+                analysisSettings.tempoMinBpm = tempoMin;
+                analysisSettings.tempoMaxBpm = tempoMax;
+            }
         }
 
         if (ImGui::CollapsingHeader("Compressor", ImGuiTreeNodeFlags_None))
@@ -1366,9 +1568,70 @@ void audio_show_settings_gui()
             ImGui::PopStyleColor();
         }
 
+        if (ImGui::CollapsingHeader("Voices", ImGuiTreeNodeFlags_None))
+        {
+            auto& governor = ctx.m_samples.governor;
+
+            bool enabled = governor.enabled;
+            if (ImGui::Checkbox("Adaptive Voice Limit", &enabled))
+            {
+                governor.enabled = enabled;
+            }
+
+            float highLoad = governor.highLoad;
+            if (ImGui::SliderFloat("High Load##voice_high", &highLoad, 0.1f, 1.0f, "%.2f"))
+            {
+                governor.highLoad = highLoad;
+            }
+
+            float lowLoad = governor.lowLoad;
+            if (ImGui::SliderFloat("Low Load##voice_low", &lowLoad, 0.05f, highLoad, "%.2f"))
+            {
+                governor.lowLoad = lowLoad;
+            }
+
+            ImGui::Text(fmt::format("Voices: {} / {}, Stolen: {}", governor.activeVoices.load(), governor.voiceLimit.load(), governor.stolenVoices.load()).c_str());
+            ImGui::ProgressBar(std::clamp(governor.load.load(std::memory_order_relaxed), 0.0f, 1.0f), ImVec2(-1.0f, 6.0f), "");
+        }
+
+        if (ImGui::CollapsingHeader("Deadlines", ImGuiTreeNodeFlags_None))
+        {
+            const auto stats = deadline_stats(ctx.deadline);
+            ImGui::TextUnformatted(deadline_report(stats).c_str());
+            if (ImGui::Button("Log##deadlines"))
+            {
+                LOG(INFO, deadline_report(stats));
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Reset##deadlines"))
+            {
+                deadline_reset(ctx.deadline);
+            }
+        }
+
         if (ImGui::CollapsingHeader("Waterfall", ImGuiTreeNodeFlags_None))
         {
+            ImGui::Checkbox("Enable##Waterfall", &analysisSettings.waterfallEnabled);
+
+            int waterfallBins = int(analysisSettings.waterfallBins);
+            if (ImGui::SliderInt("Columns##Waterfall", &waterfallBins, 32, int(analysisSettings.frames / 2)))
+            {
+                analysisSettings.waterfallBins = uint32_t(waterfallBins);
+            }
+
             Waterfall_DrawControls(Waterfall_Get());
+
+            ImGui::Separator();
+            if (ImGui::Checkbox("Record History", &analysisSettings.archiveEnabled))
+            {
+                audioResetRequired = true;
+            }
+            ImGui::SliderFloat("History Span (s)", &analysisSettings.archiveViewSeconds, 10.0f, 24.0f * 3600.0f, "%.0f", ImGuiSliderFlags_Logarithmic);
+            int archiveView = int(analysisSettings.archiveView);
+            if (ImGui::Combo("History View", &archiveView, "Min\0Mean\0Max\0"))
+            {
+                analysisSettings.archiveView = uint32_t(archiveView);
+            }
         }
     }
 
@@ -1407,6 +1670,25 @@ ChannelId audio_to_channel_id(uint32_t channel_type, uint32_t channel)
     return ChannelId(channel_type, channel);
 }
 
+uint32_t audio_add_stage(ChannelId channel, const fnAudioStage& fnProcess)
+{
+    auto& ctx = audioContext;
+    std::lock_guard<Zest::spin_mutex> lock(ctx.stageMutex);
+    auto id = ctx.nextStageId++;
+    ctx.stages.push_back(AudioStage{ id, channel, fnProcess });
+    audio_size_stage_input();
+    return id;
+}
+
+void audio_remove_stage(uint32_t id)
+{
+    auto& ctx = audioContext;
+    std::lock_guard<Zest::spin_mutex> lock(ctx.stageMutex);
+    ctx.stages.erase(std::remove_if(ctx.stages.begin(), ctx.stages.end(), [id](const AudioStage& stage) {
+        return stage.id == id;
+    }), ctx.stages.end());
+}
+
 void audio_add_midi_event(const libremidi::message& msg)
 {
     auto& ctx = audioContext;
@@ -0,0 +1,580 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_ambisonics.h>
+#include <zing/audio/audio_workers.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AMBISONIC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Zing
+{
+
+namespace
+{
+
+// Enough directions, spread evenly, to pin down any matrix acting on a 3rd order bus
+constexpr uint32_t AmbisonicSamplePoints = 64;
+
+uint32_t ambisonic_channel_order(uint32_t channel)
+{
+    return uint32_t(std::sqrt(float(channel)) + 1e-3f);
+}
+
+glm::vec3 ambisonic_direction(float azimuth, float elevation)
+{
+    const auto az = glm::radians(azimuth);
+    const auto el = glm::radians(elevation);
+    return glm::vec3(std::cos(az) * std::cos(el), std::sin(az) * std::cos(el), std::sin(el));
+}
+
+// x front, y left, z up
+void ambisonic_coefficients_xyz(uint32_t order, const glm::vec3& d, float* pOut)
+{
+    const float x = d.x;
+    const float y = d.y;
+    const float z = d.z;
+
+    pOut[0] = 1.0f;
+    if (order < 1)
+    {
+        return;
+    }
+    pOut[1] = y;
+    pOut[2] = z;
+    pOut[3] = x;
+    if (order < 2)
+    {
+        return;
+    }
+
+    const float root3 = std::sqrt(3.0f);
+    pOut[4] = root3 * x * y;
+    pOut[5] = root3 * y * z;
+    pOut[6] = 0.5f * (3.0f * z * z - 1.0f);
+    pOut[7] = root3 * x * z;
+    pOut[8] = 0.5f * root3 * (x * x - y * y);
+    if (order < 3)
+    {
+        return;
+    }
+
+    const float root5_8 = std::sqrt(5.0f / 8.0f);
+    const float root3_8 = std::sqrt(3.0f / 8.0f);
+    const float root15 = std::sqrt(15.0f);
+    pOut[9] = root5_8 * y * (3.0f * x * x - y * y);
+    pOut[10] = root15 * x * y * z;
+    pOut[11] = root3_8 * y * (5.0f * z * z - 1.0f);
+    pOut[12] = 0.5f * z * (5.0f * z * z - 3.0f);
+    pOut[13] = root3_8 * x * (5.0f * z * z - 1.0f);
+    pOut[14] = 0.5f * root15 * z * (x * x - y * y);
+    pOut[15] = root5_8 * x * (x * x - 3.0f * y * y);
+}
+
+std::vector<glm::vec3> ambisonic_sample_points()
+{
+    // Fibonacci sphere
+    std::vector<glm::vec3> points(AmbisonicSamplePoints);
+    const float golden = glm::pi<float>() * (3.0f - std::sqrt(5.0f));
+    for (uint32_t i = 0; i < AmbisonicSamplePoints; i++)
+    {
+        const float z = 1.0f - 2.0f * (float(i) + 0.5f) / float(AmbisonicSamplePoints);
+        const float r = std::sqrt(std::max(0.0f, 1.0f - z * z));
+        points[i] = glm::vec3(r * std::cos(golden * i), r * std::sin(golden * i), z);
+    }
+    return points;
+}
+
+// In place Cholesky of a symmetric n x n matrix (lower triangle); false if it isn't positive definite
+bool ambisonic_cholesky(std::vector<double>& a, uint32_t n)
+{
+    double trace = 0.0;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        trace += a[i * n + i];
+    }
+
+    for (uint32_t j = 0; j < n; j++)
+    {
+        double d = a[j * n + j];
+        for (uint32_t k = 0; k < j; k++)
+        {
+            d -= a[j * n + k] * a[j * n + k];
+        }
+        if (d <= trace * 1e-9)
+        {
+            return false;
+        }
+        a[j * n + j] = std::sqrt(d);
+
+        for (uint32_t i = j + 1; i < n; i++)
+        {
+            double s = a[i * n + j];
+            for (uint32_t k = 0; k < j; k++)
+            {
+                s -= a[i * n + k] * a[j * n + k];
+            }
+            a[i * n + j] = s / a[j * n + j];
+        }
+    }
+    return true;
+}
+
+void ambisonic_cholesky_solve(const std::vector<double>& l, uint32_t n, double* pB)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        double s = pB[i];
+        for (uint32_t k = 0; k < i; k++)
+        {
+            s -= l[i * n + k] * pB[k];
+        }
+        pB[i] = s / l[i * n + i];
+    }
+    for (uint32_t i = n; i-- > 0;)
+    {
+        double s = pB[i];
+        for (uint32_t k = i + 1; k < n; k++)
+        {
+            s -= l[k * n + i] * pB[k];
+        }
+        pB[i] = s / l[i * n + i];
+    }
+}
+
+// out[row] (+)= sum over col of matrix[row][col] * in[col], for frames [begin, end)
+void ambisonic_matrix_range(const float* pMatrix, uint32_t rows, uint32_t cols, const float* const* ppIn, float* const* ppOut, uint32_t begin, uint32_t end, bool accumulate)
+{
+    for (uint32_t row = 0; row < rows; row++)
+    {
+        auto pOut = ppOut[row];
+        if (!accumulate)
+        {
+            std::fill(pOut + begin, pOut + end, 0.0f);
+        }
+
+        const auto pRow = pMatrix + size_t(row) * cols;
+        for (uint32_t col = 0; col < cols; col++)
+        {
+            const auto m = pRow[col];
+            if (m == 0.0f)
+            {
+                continue;
+            }
+
+            const auto pIn = ppIn[col];
+            uint32_t frame = begin;
+#ifdef AMBISONIC_SSE2
+            const auto vM = _mm_set1_ps(m);
+            for (; frame + 4 <= end; frame += 4)
+            {
+                _mm_storeu_ps(pOut + frame, _mm_add_ps(_mm_loadu_ps(pOut + frame), _mm_mul_ps(vM, _mm_loadu_ps(pIn + frame))));
+            }
+#endif
+            for (; frame < end; frame++)
+            {
+                pOut[frame] += m * pIn[frame];
+            }
+        }
+    }
+}
+
+struct AmbisonicMatrixJob
+{
+    const float* pMatrix;
+    uint32_t rows;
+    uint32_t cols;
+    const float* const* ppIn;
+    float* const* ppOut;
+    uint32_t frames;
+    uint32_t chunk;
+    bool accumulate;
+};
+
+void ambisonic_matrix_job(void* pUser, uint32_t job)
+{
+    auto& work = *(const AmbisonicMatrixJob*)pUser;
+    const auto begin = std::min(work.frames, job * work.chunk);
+    const auto end = std::min(work.frames, begin + work.chunk);
+    ambisonic_matrix_range(work.pMatrix, work.rows, work.cols, work.ppIn, work.ppOut, begin, end, work.accumulate);
+}
+
+void ambisonic_matrix(AmbisonicBus& bus, const float* pMatrix, uint32_t rows, uint32_t cols, const float* const* ppIn, float* const* ppOut, uint32_t frames, bool accumulate)
+{
+    const auto workers = bus.pWorkers ? audio_workers_count(*bus.pWorkers) : 1;
+    const auto jobs = std::min(workers, frames / std::max(bus.minJobFrames, 4u));
+    if (jobs < 2)
+    {
+        ambisonic_matrix_range(pMatrix, rows, cols, ppIn, ppOut, 0, frames, accumulate);
+        return;
+    }
+
+    // Frame ranges stay a multiple of the vector width
+    AmbisonicMatrixJob work{ pMatrix, rows, cols, ppIn, ppOut, frames, ((frames + jobs - 1) / jobs + 3) & ~3u, accumulate };
+    audio_workers_run(*bus.pWorkers, jobs, ambisonic_matrix_job, &work);
+}
+
+float ambisonic_legendre(uint32_t n, float x)
+{
+    switch (n)
+    {
+    case 0:
+        return 1.0f;
+    case 1:
+        return x;
+    case 2:
+        return 0.5f * (3.0f * x * x - 1.0f);
+    default:
+        return 0.5f * (5.0f * x * x * x - 3.0f * x);
+    }
+}
+
+void ambisonic_projection_decoder(AmbisonicBus& bus)
+{
+    const auto channels = bus.channels;
+
+    // Max rE weights
+    const float angle = glm::radians(137.9f / (float(bus.order) + 1.51f));
+    float weights[AmbisonicMaxOrder + 1];
+    for (uint32_t n = 0; n <= bus.order; n++)
+    {
+        weights[n] = float(2 * n + 1) * ambisonic_legendre(n, std::cos(angle));
+    }
+
+    float coefficients[AmbisonicMaxChannels];
+    for (uint32_t speaker = 0; speaker < bus.speakers.size(); speaker++)
+    {
+        auto pRow = &bus.decoder[size_t(speaker) * channels];
+        if (bus.speakers[speaker].lfe)
+        {
+            continue;
+        }
+
+        ambisonic_coefficients_xyz(bus.order, ambisonic_direction(bus.speakers[speaker].azimuth, bus.speakers[speaker].elevation), coefficients);
+        for (uint32_t channel = 0; channel < channels; channel++)
+        {
+            pRow[channel] = weights[ambisonic_channel_order(channel)] * coefficients[channel];
+        }
+    }
+
+    // Keep the total energy at unity, on average over the sphere
+    double energy = 0.0;
+    for (auto& point : ambisonic_sample_points())
+    {
+        ambisonic_coefficients_xyz(bus.order, point, coefficients);
+        for (uint32_t speaker = 0; speaker < bus.speakers.size(); speaker++)
+        {
+            double gain = 0.0;
+            for (uint32_t channel = 0; channel < channels; channel++)
+            {
+                gain += bus.decoder[size_t(speaker) * channels + channel] * coefficients[channel];
+            }
+            energy += gain * gain;
+        }
+    }
+    energy /= AmbisonicSamplePoints;
+
+    if (energy > 0.0)
+    {
+        const auto scale = float(1.0 / std::sqrt(energy));
+        for (auto& value : bus.decoder)
+        {
+            value *= scale;
+        }
+    }
+}
+
+bool ambisonic_mode_matching_decoder(AmbisonicBus& bus)
+{
+    const auto channels = bus.channels;
+
+    std::vector<uint32_t> active;
+    for (uint32_t speaker = 0; speaker < bus.speakers.size(); speaker++)
+    {
+        if (!bus.speakers[speaker].lfe)
+        {
+            active.push_back(speaker);
+        }
+    }
+    if (active.size() < channels)
+    {
+        return false;
+    }
+
+    // Y is channels x speakers; each speaker's row of the decoder is (Y Y^T)^-1 Y[:, speaker]
+    std::vector<double> y(size_t(channels) * active.size());
+    float coefficients[AmbisonicMaxChannels];
+    for (uint32_t i = 0; i < active.size(); i++)
+    {
+        const auto& speaker = bus.speakers[active[i]];
+        ambisonic_coefficients_xyz(bus.order, ambisonic_direction(speaker.azimuth, speaker.elevation), coefficients);
+        for (uint32_t channel = 0; channel < channels; channel++)
+        {
+            y[size_t(channel) * active.size() + i] = coefficients[channel];
+        }
+    }
+
+    std::vector<double> a(size_t(channels) * channels, 0.0);
+    for (uint32_t r = 0; r < channels; r++)
+    {
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            for (uint32_t i = 0; i < active.size(); i++)
+            {
+                a[r * channels + c] += y[r * active.size() + i] * y[c * active.size() + i];
+            }
+        }
+    }
+
+    if (!ambisonic_cholesky(a, channels))
+    {
+        return false;
+    }
+
+    double column[AmbisonicMaxChannels];
+    for (uint32_t i = 0; i < active.size(); i++)
+    {
+        for (uint32_t channel = 0; channel < channels; channel++)
+        {
+            column[channel] = y[size_t(channel) * active.size() + i];
+        }
+        ambisonic_cholesky_solve(a, channels, column);
+        for (uint32_t channel = 0; channel < channels; channel++)
+        {
+            bus.decoder[size_t(active[i]) * channels + channel] = float(column[channel]);
+        }
+    }
+    return true;
+}
+
+void ambisonic_update_output(AmbisonicBus& bus)
+{
+    const auto channels = bus.channels;
+    const auto speakers = uint32_t(bus.speakers.size());
+    bus.output.assign(size_t(speakers) * channels, 0.0f);
+    for (uint32_t speaker = 0; speaker < speakers; speaker++)
+    {
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            float sum = 0.0f;
+            for (uint32_t k = 0; k < channels; k++)
+            {
+                sum += bus.decoder[size_t(speaker) * channels + k] * bus.rotation[k * channels + c];
+            }
+            bus.output[size_t(speaker) * channels + c] = sum;
+        }
+    }
+    bus.outputDirty = false;
+}
+
+} // namespace
+
+void ambisonic_coefficients(uint32_t order, float azimuth, float elevation, float* pCoefficients)
+{
+    ambisonic_coefficients_xyz(std::min(order, AmbisonicMaxOrder), ambisonic_direction(azimuth, elevation), pCoefficients);
+}
+
+std::vector<AmbisonicSpeaker> ambisonic_default_layout(uint32_t channelCount)
+{
+    switch (channelCount)
+    {
+    case 0:
+        return {};
+    case 1:
+        return { { 0.0f, 0.0f } };
+    case 2:
+        return { { 30.0f, 0.0f }, { -30.0f, 0.0f } };
+    case 4:
+        return { { 45.0f, 0.0f }, { -45.0f, 0.0f }, { 135.0f, 0.0f }, { -135.0f, 0.0f } };
+    case 6:
+        return { { 30.0f, 0.0f }, { -30.0f, 0.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f, true }, { 110.0f, 0.0f }, { -110.0f, 0.0f } };
+    case 8:
+        return { { 30.0f, 0.0f }, { -30.0f, 0.0f }, { 0.0f, 0.0f }, { 0.0f, 0.0f, true }, { 150.0f, 0.0f }, { -150.0f, 0.0f }, { 90.0f, 0.0f }, { -90.0f, 0.0f } };
+    default:
+        break;
+    }
+
+    std::vector<AmbisonicSpeaker> ring(channelCount);
+    for (uint32_t i = 0; i < channelCount; i++)
+    {
+        ring[i].azimuth = 360.0f * float(i) / float(channelCount);
+    }
+    return ring;
+}
+
+void ambisonic_init(AmbisonicBus& bus, uint32_t order, uint32_t maxFrames, uint32_t outputChannels)
+{
+    bus.order = std::min(order, AmbisonicMaxOrder);
+    bus.channels = (bus.order + 1) * (bus.order + 1);
+    bus.maxFrames = maxFrames;
+
+    bus.bus.assign(size_t(bus.channels) * maxFrames, 0.0f);
+    bus.busChannels.resize(bus.channels);
+    for (uint32_t channel = 0; channel < bus.channels; channel++)
+    {
+        bus.busChannels[channel] = bus.bus.data() + size_t(channel) * maxFrames;
+    }
+
+    ambisonic_set_rotation(bus, 0.0f, 0.0f, 0.0f);
+    ambisonic_set_layout(bus, ambisonic_default_layout(outputChannels));
+}
+
+void ambisonic_set_layout(AmbisonicBus& bus, const std::vector<AmbisonicSpeaker>& speakers, AmbisonicDecoder decoder)
+{
+    bus.speakers = speakers;
+    bus.decoderType = decoder;
+    bus.decoder.assign(speakers.size() * bus.channels, 0.0f);
+
+    if (decoder == AmbisonicDecoder::ModeMatching && !ambisonic_mode_matching_decoder(bus))
+    {
+        LOG(DBG, "Speaker layout can't be mode matched at order " << bus.order << "; using projection");
+        std::fill(bus.decoder.begin(), bus.decoder.end(), 0.0f);
+        bus.decoderType = AmbisonicDecoder::Projection;
+    }
+    if (bus.decoderType == AmbisonicDecoder::Projection)
+    {
+        ambisonic_projection_decoder(bus);
+    }
+
+    bus.speakerData.assign(speakers.size() * bus.maxFrames, 0.0f);
+    bus.speakerChannels.resize(speakers.size());
+    for (uint32_t speaker = 0; speaker < speakers.size(); speaker++)
+    {
+        bus.speakerChannels[speaker] = bus.speakerData.data() + size_t(speaker) * bus.maxFrames;
+    }
+    bus.outputDirty = true;
+}
+
+void ambisonic_set_rotation(AmbisonicBus& bus, float yaw, float pitch, float roll)
+{
+    const auto channels = bus.channels;
+
+    const float cy = std::cos(glm::radians(yaw)), sy = std::sin(glm::radians(yaw));
+    const float cp = std::cos(glm::radians(pitch)), sp = std::sin(glm::radians(pitch));
+    const float cr = std::cos(glm::radians(roll)), sr = std::sin(glm::radians(roll));
+    auto rotate = [&](glm::vec3 d) {
+        d = glm::vec3(d.x, cr * d.y - sr * d.z, sr * d.y + cr * d.z);
+        d = glm::vec3(cp * d.x + sp * d.z, d.y, -sp * d.x + cp * d.z);
+        return glm::vec3(cy * d.x - sy * d.y, sy * d.x + cy * d.y, d.z);
+    };
+
+    // Rotations keep each order to itself, so R with Y(rotate(d)) = R Y(d) is found exactly by least
+    // squares over enough directions: R^T = (Y Y^T)^-1 Y Yr^T
+    const auto points = ambisonic_sample_points();
+    std::vector<double> y(size_t(channels) * points.size());
+    std::vector<double> yr(size_t(channels) * points.size());
+    float coefficients[AmbisonicMaxChannels];
+    for (uint32_t i = 0; i < points.size(); i++)
+    {
+        ambisonic_coefficients_xyz(bus.order, points[i], coefficients);
+        for (uint32_t channel = 0; channel < channels; channel++)
+        {
+            y[size_t(channel) * points.size() + i] = coefficients[channel];
+        }
+        ambisonic_coefficients_xyz(bus.order, rotate(points[i]), coefficients);
+        for (uint32_t channel = 0; channel < channels; channel++)
+        {
+            yr[size_t(channel) * points.size() + i] = coefficients[channel];
+        }
+    }
+
+    std::vector<double> a(size_t(channels) * channels, 0.0);
+    std::vector<double> b(size_t(channels) * channels, 0.0);
+    for (uint32_t r = 0; r < channels; r++)
+    {
+        for (uint32_t c = 0; c < channels; c++)
+        {
+            for (uint32_t i = 0; i < points.size(); i++)
+            {
+                a[r * channels + c] += y[r * points.size() + i] * y[c * points.size() + i];
+                b[r * channels + c] += y[r * points.size() + i] * yr[c * points.size() + i];
+            }
+        }
+    }
+
+    const auto solved = ambisonic_cholesky(a, channels);
+    assert(solved);
+    UNUSED(solved);
+
+    double column[AmbisonicMaxChannels];
+    for (uint32_t c = 0; c < channels; c++)
+    {
+        for (uint32_t r = 0; r < channels; r++)
+        {
+            column[r] = b[r * channels + c];
+        }
+        ambisonic_cholesky_solve(a, channels, column);
+
+        // Column c of R^T is row c of R
+        for (uint32_t r = 0; r < channels; r++)
+        {
+            const auto value = std::abs(column[r]) < 1e-6 ? 0.0 : column[r];
+            bus.rotation[c * channels + r] = float(value);
+        }
+    }
+    bus.outputDirty = true;
+}
+
+void ambisonic_clear(AmbisonicBus& bus, uint32_t frames)
+{
+    frames = std::min(frames, bus.maxFrames);
+    for (auto pChannel : bus.busChannels)
+    {
+        std::fill(pChannel, pChannel + frames, 0.0f);
+    }
+}
+
+void ambisonic_encode(AmbisonicBus& bus, const AmbisonicSource* pSources, uint32_t sourceCount, uint32_t frames)
+{
+    TRACE_SCOPE(ambisonic_encode);
+
+    frames = std::min(frames, bus.maxFrames);
+    const auto channels = bus.channels;
+
+    // Only grows with the number of sources
+    bus.encoder.resize(size_t(channels) * sourceCount);
+    bus.sourceInputs.resize(sourceCount);
+
+    float coefficients[AmbisonicMaxChannels];
+    for (uint32_t source = 0; source < sourceCount; source++)
+    {
+        const auto& s = pSources[source];
+        const auto gain = s.pInput ? s.gain : 0.0f;
+        ambisonic_coefficients_xyz(bus.order, ambisonic_direction(s.azimuth, s.elevation), coefficients);
+        for (uint32_t channel = 0; channel < channels; channel++)
+        {
+            bus.encoder[size_t(channel) * sourceCount + source] = coefficients[channel] * gain;
+        }
+        bus.sourceInputs[source] = s.pInput;
+    }
+
+    ambisonic_matrix(bus, bus.encoder.data(), channels, sourceCount, bus.sourceInputs.data(), bus.busChannels.data(), frames, true);
+}
+
+void ambisonic_decode(AmbisonicBus& bus, float* pOutput, uint32_t channelCount, uint32_t frames)
+{
+    TRACE_SCOPE(ambisonic_decode);
+
+    frames = std::min(frames, bus.maxFrames);
+    if (bus.outputDirty)
+    {
+        ambisonic_update_output(bus);
+    }
+
+    const auto speakers = uint32_t(bus.speakers.size());
+    ambisonic_matrix(bus, bus.output.data(), speakers, bus.channels, bus.busChannels.data(), bus.speakerChannels.data(), frames, false);
+
+    for (uint32_t speaker = 0; speaker < std::min(speakers, channelCount); speaker++)
+    {
+        const auto pSpeaker = bus.speakerChannels[speaker];
+        auto pOut = pOutput + speaker;
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            *pOut += pSpeaker[frame];
+            pOut += channelCount;
+        }
+    }
+}
+
+} // namespace Zing
@@ -0,0 +1,159 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_ambisonics.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+uint32_t test_order_of(uint32_t channel)
+{
+    uint32_t order = 0;
+    while ((order + 1) * (order + 1) <= channel)
+    {
+        order++;
+    }
+    return order;
+}
+
+// Row r, column c of the bus rotation
+float test_rotation(const AmbisonicBus& bus, uint32_t r, uint32_t c)
+{
+    return bus.rotation[r * bus.channels + c];
+}
+
+void test_rotated_direction(const AmbisonicBus& bus, float azimuth, float elevation, float expectedAzimuth, float expectedElevation)
+{
+    float in[AmbisonicMaxChannels];
+    float expected[AmbisonicMaxChannels];
+    ambisonic_coefficients(bus.order, azimuth, elevation, in);
+    ambisonic_coefficients(bus.order, expectedAzimuth, expectedElevation, expected);
+
+    for (uint32_t r = 0; r < bus.channels; r++)
+    {
+        float sum = 0.0f;
+        for (uint32_t c = 0; c < bus.channels; c++)
+        {
+            sum += test_rotation(bus, r, c) * in[c];
+        }
+        REQUIRE(sum == Approx(expected[r]).margin(1e-4));
+    }
+}
+
+} // namespace
+
+TEST_CASE("Ambisonics.Coefficients", "[Ambisonics]")
+{
+    // AmbiX: ACN order W, Y, Z, X with SN3D, so W is 1 and the first order is the unit direction
+    float coefficients[AmbisonicMaxChannels];
+    ambisonic_coefficients(1, 90.0f, 0.0f, coefficients);
+    REQUIRE(coefficients[0] == Approx(1.0f));
+    REQUIRE(coefficients[1] == Approx(1.0f).margin(1e-6));
+    REQUIRE(coefficients[2] == Approx(0.0f).margin(1e-6));
+    REQUIRE(coefficients[3] == Approx(0.0f).margin(1e-6));
+
+    ambisonic_coefficients(1, 0.0f, 90.0f, coefficients);
+    REQUIRE(coefficients[1] == Approx(0.0f).margin(1e-6));
+    REQUIRE(coefficients[2] == Approx(1.0f).margin(1e-6));
+    REQUIRE(coefficients[3] == Approx(0.0f).margin(1e-6));
+
+    // SN3D: the harmonics of each order have a sum of squares of 1 in every direction
+    for (float azimuth : { 0.0f, 33.0f, -120.0f })
+    {
+        for (float elevation : { 0.0f, 25.0f, -60.0f })
+        {
+            ambisonic_coefficients(AmbisonicMaxOrder, azimuth, elevation, coefficients);
+            for (uint32_t order = 0; order <= AmbisonicMaxOrder; order++)
+            {
+                float sum = 0.0f;
+                for (uint32_t channel = order * order; channel < (order + 1) * (order + 1); channel++)
+                {
+                    sum += coefficients[channel] * coefficients[channel];
+                }
+                REQUIRE(sum == Approx(1.0f).margin(1e-4));
+            }
+        }
+    }
+}
+
+TEST_CASE("Ambisonics.RotationOrthonormalPerOrder", "[Ambisonics]")
+{
+    for (uint32_t order = 1; order <= AmbisonicMaxOrder; order++)
+    {
+        AmbisonicBus bus;
+        ambisonic_init(bus, order, 256, 2);
+
+        const float angles[][3] = { { 0.0f, 0.0f, 0.0f }, { 90.0f, 0.0f, 0.0f }, { 30.0f, -45.0f, 10.0f }, { -170.0f, 80.0f, 135.0f } };
+        for (const auto& angle : angles)
+        {
+            ambisonic_set_rotation(bus, angle[0], angle[1], angle[2]);
+
+            // Each order only maps to itself, and within it the rotation is orthonormal
+            for (uint32_t r = 0; r < bus.channels; r++)
+            {
+                for (uint32_t c = 0; c < bus.channels; c++)
+                {
+                    if (test_order_of(r) != test_order_of(c))
+                    {
+                        REQUIRE(test_rotation(bus, r, c) == Approx(0.0f).margin(1e-5));
+                        continue;
+                    }
+
+                    float dot = 0.0f;
+                    for (uint32_t k = 0; k < bus.channels; k++)
+                    {
+                        dot += test_rotation(bus, r, k) * test_rotation(bus, c, k);
+                    }
+                    REQUIRE(dot == Approx(r == c ? 1.0f : 0.0f).margin(1e-4));
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("Ambisonics.RotationDirections", "[Ambisonics]")
+{
+    AmbisonicBus bus;
+    ambisonic_init(bus, AmbisonicMaxOrder, 256, 2);
+
+    // Positive yaw turns left
+    ambisonic_set_rotation(bus, 90.0f, 0.0f, 0.0f);
+    test_rotated_direction(bus, 0.0f, 0.0f, 90.0f, 0.0f);
+    test_rotated_direction(bus, 0.0f, 90.0f, 0.0f, 90.0f);
+
+    // Positive pitch tips the front down
+    ambisonic_set_rotation(bus, 0.0f, 30.0f, 0.0f);
+    test_rotated_direction(bus, 0.0f, 0.0f, 0.0f, -30.0f);
+
+    // Positive roll lifts the left side
+    ambisonic_set_rotation(bus, 0.0f, 0.0f, 40.0f);
+    test_rotated_direction(bus, 90.0f, 0.0f, 90.0f, 40.0f);
+}
+
+TEST_CASE("Ambisonics.EncodeDecodeStereo", "[Ambisonics]")
+{
+    constexpr uint32_t Frames = 64;
+    AmbisonicBus bus;
+    ambisonic_init(bus, 1, Frames, 2);
+    ambisonic_set_layout(bus, ambisonic_default_layout(2));
+
+    std::vector<float> input(Frames, 1.0f);
+    AmbisonicSource source;
+    source.pInput = input.data();
+    source.azimuth = 90.0f;
+
+    std::vector<float> output(Frames * 2, 0.0f);
+    ambisonic_clear(bus, Frames);
+    ambisonic_encode(bus, &source, 1, Frames);
+    ambisonic_decode(bus, output.data(), 2, Frames);
+
+    // Hard left comes out of the left speaker
+    for (uint32_t frame = 0; frame < Frames; frame++)
+    {
+        REQUIRE(output[frame * 2] > 0.0f);
+        REQUIRE(output[frame * 2] > output[frame * 2 + 1]);
+    }
+}
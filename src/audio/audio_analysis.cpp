@@ -1,6 +1,7 @@
 #include <algorithm>
 #include <complex>
 #include <cstdint>
+#include <mutex>
 #include <vector>
 
 #include <glm/gtc/constants.hpp>
@@ -50,6 +51,10 @@ void audio_analysis_create_all()
 {
     auto& ctx = Zing::GetAudioContext();
 
+    // The built in feature stages, the first time only, so stages removed since stay removed
+    static std::once_flag builtinStages;
+    std::call_once(builtinStages, audio_analysis_add_builtin_stages);
+
     // Initialize the analysis
     for (uint32_t channel = 0; channel < ctx.inputState.channelCount; channel++)
     {
@@ -57,6 +62,22 @@ void audio_analysis_create_all()
         auto id = audio_to_channel_id(Channel_In, channel);
         ctx.analysisChannels[id] = pAnalysis;
         pAnalysis->thisChannel = id;
+
+        if (ctx.audioAnalysisSettings.archiveEnabled)
+        {
+            auto folder = ctx.audioAnalysisSettings.archivePath.empty() ? fs::temp_directory_path() / "zing" : fs::path(ctx.audioAnalysisSettings.archivePath);
+
+            SpectrogramSettings archiveSettings;
+            archiveSettings.bins = ctx.audioAnalysisSettings.waterfallBins;
+            archiveSettings.rowSeconds = ctx.audioAnalysisSettings.archiveRowSeconds;
+
+            pAnalysis->spArchive = std::make_shared<SpectrogramArchive>();
+            if (!spectrogram_start(*pAnalysis->spArchive, folder / fmt::format("spectrogram_in{}.zspg", channel), archiveSettings, ctx.inputState.sampleRate))
+            {
+                pAnalysis->spArchive.reset();
+            }
+        }
+
         audio_analysis_start(*pAnalysis, ctx.inputState);
     }
 
@@ -77,6 +98,11 @@ void audio_analysis_destroy_all()
     for (auto& [name, analysis] : ctx.analysisChannels)
     {
         audio_analysis_stop(*analysis);
+        if (analysis->spArchive)
+        {
+            spectrogram_stop(*analysis->spArchive);
+            analysis->spArchive.reset();
+        }
         if (analysis->cfg)
         {
             kiss_fftr_free(analysis->cfg);
@@ -105,6 +131,10 @@ bool audio_analysis_start(AudioAnalysis& analysis, const AudioChannelState& stat
     analysis.exited = false;
     analysis.quitThread = false;
     analysis.analysisThread = std::move(std::thread([=]() {
+        const auto threadName = fmt::format("Analysis: {}", audio_to_channel_name(pAnalysis->thisChannel));
+        Zest::Profiler::NameThread(threadName.c_str());
+        trace_name_thread(threadName.c_str());
+
         const auto wakeUpDelta = std::chrono::milliseconds(1);
         for (;;)
         {
@@ -117,9 +147,6 @@ bool audio_analysis_start(AudioAnalysis& analysis, const AudioChannelState& stat
             std::shared_ptr<AudioBundle> spData;
             if (!pAnalysis->processBundles.try_dequeue(spData))
             {
-#ifdef DEBUG
-                Zest::Profiler::NameThread(fmt::format("Analysis: {}", audio_to_channel_name(pAnalysis->thisChannel)).c_str());
-#endif
                 // Sleep
                 std::this_thread::sleep_for(wakeUpDelta);
                 continue;
@@ -192,7 +219,7 @@ bool audio_analysis_init(AudioAnalysis& analysis, AudioAnalysisData& analysisDat
 // On thread; update
 void audio_analysis_update(AudioAnalysis& analysis, AudioBundle& bundle)
 {
-    PROFILE_SCOPE(Audio_Analysis);
+    TRACE_SCOPE(Audio_Analysis);
     auto& ctx = GetAudioContext();
 
     auto frameOffset = 0; // ctx.audioAnalysisSettings.removeFFTJitter ? (uint32_t)-_lastPeakHarmonic & ~0x1 : 0;
@@ -252,7 +279,7 @@ void audio_analysis_update(AudioAnalysis& analysis, AudioBundle& bundle)
     //   https://github.com/beautypi/shadertoy-iOS-v2/blob/master/shadertoy/SoundStreamHelper.m
     {
         {
-            PROFILE_SCOPE(FFT);
+            TRACE_SCOPE(FFT);
             for (uint32_t i = 0; i < ctx.audioAnalysisSettings.frames; i++)
             {
                 // Hamming window, FF
@@ -285,6 +312,29 @@ void audio_analysis_update(AudioAnalysis& analysis, AudioBundle& bundle)
         }
 
         audio_analysis_calculate_spectrum(analysis, analysisData);
+
+        // The frame slides on by one bundle each update
+        const auto hopSeconds = double(floatsToAdd) * analysis.channel.deltaTime;
+
+        audio_analysis_run_stages(analysis, analysisData, hopSeconds);
+
+        if (ctx.audioAnalysisSettings.waterfallEnabled)
+        {
+            TRACE_SCOPE(Waterfall);
+            std::lock_guard<std::mutex> lock(analysis.waterfallMutex);
+            auto& wf = analysis.waterfall;
+            const auto bins = int(std::min(ctx.audioAnalysisSettings.waterfallBins, analysis.outputSamples));
+            if (wf.bins != bins)
+            {
+                Waterfall_Init(wf, bins, wf.rows);
+            }
+            Waterfall_AccumulatePower(wf, analysis.fftMag.data(), int(analysis.outputSamples));
+        }
+
+        if (analysis.spArchive)
+        {
+            spectrogram_push(*analysis.spArchive, analysis.fftMag.data(), analysis.outputSamples, hopSeconds);
+        }
     }
 
     // Send it
@@ -295,7 +345,7 @@ void audio_analysis_update(AudioAnalysis& analysis, AudioBundle& bundle)
 
 void audio_analysis_calculate_audio(AudioAnalysis& analysis, AudioAnalysisData& analysisData)
 {
-    PROFILE_SCOPE(Audio);
+    TRACE_SCOPE(Audio);
     auto& ctx = GetAudioContext();
 
     // TODO: This can't be right?
@@ -339,7 +389,7 @@ void audio_analysis_calculate_audio(AudioAnalysis& analysis, AudioAnalysisData&
 
 void audio_analysis_calculate_spectrum(AudioAnalysis& analysis, AudioAnalysisData& analysisData)
 {
-    PROFILE_SCOPE(Spectrum);
+    TRACE_SCOPE(Spectrum);
     auto& ctx = GetAudioContext();
 
     float minSpec = std::numeric_limits<float>::max();
@@ -491,7 +541,7 @@ void audio_analysis_calculate_spectrum(AudioAnalysis& analysis, AudioAnalysisDat
 // For example, vec4.x might end up containing 0->500Hz, vec4.y might be 500-1000Hz, etc.
 void audio_analysis_calculate_spectrum_bands(AudioAnalysis& analysis, AudioAnalysisData& analysisData)
 {
-    PROFILE_SCOPE(Bands);
+    TRACE_SCOPE(Bands);
     auto& ctx = GetAudioContext();
 
     auto blendFactor = 1.0f;
@@ -0,0 +1,625 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio.h>
+#include <zing/audio/audio_analysis.h>
+#include <zing/audio/audio_analysis_stages.h>
+#include <zing/audio/audio_onset.h>
+#include <zing/audio/audio_pitch.h>
+
+namespace Zing
+{
+
+namespace
+{
+
+// Distinguishes one build of a pipeline from the next, so the published layout is only copied on change
+std::atomic<uint32_t> pipelineBuilds = 1;
+
+float stage_bin_frequency(const AnalysisFrame& frame, uint32_t bin)
+{
+    return float(bin) * float(frame.sampleRate) / float(frame.frames);
+}
+
+float stage_mel(float frequency)
+{
+    return 2595.0f * std::log10(1.0f + frequency / 700.0f);
+}
+
+float stage_mel_to_frequency(float mel)
+{
+    return 700.0f * (std::pow(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+AnalysisStageInfo stage_rms()
+{
+    AnalysisStageInfo info;
+    info.name = "rms";
+    info.inputs = AnalysisInput_Time;
+    info.fnCreate = [](uint32_t, uint32_t) -> fnAnalysisStage {
+        return [](const AnalysisFrame& frame, float* pOut) {
+            double sum = 0.0;
+            for (uint32_t i = 0; i < frame.frames; i++)
+            {
+                sum += double(frame.pTime[i]) * frame.pTime[i];
+            }
+            pOut[0] = float(std::sqrt(sum / frame.frames));
+        };
+    };
+    return info;
+}
+
+// Magnitude weighted mean frequency, in Hz
+AnalysisStageInfo stage_centroid()
+{
+    AnalysisStageInfo info;
+    info.name = "centroid";
+    info.inputs = AnalysisInput_Magnitude;
+    info.fnCreate = [](uint32_t, uint32_t) -> fnAnalysisStage {
+        return [](const AnalysisFrame& frame, float* pOut) {
+            double weighted = 0.0;
+            double total = 0.0;
+            for (uint32_t bin = 1; bin < frame.bins; bin++)
+            {
+                weighted += double(frame.pMagnitude[bin]) * bin;
+                total += frame.pMagnitude[bin];
+            }
+            pOut[0] = total > 1e-12 ? float(weighted / total) * stage_bin_frequency(frame, 1) : 0.0f;
+        };
+    };
+    return info;
+}
+
+// Frequency under which 85% of the energy lies, in Hz
+AnalysisStageInfo stage_rolloff()
+{
+    AnalysisStageInfo info;
+    info.name = "rolloff";
+    info.inputs = AnalysisInput_Power;
+    info.fnCreate = [](uint32_t, uint32_t) -> fnAnalysisStage {
+        return [](const AnalysisFrame& frame, float* pOut) {
+            double total = 0.0;
+            for (uint32_t bin = 1; bin < frame.bins; bin++)
+            {
+                total += frame.pPower[bin];
+            }
+
+            pOut[0] = 0.0f;
+            if (total <= 1e-20)
+            {
+                return;
+            }
+
+            double sum = 0.0;
+            for (uint32_t bin = 1; bin < frame.bins; bin++)
+            {
+                sum += frame.pPower[bin];
+                if (sum >= total * 0.85)
+                {
+                    pOut[0] = stage_bin_frequency(frame, bin);
+                    break;
+                }
+            }
+        };
+    };
+    return info;
+}
+
+// Geometric over arithmetic mean of the power; near 1 for noise, near 0 for tones
+AnalysisStageInfo stage_flatness()
+{
+    AnalysisStageInfo info;
+    info.name = "flatness";
+    info.inputs = AnalysisInput_Power;
+    info.fnCreate = [](uint32_t, uint32_t) -> fnAnalysisStage {
+        return [](const AnalysisFrame& frame, float* pOut) {
+            double logSum = 0.0;
+            double sum = 0.0;
+            for (uint32_t bin = 1; bin < frame.bins; bin++)
+            {
+                const double power = double(frame.pPower[bin]) + 1e-20;
+                logSum += std::log(power);
+                sum += power;
+            }
+
+            const auto count = double(frame.bins - 1);
+            const auto mean = sum / count;
+            pOut[0] = mean > 1e-18 ? float(std::exp(logSum / count) / mean) : 0.0f;
+        };
+    };
+    return info;
+}
+
+// Energy per pitch class, C first, scaled so the largest is 1
+AnalysisStageInfo stage_chroma()
+{
+    AnalysisStageInfo info;
+    info.name = "chroma";
+    info.inputs = AnalysisInput_Power;
+    info.size = 12;
+    info.fnCreate = [](uint32_t frames, uint32_t sampleRate) -> fnAnalysisStage {
+        // Pitch class of each bin, -1 outside the musical range
+        std::vector<int> classes(frames / 2 + 1, -1);
+        for (uint32_t bin = 1; bin < classes.size(); bin++)
+        {
+            const auto frequency = float(bin) * float(sampleRate) / float(frames);
+            if (frequency >= 27.5f && frequency <= 5000.0f)
+            {
+                const auto note = int(std::lround(12.0f * std::log2(frequency / 440.0f))) + 9;
+                classes[bin] = ((note % 12) + 12) % 12;
+            }
+        }
+
+        return [classes](const AnalysisFrame& frame, float* pOut) {
+            std::fill(pOut, pOut + 12, 0.0f);
+            for (uint32_t bin = 1; bin < frame.bins; bin++)
+            {
+                if (classes[bin] >= 0)
+                {
+                    pOut[classes[bin]] += frame.pPower[bin];
+                }
+            }
+
+            const auto peak = *std::max_element(pOut, pOut + 12);
+            if (peak > 1e-20f)
+            {
+                for (uint32_t i = 0; i < 12; i++)
+                {
+                    pOut[i] /= peak;
+                }
+            }
+        };
+    };
+    return info;
+}
+
+// Log energies of 40 triangular mel bands, 20Hz to 16kHz
+AnalysisStageInfo stage_mel_bands()
+{
+    constexpr uint32_t Bands = 40;
+
+    AnalysisStageInfo info;
+    info.name = "mel";
+    info.inputs = AnalysisInput_Power;
+    info.size = Bands;
+    info.fnCreate = [](uint32_t frames, uint32_t sampleRate) -> fnAnalysisStage {
+        struct Band
+        {
+            uint32_t firstBin = 0;
+            std::vector<float> weights;
+        };
+
+        const auto bins = frames / 2 + 1;
+        const auto binWidth = float(sampleRate) / float(frames);
+        const auto low = stage_mel(20.0f);
+        const auto high = stage_mel(std::min(16000.0f, sampleRate * 0.5f));
+
+        std::vector<Band> bands(Bands);
+        for (uint32_t band = 0; band < Bands; band++)
+        {
+            const auto left = stage_mel_to_frequency(low + (high - low) * band / (Bands + 1));
+            const auto centre = stage_mel_to_frequency(low + (high - low) * (band + 1) / (Bands + 1));
+            const auto right = stage_mel_to_frequency(low + (high - low) * (band + 2) / (Bands + 1));
+
+            auto& b = bands[band];
+            b.firstBin = std::min(bins - 1, uint32_t(std::ceil(left / binWidth)));
+            for (uint32_t bin = b.firstBin; bin < bins && bin * binWidth < right; bin++)
+            {
+                const auto frequency = bin * binWidth;
+                const auto weight = frequency < centre ? (frequency - left) / (centre - left) : (right - frequency) / (right - centre);
+                b.weights.push_back(std::max(weight, 0.0f));
+            }
+        }
+
+        return [bands](const AnalysisFrame& frame, float* pOut) {
+            for (uint32_t band = 0; band < Bands; band++)
+            {
+                const auto& b = bands[band];
+                float energy = 0.0f;
+                for (uint32_t i = 0; i < b.weights.size(); i++)
+                {
+                    energy += b.weights[i] * frame.pPower[b.firstBin + i];
+                }
+                pOut[band] = std::log10(energy + 1e-10f);
+            }
+        };
+    };
+    return info;
+}
+
+// The first 13 cepstral coefficients of the mel bands (orthonormal DCT-II)
+AnalysisStageInfo stage_mfcc()
+{
+    constexpr uint32_t Coefficients = 13;
+
+    AnalysisStageInfo info;
+    info.name = "mfcc";
+    info.size = Coefficients;
+    info.after = { "mel" };
+    info.fnCreate = [](uint32_t, uint32_t) -> fnAnalysisStage {
+        auto spBasis = std::make_shared<std::vector<float>>();
+        return [spBasis](const AnalysisFrame& frame, float* pOut) {
+            uint32_t bands = 0;
+            auto pMel = audio_analysis_frame_feature(frame, "mel", &bands);
+            if (!pMel || bands == 0)
+            {
+                std::fill(pOut, pOut + Coefficients, 0.0f);
+                return;
+            }
+
+            auto& basis = *spBasis;
+            if (basis.size() != size_t(bands) * Coefficients)
+            {
+                basis.resize(size_t(bands) * Coefficients);
+                for (uint32_t k = 0; k < Coefficients; k++)
+                {
+                    const auto scale = std::sqrt((k == 0 ? 1.0f : 2.0f) / float(bands));
+                    for (uint32_t n = 0; n < bands; n++)
+                    {
+                        basis[k * bands + n] = scale * std::cos(glm::pi<float>() * k * (n + 0.5f) / float(bands));
+                    }
+                }
+            }
+
+            for (uint32_t k = 0; k < Coefficients; k++)
+            {
+                float sum = 0.0f;
+                for (uint32_t n = 0; n < bands; n++)
+                {
+                    sum += basis[k * bands + n] * pMel[n];
+                }
+                pOut[k] = sum;
+            }
+        };
+    };
+    return info;
+}
+
+// 12th order linear prediction of the windowed frame (Levinson-Durbin): a1..a12, then the residual
+// energy as a fraction of the frame's
+AnalysisStageInfo stage_lpc()
+{
+    constexpr uint32_t Order = 12;
+
+    AnalysisStageInfo info;
+    info.name = "lpc";
+    info.inputs = AnalysisInput_Windowed;
+    info.size = Order + 1;
+    info.fnCreate = [](uint32_t, uint32_t) -> fnAnalysisStage {
+        return [](const AnalysisFrame& frame, float* pOut) {
+            double r[Order + 1];
+            for (uint32_t lag = 0; lag <= Order; lag++)
+            {
+                double sum = 0.0;
+                for (uint32_t i = lag; i < frame.frames; i++)
+                {
+                    sum += double(frame.pWindowed[i]) * frame.pWindowed[i - lag];
+                }
+                r[lag] = sum;
+            }
+
+            std::fill(pOut, pOut + Order + 1, 0.0f);
+            if (r[0] <= 1e-12)
+            {
+                return;
+            }
+
+            // Slight lag window against ill conditioning
+            r[0] *= 1.0 + 1e-9;
+
+            double a[Order + 1] = { 1.0 };
+            double error = r[0];
+            for (uint32_t i = 1; i <= Order; i++)
+            {
+                double acc = r[i];
+                for (uint32_t j = 1; j < i; j++)
+                {
+                    acc += a[j] * r[i - j];
+                }
+                const auto k = -acc / error;
+
+                double previous[Order + 1];
+                std::copy(a, a + Order + 1, previous);
+                for (uint32_t j = 1; j < i; j++)
+                {
+                    a[j] = previous[j] + k * previous[i - j];
+                }
+                a[i] = k;
+                error *= 1.0 - k * k;
+            }
+
+            for (uint32_t i = 1; i <= Order; i++)
+            {
+                pOut[i - 1] = float(a[i]);
+            }
+            pOut[Order] = float(error / r[0]);
+        };
+    };
+    return info;
+}
+
+// YIN pitch from the power spectrum: frequency in Hz (0 when unpitched), then confidence
+AnalysisStageInfo stage_pitch()
+{
+    AnalysisStageInfo info;
+    info.name = "pitch";
+    info.inputs = AnalysisInput_Power;
+    info.size = 2;
+    info.fnCreate = [](uint32_t, uint32_t) -> fnAnalysisStage {
+        auto spTracker = std::shared_ptr<PitchTracker>(new PitchTracker, [](PitchTracker* pTracker) {
+            pitch_tracker_destroy(*pTracker);
+            delete pTracker;
+        });
+        return [spTracker](const AnalysisFrame& frame, float* pOut) {
+            const auto& settings = GetAudioContext().audioAnalysisSettings;
+
+            AudioPitch pitch;
+            if (settings.pitchEnabled && frame.active && frame.pWindow)
+            {
+                // Set up on the first frame, as the tracker undoes the window the frame was shaped with
+                if (spTracker->frames != frame.frames)
+                {
+                    pitch_tracker_init(*spTracker, frame.pWindow, frame.frames);
+                }
+                pitch = pitch_tracker_update(*spTracker, frame.pPower, frame.sampleRate, settings.pitchMinFrequency, settings.pitchMaxFrequency, settings.pitchThreshold);
+            }
+            pOut[0] = pitch.frequency;
+            pOut[1] = pitch.confidence;
+        };
+    };
+    return info;
+}
+
+// Spectral flux onsets and tempo: 1 if an onset peaked last frame, the flux, BPM (0 until found), then
+// tempo confidence
+AnalysisStageInfo stage_onset()
+{
+    AnalysisStageInfo info;
+    info.name = "onset";
+    info.inputs = AnalysisInput_Power;
+    info.size = 4;
+    info.fnCreate = [](uint32_t, uint32_t) -> fnAnalysisStage {
+        auto spDetector = std::make_shared<OnsetDetector>();
+        return [spDetector](const AnalysisFrame& frame, float* pOut) {
+            const auto& settings = GetAudioContext().audioAnalysisSettings;
+
+            AudioOnset onset;
+            if (settings.onsetEnabled)
+            {
+                OnsetSettings onsetSettings;
+                onsetSettings.sensitivity = settings.onsetSensitivity;
+                onsetSettings.minBpm = settings.tempoMinBpm;
+                onsetSettings.maxBpm = settings.tempoMaxBpm;
+                onset = onset_detector_update(*spDetector, frame.pPower, frame.bins, frame.hopSeconds, onsetSettings);
+            }
+            pOut[0] = onset.onset ? 1.0f : 0.0f;
+            pOut[1] = onset.flux;
+            pOut[2] = onset.bpm;
+            pOut[3] = onset.tempoConfidence;
+        };
+    };
+    return info;
+}
+
+void analysis_pipeline_build(AnalysisPipeline& pipeline, uint32_t generation, uint32_t frames, uint32_t sampleRate)
+{
+    auto& registry = GetAudioContext().analysisStages;
+
+    pipeline.generation = generation;
+    pipeline.frames = frames;
+    pipeline.sampleRate = sampleRate;
+    pipeline.inputs = 0;
+    pipeline.stages.clear();
+    pipeline.features.clear();
+    pipeline.featureFloats = 0;
+
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto pInfo : audio_analysis_stage_order(registry.stages))
+    {
+        auto fnProcess = pInfo->fnCreate ? pInfo->fnCreate(frames, sampleRate) : fnAnalysisStage{};
+        if (!fnProcess || pInfo->size == 0)
+        {
+            continue;
+        }
+
+        pipeline.stages.push_back(AnalysisPipeline::Stage{ fnProcess, pipeline.featureFloats });
+        pipeline.features.push_back(AnalysisFeature{ pInfo->name, pipeline.featureFloats, pInfo->size });
+        pipeline.featureFloats += pInfo->size;
+        pipeline.inputs |= pInfo->inputs;
+    }
+    pipeline.layout = pipelineBuilds++;
+}
+
+} // namespace
+
+// Stable order: each stage goes after the stages it reads, otherwise in the order they were added
+std::vector<const AnalysisStageInfo*> audio_analysis_stage_order(const std::vector<AnalysisStageInfo>& stages)
+{
+    auto exists = [&](const std::string& name) {
+        return std::any_of(stages.begin(), stages.end(), [&](const AnalysisStageInfo& info) {
+            return info.name == name;
+        });
+    };
+
+    std::vector<const AnalysisStageInfo*> order;
+    std::vector<bool> placed(stages.size(), false);
+    while (order.size() < stages.size())
+    {
+        bool progress = false;
+        for (size_t i = 0; i < stages.size(); i++)
+        {
+            if (placed[i])
+            {
+                continue;
+            }
+
+            const bool ready = std::all_of(stages[i].after.begin(), stages[i].after.end(), [&](const std::string& name) {
+                return !exists(name) || std::any_of(order.begin(), order.end(), [&](const AnalysisStageInfo* pInfo) {
+                    return pInfo->name == name;
+                });
+            });
+            if (ready)
+            {
+                order.push_back(&stages[i]);
+                placed[i] = true;
+                progress = true;
+            }
+        }
+
+        if (!progress)
+        {
+            // A cycle; run the rest as they were added
+            for (size_t i = 0; i < stages.size(); i++)
+            {
+                if (!placed[i])
+                {
+                    LOG(ERR, "Analysis stage '" << stages[i].name << "' is in a dependency cycle");
+                    order.push_back(&stages[i]);
+                    placed[i] = true;
+                }
+            }
+        }
+    }
+    return order;
+}
+
+void audio_analysis_add_stage(const AnalysisStageInfo& info)
+{
+    auto& registry = GetAudioContext().analysisStages;
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    auto itr = std::find_if(registry.stages.begin(), registry.stages.end(), [&](const AnalysisStageInfo& stage) {
+        return stage.name == info.name;
+    });
+    if (itr != registry.stages.end())
+    {
+        *itr = info;
+    }
+    else
+    {
+        registry.stages.push_back(info);
+    }
+    registry.generation++;
+}
+
+void audio_analysis_remove_stage(const std::string& name)
+{
+    auto& registry = GetAudioContext().analysisStages;
+    std::lock_guard<std::mutex> lock(registry.mutex);
+
+    registry.stages.erase(std::remove_if(registry.stages.begin(), registry.stages.end(), [&](const AnalysisStageInfo& stage) {
+        return stage.name == name;
+    }), registry.stages.end());
+    registry.generation++;
+}
+
+std::vector<AnalysisStageInfo> audio_analysis_builtin_stages()
+{
+    return { stage_rms(), stage_centroid(), stage_rolloff(), stage_flatness(), stage_chroma(), stage_mel_bands(), stage_mfcc(), stage_lpc(), stage_pitch(), stage_onset() };
+}
+
+void audio_analysis_add_builtin_stages()
+{
+    for (auto& info : audio_analysis_builtin_stages())
+    {
+        audio_analysis_add_stage(info);
+    }
+}
+
+const float* audio_analysis_find_feature(const std::vector<AnalysisFeature>& features, const float* pData, const std::string& name, uint32_t* pSize)
+{
+    for (auto& feature : features)
+    {
+        if (feature.name == name)
+        {
+            if (pSize)
+            {
+                *pSize = feature.size;
+            }
+            return pData + feature.offset;
+        }
+    }
+    return nullptr;
+}
+
+const float* audio_analysis_frame_feature(const AnalysisFrame& frame, const std::string& name, uint32_t* pSize)
+{
+    if (!frame.pFeatures)
+    {
+        return nullptr;
+    }
+    return audio_analysis_find_feature(*frame.pFeatures, frame.pFeatureData, name, pSize);
+}
+
+const float* audio_analysis_feature(const AudioAnalysisData& data, const std::string& name, uint32_t* pSize)
+{
+    return audio_analysis_find_feature(data.features, data.featureData.data(), name, pSize);
+}
+
+void audio_analysis_run_stages(AudioAnalysis& analysis, AudioAnalysisData& analysisData, double hopSeconds)
+{
+    TRACE_SCOPE(Analysis_Stages);
+
+    auto& ctx = GetAudioContext();
+    auto& pipeline = analysis.pipeline;
+    const auto frames = uint32_t(analysis.fftIn.size());
+
+    const auto generation = ctx.analysisStages.generation.load(std::memory_order_acquire);
+    if (pipeline.generation != generation || pipeline.frames != frames || pipeline.sampleRate != analysis.channel.sampleRate)
+    {
+        analysis_pipeline_build(pipeline, generation, frames, analysis.channel.sampleRate);
+    }
+
+    if (analysisData.featureLayout != pipeline.layout)
+    {
+        analysisData.features = pipeline.features;
+        analysisData.featureData.assign(pipeline.featureFloats, 0.0f);
+        analysisData.featureLayout = pipeline.layout;
+    }
+
+    if (pipeline.stages.empty())
+    {
+        return;
+    }
+
+    // The shared inputs, each worked out once
+    const auto bins = analysis.outputSamples;
+    AnalysisFrame frame;
+    frame.frames = frames;
+    frame.bins = bins;
+    frame.sampleRate = analysis.channel.sampleRate;
+    frame.hopSeconds = hopSeconds;
+    frame.active = analysis.audioActive;
+    frame.pTime = analysisData.audio.data();
+    frame.pWindowed = analysis.fftIn.data();
+    frame.pWindow = analysis.window.data();
+    frame.pPower = analysis.fftMag.data();
+
+    if (pipeline.inputs & AnalysisInput_Magnitude)
+    {
+        pipeline.magnitude.resize(bins);
+        for (uint32_t bin = 0; bin < bins; bin++)
+        {
+            pipeline.magnitude[bin] = std::sqrt(analysis.fftMag[bin]);
+        }
+        frame.pMagnitude = pipeline.magnitude.data();
+    }
+
+    if (pipeline.inputs & AnalysisInput_Phase)
+    {
+        pipeline.phase.resize(bins);
+        for (uint32_t bin = 0; bin < bins; bin++)
+        {
+            pipeline.phase[bin] = std::atan2(analysis.fftOut[bin].i, analysis.fftOut[bin].r);
+        }
+        frame.pPhase = pipeline.phase.data();
+    }
+
+    frame.pFeatures = &pipeline.features;
+    frame.pFeatureData = analysisData.featureData.data();
+    for (auto& stage : pipeline.stages)
+    {
+        stage.fnProcess(frame, analysisData.featureData.data() + stage.offset);
+    }
+}
+
+} // namespace Zing
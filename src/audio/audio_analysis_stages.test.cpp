@@ -0,0 +1,234 @@
+#include <zing/pch.h>
+
+#include <kiss_fftr.h>
+
+#include <zing/audio/audio_analysis_stages.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+constexpr uint32_t TestFrames = 2048;
+constexpr uint32_t TestRate = 48000;
+
+AnalysisStageInfo test_stage(const std::string& name, std::vector<std::string> after = {})
+{
+    AnalysisStageInfo info;
+    info.name = name;
+    info.after = after;
+    return info;
+}
+
+std::vector<std::string> test_order_names(const std::vector<AnalysisStageInfo>& stages)
+{
+    std::vector<std::string> names;
+    for (auto pInfo : audio_analysis_stage_order(stages))
+    {
+        names.push_back(pInfo->name);
+    }
+    return names;
+}
+
+// A frame as the analysis builds it, run through the stages as a pipeline would run them
+struct TestFrame
+{
+    explicit TestFrame(const std::vector<float>& signal)
+        : time(signal)
+    {
+        window.resize(TestFrames);
+        windowed.resize(TestFrames);
+        for (uint32_t i = 0; i < TestFrames; i++)
+        {
+            window[i] = 0.5f * (1.0f - std::cos(2.0f * glm::pi<float>() * i / float(TestFrames - 1)));
+            windowed[i] = time[i] * window[i];
+        }
+
+        std::vector<kiss_fft_cpx> out(TestFrames / 2 + 1);
+        auto forward = kiss_fftr_alloc(TestFrames, 0, nullptr, nullptr);
+        kiss_fftr(forward, windowed.data(), out.data());
+        kiss_fftr_free(forward);
+
+        for (auto& bin : out)
+        {
+            power.push_back(bin.r * bin.r + bin.i * bin.i);
+            magnitude.push_back(std::sqrt(power.back()));
+            phase.push_back(std::atan2(bin.i, bin.r));
+        }
+    }
+
+    void run(const std::vector<AnalysisStageInfo>& stages)
+    {
+        features.clear();
+        uint32_t floats = 0;
+        std::vector<std::pair<fnAnalysisStage, uint32_t>> processes;
+        for (auto pInfo : audio_analysis_stage_order(stages))
+        {
+            processes.emplace_back(pInfo->fnCreate(TestFrames, TestRate), floats);
+            features.push_back(AnalysisFeature{ pInfo->name, floats, pInfo->size });
+            floats += pInfo->size;
+        }
+        data.assign(floats, 0.0f);
+
+        AnalysisFrame frame;
+        frame.frames = TestFrames;
+        frame.bins = TestFrames / 2 + 1;
+        frame.sampleRate = TestRate;
+        frame.hopSeconds = 0.01;
+        frame.active = true;
+        frame.pTime = time.data();
+        frame.pWindowed = windowed.data();
+        frame.pWindow = window.data();
+        frame.pPower = power.data();
+        frame.pMagnitude = magnitude.data();
+        frame.pPhase = phase.data();
+        frame.pFeatures = &features;
+        frame.pFeatureData = data.data();
+        for (auto& [fnProcess, offset] : processes)
+        {
+            fnProcess(frame, data.data() + offset);
+        }
+    }
+
+    const float* feature(const std::string& name, uint32_t expectedSize) const
+    {
+        uint32_t size = 0;
+        auto pFeature = audio_analysis_find_feature(features, data.data(), name, &size);
+        REQUIRE(pFeature);
+        REQUIRE(size == expectedSize);
+        return pFeature;
+    }
+
+    std::vector<float> time;
+    std::vector<float> window;
+    std::vector<float> windowed;
+    std::vector<float> power;
+    std::vector<float> magnitude;
+    std::vector<float> phase;
+    std::vector<AnalysisFeature> features;
+    std::vector<float> data;
+};
+
+std::vector<float> test_sine(float frequency, float amplitude)
+{
+    std::vector<float> signal(TestFrames);
+    for (uint32_t i = 0; i < TestFrames; i++)
+    {
+        signal[i] = amplitude * std::sin(2.0f * glm::pi<float>() * frequency * i / float(TestRate));
+    }
+    return signal;
+}
+
+} // namespace
+
+TEST_CASE("AnalysisStages.Order", "[AnalysisStages]")
+{
+    // Each stage after the ones it reads, wherever it was added
+    std::vector<AnalysisStageInfo> stages = { test_stage("c", { "b" }), test_stage("b", { "a" }), test_stage("a"), test_stage("d") };
+    REQUIRE(test_order_names(stages) == std::vector<std::string>{ "a", "d", "b", "c" });
+
+    // Independent stages keep the order they were added in
+    stages = { test_stage("x"), test_stage("y"), test_stage("z") };
+    REQUIRE(test_order_names(stages) == std::vector<std::string>{ "x", "y", "z" });
+
+    // Reading a stage that isn't there doesn't hold a stage back
+    stages = { test_stage("late", { "missing" }), test_stage("early") };
+    REQUIRE(test_order_names(stages) == std::vector<std::string>{ "late", "early" });
+
+    // Several inputs: after all of them
+    stages = { test_stage("mix", { "p", "q" }), test_stage("q", { "p" }), test_stage("p") };
+    REQUIRE(test_order_names(stages) == std::vector<std::string>{ "p", "q", "mix" });
+}
+
+TEST_CASE("AnalysisStages.Cycle", "[AnalysisStages]")
+{
+    // A cycle can't be ordered; every stage still runs, the cycle in the order it was added
+    std::vector<AnalysisStageInfo> stages = { test_stage("a", { "b" }), test_stage("b", { "a" }), test_stage("c") };
+    REQUIRE(test_order_names(stages) == std::vector<std::string>{ "c", "a", "b" });
+}
+
+TEST_CASE("AnalysisStages.FindFeature", "[AnalysisStages]")
+{
+    std::vector<AnalysisFeature> features = { { "one", 0, 1 }, { "three", 1, 3 } };
+    std::vector<float> data = { 1.0f, 2.0f, 3.0f, 4.0f };
+
+    uint32_t size = 0;
+    REQUIRE(audio_analysis_find_feature(features, data.data(), "three", &size) == data.data() + 1);
+    REQUIRE(size == 3);
+    REQUIRE(audio_analysis_find_feature(features, data.data(), "one") == data.data());
+    REQUIRE(audio_analysis_find_feature(features, data.data(), "two") == nullptr);
+
+    // A stage only sees features once there is a frame to read them from
+    AnalysisFrame frame;
+    REQUIRE(audio_analysis_frame_feature(frame, "one") == nullptr);
+    frame.pFeatures = &features;
+    frame.pFeatureData = data.data();
+    REQUIRE(audio_analysis_frame_feature(frame, "three") == data.data() + 1);
+}
+
+TEST_CASE("AnalysisStages.BuiltinSine", "[AnalysisStages]")
+{
+    const auto builtins = audio_analysis_builtin_stages();
+    auto names = test_order_names(builtins);
+    auto mel = std::find(names.begin(), names.end(), "mel");
+    auto mfcc = std::find(names.begin(), names.end(), "mfcc");
+    REQUIRE(mel < mfcc);
+
+    // On a bin centre, so nothing leaks past the window's main lobe
+    const auto frequency = 43.0f * float(TestRate) / float(TestFrames);
+    TestFrame frame(test_sine(frequency, 0.5f));
+    frame.run(builtins);
+
+    REQUIRE(frame.feature("rms", 1)[0] == Approx(0.5f / std::sqrt(2.0f)).epsilon(0.01));
+    REQUIRE(frame.feature("centroid", 1)[0] == Approx(frequency).epsilon(0.02));
+    REQUIRE(frame.feature("rolloff", 1)[0] == Approx(frequency).margin(2.0f * TestRate / TestFrames));
+    REQUIRE(frame.feature("flatness", 1)[0] < 0.01f);
+
+    // 1007Hz is nearest B
+    auto pChroma = frame.feature("chroma", 12);
+    REQUIRE(std::max_element(pChroma, pChroma + 12) - pChroma == 11);
+    REQUIRE(pChroma[11] == 1.0f);
+
+    // The cepstrum is of the mel bands published before it
+    auto pMel = frame.feature("mel", 40);
+    auto pMfcc = frame.feature("mfcc", 13);
+    float sum = 0.0f;
+    for (uint32_t band = 0; band < 40; band++)
+    {
+        sum += pMel[band];
+    }
+    REQUIRE(pMfcc[0] == Approx(sum / std::sqrt(40.0f)).epsilon(1e-4));
+
+    // A sine is all prediction, barely any residual
+    auto pLpc = frame.feature("lpc", 13);
+    REQUIRE(pLpc[12] < 0.01f);
+
+    // Pitch and onsets are stages like the rest
+    auto pPitch = frame.feature("pitch", 2);
+    REQUIRE(pPitch[0] == Approx(frequency).epsilon(0.01));
+    REQUIRE(pPitch[1] > 0.8f);
+
+    // A single frame has nothing to rise from, and no tempo yet
+    auto pOnset = frame.feature("onset", 4);
+    REQUIRE(pOnset[0] == 0.0f);
+    REQUIRE(pOnset[2] == 0.0f);
+}
+
+TEST_CASE("AnalysisStages.BuiltinSilence", "[AnalysisStages]")
+{
+    TestFrame frame(std::vector<float>(TestFrames, 0.0f));
+    frame.run(audio_analysis_builtin_stages());
+
+    REQUIRE(frame.feature("rms", 1)[0] == 0.0f);
+    REQUIRE(frame.feature("centroid", 1)[0] == 0.0f);
+    REQUIRE(frame.feature("rolloff", 1)[0] == 0.0f);
+    auto pLpc = frame.feature("lpc", 13);
+    for (uint32_t i = 0; i < 13; i++)
+    {
+        REQUIRE(pLpc[i] == 0.0f);
+    }
+    REQUIRE(frame.feature("pitch", 2)[0] == 0.0f);
+    REQUIRE(frame.feature("onset", 4)[1] == 0.0f);
+}
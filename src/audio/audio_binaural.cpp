@@ -0,0 +1,483 @@
+#include <zing/pch.h>
+
+#include <regex>
+
+#include <zing/audio/audio_binaural.h>
+
+#include <dr_wav.h>
+
+namespace Zing
+{
+
+namespace
+{
+
+constexpr uint32_t BinauralMaxNeighbours = 8;
+
+glm::vec3 binaural_direction(float azimuth, float elevation)
+{
+    const auto az = glm::radians(azimuth);
+    const auto el = glm::radians(elevation);
+    return glm::vec3(std::sin(az) * std::cos(el), std::sin(el), std::cos(az) * std::cos(el));
+}
+
+uint32_t binaural_bins(const BinauralRenderer& renderer)
+{
+    return renderer.settings.blockSize + 1;
+}
+
+// Partition the response and transform each piece; the inverse transform's scale is folded in
+void binaural_transform(BinauralRenderer& renderer, const std::vector<float>& response, std::vector<kiss_fft_cpx>& spectra)
+{
+    const auto blockSize = renderer.settings.blockSize;
+    const auto bins = binaural_bins(renderer);
+    const float scale = 1.0f / float(blockSize * 2);
+
+    spectra.resize(size_t(renderer.partitions) * bins);
+    std::vector<float> time(blockSize * 2);
+    for (uint32_t partition = 0; partition < renderer.partitions; partition++)
+    {
+        std::fill(time.begin(), time.end(), 0.0f);
+        for (uint32_t i = 0; i < blockSize; i++)
+        {
+            const auto index = size_t(partition) * blockSize + i;
+            if (index < response.size())
+            {
+                time[i] = response[index] * scale;
+            }
+        }
+        kiss_fftr(renderer.forward, time.data(), &spectra[size_t(partition) * bins]);
+    }
+}
+
+// Blend the nearest measured directions, weighted by how close they are
+void binaural_update_filter(BinauralRenderer& renderer, BinauralSource& source)
+{
+    source.directionChanged = false;
+
+    const auto bins = binaural_bins(renderer);
+    const auto count = size_t(renderer.partitions) * bins;
+    for (auto& filter : source.filter)
+    {
+        std::fill(filter.begin(), filter.end(), kiss_fft_cpx{ 0.0f, 0.0f });
+    }
+
+    if (renderer.hrirs.empty())
+    {
+        return;
+    }
+
+    const auto direction = binaural_direction(source.azimuth, source.elevation);
+    const auto neighbours = std::min(size_t(std::max(renderer.settings.neighbours, 1u)), renderer.hrirs.size());
+
+    struct Candidate
+    {
+        float angle;
+        uint32_t index;
+    };
+    Candidate nearest[BinauralMaxNeighbours];
+    const auto keep = uint32_t(std::min(neighbours, size_t(BinauralMaxNeighbours)));
+    uint32_t found = 0;
+    for (uint32_t index = 0; index < renderer.hrirs.size(); index++)
+    {
+        const auto angle = std::acos(std::clamp(glm::dot(direction, renderer.hrirs[index].direction), -1.0f, 1.0f));
+        if (found < keep)
+        {
+            nearest[found++] = Candidate{ angle, index };
+        }
+        else if (angle < nearest[keep - 1].angle)
+        {
+            nearest[keep - 1] = Candidate{ angle, index };
+        }
+        else
+        {
+            continue;
+        }
+
+        // Keep the short list sorted, nearest first
+        for (auto slot = found - 1; slot > 0 && nearest[slot].angle < nearest[slot - 1].angle; slot--)
+        {
+            std::swap(nearest[slot], nearest[slot - 1]);
+        }
+    }
+
+    float weights[BinauralMaxNeighbours];
+    float total = 0.0f;
+    for (uint32_t i = 0; i < found; i++)
+    {
+        weights[i] = 1.0f / (nearest[i].angle + 1e-3f);
+        total += weights[i];
+    }
+
+    for (uint32_t i = 0; i < found; i++)
+    {
+        const auto weight = source.gain * weights[i] / total;
+        auto& hrir = renderer.hrirs[nearest[i].index];
+        for (uint32_t ear = 0; ear < 2; ear++)
+        {
+            auto pFilter = source.filter[ear].data();
+            auto pHrir = hrir.spectra[ear].data();
+            for (size_t bin = 0; bin < count; bin++)
+            {
+                pFilter[bin].r += pHrir[bin].r * weight;
+                pFilter[bin].i += pHrir[bin].i * weight;
+            }
+        }
+    }
+}
+
+bool binaural_is_silent(const float* pInput, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (pInput[i] != 0.0f)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void binaural_block(BinauralRenderer& renderer)
+{
+    TRACE_SCOPE(binaural_block);
+
+    const auto blockSize = renderer.settings.blockSize;
+    const auto bins = binaural_bins(renderer);
+    const auto partitions = renderer.partitions;
+
+    for (auto& accumulate : renderer.accumulate)
+    {
+        std::fill(accumulate.begin(), accumulate.end(), kiss_fft_cpx{ 0.0f, 0.0f });
+    }
+
+    for (uint32_t index = 0; index < renderer.sources.size(); index++)
+    {
+        auto& source = renderer.sources[index];
+        if (!source.active)
+        {
+            continue;
+        }
+
+        // Once the delay line has emptied, a silent source costs nothing
+        const auto pInput = renderer.input.data() + size_t(index) * blockSize;
+        source.silentBlocks = binaural_is_silent(pInput, blockSize) ? source.silentBlocks + 1 : 0;
+        if (source.silentBlocks > partitions)
+        {
+            continue;
+        }
+
+        if (source.directionChanged)
+        {
+            binaural_update_filter(renderer, source);
+        }
+
+        // The one forward transform for this source
+        std::copy(source.window.begin() + blockSize, source.window.end(), source.window.begin());
+        std::copy(pInput, pInput + blockSize, source.window.begin() + blockSize);
+        kiss_fftr(renderer.forward, source.window.data(), &source.spectra[size_t(source.spectrumIndex) * bins]);
+
+        for (uint32_t ear = 0; ear < 2; ear++)
+        {
+            auto pAccumulate = renderer.accumulate[ear].data();
+            for (uint32_t partition = 0; partition < partitions; partition++)
+            {
+                const auto spectrum = (source.spectrumIndex + partitions - partition) % partitions;
+                const auto pX = &source.spectra[size_t(spectrum) * bins];
+                const auto pH = &source.filter[ear][size_t(partition) * bins];
+                for (uint32_t bin = 0; bin < bins; bin++)
+                {
+                    pAccumulate[bin].r += pX[bin].r * pH[bin].r - pX[bin].i * pH[bin].i;
+                    pAccumulate[bin].i += pX[bin].r * pH[bin].i + pX[bin].i * pH[bin].r;
+                }
+            }
+        }
+
+        source.spectrumIndex = (source.spectrumIndex + 1) % partitions;
+    }
+
+    // One inverse per ear; overlap save keeps the second half
+    for (uint32_t ear = 0; ear < 2; ear++)
+    {
+        kiss_fftri(renderer.inverse, renderer.accumulate[ear].data(), renderer.time.data());
+        for (uint32_t i = 0; i < blockSize; i++)
+        {
+            renderer.output[i * 2 + ear] = renderer.time[blockSize + i];
+        }
+    }
+}
+
+std::vector<float> binaural_resample(const float* pData, uint32_t length, uint32_t stride, uint32_t fromRate, uint32_t toRate, uint32_t maxLength)
+{
+    std::vector<float> result;
+    if (fromRate == toRate)
+    {
+        result.resize(std::min(length, maxLength));
+        for (uint32_t i = 0; i < result.size(); i++)
+        {
+            result[i] = pData[i * stride];
+        }
+        return result;
+    }
+
+    // Linear is enough for a few hundred taps of a smooth response
+    const double step = double(fromRate) / double(toRate);
+    const auto outLength = std::min(uint32_t(std::ceil(length / step)), maxLength);
+    result.resize(outLength);
+    for (uint32_t i = 0; i < outLength; i++)
+    {
+        const auto pos = i * step;
+        const auto index = uint32_t(pos);
+        const auto frac = float(pos - index);
+        const auto a = index < length ? pData[index * stride] : 0.0f;
+        const auto b = index + 1 < length ? pData[(index + 1) * stride] : 0.0f;
+        result[i] = a + (b - a) * frac;
+    }
+    return result;
+}
+
+} // namespace
+
+void binaural_init(BinauralRenderer& renderer, uint32_t sampleRate, const BinauralSettings& settings)
+{
+    binaural_destroy(renderer);
+
+    assert(settings.blockSize >= 2 && (settings.blockSize & (settings.blockSize - 1)) == 0);
+
+    renderer.settings = settings;
+    renderer.sampleRate = sampleRate;
+    renderer.partitions = std::max(1u, (settings.maxHrirLength + settings.blockSize - 1) / settings.blockSize);
+
+    const auto blockSize = settings.blockSize;
+    renderer.forward = kiss_fftr_alloc(int(blockSize * 2), 0, nullptr, nullptr);
+    renderer.inverse = kiss_fftr_alloc(int(blockSize * 2), 1, nullptr, nullptr);
+
+    const auto bins = binaural_bins(renderer);
+    const auto count = size_t(renderer.partitions) * bins;
+    renderer.sources.resize(settings.maxSources);
+    for (auto& source : renderer.sources)
+    {
+        source.filter[0].resize(count);
+        source.filter[1].resize(count);
+        source.spectra.resize(count);
+        source.window.resize(blockSize * 2);
+    }
+
+    renderer.input.resize(size_t(settings.maxSources) * blockSize, 0.0f);
+    renderer.output.resize(blockSize * 2, 0.0f);
+    renderer.fill = 0;
+    renderer.accumulate[0].resize(bins);
+    renderer.accumulate[1].resize(bins);
+    renderer.time.resize(blockSize * 2);
+}
+
+void binaural_destroy(BinauralRenderer& renderer)
+{
+    if (renderer.forward)
+    {
+        kiss_fftr_free(renderer.forward);
+        renderer.forward = nullptr;
+    }
+    if (renderer.inverse)
+    {
+        kiss_fftr_free(renderer.inverse);
+        renderer.inverse = nullptr;
+    }
+    renderer.hrirs.clear();
+    renderer.sources.clear();
+}
+
+void binaural_add_hrir(BinauralRenderer& renderer, float azimuth, float elevation, const float* pLeft, const float* pRight, uint32_t length, uint32_t sampleRate)
+{
+    auto& hrir = renderer.hrirs.emplace_back();
+    hrir.azimuth = azimuth;
+    hrir.elevation = elevation;
+    hrir.direction = binaural_direction(azimuth, elevation);
+
+    binaural_transform(renderer, binaural_resample(pLeft, length, 1, sampleRate, renderer.sampleRate, renderer.settings.maxHrirLength), hrir.spectra[0]);
+    binaural_transform(renderer, binaural_resample(pRight, length, 1, sampleRate, renderer.sampleRate, renderer.settings.maxHrirLength), hrir.spectra[1]);
+
+    // Existing sources may have a nearer neighbour now
+    for (auto& source : renderer.sources)
+    {
+        source.directionChanged = true;
+    }
+}
+
+uint32_t binaural_load_hrirs(BinauralRenderer& renderer, const fs::path& folder)
+{
+    struct Measured
+    {
+        std::vector<float> ears[2];
+        uint32_t sampleRate = 0;
+    };
+    std::map<std::pair<int, int>, Measured> measured;
+
+    const std::regex name(R"(([HLR])(-?\d+)e(\d+)a\.wav)", std::regex::icase);
+
+    std::error_code ec;
+    for (auto& entry : fs::recursive_directory_iterator(folder, ec))
+    {
+        std::smatch match;
+        const auto fileName = entry.path().filename().string();
+        if (!entry.is_regular_file() || !std::regex_match(fileName, match, name))
+        {
+            continue;
+        }
+
+        unsigned int channels = 0;
+        unsigned int sampleRate = 0;
+        drwav_uint64 frames = 0;
+        auto pData = drwav_open_file_and_read_pcm_frames_f32(entry.path().string().c_str(), &channels, &sampleRate, &frames);
+        if (!pData)
+        {
+            LOG(DBG, "Failed to read HRIR: " << entry.path().string());
+            continue;
+        }
+
+        auto& m = measured[std::make_pair(std::stoi(match[2].str()), std::stoi(match[3].str()))];
+        m.sampleRate = sampleRate;
+
+        const auto type = char(std::toupper(match[1].str()[0]));
+        for (uint32_t ear = 0; ear < 2; ear++)
+        {
+            if ((type == 'L' && ear == 1) || (type == 'R' && ear == 0))
+            {
+                continue;
+            }
+
+            // A stereo file holds both ears; a mono one holds the ear it is named for
+            const auto channel = type == 'H' ? std::min(ear, channels - 1) : 0;
+            auto& samples = m.ears[ear];
+            samples.resize(size_t(frames));
+            for (size_t i = 0; i < frames; i++)
+            {
+                samples[i] = pData[i * channels + channel];
+            }
+        }
+        drwav_free(pData);
+    }
+
+    int maxAzimuth = 0;
+    for (auto& [direction, m] : measured)
+    {
+        if (!m.ears[0].empty() && !m.ears[1].empty())
+        {
+            maxAzimuth = std::max(maxAzimuth, direction.second);
+        }
+    }
+
+    uint32_t loaded = 0;
+    for (auto& [direction, m] : measured)
+    {
+        auto& left = m.ears[0];
+        auto& right = m.ears[1];
+        if (left.empty() || right.empty() || left.size() != right.size())
+        {
+            continue;
+        }
+
+        const auto elevation = float(direction.first);
+        const auto azimuth = float(direction.second);
+        binaural_add_hrir(renderer, azimuth, elevation, left.data(), right.data(), uint32_t(left.size()), m.sampleRate);
+        loaded++;
+
+        // One sided sets assume a symmetric head
+        if (maxAzimuth <= 180 && direction.second > 0 && direction.second < 180)
+        {
+            binaural_add_hrir(renderer, 360.0f - azimuth, elevation, right.data(), left.data(), uint32_t(left.size()), m.sampleRate);
+            loaded++;
+        }
+    }
+
+    LOG(INFO, "Loaded " << loaded << " HRIR directions from " << folder.string());
+    return loaded;
+}
+
+int binaural_add_source(BinauralRenderer& renderer)
+{
+    for (uint32_t index = 0; index < renderer.sources.size(); index++)
+    {
+        auto& source = renderer.sources[index];
+        if (!source.active)
+        {
+            source.active = true;
+            source.gain = 1.0f;
+            source.azimuth = 0.0f;
+            source.elevation = 0.0f;
+            source.directionChanged = true;
+            source.spectrumIndex = 0;
+            source.silentBlocks = 0;
+            std::fill(source.window.begin(), source.window.end(), 0.0f);
+            std::fill(source.spectra.begin(), source.spectra.end(), kiss_fft_cpx{ 0.0f, 0.0f });
+            return int(index);
+        }
+    }
+    return -1;
+}
+
+void binaural_remove_source(BinauralRenderer& renderer, int source)
+{
+    if (source >= 0 && source < int(renderer.sources.size()))
+    {
+        renderer.sources[source].active = false;
+    }
+}
+
+void binaural_set_source(BinauralRenderer& renderer, int source, float azimuth, float elevation, float gain)
+{
+    if (source < 0 || source >= int(renderer.sources.size()))
+    {
+        return;
+    }
+
+    auto& s = renderer.sources[source];
+    if (s.azimuth != azimuth || s.elevation != elevation || s.gain != gain)
+    {
+        s.azimuth = azimuth;
+        s.elevation = elevation;
+        s.gain = gain;
+        s.directionChanged = true;
+    }
+}
+
+void binaural_process(BinauralRenderer& renderer, const float* const* ppInputs, float* pOut, uint32_t frames)
+{
+    const auto blockSize = renderer.settings.blockSize;
+
+    uint32_t frame = 0;
+    while (frame < frames)
+    {
+        const auto run = std::min(frames - frame, blockSize - renderer.fill);
+
+        for (uint32_t index = 0; index < renderer.sources.size(); index++)
+        {
+            if (!renderer.sources[index].active)
+            {
+                continue;
+            }
+
+            auto pInput = renderer.input.data() + size_t(index) * blockSize + renderer.fill;
+            if (ppInputs[index])
+            {
+                std::copy(ppInputs[index] + frame, ppInputs[index] + frame + run, pInput);
+            }
+            else
+            {
+                std::fill(pInput, pInput + run, 0.0f);
+            }
+        }
+
+        std::copy(renderer.output.begin() + renderer.fill * 2, renderer.output.begin() + (renderer.fill + run) * 2, pOut + frame * 2);
+
+        frame += run;
+        renderer.fill += run;
+        if (renderer.fill == blockSize)
+        {
+            binaural_block(renderer);
+            renderer.fill = 0;
+        }
+    }
+}
+
+} // namespace Zing
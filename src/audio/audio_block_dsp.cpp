@@ -0,0 +1,465 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_block_dsp.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define BLOCK_DSP_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Zing
+{
+
+namespace
+{
+
+constexpr double Root2 = 1.4142135623730950488;
+constexpr double Thermal = 0.000025; // transistor thermal voltage, as sp_moogladder
+constexpr uint32_t PhaserChunkFrames = 256;
+
+// 4 channels side by side; without SSE2 the same code runs on plain arrays
+#ifdef BLOCK_DSP_SSE2
+using Lanes = __m128;
+
+inline Lanes lanes_set(float v)
+{
+    return _mm_set1_ps(v);
+}
+inline Lanes lanes_add(Lanes a, Lanes b)
+{
+    return _mm_add_ps(a, b);
+}
+inline Lanes lanes_sub(Lanes a, Lanes b)
+{
+    return _mm_sub_ps(a, b);
+}
+inline Lanes lanes_mul(Lanes a, Lanes b)
+{
+    return _mm_mul_ps(a, b);
+}
+
+// Load/store the channels of one frame; fewer than 4 leaves the rest of the vector zero
+inline Lanes lanes_load(const float* p, uint32_t count)
+{
+    switch (count)
+    {
+    case 4:
+        return _mm_loadu_ps(p);
+    case 2:
+        return _mm_castpd_ps(_mm_load_sd((const double*)p));
+    case 1:
+        return _mm_load_ss(p);
+    default:
+        return _mm_set_ps(0.0f, p[2], p[1], p[0]);
+    }
+}
+
+inline void lanes_store(float* p, Lanes v, uint32_t count)
+{
+    switch (count)
+    {
+    case 4:
+        _mm_storeu_ps(p, v);
+        break;
+    case 2:
+        _mm_store_sd((double*)p, _mm_castps_pd(v));
+        break;
+    case 1:
+        _mm_store_ss(p, v);
+        break;
+    default:
+        alignas(16) float t[4];
+        _mm_store_ps(t, v);
+        p[0] = t[0];
+        p[1] = t[1];
+        p[2] = t[2];
+        break;
+    }
+}
+#else
+struct Lanes
+{
+    float v[4];
+};
+
+inline Lanes lanes_set(float v)
+{
+    return Lanes{ { v, v, v, v } };
+}
+inline Lanes lanes_add(Lanes a, Lanes b)
+{
+    return Lanes{ { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } };
+}
+inline Lanes lanes_sub(Lanes a, Lanes b)
+{
+    return Lanes{ { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } };
+}
+inline Lanes lanes_mul(Lanes a, Lanes b)
+{
+    return Lanes{ { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } };
+}
+
+inline Lanes lanes_load(const float* p, uint32_t count)
+{
+    Lanes l{};
+    for (uint32_t i = 0; i < count; i++)
+    {
+        l.v[i] = p[i];
+    }
+    return l;
+}
+
+inline void lanes_store(float* p, Lanes v, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        p[i] = v.v[i];
+    }
+}
+#endif
+
+// As sp_moogladder's my_tanh
+double block_moog_tanh(double x)
+{
+    double sign = 1.0;
+    if (x < 0)
+    {
+        sign = -1.0;
+        x = -x;
+    }
+    if (x >= 4.0)
+    {
+        return sign;
+    }
+    if (x < 0.5)
+    {
+        return x * sign;
+    }
+    return sign * std::tanh(x);
+}
+
+} // namespace
+
+void block_osc_init(BlockOsc& osc, sp_ftbl* pTable, uint32_t channels, float initialPhase)
+{
+    osc = BlockOsc{};
+    osc.pTable = pTable;
+    osc.channels = std::clamp(channels, 1u, BlockDspMaxChannels);
+
+    const auto phase = int32_t(std::fabs(initialPhase) * SP_FT_MAXLEN) & SP_FT_PHMASK;
+    for (uint32_t ch = 0; ch < BlockDspMaxChannels; ch++)
+    {
+        osc.freq[ch] = 440.0f;
+        osc.amp[ch] = 0.2f;
+        osc.phase[ch] = phase;
+    }
+}
+
+void block_osc_set(BlockOsc& osc, float freq, float amp)
+{
+    for (uint32_t ch = 0; ch < osc.channels; ch++)
+    {
+        osc.freq[ch] = freq;
+        osc.amp[ch] = amp;
+    }
+}
+
+void block_osc_process(BlockOsc& osc, float* pOut, uint32_t frames)
+{
+    // Every read is a table lookup, so each channel runs on its own with its phase held in a register
+    const auto pTable = osc.pTable;
+    const auto lobits = int32_t(pTable->lobits);
+    const auto lomask = int32_t(pTable->lomask);
+    const auto lodiv = pTable->lodiv;
+    const auto sizeMask = int32_t(pTable->size) - 1;
+    const auto pData = pTable->tbl;
+    const auto channels = osc.channels;
+
+    for (uint32_t ch = 0; ch < channels; ch++)
+    {
+        const auto inc = int32_t(lrintf(osc.freq[ch] * pTable->sicvt));
+        const auto amp = osc.amp[ch];
+        auto phs = osc.phase[ch];
+
+        auto pDest = pOut + ch;
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            const float fract = (phs & lomask) * lodiv;
+            const auto pos = phs >> lobits;
+            const auto v1 = pData[pos];
+            const auto v2 = pData[(pos + 1) & sizeMask];
+            *pDest = (v1 + (v2 - v1) * fract) * amp;
+            pDest += channels;
+
+            phs += inc;
+            phs &= SP_FT_PHMASK;
+        }
+        osc.phase[ch] = phs;
+    }
+}
+
+void block_biquad_init(BlockBiquad& biquad, sp_data* pSP, uint32_t channels)
+{
+    biquad = BlockBiquad{};
+    biquad.channels = std::clamp(channels, 1u, BlockDspMaxChannels);
+    biquad.sampleRate = float(pSP->sr);
+    block_biquad_set(biquad, 500.0f, 0.7f);
+}
+
+void block_biquad_set(BlockBiquad& biquad, float cutoff, float res)
+{
+    biquad.cutoff = cutoff;
+    biquad.res = res;
+
+    // Mixed float and double, step for step with sp_biquad_init
+    const float tpidsr = float(2.0 * glm::pi<double>() / double(biquad.sampleRate));
+    const float fcon = cutoff * tpidsr;
+    const double c = std::cos(double(fcon));
+    const double s = std::sin(double(fcon));
+    const float alpha = float(1 - 2 * res * c * c + res * res * std::cos(double(2 * fcon)));
+    const float beta = float(res * res * std::sin(double(2 * fcon)) - 2 * res * c * s);
+    const float gamma = float(1 + c);
+    const float m1 = float(alpha * gamma + beta * s);
+    const float m2 = float(alpha * gamma - beta * s);
+    const float den = float(std::sqrt(double(m1 * m1 + m2 * m2)));
+
+    biquad.b0 = float(1.5 * (alpha * alpha + beta * beta) / den);
+    biquad.b1 = biquad.b0;
+    biquad.b2 = 0.0f;
+    biquad.a1 = float(-2.0 * res * c);
+    biquad.a2 = res * res;
+}
+
+void block_biquad_process(BlockBiquad& biquad, const float* pIn, float* pOut, uint32_t frames)
+{
+    const auto channels = biquad.channels;
+    const auto b0 = lanes_set(biquad.b0);
+    const auto b1 = lanes_set(biquad.b1);
+    const auto b2 = lanes_set(biquad.b2);
+    const auto a1 = lanes_set(biquad.a1);
+    const auto a2 = lanes_set(biquad.a2);
+
+    for (uint32_t group = 0; group < channels; group += 4)
+    {
+        const auto count = std::min(4u, channels - group);
+        auto xnm1 = lanes_load(biquad.xnm1 + group, count);
+        auto xnm2 = lanes_load(biquad.xnm2 + group, count);
+        auto ynm1 = lanes_load(biquad.ynm1 + group, count);
+        auto ynm2 = lanes_load(biquad.ynm2 + group, count);
+
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            const auto offset = frame * channels + group;
+            const auto xn = lanes_load(pIn + offset, count);
+
+            // a0 is always 1
+            auto yn = lanes_add(lanes_mul(b0, xn), lanes_mul(b1, xnm1));
+            yn = lanes_add(yn, lanes_mul(b2, xnm2));
+            yn = lanes_sub(yn, lanes_mul(a1, ynm1));
+            yn = lanes_sub(yn, lanes_mul(a2, ynm2));
+            lanes_store(pOut + offset, yn, count);
+
+            xnm2 = xnm1;
+            xnm1 = xn;
+            ynm2 = ynm1;
+            ynm1 = yn;
+        }
+
+        lanes_store(biquad.xnm1 + group, xnm1, count);
+        lanes_store(biquad.xnm2 + group, xnm2, count);
+        lanes_store(biquad.ynm1 + group, ynm1, count);
+        lanes_store(biquad.ynm2 + group, ynm2, count);
+    }
+}
+
+void block_butter_init(BlockButter& butter, sp_data* pSP, BlockButterType type, uint32_t channels)
+{
+    butter = BlockButter{};
+    butter.type = type;
+    butter.channels = std::clamp(channels, 1u, BlockDspMaxChannels);
+    butter.pidsr = float(glm::pi<double>() / pSP->sr * 1.0);
+}
+
+void block_butter_process(BlockButter& butter, const float* pIn, float* pOut, uint32_t frames)
+{
+    const auto channels = butter.channels;
+    if (butter.freq <= 0.0f)
+    {
+        std::fill(pOut, pOut + frames * channels, 0.0f);
+        return;
+    }
+
+    if (butter.freq != butter.lastFreq)
+    {
+        // As sp_butlp/sp_buthp, including where they round to float
+        auto& a = butter.a;
+        butter.lastFreq = butter.freq;
+        if (butter.type == BlockButterType::LowPass)
+        {
+            const float c = float(1.0 / std::tan(double(butter.pidsr * butter.lastFreq)));
+            a[1] = float(1.0 / (1.0 + Root2 * c + c * c));
+            a[2] = a[1] + a[1];
+            a[3] = a[1];
+            a[4] = float(2.0 * (1.0 - c * c) * a[1]);
+            a[5] = float((1.0 - Root2 * c + c * c) * a[1]);
+        }
+        else
+        {
+            const float c = float(std::tan(double(butter.pidsr * butter.lastFreq)));
+            a[1] = float(1.0 / (1.0 + Root2 * c + c * c));
+            a[2] = -(a[1] + a[1]);
+            a[3] = a[1];
+            a[4] = float(2.0 * (c * c - 1.0) * a[1]);
+            a[5] = float((1.0 - Root2 * c + c * c) * a[1]);
+        }
+    }
+
+    const auto a1 = lanes_set(butter.a[1]);
+    const auto a2 = lanes_set(butter.a[2]);
+    const auto a3 = lanes_set(butter.a[3]);
+    const auto a4 = lanes_set(butter.a[4]);
+    const auto a5 = lanes_set(butter.a[5]);
+
+    for (uint32_t group = 0; group < channels; group += 4)
+    {
+        const auto count = std::min(4u, channels - group);
+        auto z1 = lanes_load(butter.z1 + group, count);
+        auto z2 = lanes_load(butter.z2 + group, count);
+
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            const auto offset = frame * channels + group;
+            auto t = lanes_sub(lanes_load(pIn + offset, count), lanes_mul(a4, z1));
+            t = lanes_sub(t, lanes_mul(a5, z2));
+            auto y = lanes_add(lanes_mul(t, a1), lanes_mul(a2, z1));
+            y = lanes_add(y, lanes_mul(a3, z2));
+            lanes_store(pOut + offset, y, count);
+
+            z2 = z1;
+            z1 = t;
+        }
+
+        lanes_store(butter.z1 + group, z1, count);
+        lanes_store(butter.z2 + group, z2, count);
+    }
+}
+
+void block_moog_init(BlockMoog& moog, sp_data* pSP, uint32_t channels)
+{
+    moog = BlockMoog{};
+    moog.channels = std::clamp(channels, 1u, BlockDspMaxChannels);
+    moog.sampleRate = float(pSP->sr);
+}
+
+void block_moog_process(BlockMoog& moog, const float* pIn, float* pOut, uint32_t frames)
+{
+    const float res = std::max(moog.res, 0.0f);
+    if (moog.oldFreq != moog.freq || moog.oldRes != res)
+    {
+        // sr is half the actual filter sampling rate
+        const float fc = moog.freq / moog.sampleRate;
+        const float f = float(0.5 * fc);
+        const float fc2 = fc * fc;
+        const float fc3 = fc2 * fc;
+
+        // Frequency & amplitude correction
+        const float fcr = float(1.8730 * fc3 + 0.4955 * fc2 - 0.6490 * fc + 0.9988);
+        moog.acr = float(-3.9364 * fc2 + 1.8409 * fc + 0.9968);
+        moog.tune = float((1.0 - std::exp(-((2 * glm::pi<double>()) * f * fcr))) / Thermal);
+        moog.oldFreq = moog.freq;
+        moog.oldRes = res;
+    }
+
+    const float res4 = float(4.0 * res * moog.acr);
+    const double tune = moog.tune;
+    const auto channels = moog.channels;
+
+    for (uint32_t ch = 0; ch < channels; ch++)
+    {
+        auto delay = moog.delay[ch];
+        auto tanhstg = moog.tanhstg[ch];
+        float stg[4];
+
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            const float in = pIn[frame * channels + ch];
+
+            // 2x oversampled
+            for (int j = 0; j < 2; j++)
+            {
+                float input = in - res4 * delay[5];
+                delay[0] = stg[0] = float(delay[0] + tune * (block_moog_tanh(input * Thermal) - tanhstg[0]));
+                for (int k = 1; k < 4; k++)
+                {
+                    input = stg[k - 1];
+                    tanhstg[k - 1] = float(block_moog_tanh(input * Thermal));
+                    const double next = k != 3 ? double(tanhstg[k]) : block_moog_tanh(delay[k] * Thermal);
+                    stg[k] = float(delay[k] + tune * (tanhstg[k - 1] - next));
+                    delay[k] = stg[k];
+                }
+
+                // 1/2 sample delay for phase compensation
+                delay[5] = float((stg[3] + delay[4]) * 0.5);
+                delay[4] = stg[3];
+            }
+            pOut[frame * channels + ch] = delay[5];
+        }
+    }
+}
+
+void block_phaser_init(BlockPhaser& phaser, sp_data* pSP)
+{
+    block_phaser_destroy(phaser);
+    sp_phaser_create(&phaser.pPhaser);
+    sp_phaser_init(pSP, phaser.pPhaser);
+    phaser.pSP = pSP;
+}
+
+void block_phaser_destroy(BlockPhaser& phaser)
+{
+    if (phaser.pPhaser)
+    {
+        sp_phaser_destroy(&phaser.pPhaser);
+        phaser.pPhaser = nullptr;
+    }
+    phaser.pSP = nullptr;
+}
+
+void block_phaser_process(BlockPhaser& phaser, const float* pIn, float* pOut, uint32_t frames, uint32_t channels)
+{
+    float inLeft[PhaserChunkFrames];
+    float inRight[PhaserChunkFrames];
+    float outLeft[PhaserChunkFrames];
+    float outRight[PhaserChunkFrames];
+    float* inputs[] = { inLeft, inRight };
+    float* outputs[] = { outLeft, outRight };
+
+    for (uint32_t start = 0; start < frames; start += PhaserChunkFrames)
+    {
+        const auto count = std::min(PhaserChunkFrames, frames - start);
+        auto pSource = pIn + start * channels;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            inLeft[i] = pSource[i * channels];
+            inRight[i] = pSource[i * channels + channels - 1];
+        }
+
+        sp_phaser_compute_block(phaser.pSP, phaser.pPhaser, int(count), inputs, outputs);
+
+        auto pDest = pOut + start * channels;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (channels == 1)
+            {
+                pDest[i] = (outLeft[i] + outRight[i]) * 0.5f;
+            }
+            else
+            {
+                pDest[i * channels] = outLeft[i];
+                pDest[i * channels + 1] = outRight[i];
+            }
+        }
+    }
+}
+
+} // namespace Zing
@@ -0,0 +1,293 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_block_dsp.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+// Each block module against its scalar soundpipe module, driven as the soundpipe tests in
+// libs/soundpipe/test/t drive them: 5 seconds of sp_noise from seed 0, with the same parameters.
+// The inputs are interleaved so every channel gets its own signal; the scalar module runs once per channel.
+namespace
+{
+
+constexpr uint32_t TestFrames = 44100 * 5;
+
+// As the t_moogladder/t_butlp tests, which pick a new frequency every 5000 samples; blocks of 50 land on it
+constexpr uint32_t TestBlockFrames = 50;
+constexpr uint32_t TestChangeFrames = 5000;
+
+// The block sums run in the same order as the scalar ones, so only float/double rounding differs
+constexpr float Tolerance = 1e-5f;
+
+struct TestSP
+{
+    TestSP()
+    {
+        sp_create(&pSP);
+        sp_srand(pSP, 0);
+    }
+    ~TestSP()
+    {
+        sp_destroy(&pSP);
+    }
+    sp_data* pSP = nullptr;
+};
+
+std::vector<float> test_noise(sp_data* pSP, uint32_t channels)
+{
+    sp_noise* pNoise;
+    sp_noise_create(&pNoise);
+    sp_noise_init(pSP, pNoise);
+
+    std::vector<float> in(size_t(TestFrames) * channels);
+    for (auto& sample : in)
+    {
+        sp_noise_compute(pSP, pNoise, nullptr, &sample);
+    }
+    sp_noise_destroy(&pNoise);
+    return in;
+}
+
+float test_max_error(const std::vector<float>& expected, const std::vector<float>& actual)
+{
+    REQUIRE(expected.size() == actual.size());
+    float error = 0.0f;
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        error = std::max(error, std::fabs(expected[i] - actual[i]));
+    }
+    return error;
+}
+
+} // namespace
+
+TEST_CASE("BlockDsp.Osc", "[BlockDsp]")
+{
+    // t_osc: a 500Hz sine from a 2048 point table
+    TestSP sp;
+    sp_ftbl* pTable;
+    sp_ftbl_create(sp.pSP, &pTable, 2048);
+    sp_gen_sine(sp.pSP, pTable);
+
+    for (uint32_t channels : { 1u, 2u, 5u })
+    {
+        std::vector<float> expected(size_t(TestFrames) * channels);
+        for (uint32_t ch = 0; ch < channels; ch++)
+        {
+            sp_osc* pOsc;
+            sp_osc_create(&pOsc);
+            sp_osc_init(sp.pSP, pOsc, pTable, 0);
+            pOsc->freq = 500;
+            for (uint32_t frame = 0; frame < TestFrames; frame++)
+            {
+                sp_osc_compute(sp.pSP, pOsc, nullptr, &expected[frame * channels + ch]);
+            }
+            sp_osc_destroy(&pOsc);
+        }
+
+        BlockOsc osc;
+        block_osc_init(osc, pTable, channels);
+        block_osc_set(osc, 500.0f, 0.2f);
+
+        std::vector<float> actual(expected.size());
+        for (uint32_t frame = 0; frame < TestFrames; frame += TestBlockFrames)
+        {
+            block_osc_process(osc, actual.data() + frame * channels, TestBlockFrames);
+        }
+        REQUIRE(test_max_error(expected, actual) <= Tolerance);
+    }
+
+    sp_ftbl_destroy(&pTable);
+}
+
+TEST_CASE("BlockDsp.Biquad", "[BlockDsp]")
+{
+    // t_biquad: noise through the default filter
+    for (uint32_t channels : { 1u, 2u, 5u })
+    {
+        TestSP sp;
+        const auto in = test_noise(sp.pSP, channels);
+
+        std::vector<float> expected(in.size());
+        for (uint32_t ch = 0; ch < channels; ch++)
+        {
+            sp_biquad* pBiquad;
+            sp_biquad_create(&pBiquad);
+            sp_biquad_init(sp.pSP, pBiquad);
+            for (uint32_t frame = 0; frame < TestFrames; frame++)
+            {
+                auto input = in[frame * channels + ch];
+                sp_biquad_compute(sp.pSP, pBiquad, &input, &expected[frame * channels + ch]);
+            }
+            sp_biquad_destroy(&pBiquad);
+        }
+
+        BlockBiquad biquad;
+        block_biquad_init(biquad, sp.pSP, channels);
+
+        std::vector<float> actual(in.size());
+        for (uint32_t frame = 0; frame < TestFrames; frame += TestBlockFrames)
+        {
+            block_biquad_process(biquad, in.data() + frame * channels, actual.data() + frame * channels, TestBlockFrames);
+        }
+        REQUIRE(test_max_error(expected, actual) <= Tolerance);
+    }
+}
+
+TEST_CASE("BlockDsp.ButterLowPass", "[BlockDsp]")
+{
+    // t_butlp: noise, with the cutoff moved to 500 + rand % 4000 every 5000 samples
+    for (uint32_t channels : { 1u, 2u, 5u })
+    {
+        TestSP sp;
+        const auto in = test_noise(sp.pSP, channels);
+
+        std::vector<float> freqs;
+        for (uint32_t frame = 0; frame < TestFrames; frame += TestChangeFrames)
+        {
+            freqs.push_back(float(500 + sp_rand(sp.pSP) % 4000));
+        }
+
+        std::vector<float> expected(in.size());
+        for (uint32_t ch = 0; ch < channels; ch++)
+        {
+            sp_butlp* pButter;
+            sp_butlp_create(&pButter);
+            sp_butlp_init(sp.pSP, pButter);
+            for (uint32_t frame = 0; frame < TestFrames; frame++)
+            {
+                pButter->freq = freqs[frame / TestChangeFrames];
+                auto input = in[frame * channels + ch];
+                sp_butlp_compute(sp.pSP, pButter, &input, &expected[frame * channels + ch]);
+            }
+            sp_butlp_destroy(&pButter);
+        }
+
+        BlockButter butter;
+        block_butter_init(butter, sp.pSP, BlockButterType::LowPass, channels);
+
+        std::vector<float> actual(in.size());
+        for (uint32_t frame = 0; frame < TestFrames; frame += TestBlockFrames)
+        {
+            butter.freq = freqs[frame / TestChangeFrames];
+            block_butter_process(butter, in.data() + frame * channels, actual.data() + frame * channels, TestBlockFrames);
+        }
+        REQUIRE(test_max_error(expected, actual) <= Tolerance);
+    }
+}
+
+TEST_CASE("BlockDsp.ButterHighPass", "[BlockDsp]")
+{
+    // t_buthp: noise through a 5kHz high pass
+    for (uint32_t channels : { 1u, 2u, 5u })
+    {
+        TestSP sp;
+        const auto in = test_noise(sp.pSP, channels);
+
+        std::vector<float> expected(in.size());
+        for (uint32_t ch = 0; ch < channels; ch++)
+        {
+            sp_buthp* pButter;
+            sp_buthp_create(&pButter);
+            sp_buthp_init(sp.pSP, pButter);
+            pButter->freq = 5000;
+            for (uint32_t frame = 0; frame < TestFrames; frame++)
+            {
+                auto input = in[frame * channels + ch];
+                sp_buthp_compute(sp.pSP, pButter, &input, &expected[frame * channels + ch]);
+            }
+            sp_buthp_destroy(&pButter);
+        }
+
+        BlockButter butter;
+        block_butter_init(butter, sp.pSP, BlockButterType::HighPass, channels);
+        butter.freq = 5000.0f;
+
+        std::vector<float> actual(in.size());
+        for (uint32_t frame = 0; frame < TestFrames; frame += TestBlockFrames)
+        {
+            block_butter_process(butter, in.data() + frame * channels, actual.data() + frame * channels, TestBlockFrames);
+        }
+        REQUIRE(test_max_error(expected, actual) <= Tolerance);
+    }
+}
+
+TEST_CASE("BlockDsp.Moog", "[BlockDsp]")
+{
+    // t_moogladder: noise, resonance 0.8, the cutoff moved to 500 + rand % 4000 every 5000 samples
+    for (uint32_t channels : { 1u, 2u })
+    {
+        TestSP sp;
+        const auto in = test_noise(sp.pSP, channels);
+
+        std::vector<float> freqs;
+        for (uint32_t frame = 0; frame < TestFrames; frame += TestChangeFrames)
+        {
+            freqs.push_back(float(500 + sp_rand(sp.pSP) % 4000));
+        }
+
+        std::vector<float> expected(in.size());
+        for (uint32_t ch = 0; ch < channels; ch++)
+        {
+            sp_moogladder* pMoog;
+            sp_moogladder_create(&pMoog);
+            sp_moogladder_init(sp.pSP, pMoog);
+            for (uint32_t frame = 0; frame < TestFrames; frame++)
+            {
+                pMoog->res = 0.8f;
+                pMoog->freq = freqs[frame / TestChangeFrames];
+                auto input = in[frame * channels + ch];
+                sp_moogladder_compute(sp.pSP, pMoog, &input, &expected[frame * channels + ch]);
+            }
+            sp_moogladder_destroy(&pMoog);
+        }
+
+        BlockMoog moog;
+        block_moog_init(moog, sp.pSP, channels);
+        moog.res = 0.8f;
+
+        std::vector<float> actual(in.size());
+        for (uint32_t frame = 0; frame < TestFrames; frame += TestBlockFrames)
+        {
+            moog.freq = freqs[frame / TestChangeFrames];
+            block_moog_process(moog, in.data() + frame * channels, actual.data() + frame * channels, TestBlockFrames);
+        }
+        REQUIRE(test_max_error(expected, actual) <= Tolerance);
+    }
+}
+
+TEST_CASE("BlockDsp.Phaser", "[BlockDsp]")
+{
+    // t_phaser plays a file through both sides; noise stands in for it here
+    TestSP sp;
+    const auto in = test_noise(sp.pSP, 2);
+
+    std::vector<float> expected(in.size());
+    sp_phaser* pPhaser;
+    sp_phaser_create(&pPhaser);
+    sp_phaser_init(sp.pSP, pPhaser);
+    for (uint32_t frame = 0; frame < TestFrames; frame++)
+    {
+        auto left = in[frame * 2];
+        auto right = in[frame * 2 + 1];
+        sp_phaser_compute(sp.pSP, pPhaser, &left, &right, &expected[frame * 2], &expected[frame * 2 + 1]);
+    }
+    sp_phaser_destroy(&pPhaser);
+
+    BlockPhaser phaser;
+    block_phaser_init(phaser, sp.pSP);
+
+    // Bigger than the phaser's internal chunk, and not a multiple of it
+    constexpr uint32_t PhaserBlockFrames = 300;
+    std::vector<float> actual(in.size());
+    for (uint32_t frame = 0; frame < TestFrames; frame += PhaserBlockFrames)
+    {
+        const auto count = std::min(PhaserBlockFrames, TestFrames - frame);
+        block_phaser_process(phaser, in.data() + frame * 2, actual.data() + frame * 2, count, 2);
+    }
+    block_phaser_destroy(phaser);
+
+    REQUIRE(test_max_error(expected, actual) <= Tolerance);
+}
@@ -0,0 +1,380 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_convolver.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define CONVOLVER_PAUSE() _mm_pause()
+#else
+#define CONVOLVER_PAUSE() std::this_thread::yield()
+#endif
+
+namespace Zing
+{
+
+namespace
+{
+
+constexpr uint32_t ConvolverMaxLevels = 16;
+
+bool convolver_is_pow2(uint32_t v)
+{
+    return v != 0 && (v & (v - 1)) == 0;
+}
+
+void convolver_level_free(ConvolverLevel& level)
+{
+    if (level.forward)
+    {
+        kiss_fftr_free(level.forward);
+        level.forward = nullptr;
+    }
+    if (level.inverse)
+    {
+        kiss_fftr_free(level.inverse);
+        level.inverse = nullptr;
+    }
+}
+
+std::unique_ptr<ConvolverLevel> convolver_level_create(const float* pImpulse, uint32_t length, uint32_t size, uint32_t offset, uint32_t end, bool background)
+{
+    auto pLevel = std::make_unique<ConvolverLevel>();
+    auto& level = *pLevel;
+    level.size = size;
+    level.offset = offset;
+    level.partitions = (end - offset + size - 1) / size;
+    level.background = background;
+
+    level.forward = kiss_fftr_alloc(int(size * 2), 0, nullptr, nullptr);
+    level.inverse = kiss_fftr_alloc(int(size * 2), 1, nullptr, nullptr);
+
+    const auto bins = size + 1;
+    level.irSpectra.resize(size_t(level.partitions) * bins);
+    level.inputSpectra.resize(size_t(level.partitions) * bins, kiss_fft_cpx{ 0.0f, 0.0f });
+    level.accumulate.resize(bins);
+    level.window.resize(size * 2, 0.0f);
+    level.time.resize(size * 2, 0.0f);
+    level.output.resize(size * 2, 0.0f);
+
+    // Each partition zero padded to the FFT size; kissfft's inverse is unscaled, so fold that in here
+    const float scale = 1.0f / float(size * 2);
+    for (uint32_t partition = 0; partition < level.partitions; partition++)
+    {
+        std::fill(level.time.begin(), level.time.end(), 0.0f);
+        for (uint32_t i = 0; i < size; i++)
+        {
+            const auto tap = uint64_t(offset) + uint64_t(partition) * size + i;
+            if (tap < length)
+            {
+                level.time[i] = pImpulse[tap] * scale;
+            }
+        }
+        kiss_fftr(level.forward, level.time.data(), &level.irSpectra[size_t(partition) * bins]);
+    }
+    return pLevel;
+}
+
+// Overlap save for one completed block of input
+void convolver_level_run(AudioConvolver& convolver, ConvolverLevel& level, uint64_t block)
+{
+    TRACE_SCOPE(convolver_level);
+
+    const auto size = level.size;
+    const auto bins = size + 1;
+
+    std::copy(level.window.begin() + size, level.window.end(), level.window.begin());
+    const auto start = block * size;
+    for (uint32_t i = 0; i < size; i++)
+    {
+        level.window[size + i] = convolver.input[(start + i) & convolver.inputMask];
+    }
+
+    kiss_fftr(level.forward, level.window.data(), &level.inputSpectra[size_t(level.spectrumIndex) * bins]);
+
+    // Partition p meets the input from p blocks ago
+    std::fill(level.accumulate.begin(), level.accumulate.end(), kiss_fft_cpx{ 0.0f, 0.0f });
+    auto pAccumulate = level.accumulate.data();
+    for (uint32_t partition = 0; partition < level.partitions; partition++)
+    {
+        const auto index = (level.spectrumIndex + level.partitions - partition) % level.partitions;
+        const auto pInput = &level.inputSpectra[size_t(index) * bins];
+        const auto pIR = &level.irSpectra[size_t(partition) * bins];
+        for (uint32_t bin = 0; bin < bins; bin++)
+        {
+            pAccumulate[bin].r += pInput[bin].r * pIR[bin].r - pInput[bin].i * pIR[bin].i;
+            pAccumulate[bin].i += pInput[bin].r * pIR[bin].i + pInput[bin].i * pIR[bin].r;
+        }
+    }
+
+    kiss_fftri(level.inverse, pAccumulate, level.time.data());
+
+    // The second half is the part that didn't wrap
+    std::copy(level.time.begin() + size, level.time.end(), level.output.begin() + (block & 1) * size);
+
+    level.spectrumIndex = (level.spectrumIndex + 1) % level.partitions;
+}
+
+// Called on the audio thread when a block's output is due
+void convolver_level_finish(AudioConvolver& convolver, ConvolverLevel& level)
+{
+    auto expected = ConvolverJobState::Pending;
+    if (level.state.compare_exchange_strong(expected, ConvolverJobState::Running, std::memory_order_acquire))
+    {
+        // The worker never got to it
+        convolver_level_run(convolver, level, level.jobBlock);
+        level.state.store(ConvolverJobState::Done, std::memory_order_release);
+        convolver.steals.fetch_add(1, std::memory_order_relaxed);
+    }
+    else if (expected == ConvolverJobState::Running)
+    {
+        convolver.waits.fetch_add(1, std::memory_order_relaxed);
+        while (level.state.load(std::memory_order_acquire) != ConvolverJobState::Done)
+        {
+            CONVOLVER_PAUSE();
+        }
+    }
+}
+
+void convolver_worker(AudioConvolver& convolver)
+{
+    TRACE_NAME_THREAD(Convolver);
+
+    while (!convolver.quit.load(std::memory_order_relaxed))
+    {
+        const auto wake = convolver.wake.load(std::memory_order_acquire);
+
+        // Earliest deadline first; a block is due two partitions after it starts
+        ConvolverLevel* pNext = nullptr;
+        uint64_t nextDeadline = std::numeric_limits<uint64_t>::max();
+        for (auto& pLevel : convolver.levels)
+        {
+            if (pLevel->background && pLevel->state.load(std::memory_order_acquire) == ConvolverJobState::Pending)
+            {
+                const auto deadline = (pLevel->jobBlock + 2) * pLevel->size;
+                if (deadline < nextDeadline)
+                {
+                    nextDeadline = deadline;
+                    pNext = pLevel.get();
+                }
+            }
+        }
+
+        if (pNext)
+        {
+            auto expected = ConvolverJobState::Pending;
+            if (pNext->state.compare_exchange_strong(expected, ConvolverJobState::Running, std::memory_order_acquire))
+            {
+                convolver_level_run(convolver, *pNext, pNext->jobBlock);
+                pNext->state.store(ConvolverJobState::Done, std::memory_order_release);
+            }
+            continue;
+        }
+
+        convolver.wake.wait(wake, std::memory_order_acquire);
+    }
+}
+
+// Every headSize samples; run the first level and hand the tail blocks over
+void convolver_boundary(AudioConvolver& convolver)
+{
+    bool published = false;
+    for (auto& pLevel : convolver.levels)
+    {
+        auto& level = *pLevel;
+        if (convolver.time % level.size != 0)
+        {
+            continue;
+        }
+
+        const auto block = convolver.time / level.size - 1;
+        if (!level.background)
+        {
+            convolver_level_run(convolver, level, block);
+            continue;
+        }
+
+        // The previous block starts playing now, and the level's state can only hold one job
+        convolver_level_finish(convolver, level);
+
+        level.jobBlock = block;
+        level.state.store(ConvolverJobState::Pending, std::memory_order_release);
+        published = true;
+    }
+
+    if (published)
+    {
+        convolver.wake.fetch_add(1, std::memory_order_release);
+        convolver.wake.notify_one();
+    }
+}
+
+} // namespace
+
+bool audio_convolver_init(AudioConvolver& convolver, const float* pImpulse, uint32_t length, const AudioConvolverSettings& settings)
+{
+    audio_convolver_destroy(convolver);
+
+    if (!convolver_is_pow2(settings.headSize) || !convolver_is_pow2(settings.growth) || !convolver_is_pow2(settings.maxPartition) || settings.growth < 2 || settings.maxPartition < settings.headSize)
+    {
+        LOG(ERR, "Convolver partition sizes must be powers of 2");
+        return false;
+    }
+
+    convolver.settings = settings;
+    convolver.time = 0;
+    convolver.steals = 0;
+    convolver.waits = 0;
+
+    const auto headSize = settings.headSize;
+    convolver.head.assign(headSize, 0.0f);
+    for (uint32_t i = 0; i < headSize && i < length; i++)
+    {
+        convolver.head[headSize - 1 - i] = pImpulse[i];
+    }
+    convolver.history.assign(headSize * 2, 0.0f);
+    convolver.historyIndex = 0;
+
+    // Each level ends where the next, bigger one can start with a partition of slack
+    uint32_t size = headSize;
+    uint32_t offset = headSize;
+    bool background = false;
+    while (offset < length && convolver.levels.size() < ConvolverMaxLevels)
+    {
+        const auto next = std::min(size * settings.growth, settings.maxPartition);
+        const auto last = next == size || convolver.levels.size() == ConvolverMaxLevels - 1;
+        const auto end = last ? length : std::min(length, next * 2);
+
+        convolver.levels.push_back(convolver_level_create(pImpulse, length, size, offset, end, background));
+        if (last)
+        {
+            break;
+        }
+
+        offset = next * 2;
+        size = next;
+        background = true;
+    }
+
+    // Enough input for the biggest level to read a block a partition after it arrived
+    uint64_t ringSize = 1;
+    while (ringSize < uint64_t(size) * 4)
+    {
+        ringSize <<= 1;
+    }
+    convolver.input.assign(ringSize, 0.0f);
+    convolver.inputMask = ringSize - 1;
+
+    const auto hasBackground = std::any_of(convolver.levels.begin(), convolver.levels.end(), [](auto& pLevel) {
+        return pLevel->background;
+    });
+    if (hasBackground)
+    {
+        convolver.quit = false;
+        convolver.worker = std::thread([&convolver]() {
+            convolver_worker(convolver);
+        });
+    }
+    return true;
+}
+
+void audio_convolver_destroy(AudioConvolver& convolver)
+{
+    if (convolver.worker.joinable())
+    {
+        convolver.quit = true;
+        convolver.wake.fetch_add(1, std::memory_order_release);
+        convolver.wake.notify_one();
+        convolver.worker.join();
+    }
+
+    for (auto& pLevel : convolver.levels)
+    {
+        convolver_level_free(*pLevel);
+    }
+    convolver.levels.clear();
+    convolver.head.clear();
+    convolver.history.clear();
+    convolver.input.clear();
+}
+
+void audio_convolver_process(AudioConvolver& convolver, const float* pIn, float* pOut, uint32_t frames, uint32_t stride)
+{
+    TRACE_SCOPE(audio_convolver_process);
+
+    const auto headSize = convolver.settings.headSize;
+    const auto wet = convolver.settings.wet;
+    const auto dry = convolver.settings.dry;
+    const auto pHead = convolver.head.data();
+    const auto levelCount = uint32_t(convolver.levels.size());
+
+    if (convolver.head.empty())
+    {
+        return;
+    }
+
+    uint32_t frame = 0;
+    while (frame < frames)
+    {
+        // Up to the next boundary, so each level reads from one block of its output
+        const auto run = std::min(frames - frame, headSize - uint32_t(convolver.time % headSize));
+
+        const float* pLevelOut[ConvolverMaxLevels];
+        for (uint32_t l = 0; l < levelCount; l++)
+        {
+            auto& level = *convolver.levels[l];
+            pLevelOut[l] = nullptr;
+            if (convolver.time >= level.offset)
+            {
+                const auto since = convolver.time - level.offset;
+                pLevelOut[l] = level.output.data() + ((since / level.size) & 1) * level.size + since % level.size;
+            }
+        }
+
+        for (uint32_t i = 0; i < run; i++)
+        {
+            const auto index = (frame + i) * stride;
+            const auto x = pIn[index];
+            convolver.input[(convolver.time + i) & convolver.inputMask] = x;
+
+            auto& historyIndex = convolver.historyIndex;
+            convolver.history[historyIndex] = convolver.history[historyIndex + headSize] = x;
+            historyIndex = (historyIndex + 1) & (headSize - 1);
+
+            // Oldest to newest against the reversed taps; 4 sums to break the dependency chain
+            const auto pHistory = convolver.history.data() + historyIndex;
+            float sum[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+            uint32_t tap = 0;
+            for (; tap + 4 <= headSize; tap += 4)
+            {
+                sum[0] += pHead[tap] * pHistory[tap];
+                sum[1] += pHead[tap + 1] * pHistory[tap + 1];
+                sum[2] += pHead[tap + 2] * pHistory[tap + 2];
+                sum[3] += pHead[tap + 3] * pHistory[tap + 3];
+            }
+            for (; tap < headSize; tap++)
+            {
+                sum[0] += pHead[tap] * pHistory[tap];
+            }
+            auto y = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+
+            for (uint32_t l = 0; l < levelCount; l++)
+            {
+                if (pLevelOut[l])
+                {
+                    y += pLevelOut[l][i];
+                }
+            }
+
+            pOut[index] = x * dry + y * wet;
+        }
+
+        frame += run;
+        convolver.time += run;
+        if (convolver.time % headSize == 0)
+        {
+            convolver_boundary(convolver);
+        }
+    }
+}
+
+} // namespace Zing
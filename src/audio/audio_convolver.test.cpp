@@ -0,0 +1,124 @@
+#include <zing/pch.h>
+
+#include <random>
+
+#include <zing/audio/audio_convolver.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+std::vector<float> test_signal(uint32_t length, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> signal(length);
+    for (auto& sample : signal)
+    {
+        sample = dist(rng);
+    }
+    return signal;
+}
+
+// Odd sized blocks, so partitions finish part way through a call
+void test_process(AudioConvolver& convolver, std::vector<float>& buffer, uint32_t blockFrames)
+{
+    for (uint32_t frame = 0; frame < buffer.size(); frame += blockFrames)
+    {
+        const auto count = std::min(blockFrames, uint32_t(buffer.size()) - frame);
+        audio_convolver_process(convolver, buffer.data() + frame, buffer.data() + frame, count);
+    }
+}
+
+} // namespace
+
+TEST_CASE("Convolver.Impulse", "[Convolver]")
+{
+    // Long enough to reach the background levels
+    const auto impulse = test_signal(40000, 1);
+
+    AudioConvolver convolver;
+    REQUIRE(audio_convolver_init(convolver, impulse.data(), uint32_t(impulse.size())));
+    REQUIRE(convolver.levels.size() > 1);
+
+    // No added latency: a unit impulse gives back the IR from the first sample
+    std::vector<float> buffer(impulse.size() + 5000, 0.0f);
+    buffer[0] = 1.0f;
+    test_process(convolver, buffer, 37);
+    audio_convolver_destroy(convolver);
+
+    for (size_t i = 0; i < impulse.size(); i++)
+    {
+        REQUIRE(buffer[i] == Approx(impulse[i]).margin(1e-4));
+    }
+    for (size_t i = impulse.size(); i < buffer.size(); i++)
+    {
+        REQUIRE(buffer[i] == Approx(0.0f).margin(1e-4));
+    }
+}
+
+TEST_CASE("Convolver.MatchesDirect", "[Convolver]")
+{
+    const auto impulse = test_signal(5000, 2);
+    const auto input = test_signal(12000, 3);
+
+    std::vector<float> expected(input.size(), 0.0f);
+    for (size_t n = 0; n < input.size(); n++)
+    {
+        double sum = 0.0;
+        for (size_t k = 0; k < impulse.size() && k <= n; k++)
+        {
+            sum += double(impulse[k]) * double(input[n - k]);
+        }
+        expected[n] = float(sum);
+    }
+
+    AudioConvolverSettings settings;
+    settings.maxPartition = 1024;
+
+    for (uint32_t blockFrames : { 1u, 64u, 100u, 512u })
+    {
+        AudioConvolver convolver;
+        REQUIRE(audio_convolver_init(convolver, impulse.data(), uint32_t(impulse.size()), settings));
+
+        auto buffer = input;
+        test_process(convolver, buffer, blockFrames);
+        audio_convolver_destroy(convolver);
+
+        // Sums of thousands of terms; relative to their size the error is tiny
+        for (size_t i = 0; i < buffer.size(); i++)
+        {
+            REQUIRE(buffer[i] == Approx(expected[i]).margin(2e-3));
+        }
+    }
+}
+
+TEST_CASE("Convolver.WetDryStride", "[Convolver]")
+{
+    const auto impulse = test_signal(300, 4);
+
+    AudioConvolverSettings settings;
+    settings.wet = 0.5f;
+    settings.dry = 0.25f;
+
+    AudioConvolver convolver;
+    REQUIRE(audio_convolver_init(convolver, impulse.data(), uint32_t(impulse.size()), settings));
+
+    // Only the left side of an interleaved stereo buffer is touched
+    std::vector<float> buffer(2048 * 2, 0.0f);
+    buffer[0] = 1.0f;
+    buffer[1] = 7.0f;
+    audio_convolver_process(convolver, buffer.data(), buffer.data(), 2048, 2);
+    audio_convolver_destroy(convolver);
+
+    REQUIRE(buffer[0] == Approx(impulse[0] * 0.5f + 0.25f).margin(1e-5));
+    REQUIRE(buffer[1] == 7.0f);
+    for (size_t i = 1; i < impulse.size(); i++)
+    {
+        REQUIRE(buffer[i * 2] == Approx(impulse[i] * 0.5f).margin(1e-5));
+        REQUIRE(buffer[i * 2 + 1] == 0.0f);
+    }
+}
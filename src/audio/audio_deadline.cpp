@@ -0,0 +1,279 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_deadline.h>
+
+namespace Zing
+{
+
+namespace
+{
+
+using namespace std::chrono;
+
+double deadline_micros(steady_clock::time_point from, steady_clock::time_point to)
+{
+    return duration<double, std::micro>(to - from).count();
+}
+
+void deadline_add(DeadlineHistogram& histogram, double value)
+{
+    uint32_t bucket = 0;
+    if (value > 1.0)
+    {
+        bucket = std::min(DeadlineHistogram::Buckets - 1, uint32_t(std::log2(value) * DeadlineHistogram::BucketsPerOctave));
+    }
+    histogram.counts[bucket]++;
+    histogram.count++;
+    histogram.sum += value;
+    histogram.max = std::max(histogram.max, value);
+}
+
+void deadline_collect(DeadlineStats& stats, const DeadlineRecord& record)
+{
+    stats.callbacks++;
+    stats.budgetUs = record.budgetUs;
+
+    if (record.flags & Deadline_Skipped)
+    {
+        stats.skipped++;
+    }
+    stats.inputUnderflows += (record.flags & Deadline_InputUnderflow) ? 1 : 0;
+    stats.inputOverflows += (record.flags & Deadline_InputOverflow) ? 1 : 0;
+    stats.outputUnderflows += (record.flags & Deadline_OutputUnderflow) ? 1 : 0;
+    stats.outputOverflows += (record.flags & Deadline_OutputOverflow) ? 1 : 0;
+
+    if (record.totalUs > record.budgetUs)
+    {
+        stats.late++;
+    }
+
+    if (record.leadUs > 0.0f)
+    {
+        const auto slack = double(record.leadUs - record.totalUs);
+        stats.minSlackUs = stats.slackKnown ? std::min(stats.minSlackUs, slack) : slack;
+        stats.slackKnown = true;
+    }
+
+    deadline_add(stats.total, record.totalUs);
+    if (record.budgetUs > 0.0f)
+    {
+        deadline_add(stats.load, 10000.0 * record.totalUs / record.budgetUs);
+    }
+    for (uint32_t stage = 0; stage < uint32_t(DeadlineStage::Count); stage++)
+    {
+        deadline_add(stats.stages[stage], record.stageUs[stage]);
+    }
+}
+
+// Copies out what the audio thread has published since last time; call with the stats mutex held.
+// A slot can be rewritten while it is being copied if the collector has fallen a whole ring behind, so
+// the count is checked again after the copy and such records are dropped.
+void deadline_drain(DeadlineMonitor& monitor)
+{
+    // deadline_begin fills slot 'written % RingSize' before it bumps the count, so the record at
+    // 'written - RingSize' may already be half overwritten; the oldest safe one is the next
+    auto written = monitor.written.load(std::memory_order_acquire);
+    if (written - monitor.read >= DeadlineMonitor::RingSize)
+    {
+        monitor.stats.lost += written - monitor.read - DeadlineMonitor::RingSize + 1;
+        monitor.read = written - DeadlineMonitor::RingSize + 1;
+    }
+
+    while (monitor.read < written)
+    {
+        const auto record = monitor.ring[monitor.read % DeadlineMonitor::RingSize];
+        if (monitor.written.load(std::memory_order_acquire) - monitor.read >= DeadlineMonitor::RingSize)
+        {
+            monitor.stats.lost++;
+        }
+        else
+        {
+            deadline_collect(monitor.stats, record);
+        }
+        monitor.read++;
+    }
+}
+
+} // namespace
+
+DeadlineStageScope::DeadlineStageScope(DeadlineMonitor& monitor, DeadlineStage stage)
+    : pRecord(monitor.pCurrent)
+    , stage(stage)
+    , start(steady_clock::now())
+{
+}
+
+DeadlineStageScope::~DeadlineStageScope()
+{
+    if (pRecord)
+    {
+        pRecord->stageUs[uint32_t(stage)] += float(deadline_micros(start, steady_clock::now()));
+    }
+}
+
+void deadline_start(DeadlineMonitor& monitor)
+{
+    if (monitor.running)
+    {
+        return;
+    }
+
+    auto pMonitor = &monitor;
+    monitor.quitThread = false;
+    monitor.running = true;
+    monitor.thread = std::thread([pMonitor]() {
+        TRACE_NAME_THREAD(Deadlines);
+        const auto wakeUpDelta = std::chrono::milliseconds(20);
+        while (!pMonitor->quitThread.load())
+        {
+            {
+                std::lock_guard<std::mutex> lock(pMonitor->statsMutex);
+                deadline_drain(*pMonitor);
+            }
+            std::this_thread::sleep_for(wakeUpDelta);
+        }
+    });
+}
+
+void deadline_stop(DeadlineMonitor& monitor)
+{
+    if (!monitor.running)
+    {
+        return;
+    }
+
+    monitor.quitThread = true;
+    monitor.thread.join();
+    monitor.running = false;
+}
+
+void deadline_begin(DeadlineMonitor& monitor, uint32_t frames, uint32_t sampleRate, uint32_t flags, double leadSeconds)
+{
+    const auto index = monitor.written.load(std::memory_order_relaxed);
+    auto& record = monitor.ring[index % DeadlineMonitor::RingSize];
+    record.callback = index;
+    record.frames = frames;
+    record.flags = flags;
+    record.budgetUs = sampleRate > 0 ? float(1e6 * frames / sampleRate) : 0.0f;
+    record.totalUs = 0.0f;
+    record.leadUs = float(std::max(0.0, leadSeconds) * 1e6);
+    record.stageUs.fill(0.0f);
+
+    monitor.pCurrent = &record;
+    monitor.start = steady_clock::now();
+}
+
+void deadline_end(DeadlineMonitor& monitor, uint32_t flags)
+{
+    if (!monitor.pCurrent)
+    {
+        return;
+    }
+
+    monitor.pCurrent->flags |= flags;
+    monitor.pCurrent->totalUs = float(deadline_micros(monitor.start, steady_clock::now()));
+    monitor.pCurrent = nullptr;
+    monitor.written.fetch_add(1, std::memory_order_release);
+}
+
+DeadlineStats deadline_stats(DeadlineMonitor& monitor)
+{
+    std::lock_guard<std::mutex> lock(monitor.statsMutex);
+    deadline_drain(monitor);
+    return monitor.stats;
+}
+
+void deadline_reset(DeadlineMonitor& monitor)
+{
+    std::lock_guard<std::mutex> lock(monitor.statsMutex);
+    monitor.read = monitor.written.load(std::memory_order_acquire);
+    monitor.stats = DeadlineStats{};
+}
+
+double deadline_percentile(const DeadlineHistogram& histogram, double fraction)
+{
+    if (histogram.count == 0)
+    {
+        return 0.0;
+    }
+
+    const auto target = std::max(1.0, std::ceil(std::clamp(fraction, 0.0, 1.0) * double(histogram.count)));
+    uint64_t seen = 0;
+    for (uint32_t bucket = 0; bucket < DeadlineHistogram::Buckets; bucket++)
+    {
+        seen += histogram.counts[bucket];
+        if (double(seen) >= target)
+        {
+            // Upper edge of the bucket, but never past the largest value seen
+            const auto edge = std::exp2(double(bucket + 1) / DeadlineHistogram::BucketsPerOctave);
+            return std::min(edge, histogram.max);
+        }
+    }
+    return histogram.max;
+}
+
+const char* deadline_stage_name(DeadlineStage stage)
+{
+    switch (stage)
+    {
+    case DeadlineStage::PreCallback:
+        return "Pre Callback";
+    case DeadlineStage::Midi:
+        return "Midi";
+    case DeadlineStage::InputStages:
+        return "Input Stages";
+    case DeadlineStage::UserCallback:
+        return "User Callback";
+    case DeadlineStage::OutputStages:
+        return "Output Stages";
+    case DeadlineStage::Compressor:
+        return "Compressor";
+    case DeadlineStage::SendAnalysis:
+        return "Send Analysis";
+    default:
+        return "?";
+    }
+}
+
+std::string deadline_report(const DeadlineStats& stats)
+{
+    std::string report;
+    char line[256];
+
+    snprintf(line, sizeof(line), "Audio callbacks: %llu, late: %llu, skipped: %llu, lost: %llu\n",
+        (unsigned long long)stats.callbacks, (unsigned long long)stats.late, (unsigned long long)stats.skipped, (unsigned long long)stats.lost);
+    report += line;
+    snprintf(line, sizeof(line), "Xruns: input under %llu / over %llu, output under %llu / over %llu\n",
+        (unsigned long long)stats.inputUnderflows, (unsigned long long)stats.inputOverflows, (unsigned long long)stats.outputUnderflows, (unsigned long long)stats.outputOverflows);
+    report += line;
+    if (stats.slackKnown)
+    {
+        snprintf(line, sizeof(line), "Budget: %.1fus, least slack: %.1fus\n", stats.budgetUs, stats.minSlackUs);
+    }
+    else
+    {
+        snprintf(line, sizeof(line), "Budget: %.1fus, least slack: unknown\n", stats.budgetUs);
+    }
+    report += line;
+
+    snprintf(line, sizeof(line), "%-14s %10s %10s %10s %10s %10s %10s\n", "(us)", "mean", "p50", "p90", "p99", "p99.9", "max");
+    report += line;
+
+    auto row = [&](const char* pName, const DeadlineHistogram& histogram, double scale) {
+        const auto mean = histogram.count ? histogram.sum / double(histogram.count) : 0.0;
+        snprintf(line, sizeof(line), "%-14s %10.1f %10.1f %10.1f %10.1f %10.1f %10.1f\n", pName, mean * scale,
+            deadline_percentile(histogram, 0.5) * scale, deadline_percentile(histogram, 0.9) * scale, deadline_percentile(histogram, 0.99) * scale,
+            deadline_percentile(histogram, 0.999) * scale, histogram.max * scale);
+        report += line;
+    };
+
+    row("Total", stats.total, 1.0);
+    row("Load (%)", stats.load, 0.01);
+    for (uint32_t stage = 0; stage < uint32_t(DeadlineStage::Count); stage++)
+    {
+        row(deadline_stage_name(DeadlineStage(stage)), stats.stages[stage], 1.0);
+    }
+    return report;
+}
+
+} // namespace Zing
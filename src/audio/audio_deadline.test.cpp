@@ -0,0 +1,149 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_deadline.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+constexpr uint32_t TestFrames = 512;
+constexpr uint32_t TestRate = 48000;
+
+// Callbacks as the audio thread makes them, without a collector running
+void test_callbacks(DeadlineMonitor& monitor, uint64_t count, uint32_t flags = 0)
+{
+    for (uint64_t i = 0; i < count; i++)
+    {
+        deadline_begin(monitor, TestFrames, TestRate, flags, 0.0);
+        deadline_end(monitor);
+    }
+}
+
+} // namespace
+
+TEST_CASE("Deadline.Collect", "[Deadline]")
+{
+    auto spMonitor = std::make_unique<DeadlineMonitor>();
+    auto& monitor = *spMonitor;
+
+    test_callbacks(monitor, 10);
+    test_callbacks(monitor, 2, Deadline_InputOverflow | Deadline_OutputUnderflow);
+    deadline_begin(monitor, TestFrames, TestRate, 0, 0.0);
+    deadline_end(monitor, Deadline_Skipped);
+
+    auto stats = deadline_stats(monitor);
+    REQUIRE(stats.callbacks == 13);
+    REQUIRE(stats.skipped == 1);
+    REQUIRE(stats.inputOverflows == 2);
+    REQUIRE(stats.outputUnderflows == 2);
+    REQUIRE(stats.inputUnderflows == 0);
+    REQUIRE(stats.outputOverflows == 0);
+    REQUIRE(stats.lost == 0);
+    REQUIRE(stats.budgetUs == Approx(1e6 * TestFrames / TestRate));
+    REQUIRE(stats.total.count == 13);
+    REQUIRE(!stats.slackKnown);
+    for (auto& stage : stats.stages)
+    {
+        REQUIRE(stage.count == 13);
+    }
+
+    // Nothing is counted twice
+    stats = deadline_stats(monitor);
+    REQUIRE(stats.callbacks == 13);
+
+    deadline_reset(monitor);
+    stats = deadline_stats(monitor);
+    REQUIRE(stats.callbacks == 0);
+    REQUIRE(stats.total.count == 0);
+}
+
+TEST_CASE("Deadline.LateAndSlack", "[Deadline]")
+{
+    auto spMonitor = std::make_unique<DeadlineMonitor>();
+    auto& monitor = *spMonitor;
+
+    // A single frame lasts 20us; this callback takes at least 2ms, all of it in one stage
+    deadline_begin(monitor, 1, TestRate, 0, 0.01);
+    {
+        DeadlineStageScope scope(monitor, DeadlineStage::UserCallback);
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    deadline_end(monitor);
+
+    auto stats = deadline_stats(monitor);
+    REQUIRE(stats.late == 1);
+    REQUIRE(stats.total.max >= 2000.0);
+    REQUIRE(stats.stages[uint32_t(DeadlineStage::UserCallback)].max >= 2000.0);
+    REQUIRE(stats.stages[uint32_t(DeadlineStage::UserCallback)].max <= stats.total.max);
+    REQUIRE(stats.slackKnown);
+    REQUIRE(stats.minSlackUs == Approx(10000.0 - stats.total.max).margin(1.0));
+}
+
+TEST_CASE("Deadline.RingBoundary", "[Deadline]")
+{
+    // One short of the ring: the oldest record can't have been touched, so all of it is collected
+    {
+        auto spMonitor = std::make_unique<DeadlineMonitor>();
+        test_callbacks(*spMonitor, DeadlineMonitor::RingSize - 1);
+        auto stats = deadline_stats(*spMonitor);
+        REQUIRE(stats.callbacks == DeadlineMonitor::RingSize - 1);
+        REQUIRE(stats.lost == 0);
+    }
+
+    // A whole ring: the oldest slot is the one the next callback fills, so it is dropped
+    {
+        auto spMonitor = std::make_unique<DeadlineMonitor>();
+        test_callbacks(*spMonitor, DeadlineMonitor::RingSize);
+        auto stats = deadline_stats(*spMonitor);
+        REQUIRE(stats.callbacks == DeadlineMonitor::RingSize - 1);
+        REQUIRE(stats.lost == 1);
+    }
+
+    // Far behind: everything but the newest RingSize - 1 is lost, and the count carries on after
+    {
+        auto spMonitor = std::make_unique<DeadlineMonitor>();
+        test_callbacks(*spMonitor, DeadlineMonitor::RingSize * 3 + 5);
+        auto stats = deadline_stats(*spMonitor);
+        REQUIRE(stats.callbacks == DeadlineMonitor::RingSize - 1);
+        REQUIRE(stats.lost == DeadlineMonitor::RingSize * 2 + 6);
+        REQUIRE(stats.callbacks + stats.lost == DeadlineMonitor::RingSize * 3 + 5);
+
+        test_callbacks(*spMonitor, 7);
+        stats = deadline_stats(*spMonitor);
+        REQUIRE(stats.callbacks == DeadlineMonitor::RingSize + 6);
+        REQUIRE(stats.lost == DeadlineMonitor::RingSize * 2 + 6);
+    }
+}
+
+TEST_CASE("Deadline.Percentile", "[Deadline]")
+{
+    DeadlineHistogram histogram;
+    REQUIRE(deadline_percentile(histogram, 0.5) == 0.0);
+
+    // 90 at under a microsecond, 10 at about a millisecond
+    histogram.counts[0] = 90;
+    histogram.counts[10 * DeadlineHistogram::BucketsPerOctave] = 10;
+    histogram.count = 100;
+    histogram.max = 1100.0;
+
+    REQUIRE(deadline_percentile(histogram, 0.5) == Approx(std::exp2(1.0 / DeadlineHistogram::BucketsPerOctave)));
+    REQUIRE(deadline_percentile(histogram, 0.8) == Approx(std::exp2(1.0 / DeadlineHistogram::BucketsPerOctave)));
+    REQUIRE(deadline_percentile(histogram, 0.91) == 1100.0);
+    REQUIRE(deadline_percentile(histogram, 1.0) == 1100.0);
+}
+
+TEST_CASE("Deadline.Report", "[Deadline]")
+{
+    auto spMonitor = std::make_unique<DeadlineMonitor>();
+    test_callbacks(*spMonitor, 3);
+
+    auto report = deadline_report(deadline_stats(*spMonitor));
+    REQUIRE(report.find("Audio callbacks: 3, late: 0, skipped: 0, lost: 0") != std::string::npos);
+    for (uint32_t stage = 0; stage < uint32_t(DeadlineStage::Count); stage++)
+    {
+        REQUIRE(report.find(deadline_stage_name(DeadlineStage(stage))) != std::string::npos);
+    }
+}
@@ -0,0 +1,222 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_onset.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ONSET_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace Zing
+{
+
+namespace
+{
+
+// Sum of the rises in |X|^0.5 since the last frame; updates pPrevious
+float onset_flux(const float* pPower, float* pPrevious, uint32_t bins)
+{
+    // Skip DC
+    uint32_t bin = 1;
+    float flux = 0.0f;
+#ifdef ONSET_SSE2
+    auto sum = _mm_setzero_ps();
+    const auto zero = _mm_setzero_ps();
+    for (; bin + 4 <= bins; bin += 4)
+    {
+        const auto compressed = _mm_sqrt_ps(_mm_sqrt_ps(_mm_loadu_ps(pPower + bin)));
+        const auto rise = _mm_sub_ps(compressed, _mm_loadu_ps(pPrevious + bin));
+        sum = _mm_add_ps(sum, _mm_max_ps(rise, zero));
+        _mm_storeu_ps(pPrevious + bin, compressed);
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    flux = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; bin < bins; bin++)
+    {
+        const auto compressed = std::sqrt(std::sqrt(pPower[bin]));
+        flux += std::max(compressed - pPrevious[bin], 0.0f);
+        pPrevious[bin] = compressed;
+    }
+    return flux;
+}
+
+float onset_dot(const float* pA, const float* pB, uint32_t count)
+{
+    uint32_t i = 0;
+    float total = 0.0f;
+#ifdef ONSET_SSE2
+    auto sum = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4)
+    {
+        sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(pA + i), _mm_loadu_ps(pB + i)));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    total = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; i++)
+    {
+        total += pA[i] * pB[i];
+    }
+    return total;
+}
+
+void onset_estimate_tempo(OnsetDetector& detector, const OnsetSettings& settings)
+{
+    TRACE_SCOPE(Tempo);
+
+    const auto hop = detector.hopSeconds;
+    const auto count = detector.envelopeCount;
+    const auto minLag = std::max(1u, uint32_t(60.0 / settings.maxBpm / hop));
+    const auto maxLag = uint32_t(std::ceil(60.0 / settings.minBpm / hop));
+    if (count < maxLag * 4)
+    {
+        return;
+    }
+
+    // The newest 'count' values, oldest first
+    const auto start = (detector.envelopeIndex + detector.envelopeSize - count) % detector.envelopeSize;
+    const float* pEnvelope = detector.envelope.data() + start;
+
+    const auto energy = onset_dot(pEnvelope, pEnvelope, count) / float(count);
+    if (energy <= 1e-12f)
+    {
+        return;
+    }
+
+    // Unbiased autocorrelation up to twice the longest lag, for the double
+    auto& scores = detector.lagScores;
+    scores.resize(maxLag * 2 + 1);
+    for (uint32_t lag = minLag; lag <= maxLag * 2; lag++)
+    {
+        scores[lag] = onset_dot(pEnvelope, pEnvelope + lag, count - lag) / float(count - lag);
+    }
+
+    uint32_t best = 0;
+    float bestScore = 0.0f;
+    auto score = [&](uint32_t lag) {
+        const auto bpm = 60.0 / (lag * hop);
+        const auto octaves = std::log2(bpm / 120.0);
+        const auto prior = float(std::exp(-0.5 * octaves * octaves));
+        return (scores[lag] + 0.5f * scores[lag * 2]) * prior;
+    };
+    for (uint32_t lag = minLag; lag <= maxLag; lag++)
+    {
+        const auto s = score(lag);
+        if (s > bestScore)
+        {
+            best = lag;
+            bestScore = s;
+        }
+    }
+    if (best == 0)
+    {
+        return;
+    }
+
+    float lag = float(best);
+    if (best > minLag && best < maxLag)
+    {
+        const auto prev = score(best - 1);
+        const auto next = score(best + 1);
+        const auto denominator = prev - 2.0f * bestScore + next;
+        if (denominator < -1e-12f)
+        {
+            lag += std::clamp(0.5f * (prev - next) / denominator, -0.5f, 0.5f);
+        }
+    }
+
+    const auto bpm = float(60.0 / (lag * hop));
+    detector.tempoConfidence = std::clamp(scores[best] / energy, 0.0f, 1.0f);
+
+    // Settle on a steady tempo, but follow a real change straight away
+    if (detector.bpm > 0.0f && std::abs(bpm - detector.bpm) < detector.bpm * 0.04f)
+    {
+        detector.bpm += 0.3f * (bpm - detector.bpm);
+    }
+    else
+    {
+        detector.bpm = bpm;
+    }
+}
+
+} // namespace
+
+void onset_detector_reset(OnsetDetector& detector)
+{
+    detector = OnsetDetector{};
+}
+
+AudioOnset onset_detector_update(OnsetDetector& detector, const float* pPower, uint32_t bins, double hopSeconds, const OnsetSettings& settings)
+{
+    TRACE_SCOPE(Onset);
+
+    if (hopSeconds <= 0.0)
+    {
+        return AudioOnset{};
+    }
+
+    if (std::abs(hopSeconds - detector.hopSeconds) > detector.hopSeconds * 0.01)
+    {
+        onset_detector_reset(detector);
+        detector.hopSeconds = hopSeconds;
+        detector.envelopeSize = std::max(16u, uint32_t(settings.tempoSeconds / hopSeconds));
+        detector.envelope.assign(detector.envelopeSize * 2, 0.0f);
+    }
+
+    if (detector.previous.size() != bins)
+    {
+        detector.previous.assign(bins, 0.0f);
+        detector.primed = false;
+    }
+
+    auto flux = onset_flux(pPower, detector.previous.data(), bins);
+    if (!detector.primed)
+    {
+        // Nothing to compare the first frame with
+        detector.primed = true;
+        flux = 0.0f;
+    }
+
+    AudioOnset result;
+    result.flux = flux;
+
+    // Peak pick on the frame before, against a running mean of about a second
+    detector.recent[2] = detector.recent[1];
+    detector.recent[1] = detector.recent[0];
+    detector.recent[0] = flux;
+    detector.sinceOnset += hopSeconds;
+
+    const auto peak = detector.recent[1];
+    const auto threshold = detector.fluxMean * settings.sensitivity + 1e-4f;
+    if (peak > detector.recent[2] && peak >= detector.recent[0] && peak > threshold && detector.sinceOnset >= settings.minInterval + hopSeconds)
+    {
+        result.onset = true;
+        detector.sinceOnset = hopSeconds;
+    }
+
+    const auto alpha = float(1.0 - std::exp(-hopSeconds));
+    detector.fluxMean += alpha * (flux - detector.fluxMean);
+
+    // Tempo from the part of the flux that stands out
+    const auto value = std::max(0.0f, flux - detector.fluxMean);
+    detector.envelope[detector.envelopeIndex] = value;
+    detector.envelope[detector.envelopeIndex + detector.envelopeSize] = value;
+    detector.envelopeIndex = (detector.envelopeIndex + 1) % detector.envelopeSize;
+    detector.envelopeCount = std::min(detector.envelopeCount + 1, detector.envelopeSize);
+
+    detector.sinceTempo += hopSeconds;
+    if (detector.sinceTempo >= 0.5)
+    {
+        detector.sinceTempo = 0.0;
+        onset_estimate_tempo(detector, settings);
+    }
+
+    result.bpm = detector.bpm;
+    result.tempoConfidence = detector.tempoConfidence;
+    return result;
+}
+
+} // namespace Zing
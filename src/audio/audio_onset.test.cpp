@@ -0,0 +1,137 @@
+#include <zing/pch.h>
+
+#include <random>
+
+#include <zing/audio/audio_onset.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+constexpr uint32_t TestBins = 513;
+
+// A 480 sample hop at 48kHz; the test tempos are then a whole number of frames per beat, so the
+// clicks are exactly periodic and don't alternate between two spacings
+constexpr double TestHop = 0.01;
+
+// The running mean starts at 0, and takes a second or so to settle
+constexpr double TestSettleSeconds = 2.0;
+
+// Power spectra of a quiet noise bed with a click on each beat, which dies away over a few frames
+struct TestClicks
+{
+    explicit TestClicks(double bpm)
+        : beatFrames(uint64_t(std::lround(60.0 / bpm / TestHop)))
+    {
+    }
+
+    const float* next()
+    {
+        const auto sinceBeat = frame % beatFrames;
+        click = sinceBeat == 0;
+
+        const float level = sinceBeat < 8 ? std::pow(0.5f, float(sinceBeat)) : 0.0f;
+        for (auto& bin : power)
+        {
+            bin = level + 1e-4f * (0.9f + 0.2f * dist(rng));
+        }
+        frame++;
+        return power.data();
+    }
+
+    uint64_t beatFrames;
+    uint64_t frame = 0;
+    bool click = false;
+    std::vector<float> power = std::vector<float>(TestBins);
+    std::mt19937 rng{ 1 };
+    std::uniform_real_distribution<float> dist{ 0.0f, 1.0f };
+};
+
+} // namespace
+
+TEST_CASE("Onset.Steady", "[Onset]")
+{
+    OnsetDetector detector;
+    OnsetSettings settings;
+
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<float> dist(0.9f, 1.1f);
+    std::vector<float> power(TestBins);
+    for (uint32_t frame = 0; frame < 1000; frame++)
+    {
+        for (auto& bin : power)
+        {
+            bin = 0.01f * dist(rng);
+        }
+        auto onset = onset_detector_update(detector, power.data(), TestBins, TestHop, settings);
+        if (frame * TestHop > TestSettleSeconds)
+        {
+            REQUIRE(!onset.onset);
+        }
+    }
+}
+
+TEST_CASE("Onset.Clicks", "[Onset]")
+{
+    OnsetDetector detector;
+    OnsetSettings settings;
+    TestClicks clicks(120.0);
+
+    // Onsets are reported the frame after their peak
+    uint32_t onsets = 0;
+    uint32_t beats = 0;
+    bool lastClick = false;
+    for (uint32_t frame = 0; frame < uint32_t(10.0 / TestHop); frame++)
+    {
+        auto onset = onset_detector_update(detector, clicks.next(), TestBins, TestHop, settings);
+        if (frame * TestHop > TestSettleSeconds)
+        {
+            REQUIRE(onset.onset == lastClick);
+            onsets += onset.onset ? 1 : 0;
+            beats += lastClick ? 1 : 0;
+        }
+        lastClick = clicks.click;
+    }
+
+    // Every click, and nothing else
+    REQUIRE(beats > 10);
+    REQUIRE(onsets == beats);
+}
+
+TEST_CASE("Onset.Tempo", "[Onset]")
+{
+    for (double bpm : { 100.0, 120.0, 150.0 })
+    {
+        OnsetDetector detector;
+        OnsetSettings settings;
+        TestClicks clicks(bpm);
+
+        AudioOnset onset;
+        for (uint32_t frame = 0; frame < uint32_t(12.0 / TestHop); frame++)
+        {
+            onset = onset_detector_update(detector, clicks.next(), TestBins, TestHop, settings);
+        }
+
+        REQUIRE(onset.bpm == Approx(bpm).epsilon(0.02));
+        REQUIRE(onset.tempoConfidence > 0.0f);
+    }
+}
+
+TEST_CASE("Onset.Reset", "[Onset]")
+{
+    OnsetDetector detector;
+    OnsetSettings settings;
+    TestClicks clicks(120.0);
+    for (uint32_t frame = 0; frame < uint32_t(8.0 / TestHop); frame++)
+    {
+        onset_detector_update(detector, clicks.next(), TestBins, TestHop, settings);
+    }
+    REQUIRE(detector.bpm > 0.0f);
+
+    onset_detector_reset(detector);
+    REQUIRE(detector.bpm == 0.0f);
+    REQUIRE(detector.envelopeCount == 0);
+}
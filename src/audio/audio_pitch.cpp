@@ -0,0 +1,125 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_pitch.h>
+
+namespace Zing
+{
+
+void pitch_tracker_init(PitchTracker& tracker, const float* pWindow, uint32_t frames)
+{
+    pitch_tracker_destroy(tracker);
+
+    assert(frames >= 64 && (frames % 2) == 0);
+    tracker.frames = frames;
+    tracker.inverse = kiss_fftr_alloc(frames, 1, nullptr, nullptr);
+
+    tracker.spectrum.resize(frames / 2 + 1);
+    tracker.correlation.resize(frames);
+    tracker.difference.resize(frames / 2 + 1);
+
+    // The window's own autocorrelation, taken the same (circular) way as the signal's
+    auto forward = kiss_fftr_alloc(frames, 0, nullptr, nullptr);
+    kiss_fftr(forward, pWindow, tracker.spectrum.data());
+    kiss_fftr_free(forward);
+    for (auto& bin : tracker.spectrum)
+    {
+        bin = kiss_fft_cpx{ bin.r * bin.r + bin.i * bin.i, 0.0f };
+    }
+    kiss_fftri(tracker.inverse, tracker.spectrum.data(), tracker.correlation.data());
+
+    tracker.windowCorrection.resize(frames / 2 + 1);
+    for (uint32_t lag = 0; lag <= frames / 2; lag++)
+    {
+        tracker.windowCorrection[lag] = tracker.correlation[0] / std::max(tracker.correlation[lag], tracker.correlation[0] * 1e-3f);
+    }
+}
+
+void pitch_tracker_destroy(PitchTracker& tracker)
+{
+    if (tracker.inverse)
+    {
+        kiss_fftr_free(tracker.inverse);
+        tracker.inverse = nullptr;
+    }
+    tracker.frames = 0;
+}
+
+AudioPitch pitch_tracker_update(PitchTracker& tracker, const float* pPower, uint32_t sampleRate, float minFrequency, float maxFrequency, float threshold)
+{
+    TRACE_SCOPE(Pitch);
+
+    const auto frames = tracker.frames;
+    const auto bins = frames / 2 + 1;
+
+    // Autocorrelation; DC would only add a constant, so leave it out
+    tracker.spectrum[0] = kiss_fft_cpx{ 0.0f, 0.0f };
+    for (uint32_t bin = 1; bin < bins; bin++)
+    {
+        tracker.spectrum[bin] = kiss_fft_cpx{ pPower[bin], 0.0f };
+    }
+    kiss_fftri(tracker.inverse, tracker.spectrum.data(), tracker.correlation.data());
+
+    const auto& correlation = tracker.correlation;
+    const auto minLag = std::max(2u, uint32_t(sampleRate / std::max(maxFrequency, 1.0f)));
+    const auto maxLag = std::min(frames / 2 - 1, uint32_t(sampleRate / std::max(minFrequency, 1.0f)) + 1);
+    if (minLag + 2 >= maxLag || correlation[0] <= 1e-20f)
+    {
+        return AudioPitch{};
+    }
+
+    // Cumulative mean normalised difference
+    auto& difference = tracker.difference;
+    difference[0] = 1.0f;
+    const float r0 = correlation[0];
+    float sum = 0.0f;
+    for (uint32_t lag = 1; lag <= maxLag; lag++)
+    {
+        const auto d = std::max(0.0f, 2.0f * (r0 - correlation[lag] * tracker.windowCorrection[lag]));
+        sum += d;
+        difference[lag] = sum > 0.0f ? d * float(lag) / sum : 1.0f;
+    }
+
+    // The first dip under the threshold, walked down to its floor; else the deepest dip
+    uint32_t best = 0;
+    for (uint32_t lag = minLag; lag < maxLag; lag++)
+    {
+        if (difference[lag] < threshold)
+        {
+            while (lag + 1 < maxLag && difference[lag + 1] < difference[lag])
+            {
+                lag++;
+            }
+            best = lag;
+            break;
+        }
+    }
+    if (best == 0)
+    {
+        best = minLag;
+        for (uint32_t lag = minLag + 1; lag < maxLag; lag++)
+        {
+            if (difference[lag] < difference[best])
+            {
+                best = lag;
+            }
+        }
+    }
+
+    // Parabolic interpolation around the dip
+    float lag = float(best);
+    const auto prev = difference[best - 1];
+    const auto here = difference[best];
+    const auto next = difference[best + 1];
+    const auto denominator = prev - 2.0f * here + next;
+    if (denominator > 1e-9f)
+    {
+        lag += std::clamp(0.5f * (prev - next) / denominator, -0.5f, 0.5f);
+    }
+
+    AudioPitch pitch;
+    pitch.confidence = std::clamp(1.0f - here, 0.0f, 1.0f);
+    pitch.frequency = here < threshold ? float(sampleRate) / lag : 0.0f;
+    return pitch;
+}
+
+} // namespace Zing
@@ -0,0 +1,115 @@
+#include <zing/pch.h>
+
+#include <random>
+
+#include <zing/audio/audio_pitch.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+constexpr uint32_t TestFrames = 2048;
+constexpr uint32_t TestRate = 48000;
+
+// As the analysis does it: a Hann window, a real FFT, then |X|^2
+struct TestSpectrum
+{
+    TestSpectrum()
+    {
+        window.resize(TestFrames);
+        for (uint32_t i = 0; i < TestFrames; i++)
+        {
+            window[i] = 0.5f * (1.0f - std::cos(2.0f * glm::pi<float>() * i / float(TestFrames - 1)));
+        }
+        forward = kiss_fftr_alloc(TestFrames, 0, nullptr, nullptr);
+        pitch_tracker_init(tracker, window.data(), TestFrames);
+    }
+
+    ~TestSpectrum()
+    {
+        kiss_fftr_free(forward);
+        pitch_tracker_destroy(tracker);
+    }
+
+    AudioPitch track(const std::vector<float>& signal)
+    {
+        std::vector<float> shaped(TestFrames);
+        for (uint32_t i = 0; i < TestFrames; i++)
+        {
+            shaped[i] = signal[i] * window[i];
+        }
+
+        std::vector<kiss_fft_cpx> bins(TestFrames / 2 + 1);
+        kiss_fftr(forward, shaped.data(), bins.data());
+
+        std::vector<float> power(bins.size());
+        for (size_t i = 0; i < bins.size(); i++)
+        {
+            power[i] = bins[i].r * bins[i].r + bins[i].i * bins[i].i;
+        }
+        return pitch_tracker_update(tracker, power.data(), TestRate, 50.0f, 2000.0f, 0.2f);
+    }
+
+    std::vector<float> window;
+    kiss_fftr_cfg forward = nullptr;
+    PitchTracker tracker;
+};
+
+std::vector<float> test_tone(float frequency, uint32_t harmonics)
+{
+    std::vector<float> signal(TestFrames, 0.0f);
+    for (uint32_t h = 1; h <= harmonics; h++)
+    {
+        for (uint32_t i = 0; i < TestFrames; i++)
+        {
+            signal[i] += std::sin(2.0f * glm::pi<float>() * frequency * h * i / float(TestRate)) * 0.5f / float(h);
+        }
+    }
+    return signal;
+}
+
+} // namespace
+
+TEST_CASE("Pitch.Sine", "[Pitch]")
+{
+    TestSpectrum spectrum;
+    for (float frequency : { 82.4f, 220.0f, 440.0f, 1001.0f, 1760.0f })
+    {
+        auto pitch = spectrum.track(test_tone(frequency, 1));
+        REQUIRE(pitch.frequency == Approx(frequency).epsilon(0.01));
+        REQUIRE(pitch.confidence > 0.9f);
+    }
+}
+
+TEST_CASE("Pitch.Harmonics", "[Pitch]")
+{
+    // YIN takes the first dip under the threshold, so a rich tone gives its fundamental, not an octave up
+    TestSpectrum spectrum;
+    for (float frequency : { 110.0f, 330.0f })
+    {
+        auto pitch = spectrum.track(test_tone(frequency, 8));
+        REQUIRE(pitch.frequency == Approx(frequency).epsilon(0.01));
+    }
+}
+
+TEST_CASE("Pitch.Unpitched", "[Pitch]")
+{
+    TestSpectrum spectrum;
+
+    auto silence = spectrum.track(std::vector<float>(TestFrames, 0.0f));
+    REQUIRE(silence.frequency == 0.0f);
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    std::vector<float> noise(TestFrames);
+    for (auto& sample : noise)
+    {
+        sample = dist(rng);
+    }
+    auto pitch = spectrum.track(noise);
+    REQUIRE(pitch.frequency == 0.0f);
+    REQUIRE(pitch.confidence < 0.8f);
+}
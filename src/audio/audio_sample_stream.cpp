@@ -0,0 +1,398 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_sample_stream.h>
+
+#include <dr_wav.h>
+
+namespace Zing
+{
+
+namespace
+{
+
+void sample_stream_close(SampleStreamVoice& voice)
+{
+    if (voice.pDecoder)
+    {
+        auto pWav = (drwav*)voice.pDecoder;
+        drwav_uninit(pWav);
+        delete pWav;
+        voice.pDecoder = nullptr;
+    }
+}
+
+// The voice gets nothing more than the head; the audio thread fades it out and frees it.
+// The source is marked too, so other voices don't try the file again, and it is only reported once.
+void sample_stream_fail(SampleStreamVoice& voice, const char* pReason)
+{
+    sample_stream_close(voice);
+    if (!voice.pSource->failed.exchange(true))
+    {
+        LOG(ERR, pReason << voice.pSource->path.string());
+    }
+    voice.failed.store(true, std::memory_order_release);
+}
+
+// Top up one voice's ring; returns true if it read anything
+bool sample_stream_fill(SampleStreamer& streamer, SampleStreamVoice& voice)
+{
+    auto pSource = voice.pSource;
+    if (pSource->headFrames >= pSource->frames || voice.failed.load(std::memory_order_relaxed))
+    {
+        return false;
+    }
+
+    if (pSource->failed.load())
+    {
+        voice.failed.store(true, std::memory_order_release);
+        return false;
+    }
+
+    if (!voice.pDecoder)
+    {
+        auto pWav = new drwav;
+        if (!drwav_init_file(pWav, pSource->path.string().c_str()))
+        {
+            delete pWav;
+            sample_stream_fail(voice, "Failed to open stream: ");
+            return false;
+        }
+
+        voice.pDecoder = pWav;
+        if (!drwav_seek_to_pcm_frame(pWav, pSource->headFrames))
+        {
+            sample_stream_fail(voice, "Failed to seek stream: ");
+            return false;
+        }
+    }
+
+    const auto ringFrames = uint64_t(streamer.settings.ringFrames);
+    const auto written = voice.written.load(std::memory_order_relaxed);
+    const auto consumed = voice.consumed.load(std::memory_order_acquire);
+    const auto space = ringFrames - (written - consumed);
+    const auto remaining = pSource->frames - pSource->headFrames - written;
+
+    auto toRead = std::min({ space, remaining, uint64_t(streamer.settings.readFrames) });
+    if (toRead == 0)
+    {
+        return false;
+    }
+
+    // Up to the end of the ring, the wrap is picked up next time round
+    const auto ringIndex = written % ringFrames;
+    toRead = std::min(toRead, ringFrames - ringIndex);
+
+    auto pWav = (drwav*)voice.pDecoder;
+    auto read = drwav_read_pcm_frames_f32(pWav, toRead, voice.ring.data() + ringIndex * pSource->channels);
+    if (read == 0)
+    {
+        // Shorter than its header said, or the file has gone
+        sample_stream_fail(voice, "Failed to read stream: ");
+        return false;
+    }
+
+    voice.written.store(written + read, std::memory_order_release);
+    return true;
+}
+
+// Frees replaced sources that no voice is playing. Voices are only started under the source lock, and
+// a source is out of the map once retired, so none can pick it up again.
+void sample_stream_free_retired(SampleStreamer& streamer)
+{
+    std::lock_guard<std::mutex> lock(streamer.sourceMutex);
+    auto itrEnd = std::remove_if(streamer.retired.begin(), streamer.retired.end(), [&](auto& spSource) {
+        for (uint32_t i = 0; i < streamer.settings.voiceCount; i++)
+        {
+            auto& voice = streamer.voices[i];
+            if (voice.pSource == spSource.get() && voice.state.load(std::memory_order_acquire) != SampleStreamVoiceState::Free)
+            {
+                return false;
+            }
+        }
+        return true;
+    });
+    streamer.retired.erase(itrEnd, streamer.retired.end());
+}
+
+void sample_stream_thread(SampleStreamer& streamer)
+{
+    TRACE_NAME_THREAD(SampleStream);
+
+    while (!streamer.quit.load(std::memory_order_relaxed))
+    {
+        bool busy = false;
+        for (uint32_t i = 0; i < streamer.settings.voiceCount; i++)
+        {
+            auto& voice = streamer.voices[i];
+            switch (voice.state.load(std::memory_order_acquire))
+            {
+            case SampleStreamVoiceState::Stopping:
+                sample_stream_close(voice);
+                voice.state.store(SampleStreamVoiceState::Free, std::memory_order_release);
+                break;
+            case SampleStreamVoiceState::Active:
+                busy |= sample_stream_fill(streamer, voice);
+                break;
+            default:
+                break;
+            }
+        }
+
+        sample_stream_free_retired(streamer);
+
+        if (!busy)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+}
+
+} // namespace
+
+void sample_stream_start(SampleStreamer& streamer, const SampleStreamSettings& settings)
+{
+    sample_stream_stop(streamer);
+
+    streamer.settings = settings;
+    streamer.voices = std::make_unique<SampleStreamVoice[]>(settings.voiceCount);
+    for (uint32_t i = 0; i < settings.voiceCount; i++)
+    {
+        // Stereo at most
+        streamer.voices[i].ring.resize(size_t(settings.ringFrames) * 2);
+    }
+
+    streamer.quit = false;
+    streamer.ioThread = std::thread([&streamer]() {
+        sample_stream_thread(streamer);
+    });
+}
+
+void sample_stream_stop(SampleStreamer& streamer)
+{
+    if (!streamer.ioThread.joinable())
+    {
+        return;
+    }
+
+    streamer.quit = true;
+    streamer.ioThread.join();
+
+    for (uint32_t i = 0; i < streamer.settings.voiceCount; i++)
+    {
+        sample_stream_close(streamer.voices[i]);
+    }
+    streamer.voices.reset();
+
+    std::lock_guard<std::mutex> lock(streamer.sourceMutex);
+    streamer.sources.clear();
+    streamer.retired.clear();
+}
+
+bool sample_stream_add(SampleStreamer& streamer, Zest::StringId id, const fs::path& path)
+{
+    drwav wav;
+    if (!drwav_init_file(&wav, path.string().c_str()))
+    {
+        LOG(DBG, "Failed to open stream: " << path.string());
+        return false;
+    }
+
+    if (wav.channels == 0 || wav.channels > 2)
+    {
+        LOG(DBG, "Only mono and stereo samples can be streamed: " << path.string());
+        drwav_uninit(&wav);
+        return false;
+    }
+
+    auto pSource = std::make_unique<SampleStreamSource>();
+    pSource->path = path;
+    pSource->channels = wav.channels;
+    pSource->sampleRate = wav.sampleRate;
+    pSource->frames = wav.totalPCMFrameCount;
+    pSource->head.resize(size_t(std::min(pSource->frames, uint64_t(streamer.settings.preloadFrames))) * wav.channels);
+    pSource->headFrames = drwav_read_pcm_frames_f32(&wav, pSource->head.size() / wav.channels, pSource->head.data());
+    drwav_uninit(&wav);
+
+    // A voice may still be playing the one this replaces
+    std::lock_guard<std::mutex> lock(streamer.sourceMutex);
+    auto& spSlot = streamer.sources[id];
+    if (spSlot)
+    {
+        streamer.retired.push_back(std::move(spSlot));
+    }
+    spSlot = std::move(pSource);
+    return true;
+}
+
+int sample_stream_play(SampleStreamer& streamer, Zest::StringId id, float gain)
+{
+    // Never wait on the audio thread; the note is dropped if a source is being added
+    std::unique_lock<std::mutex> lock(streamer.sourceMutex, std::try_to_lock);
+    if (!lock.owns_lock() || !streamer.voices)
+    {
+        return -1;
+    }
+
+    auto itr = streamer.sources.find(id);
+    if (itr == streamer.sources.end())
+    {
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < streamer.settings.voiceCount; i++)
+    {
+        auto& voice = streamer.voices[i];
+        if (voice.state.load(std::memory_order_acquire) != SampleStreamVoiceState::Free)
+        {
+            continue;
+        }
+
+        voice.pSource = itr->second.get();
+        voice.gain = gain;
+        voice.position = 0;
+        voice.releasing = false;
+        voice.releaseRemaining = 0;
+        voice.releaseLength = 0;
+        voice.written.store(0, std::memory_order_relaxed);
+        voice.consumed.store(0, std::memory_order_relaxed);
+        voice.underruns.store(0, std::memory_order_relaxed);
+        voice.failed.store(false, std::memory_order_relaxed);
+        voice.state.store(SampleStreamVoiceState::Active, std::memory_order_release);
+        return int(i);
+    }
+    return -1;
+}
+
+void sample_stream_release(SampleStreamer& streamer, int voice)
+{
+    if (voice < 0 || uint32_t(voice) >= streamer.settings.voiceCount)
+    {
+        return;
+    }
+
+    auto& v = streamer.voices[voice];
+    if (v.state.load(std::memory_order_acquire) == SampleStreamVoiceState::Active && !v.releasing)
+    {
+        v.releasing = true;
+        v.releaseRemaining = streamer.settings.releaseFrames;
+        v.releaseLength = streamer.settings.releaseFrames;
+    }
+}
+
+void sample_stream_release_all(SampleStreamer& streamer)
+{
+    for (uint32_t i = 0; streamer.voices && i < streamer.settings.voiceCount; i++)
+    {
+        sample_stream_release(streamer, int(i));
+    }
+}
+
+void sample_stream_render(SampleStreamer& streamer, float* pOutput, uint32_t frames, uint32_t channels)
+{
+    TRACE_SCOPE(sample_stream_render);
+
+    const auto ringFrames = uint64_t(streamer.settings.ringFrames);
+    for (uint32_t i = 0; streamer.voices && i < streamer.settings.voiceCount; i++)
+    {
+        auto& voice = streamer.voices[i];
+        if (voice.state.load(std::memory_order_acquire) != SampleStreamVoiceState::Active)
+        {
+            continue;
+        }
+
+        auto pSource = voice.pSource;
+        const auto sourceChannels = pSource->channels;
+        const auto available = pSource->headFrames + voice.written.load(std::memory_order_acquire);
+        const bool failed = voice.failed.load(std::memory_order_acquire);
+
+        auto pOut = pOutput;
+        bool finished = false;
+        for (uint32_t frame = 0; frame < frames; frame++)
+        {
+            if (voice.position >= pSource->frames || (voice.releasing && voice.releaseRemaining == 0))
+            {
+                finished = true;
+                break;
+            }
+
+            // Stall rather than skip, so the ring stays in step with the file
+            if (voice.position >= available)
+            {
+                if (failed)
+                {
+                    finished = true;
+                    break;
+                }
+                voice.underruns.fetch_add(1, std::memory_order_relaxed);
+                break;
+            }
+
+            // Nothing more is coming, so fade out to finish on the last frame there is
+            if (failed && available - voice.position <= streamer.settings.releaseFrames)
+            {
+                const auto left = uint32_t(available - voice.position);
+                if (!voice.releasing)
+                {
+                    voice.releasing = true;
+                    voice.releaseRemaining = left;
+                    voice.releaseLength = left;
+                }
+                else if (voice.releaseRemaining > left)
+                {
+                    // Already fading; carry on from the same level, just faster
+                    voice.releaseLength = std::max(uint32_t(uint64_t(voice.releaseLength) * left / voice.releaseRemaining), 1u);
+                    voice.releaseRemaining = left;
+                }
+            }
+
+            const float* pFrame;
+            if (voice.position < pSource->headFrames)
+            {
+                pFrame = pSource->head.data() + voice.position * sourceChannels;
+            }
+            else
+            {
+                pFrame = voice.ring.data() + ((voice.position - pSource->headFrames) % ringFrames) * sourceChannels;
+            }
+
+            auto gain = voice.gain;
+            if (voice.releasing)
+            {
+                gain *= float(voice.releaseRemaining--) / float(std::max(voice.releaseLength, 1u));
+            }
+
+            if (channels == 1)
+            {
+                pOut[0] += (sourceChannels == 2 ? (pFrame[0] + pFrame[1]) * 0.5f : pFrame[0]) * gain;
+            }
+            else
+            {
+                pOut[0] += pFrame[0] * gain;
+                pOut[1] += pFrame[sourceChannels - 1] * gain;
+            }
+            pOut += channels;
+            voice.position++;
+        }
+
+        if (voice.position > pSource->headFrames)
+        {
+            voice.consumed.store(voice.position - pSource->headFrames, std::memory_order_release);
+        }
+
+        if (finished)
+        {
+            voice.state.store(SampleStreamVoiceState::Stopping, std::memory_order_release);
+        }
+    }
+}
+
+uint32_t sample_stream_underruns(const SampleStreamer& streamer, int voice)
+{
+    if (!streamer.voices || voice < 0 || uint32_t(voice) >= streamer.settings.voiceCount)
+    {
+        return 0;
+    }
+    return streamer.voices[voice].underruns.load(std::memory_order_relaxed);
+}
+
+} // namespace Zing
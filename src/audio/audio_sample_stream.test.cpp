@@ -0,0 +1,275 @@
+#include <zing/pch.h>
+
+#include <dr_wav.h>
+
+#include <zing/audio/audio_sample_stream.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+constexpr uint32_t TestBlockFrames = 64;
+
+// Small buffers, so the ring wraps many times over a file
+SampleStreamSettings test_settings()
+{
+    SampleStreamSettings settings;
+    settings.voiceCount = 4;
+    settings.preloadFrames = 1000;
+    settings.ringFrames = 4096;
+    settings.readFrames = 512;
+    settings.releaseFrames = 256;
+    return settings;
+}
+
+fs::path test_write_wav(const std::string& name, const std::vector<float>& samples, uint32_t channels)
+{
+    const auto path = fs::temp_directory_path() / name;
+
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+    format.channels = channels;
+    format.sampleRate = 44100;
+    format.bitsPerSample = 32;
+
+    drwav wav;
+    REQUIRE(drwav_init_file_write(&wav, path.string().c_str(), &format));
+    REQUIRE(drwav_write_pcm_frames(&wav, samples.size() / channels, samples.data()) == samples.size() / channels);
+    drwav_uninit(&wav);
+    return path;
+}
+
+// Every frame distinct, so a frame out of place shows
+std::vector<float> test_ramp(uint32_t frames)
+{
+    std::vector<float> samples(frames);
+    for (uint32_t i = 0; i < frames; i++)
+    {
+        samples[i] = float(i % 10000) / 10000.0f + 0.001f;
+    }
+    return samples;
+}
+
+template <typename T>
+bool test_wait(T fnDone)
+{
+    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!fnDone())
+    {
+        if (std::chrono::steady_clock::now() > end)
+        {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Renders mono blocks until the voice stops, giving the I/O thread time whenever the ring runs dry
+std::vector<float> test_render_voice(SampleStreamer& streamer, int voice)
+{
+    auto& v = streamer.voices[voice];
+    std::vector<float> output;
+    std::vector<float> block(TestBlockFrames);
+    for (uint32_t blocks = 0; blocks < 100000 && v.state.load() == SampleStreamVoiceState::Active; blocks++)
+    {
+        const auto position = v.position;
+        std::fill(block.begin(), block.end(), 0.0f);
+        sample_stream_render(streamer, block.data(), TestBlockFrames, 1);
+
+        const auto rendered = size_t(v.position - position);
+        output.insert(output.end(), block.begin(), block.begin() + rendered);
+        if (rendered < TestBlockFrames)
+        {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+    return output;
+}
+
+size_t test_retired(SampleStreamer& streamer)
+{
+    std::lock_guard<std::mutex> lock(streamer.sourceMutex);
+    return streamer.retired.size();
+}
+
+} // namespace
+
+TEST_CASE("SampleStream.Playback", "[SampleStream]")
+{
+    // Many times the ring, so it wraps, and the head is read before the ring takes over
+    const auto samples = test_ramp(40000);
+    const auto path = test_write_wav("zing_test_stream.wav", samples, 1);
+
+    SampleStreamer streamer;
+    sample_stream_start(streamer, test_settings());
+    Zest::StringId id("stream");
+    REQUIRE(sample_stream_add(streamer, id, path));
+
+    auto voice = sample_stream_play(streamer, id, 1.0f);
+    REQUIRE(voice >= 0);
+
+    // Stalls are fine, but every frame comes out in order
+    auto output = test_render_voice(streamer, voice);
+    REQUIRE(output == samples);
+
+    // The I/O thread closes the file and frees the voice
+    REQUIRE(test_wait([&]() { return streamer.voices[voice].state.load() == SampleStreamVoiceState::Free; }));
+
+    sample_stream_stop(streamer);
+    fs::remove(path);
+}
+
+TEST_CASE("SampleStream.Channels", "[SampleStream]")
+{
+    // Short enough to sit in the head
+    std::vector<float> samples;
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        samples.push_back(0.25f);
+        samples.push_back(0.75f);
+    }
+    const auto path = test_write_wav("zing_test_stream_stereo.wav", samples, 2);
+
+    SampleStreamer streamer;
+    sample_stream_start(streamer, test_settings());
+    Zest::StringId id("stereo");
+    REQUIRE(sample_stream_add(streamer, id, path));
+    REQUIRE(sample_stream_play(streamer, Zest::StringId("missing"), 1.0f) == -1);
+
+    // Stereo to stereo, scaled by the gain
+    REQUIRE(sample_stream_play(streamer, id, 0.5f) >= 0);
+    std::vector<float> stereo(2 * TestBlockFrames, 0.0f);
+    sample_stream_render(streamer, stereo.data(), TestBlockFrames, 2);
+    REQUIRE(stereo[0] == 0.125f);
+    REQUIRE(stereo[1] == 0.375f);
+
+    // Stereo to mono: the average, mixed in with what is there
+    REQUIRE(sample_stream_play(streamer, id, 1.0f) >= 0);
+    std::vector<float> mono(TestBlockFrames, 1.0f);
+    sample_stream_render(streamer, mono.data(), TestBlockFrames, 1);
+    REQUIRE(mono[0] == Approx(1.0f + 0.5f * 0.5f + 0.5f));
+
+    sample_stream_stop(streamer);
+    fs::remove(path);
+}
+
+TEST_CASE("SampleStream.Release", "[SampleStream]")
+{
+    const auto path = test_write_wav("zing_test_stream_release.wav", std::vector<float>(2000, 1.0f), 1);
+
+    SampleStreamer streamer;
+    const auto settings = test_settings();
+    sample_stream_start(streamer, settings);
+    Zest::StringId id("release");
+    REQUIRE(sample_stream_add(streamer, id, path));
+
+    auto voice = sample_stream_play(streamer, id, 1.0f);
+    REQUIRE(voice >= 0);
+
+    std::vector<float> block(TestBlockFrames, 0.0f);
+    sample_stream_render(streamer, block.data(), TestBlockFrames, 1);
+    REQUIRE(block.back() == 1.0f);
+
+    // A straight fade over releaseFrames, then the voice stops
+    sample_stream_release(streamer, voice);
+    auto output = test_render_voice(streamer, voice);
+    REQUIRE(output.size() == settings.releaseFrames);
+    REQUIRE(output.front() == 1.0f);
+    for (size_t i = 1; i < output.size(); i++)
+    {
+        REQUIRE(output[i] < output[i - 1]);
+    }
+    REQUIRE(output.back() == Approx(1.0f / settings.releaseFrames));
+
+    sample_stream_stop(streamer);
+    fs::remove(path);
+}
+
+TEST_CASE("SampleStream.Failure", "[SampleStream]")
+{
+    const auto samples = std::vector<float>(40000, 0.5f);
+    const auto path = test_write_wav("zing_test_stream_failure.wav", samples, 1);
+
+    SampleStreamer streamer;
+    const auto settings = test_settings();
+    sample_stream_start(streamer, settings);
+    Zest::StringId id("failure");
+    REQUIRE(sample_stream_add(streamer, id, path));
+
+    // Gone before the I/O thread can open it; only the head can play
+    fs::remove(path);
+    auto voice = sample_stream_play(streamer, id, 1.0f);
+    REQUIRE(voice >= 0);
+    REQUIRE(test_wait([&]() { return streamer.voices[voice].failed.load(); }));
+
+    // The head plays out, fading over its last frames rather than stopping dead or stalling forever
+    auto test_fade_out = [&](int v) {
+        auto output = test_render_voice(streamer, v);
+        REQUIRE(output.size() == settings.preloadFrames);
+        REQUIRE(sample_stream_underruns(streamer, v) == 0);
+
+        const auto fadeStart = settings.preloadFrames - settings.releaseFrames;
+        for (uint32_t i = 0; i < fadeStart; i++)
+        {
+            REQUIRE(output[i] == 0.5f);
+        }
+        for (uint32_t i = fadeStart + 1; i < output.size(); i++)
+        {
+            REQUIRE(output[i] < output[i - 1]);
+        }
+        REQUIRE(output.back() < 0.01f);
+    };
+    test_fade_out(voice);
+
+    // The source is marked, so the next voice goes the same way without trying the file again
+    REQUIRE(streamer.voices[voice].pSource->failed.load());
+    auto second = sample_stream_play(streamer, id, 1.0f);
+    REQUIRE(second >= 0);
+    REQUIRE(test_wait([&]() { return streamer.voices[second].failed.load(); }));
+    test_fade_out(second);
+
+    REQUIRE(test_wait([&]() { return streamer.voices[second].state.load() == SampleStreamVoiceState::Free; }));
+    sample_stream_stop(streamer);
+}
+
+TEST_CASE("SampleStream.Retired", "[SampleStream]")
+{
+    const auto path = test_write_wav("zing_test_stream_retired.wav", std::vector<float>(5000, 0.5f), 1);
+
+    SampleStreamer streamer;
+    sample_stream_start(streamer, test_settings());
+    Zest::StringId id("retired");
+    REQUIRE(sample_stream_add(streamer, id, path));
+
+    // Replaced while a voice plays it; kept until the voice is done
+    auto voice = sample_stream_play(streamer, id, 1.0f);
+    REQUIRE(voice >= 0);
+    auto pOld = streamer.voices[voice].pSource;
+    REQUIRE(sample_stream_add(streamer, id, path));
+    REQUIRE(test_retired(streamer) == 1);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    REQUIRE(test_retired(streamer) == 1);
+
+    // New notes get the new source
+    auto newVoice = sample_stream_play(streamer, id, 1.0f);
+    REQUIRE(newVoice >= 0);
+    REQUIRE(streamer.voices[newVoice].pSource != pOld);
+
+    auto output = test_render_voice(streamer, voice);
+    REQUIRE(output.size() == 5000);
+    REQUIRE(test_wait([&]() { return test_retired(streamer) == 0; }));
+
+    // The audio thread never waits on a source being added
+    {
+        std::lock_guard<std::mutex> lock(streamer.sourceMutex);
+        REQUIRE(sample_stream_play(streamer, id, 1.0f) == -1);
+    }
+
+    sample_stream_stop(streamer);
+    fs::remove(path);
+}
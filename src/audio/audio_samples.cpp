@@ -1,13 +1,482 @@
 #include <zing/pch.h>
 
+#include <fstream>
+
 #include <zing/audio/audio.h>
 #include <zing/audio/audio_samples.h>
 
+// The parallel renderer works on individual tsf voices, so the implementation is built here
+#define TSF_IMPLEMENTATION
+#include <tsf/tsf.h>
+
 using namespace Zest;
 
 namespace Zing
 {
 
+namespace
+{
+
+void samples_render_job(void* pUser, uint32_t job)
+{
+    auto& render = *(SampleRenderState*)pUser;
+    auto pFont = render.pFont;
+
+    // Job 0 mixes directly into the output
+    auto pOut = render.pOutput;
+    if (job != 0)
+    {
+        pOut = render.scratch.data() + size_t(job - 1) * render.scratchStride;
+        std::fill(pOut, pOut + render.scratchStride, 0.0f);
+    }
+
+    for (uint32_t i = render.jobVoices[job]; i < render.jobVoices[job + 1]; i++)
+    {
+        tsf_voice_render(pFont, &pFont->voices[render.activeVoices[i]], pOut, int(render.frames));
+    }
+}
+
+// Flat loop over contiguous floats; vectorized by the compiler
+void samples_mix(float* pOut, const float* pIn, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++)
+    {
+        pOut[i] += pIn[i];
+    }
+}
+
+float samples_voice_steal_score(const tsf* pFont, const tsf_voice& voice)
+{
+    return samples_steal_score(voice.noteGainDB, voice.ampenv.level, voice.ampenv.segment == TSF_SEGMENT_RELEASE, pFont->voicePlayIndex - voice.playIndex);
+}
+
+// tsf_voice_endquick zeros the release time; such a voice is already on its way out
+bool samples_voice_stolen(const tsf_voice& voice)
+{
+    return voice.ampenv.segment == TSF_SEGMENT_RELEASE && voice.ampenv.parameters.release == 0.0f;
+}
+
+// Voices sounding across all the fonts, not counting those already stolen
+uint32_t samples_active_voices(const AudioSamples& audioSamples)
+{
+    uint32_t active = 0;
+    for (auto pFont : audioSamples.fonts)
+    {
+        for (int voice = 0; voice < pFont->voiceNum; voice++)
+        {
+            const auto& v = pFont->voices[voice];
+            if (v.playingPreset != -1 && !samples_voice_stolen(v))
+            {
+                active++;
+            }
+        }
+    }
+    return active;
+}
+
+void samples_render_font(SampleRenderState& render, tsf* pFont, float* pOutput, uint32_t frames)
+{
+    const auto workerCount = audio_workers_count(render.workers);
+    if (workerCount < 2 || render.activeVoices.capacity() < uint32_t(pFont->voiceNum))
+    {
+        tsf_render_float(pFont, pOutput, int(frames), 1);
+        return;
+    }
+
+    render.activeVoices.clear();
+    for (int voice = 0; voice < pFont->voiceNum; voice++)
+    {
+        if (pFont->voices[voice].playingPreset != -1)
+        {
+            render.activeVoices.push_back(uint32_t(voice));
+        }
+    }
+
+    // Not worth waking anyone for a few voices
+    const auto activeCount = uint32_t(render.activeVoices.size());
+    const auto jobs = std::min(workerCount, activeCount / std::max(render.minVoicesPerJob, 1u));
+    if (jobs < 2)
+    {
+        tsf_render_float(pFont, pOutput, int(frames), 1);
+        return;
+    }
+
+    const uint32_t channels = pFont->outputmode == TSF_MONO ? 1 : 2;
+    render.pFont = pFont;
+    render.pOutput = pOutput;
+    render.frames = frames;
+    render.scratchStride = frames * channels;
+
+    // Even split of the active voices
+    for (uint32_t job = 0; job <= jobs; job++)
+    {
+        render.jobVoices[job] = (activeCount * job) / jobs;
+    }
+
+    audio_workers_run(render.workers, jobs, samples_render_job, &render);
+
+    for (uint32_t job = 1; job < jobs; job++)
+    {
+        samples_mix(pOutput, render.scratch.data() + size_t(job - 1) * render.scratchStride, render.scratchStride);
+    }
+
+    render.pFont = nullptr;
+    render.pOutput = nullptr;
+}
+
+
+// Preprocessed soundfont cache.
+// Header, preset table, the raw tsf_region array, then the float samples on a page boundary, so
+// a warm start maps the file and points tsf straight at it.
+constexpr char SampleCacheMagic[8] = { 'Z', 'I', 'N', 'G', 'S', 'F', '2', 'C' };
+constexpr uint32_t SampleCacheVersion = 1;
+constexpr uint64_t SampleCachePageSize = 4096;
+
+struct SampleCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t presetSize;
+    uint32_t regionSize; // A tsf update that changes the region layout invalidates the cache
+    uint32_t presetCount;
+    uint64_t regionCount;
+    uint64_t sourceHash;
+    uint64_t sourceSize;
+    uint64_t presetOffset;
+    uint64_t regionOffset;
+    uint64_t sampleOffset;
+    uint64_t sampleCount;
+};
+
+struct SampleCachePreset
+{
+    char name[20];
+    uint16_t preset;
+    uint16_t bank;
+    uint64_t regionStart;
+    uint64_t regionCount;
+};
+
+uint64_t samples_cache_align(uint64_t offset, uint64_t align)
+{
+    return (offset + align - 1) & ~(align - 1);
+}
+
+// tsf uses one sample per 16 bit point in the smpl chunk
+uint64_t samples_cache_sample_count(const SF2Index& index)
+{
+    return index.samples.size / sizeof(int16_t);
+}
+
+tsf* samples_cache_load(SampleContainer& container, const fs::path& cachePath, uint64_t hash)
+{
+    if (!fs::exists(cachePath) || !sf2_map_file(cachePath, container.cache))
+    {
+        return nullptr;
+    }
+
+    auto& cache = container.cache;
+    SampleCacheHeader header;
+    bool valid = cache.size >= sizeof(header);
+    if (valid)
+    {
+        memcpy(&header, cache.pData, sizeof(header));
+        valid = memcmp(header.magic, SampleCacheMagic, sizeof(SampleCacheMagic)) == 0 &&
+            header.version == SampleCacheVersion &&
+            header.presetSize == sizeof(SampleCachePreset) &&
+            header.regionSize == sizeof(tsf_region) &&
+            header.sourceHash == hash &&
+            header.sourceSize == container.file.size &&
+            header.sampleCount == samples_cache_sample_count(container.index) &&
+            header.presetOffset + header.presetCount * sizeof(SampleCachePreset) <= cache.size &&
+            header.regionOffset + header.regionCount * sizeof(tsf_region) <= cache.size &&
+            header.sampleOffset + header.sampleCount * sizeof(float) <= cache.size;
+    }
+
+    if (!valid)
+    {
+        LOG(DBG, "Stale soundfont cache: " << cachePath.string());
+        sf2_unmap_file(cache);
+        return nullptr;
+    }
+
+    // Only the preset table is copied, since it points at the regions
+    auto pPresets = (const SampleCachePreset*)(cache.pData + header.presetOffset);
+    auto pRegions = (tsf_region*)(cache.pData + header.regionOffset);
+
+    auto pFont = (tsf*)malloc(sizeof(tsf));
+    memset(pFont, 0, sizeof(tsf));
+    pFont->presetNum = int(header.presetCount);
+    pFont->presets = (tsf_preset*)malloc(sizeof(tsf_preset) * header.presetCount);
+    for (uint32_t i = 0; i < header.presetCount; i++)
+    {
+        auto& preset = pFont->presets[i];
+        const auto& cached = pPresets[i];
+        if (cached.regionStart + cached.regionCount > header.regionCount)
+        {
+            LOG(DBG, "Corrupt soundfont cache: " << cachePath.string());
+            free(pFont->presets);
+            free(pFont);
+            sf2_unmap_file(cache);
+            return nullptr;
+        }
+        memcpy(preset.presetName, cached.name, sizeof(preset.presetName));
+        preset.preset = cached.preset;
+        preset.bank = cached.bank;
+        preset.regions = pRegions + cached.regionStart;
+        preset.regionNum = int(cached.regionCount);
+    }
+    pFont->fontSamples = (float*)(cache.pData + header.sampleOffset);
+    pFont->outSampleRate = 44100.0f;
+
+    // The cache holds a reference, so tsf_close never frees the mapped tables; see samples_close
+    pFont->refCount = (int*)malloc(sizeof(int));
+    *pFont->refCount = 2;
+    return pFont;
+}
+
+void samples_cache_write(const tsf* pFont, uint64_t sampleCount, const fs::path& cachePath, uint64_t hash, uint64_t sourceSize)
+{
+    TRACE_SCOPE(samples_cache_write);
+
+    SampleCacheHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SampleCacheMagic, sizeof(SampleCacheMagic));
+    header.version = SampleCacheVersion;
+    header.presetSize = sizeof(SampleCachePreset);
+    header.regionSize = sizeof(tsf_region);
+    header.presetCount = uint32_t(pFont->presetNum);
+    header.sourceHash = hash;
+    header.sourceSize = sourceSize;
+    header.sampleCount = sampleCount;
+
+    std::vector<SampleCachePreset> presets(pFont->presetNum);
+    for (int i = 0; i < pFont->presetNum; i++)
+    {
+        const auto& preset = pFont->presets[i];
+        auto& cached = presets[i];
+        memset(&cached, 0, sizeof(cached));
+        memcpy(cached.name, preset.presetName, sizeof(cached.name));
+        cached.preset = preset.preset;
+        cached.bank = preset.bank;
+        cached.regionStart = header.regionCount;
+        cached.regionCount = uint64_t(preset.regionNum);
+        header.regionCount += cached.regionCount;
+    }
+
+    header.presetOffset = samples_cache_align(sizeof(header), 16);
+    header.regionOffset = samples_cache_align(header.presetOffset + presets.size() * sizeof(SampleCachePreset), 16);
+    header.sampleOffset = samples_cache_align(header.regionOffset + header.regionCount * sizeof(tsf_region), SampleCachePageSize);
+
+    std::error_code ec;
+    fs::create_directories(cachePath.parent_path(), ec);
+
+    // Written to the side and renamed, so a reader never sees half a cache
+    auto tempPath = cachePath;
+    tempPath += ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out)
+        {
+            LOG(DBG, "Failed to write soundfont cache: " << cachePath.string());
+            return;
+        }
+
+        auto padTo = [&](uint64_t offset) {
+            static const char zeros[SampleCachePageSize] = {};
+            auto current = uint64_t(out.tellp());
+            out.write(zeros, std::streamsize(offset - current));
+        };
+
+        out.write((const char*)&header, sizeof(header));
+        padTo(header.presetOffset);
+        out.write((const char*)presets.data(), std::streamsize(presets.size() * sizeof(SampleCachePreset)));
+        padTo(header.regionOffset);
+        for (int i = 0; i < pFont->presetNum; i++)
+        {
+            out.write((const char*)pFont->presets[i].regions, std::streamsize(pFont->presets[i].regionNum * sizeof(tsf_region)));
+        }
+        padTo(header.sampleOffset);
+        out.write((const char*)pFont->fontSamples, std::streamsize(sampleCount * sizeof(float)));
+
+        if (!out)
+        {
+            LOG(DBG, "Failed to write soundfont cache: " << cachePath.string());
+            out.close();
+            fs::remove(tempPath, ec);
+            return;
+        }
+    }
+
+    fs::rename(tempPath, cachePath, ec);
+    if (ec)
+    {
+        fs::remove(tempPath, ec);
+    }
+}
+
+// With no cache directory set the cache goes in the temp directory, where it is found again next run
+fs::path samples_default_cache_directory()
+{
+    std::error_code ec;
+    auto tempPath = fs::temp_directory_path(ec);
+    if (ec)
+    {
+        return fs::path();
+    }
+    return tempPath / "zing";
+}
+
+// Earlier builds paged from a copy of the font made for each run, and a crash left it behind
+void samples_remove_scratch()
+{
+    static std::once_flag once;
+    std::call_once(once, []() {
+        const auto directory = samples_default_cache_directory();
+        if (!directory.empty())
+        {
+            std::error_code ec;
+            fs::remove_all(directory / "scratch", ec);
+        }
+    });
+}
+
+// Points tsf reads past the end of a region when interpolating
+constexpr uint64_t SamplePrefetchGuard = 2;
+
+// Starts reading in the samples of every region of the preset, so its first notes don't fault them in
+void samples_prefetch_preset(const SamplePrefetchRequest& request)
+{
+    auto pFont = request.pFont;
+    const auto& cache = *request.pCache;
+    if (request.presetIndex < 0 || request.presetIndex >= pFont->presetNum || !cache.pData)
+    {
+        return;
+    }
+
+    const auto sampleOffset = uint64_t((const uint8_t*)pFont->fontSamples - cache.pData);
+    const auto& preset = pFont->presets[request.presetIndex];
+    for (int i = 0; i < preset.regionNum; i++)
+    {
+        const auto& region = preset.regions[i];
+        const auto start = sampleOffset + uint64_t(region.offset) * sizeof(float);
+        const auto end = std::min(sampleOffset + (uint64_t(region.end) + SamplePrefetchGuard) * sizeof(float), cache.size);
+        if (end > start)
+        {
+            sf2_advise(cache, SF2Chunk{ start, end - start }, SF2Access::WillNeed);
+        }
+    }
+}
+
+void samples_prefetch_thread(SamplePrefetch& prefetch)
+{
+    TRACE_NAME_THREAD(SamplePrefetch);
+
+    SamplePrefetchRequest request;
+    while (!prefetch.quit.load())
+    {
+        if (!prefetch.requests.try_dequeue(request))
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            continue;
+        }
+
+        TRACE_SCOPE(samples_prefetch);
+        samples_prefetch_preset(request);
+    }
+}
+
+void samples_prefetch_start(SamplePrefetch& prefetch)
+{
+    if (prefetch.thread.joinable())
+    {
+        return;
+    }
+
+    prefetch.quit = false;
+    prefetch.thread = std::thread([&prefetch]() {
+        samples_prefetch_thread(prefetch);
+    });
+}
+
+void samples_prefetch_stop(SamplePrefetch& prefetch)
+{
+    if (!prefetch.thread.joinable())
+    {
+        return;
+    }
+
+    prefetch.quit = true;
+    prefetch.thread.join();
+
+    // Anything left refers to fonts which are about to close
+    SamplePrefetchRequest request;
+    while (prefetch.requests.try_dequeue(request))
+    {
+    }
+}
+
+void samples_close(SampleContainer& container)
+{
+    if (!container.soundFont)
+    {
+        return;
+    }
+
+    if (container.cache.pData)
+    {
+        // tsf_close drops our extra reference, and frees the voices and channels
+        auto pPresets = container.soundFont->presets;
+        auto pRefCount = container.soundFont->refCount;
+        tsf_close(container.soundFont);
+        free(pPresets);
+        free(pRefCount);
+        sf2_unmap_file(container.cache);
+    }
+    else
+    {
+        tsf_close(container.soundFont);
+    }
+    container.soundFont = nullptr;
+}
+
+} // namespace
+
+fs::path samples_cache_path(const fs::path& cacheDirectory, const fs::path& path)
+{
+    std::error_code ec;
+    auto sourcePath = fs::weakly_canonical(path, ec);
+    if (ec)
+    {
+        sourcePath = fs::absolute(path, ec);
+    }
+
+    const auto source = sourcePath.generic_string();
+    uint64_t hash = 14695981039346656037ull;
+    for (auto c : source)
+    {
+        hash = (hash ^ uint8_t(c)) * 1099511628211ull;
+    }
+    return cacheDirectory / fmt::format("{}.{:016x}.zcache", path.filename().string(), hash);
+}
+
+// Hashing the samples would cost as much as decoding them; any edit to the font changes the
+// info or hydra chunks, and the file size catches the rest
+uint64_t samples_cache_hash(const SF2MappedFile& file, const SF2Index& index)
+{
+    uint64_t hash = 14695981039346656037ull;
+    auto add = [&](const uint8_t* p, uint64_t size) {
+        for (uint64_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ p[i]) * 1099511628211ull;
+        }
+    };
+    add(file.pData + index.info.offset, index.info.size);
+    add(file.pData + index.hydra.offset, index.hydra.size);
+    add((const uint8_t*)&file.size, sizeof(file.size));
+    return hash;
+}
+
 bool samples_add(AudioSamples& audioSamples, Zest::StringId id, const fs::path& path)
 {
     try
@@ -17,24 +486,111 @@ bool samples_add(AudioSamples& audioSamples, Zest::StringId id, const fs::path&
             return false;
         }
 
-        SampleContainer container;
-        container.soundFont = tsf_load_filename(path.string().c_str());
-        if (!container.soundFont)
+        std::lock_guard<std::mutex> lock(audioSamples.sampleMutex);
+        if (audioSamples.samples.find(id) != audioSamples.samples.end())
         {
+            LOG(DBG, "Samples already added: " << path.string());
             return false;
         }
 
-        audioSamples.samples[id] = container;
+        // Only the headers are read here; the sample data stays on disk until the loader gets to it
+        auto& container = audioSamples.samples[id];
+        if (!sf2_map_file(path, container.file) || !sf2_read_index(container.file, container.index))
+        {
+            LOG(DBG, "Not a soundfont: " << path.string());
+            sf2_unmap_file(container.file);
+            audioSamples.samples.erase(id);
+            return false;
+        }
 
-        int pre = tsf_get_presetcount(container.soundFont);
-        for (int i = 0; i < pre; i++)
+        for (int i = 0; i < int(container.index.presets.size()); i++)
         {
-            std::string name = tsf_get_presetname(container.soundFont, i);
+            const auto& name = container.index.presets[i].name;
             LOG(DBG, i << ":" << name);
             audioSamples.presetSamples[name] = id;
         }
 
-        tsf_set_max_voices(container.soundFont, 256);
+        samples_remove_scratch();
+
+        const auto cacheDirectory = audioSamples.cacheDirectory.empty() ? samples_default_cache_directory() : audioSamples.cacheDirectory;
+        fs::path cachePath;
+        if (!cacheDirectory.empty())
+        {
+            cachePath = samples_cache_path(cacheDirectory, path);
+        }
+
+        samples_prefetch_start(audioSamples.prefetch);
+
+        // The map is node based, so the container address is stable while the loader runs
+        container.loader = std::async(std::launch::async, [&audioSamples, &container, cachePath]() {
+            TRACE_NAME_THREAD(SampleLoader);
+            TRACE_SCOPE(samples_load);
+
+            tsf* pFont = nullptr;
+            const auto hash = samples_cache_hash(container.file, container.index);
+            if (!cachePath.empty())
+            {
+                pFont = samples_cache_load(container, cachePath, hash);
+            }
+
+            if (!pFont)
+            {
+                sf2_advise(container.file, container.index.samples, SF2Access::Sequential);
+
+                auto pDecoded = tsf_load_memory(container.file.pData, int(container.file.size));
+                if (!pDecoded)
+                {
+                    LOG(ERR, "Failed to load soundfont");
+                    return (tsf*)nullptr;
+                }
+
+                // Written out once and mapped back in, so the floats are paged from disk as they are
+                // played instead of all staying resident; later runs map the cache straight away
+                if (!cachePath.empty())
+                {
+                    samples_cache_write(pDecoded, samples_cache_sample_count(container.index), cachePath, hash, container.file.size);
+                    pFont = samples_cache_load(container, cachePath, hash);
+                }
+
+                if (pFont)
+                {
+                    tsf_close(pDecoded);
+                }
+                else
+                {
+                    LOG(DBG, "Soundfont can't be paged, keeping it in memory: " << cachePath.string());
+                    pFont = pDecoded;
+                }
+            }
+            tsf_set_max_voices(pFont, int(audioSamples.maxVoices));
+
+            // Every channel made now; tsf grows its channel array on first use, which would be on the audio thread.
+            // The preset given is the one a new channel starts with anyway
+            tsf_channel_set_presetindex(pFont, int(audioSamples.channelFonts.size()) - 1, 0);
+
+            // The font plays from the cache mapping now, or from its own float copy
+            sf2_unmap_file(container.file);
+
+            auto& ctx = GetAudioContext();
+            std::lock_guard<std::mutex> lock(audioSamples.sampleMutex);
+            if (ctx.outputState.channelCount != 0)
+            {
+                tsf_set_output(pFont, ctx.outputState.channelCount == 2 ? TSF_STEREO_INTERLEAVED : TSF_MONO, ctx.outputState.sampleRate, 0.0f);
+            }
+            container.soundFont = pFont;
+
+            // Channels with nowhere to go start on the first font that arrives
+            audioSamples.fonts.push_back(pFont);
+            audioSamples.fontCaches.push_back(container.cache.pData ? &container.cache : nullptr);
+            for (auto& pChannelFont : audioSamples.channelFonts)
+            {
+                if (!pChannelFont)
+                {
+                    pChannelFont = pFont;
+                }
+            }
+            return pFont;
+        });
 
         return true;
     }
@@ -46,6 +602,62 @@ bool samples_add(AudioSamples& audioSamples, Zest::StringId id, const fs::path&
     }
 }
 
+bool samples_add_stream(AudioSamples& audioSamples, Zest::StringId id, const fs::path& path)
+{
+    if (!fs::exists(path))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(audioSamples.sampleMutex);
+    if (!audioSamples.streamer.ioThread.joinable())
+    {
+        sample_stream_start(audioSamples.streamer, audioSamples.streamer.settings);
+    }
+    return sample_stream_add(audioSamples.streamer, id, path);
+}
+
+// True when all the fonts have finished loading
+bool samples_loaded(AudioSamples& audioSamples)
+{
+    std::lock_guard<std::mutex> lock(audioSamples.sampleMutex);
+    for (auto& [id, container] : audioSamples.samples)
+    {
+        if (container.loader.valid() && container.loader.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void samples_destroy(AudioSamples& audioSamples)
+{
+    // Don't hold the lock while waiting, the loaders need it to publish
+    for (auto& [id, container] : audioSamples.samples)
+    {
+        if (container.loader.valid())
+        {
+            container.loader.wait();
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(audioSamples.sampleMutex);
+    sample_stream_stop(audioSamples.streamer);
+    samples_prefetch_stop(audioSamples.prefetch);
+
+    for (auto& [id, container] : audioSamples.samples)
+    {
+        samples_close(container);
+        sf2_unmap_file(container.file);
+    }
+    audioSamples.fonts.clear();
+    audioSamples.fontCaches.clear();
+    audioSamples.channelFonts.fill(nullptr);
+    audioSamples.samples.clear();
+    audioSamples.presetSamples.clear();
+}
+
 void samples_update_rate(AudioSamples& audioSamples)
 {
     auto& ctx = GetAudioContext();
@@ -54,6 +666,7 @@ void samples_update_rate(AudioSamples& audioSamples)
         return;
     }
 
+    std::lock_guard<std::mutex> lock(audioSamples.sampleMutex);
     for (auto& [id, container] : audioSamples.samples)
     {
         if (container.soundFont)
@@ -65,7 +678,7 @@ void samples_update_rate(AudioSamples& audioSamples)
 
 void samples_stop(AudioSamples& audioSamples)
 {
-    auto& ctx = GetAudioContext();
+    std::lock_guard<std::mutex> lock(audioSamples.sampleMutex);
     for (auto& [id, container] : audioSamples.samples)
     {
         if (container.soundFont)
@@ -76,6 +689,7 @@ void samples_stop(AudioSamples& audioSamples)
             tsf_channel_note_off_all(container.soundFont, 1);
         }
     }
+    sample_stream_release_all(audioSamples.streamer);
 }
 
 void samples_render(AudioSamples& audioSamples, float* pOutput, uint32_t numSamples)
@@ -85,26 +699,220 @@ void samples_render(AudioSamples& audioSamples, float* pOutput, uint32_t numSamp
     {
         return;
     }
-    for (auto& [id, container] : audioSamples.samples)
+
+    auto& render = audioSamples.render;
+    const uint32_t channels = ctx.outputState.channelCount == 2 ? 2 : 1;
+    for (auto pFont : audioSamples.fonts)
     {
-        if (container.soundFont)
+        // Idle fonts cost nothing
+        if (tsf_active_voice_count(pFont) == 0)
+        {
+            continue;
+        }
+
+        // Scratch is sized for maxBlockFrames, so split anything bigger
+        for (uint32_t frame = 0; frame < numSamples; frame += render.maxBlockFrames)
         {
-            tsf_render_float(container.soundFont, (float*)pOutput, int(numSamples), 1);
+            const auto frames = std::min(render.maxBlockFrames, numSamples - frame);
+            samples_render_font(render, pFont, pOutput + size_t(frame) * channels, frames);
         }
     }
 }
 
-const SampleContainer* samples_find(AudioSamples& audioSamples)
+void samples_set_render_workers(AudioSamples& audioSamples, uint32_t threadCount)
 {
-    auto& ctx = GetAudioContext();
-    for (auto& [id, container] : audioSamples.samples)
+    auto& render = audioSamples.render;
+    audio_workers_start(render.workers, threadCount);
+
+    const auto workerCount = audio_workers_count(render.workers);
+    render.scratch.assign(size_t(workerCount - 1) * render.maxBlockFrames * 2, 0.0f);
+    render.activeVoices.reserve(audioSamples.maxVoices);
+    render.jobVoices.assign(workerCount + 1, 0);
+}
+
+void samples_governor_tick(AudioSamples& audioSamples, double tickSeconds, double deadlineSeconds)
+{
+    auto& governor = audioSamples.governor;
+    if (deadlineSeconds <= 0.0)
     {
-        if (container.soundFont)
+        return;
+    }
+
+    governor.tickLoad = float(tickSeconds / deadlineSeconds);
+    governor.newLoad = true;
+
+    // Fast attack, slow decay for display
+    auto load = governor.load.load(std::memory_order_relaxed);
+    governor.load.store(governor.tickLoad > load ? governor.tickLoad : load + (governor.tickLoad - load) * 0.05f, std::memory_order_relaxed);
+}
+
+void samples_govern(AudioSamples& audioSamples)
+{
+    TRACE_SCOPE(samples_govern);
+
+    auto& governor = audioSamples.governor;
+
+    const auto active = samples_active_voices(audioSamples);
+    governor.activeVoices.store(active, std::memory_order_relaxed);
+
+    auto limit = governor.voiceLimit.load(std::memory_order_relaxed);
+    if (limit == 0 || !governor.enabled.load(std::memory_order_relaxed))
+    {
+        governor.voiceLimit.store(audioSamples.maxVoices, std::memory_order_relaxed);
+        governor.newLoad = false;
+        governor.headroomTicks = 0;
+        return;
+    }
+
+    if (!governor.newLoad)
+    {
+        return;
+    }
+    governor.newLoad = false;
+
+    // Voice cost is roughly linear, so scale the current count to what should have fit
+    const auto highLoad = governor.highLoad.load(std::memory_order_relaxed);
+    if (governor.tickLoad > highLoad)
+    {
+        auto target = uint32_t(float(active) * highLoad / governor.tickLoad);
+        limit = std::max(governor.minVoices, std::min(limit, target));
+        governor.headroomTicks = 0;
+    }
+    else if (governor.tickLoad < governor.lowLoad.load(std::memory_order_relaxed))
+    {
+        if (++governor.headroomTicks >= governor.raiseTicks)
+        {
+            limit = std::min(audioSamples.maxVoices, limit + governor.raiseStep);
+            governor.headroomTicks = 0;
+        }
+    }
+    else
+    {
+        governor.headroomTicks = 0;
+    }
+    governor.voiceLimit.store(limit, std::memory_order_relaxed);
+
+    samples_steal_voices(audioSamples, limit);
+}
+
+// A held note loses this much of its score each time the number of notes started after it doubles
+constexpr float SampleStealAgeDb = 6.0f;
+
+// Anything already releasing goes first, quietest first; its envelope level is meaningful by then.
+// A held note is scored by its note gain (velocity and region attenuation), less its age, so the oldest
+// go before the newest; the envelope level isn't used, as it is near zero through the delay and attack
+// of a note that has only just started.
+float samples_steal_score(float noteGainDb, float envelopeLevel, bool releasing, uint32_t age)
+{
+    if (releasing)
+    {
+        return noteGainDb + 20.0f * std::log10(std::max(envelopeLevel, 1e-5f)) - 1000.0f;
+    }
+    return noteGainDb - SampleStealAgeDb * std::log2(1.0f + float(age));
+}
+
+uint32_t samples_steal_voices(AudioSamples& audioSamples, uint32_t limit)
+{
+    auto& governor = audioSamples.governor;
+
+    auto active = samples_active_voices(audioSamples);
+
+    // Steal the lowest scoring voice until we fit; a steal is rare, and this doesn't need any storage
+    while (active > limit)
+    {
+        tsf* pStealFont = nullptr;
+        tsf_voice* pSteal = nullptr;
+        float stealScore = std::numeric_limits<float>::max();
+        for (auto pFont : audioSamples.fonts)
+        {
+            for (int voice = 0; voice < pFont->voiceNum; voice++)
+            {
+                auto& v = pFont->voices[voice];
+                if (v.playingPreset == -1 || samples_voice_stolen(v))
+                {
+                    continue;
+                }
+
+                // Oldest first on a tie
+                auto score = samples_voice_steal_score(pFont, v);
+                if (score < stealScore || (score == stealScore && pSteal && v.playIndex < pSteal->playIndex))
+                {
+                    stealScore = score;
+                    pSteal = &v;
+                    pStealFont = pFont;
+                }
+            }
+        }
+
+        if (!pSteal)
         {
-            return &container;
+            break;
         }
+
+        tsf_voice_endquick(pStealFont, pSteal);
+        governor.stolenVoices.fetch_add(1, std::memory_order_relaxed);
+        active--;
+    }
+    return active;
+}
+
+void samples_note_on(AudioSamples& audioSamples, tsf* pFont, int channel, int key, float velocity)
+{
+    // Make room first, so the new note isn't cut by the next governor tick
+    auto& governor = audioSamples.governor;
+    const auto limit = governor.voiceLimit.load(std::memory_order_relaxed);
+    if (limit != 0 && governor.enabled.load(std::memory_order_relaxed))
+    {
+        samples_steal_voices(audioSamples, limit - 1);
+    }
+    tsf_channel_note_on(pFont, channel, key, velocity);
+}
+
+tsf* samples_channel_font(AudioSamples& audioSamples, int channel)
+{
+    if (channel < 0 || channel >= int(audioSamples.channelFonts.size()))
+    {
+        return nullptr;
+    }
+    return audioSamples.channelFonts[channel];
+}
+
+void samples_program_change(AudioSamples& audioSamples, int channel, int program, bool drums)
+{
+    if (channel < 0 || channel >= int(audioSamples.channelFonts.size()) || audioSamples.fonts.empty())
+    {
+        return;
+    }
+
+    // First font with the preset wins; otherwise stay where we are and let tsf fall back
+    auto& pRoute = audioSamples.channelFonts[channel];
+    const int bank = drums ? 128 : 0;
+    const SF2MappedFile* pCache = nullptr;
+    int presetIndex = -1;
+    const auto font = samples_route_program(audioSamples.fonts.size(), [&](size_t index) {
+        return tsf_get_presetindex(audioSamples.fonts[index], bank, program);
+    }, presetIndex);
+    if (font >= 0)
+    {
+        auto pFont = audioSamples.fonts[font];
+        if (pRoute && pRoute != pFont)
+        {
+            tsf_channel_note_off_all(pRoute, channel);
+        }
+        pRoute = pFont;
+        pCache = audioSamples.fontCaches[font];
+    }
+
+    if (pRoute)
+    {
+        tsf_channel_set_presetnumber(pRoute, channel, program, drums ? 1 : 0);
+    }
+
+    // Page the preset's samples in ahead of its first note
+    if (pCache)
+    {
+        audioSamples.prefetch.requests.try_enqueue(SamplePrefetchRequest{ pCache, pRoute, presetIndex });
     }
-    return nullptr;
 }
 
 } //namespace Zing
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include <zing/pch.h>
+
+#include <numeric>
+
+#include <zing/audio/audio_samples.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+// A voice as the governor sees it
+struct TestVoice
+{
+    float noteGainDb = 0.0f;
+    float level = 0.0f;
+    bool releasing = false;
+    uint32_t playIndex = 0;
+};
+
+// The voices in the order the governor steals them, with 'next' the font's next play index
+std::vector<size_t> test_steal_order(const std::vector<TestVoice>& voices, uint32_t next)
+{
+    std::vector<size_t> order(voices.size());
+    std::iota(order.begin(), order.end(), size_t(0));
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        const auto& va = voices[a];
+        const auto& vb = voices[b];
+        return samples_steal_score(va.noteGainDb, va.level, va.releasing, next - va.playIndex) < samples_steal_score(vb.noteGainDb, vb.level, vb.releasing, next - vb.playIndex);
+    });
+    return order;
+}
+
+} // namespace
+
+TEST_CASE("Samples.StealReleasingFirst", "[Samples]")
+{
+    // A loud held note, a fading one, and one just into its attack at zero level
+    std::vector<TestVoice> voices = {
+        { 0.0f, 1.0f, false, 0 },
+        { 0.0f, 0.5f, true, 1 },
+        { 0.0f, 0.0f, false, 2 },
+    };
+
+    // The releasing note goes first, then the held one; the note just starting goes last
+    REQUIRE(test_steal_order(voices, 3) == std::vector<size_t>{ 1, 0, 2 });
+
+    // Even a loud releasing note goes before a quiet new one, and quieter releases before louder
+    voices.push_back({ 12.0f, 1.0f, true, 3 });
+    voices.push_back({ -40.0f, 0.0f, false, 4 });
+    auto order = test_steal_order(voices, 5);
+    REQUIRE(order[0] == 1);
+    REQUIRE(order[1] == 3);
+}
+
+TEST_CASE("Samples.StealOldestHeld", "[Samples]")
+{
+    // Held notes of the same gain; the last two still in their delay and attack
+    std::vector<TestVoice> voices;
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        voices.push_back({ -6.0f, i < 8 ? 0.8f : 0.0f, false, i });
+    }
+
+    // Oldest first, whatever the envelope level
+    auto order = test_steal_order(voices, 10);
+    for (size_t i = 0; i < order.size(); i++)
+    {
+        REQUIRE(order[i] == i);
+    }
+}
+
+TEST_CASE("Samples.StealByGain", "[Samples]")
+{
+    // A much quieter note goes before a louder one, even if it is newer
+    REQUIRE(samples_steal_score(-40.0f, 0.0f, false, 0) < samples_steal_score(0.0f, 1.0f, false, 1));
+
+    // A little quieter isn't enough to save an old note from a new one
+    REQUIRE(samples_steal_score(0.0f, 1.0f, false, 100) < samples_steal_score(-6.0f, 0.0f, false, 0));
+
+    // The envelope only matters once a note is releasing
+    REQUIRE(samples_steal_score(0.0f, 0.0f, false, 4) == samples_steal_score(0.0f, 1.0f, false, 4));
+    REQUIRE(samples_steal_score(0.0f, 0.1f, true, 4) < samples_steal_score(0.0f, 1.0f, true, 4));
+}
+
+TEST_CASE("Samples.CachePath", "[Samples]")
+{
+    const auto directory = fs::temp_directory_path() / "zing_test_cache";
+    const auto fontPath = fs::temp_directory_path() / "a" / "font.sf2";
+
+    // Stable from run to run, under the cache directory, and still named for the font
+    const auto cachePath = samples_cache_path(directory, fontPath);
+    REQUIRE(cachePath == samples_cache_path(directory, fontPath));
+    REQUIRE(cachePath.parent_path() == directory);
+    REQUIRE(cachePath.extension() == ".zcache");
+    REQUIRE(cachePath.filename().string().find("font.sf2.") == 0);
+
+    // The same name in another folder gets its own cache
+    REQUIRE(cachePath != samples_cache_path(directory, fs::temp_directory_path() / "b" / "font.sf2"));
+
+    // However the path is spelled
+    REQUIRE(cachePath == samples_cache_path(directory, fs::temp_directory_path() / "a" / "." / "font.sf2"));
+    REQUIRE(cachePath == samples_cache_path(directory, fs::temp_directory_path() / "a" / "b" / ".." / "font.sf2"));
+}
+
+TEST_CASE("Samples.RouteProgram", "[Samples]")
+{
+    // Each font's presets as (bank, program), in the order the font lists them
+    const std::vector<std::vector<std::pair<int, int>>> fonts = {
+        { { 0, 0 }, { 0, 1 } },
+        { { 0, 1 }, { 128, 0 }, { 0, 5 } },
+    };
+    auto route = [&](int bank, int program, int& presetIndex) {
+        return samples_route_program(fonts.size(), [&](size_t font) {
+            auto& presets = fonts[font];
+            auto itr = std::find(presets.begin(), presets.end(), std::make_pair(bank, program));
+            return itr == presets.end() ? -1 : int(itr - presets.begin());
+        }, presetIndex);
+    };
+
+    // Only the second font has it
+    int presetIndex = -1;
+    REQUIRE(route(0, 5, presetIndex) == 1);
+    REQUIRE(presetIndex == 2);
+
+    // Both have it; the first font loaded wins
+    REQUIRE(route(0, 1, presetIndex) == 0);
+    REQUIRE(presetIndex == 1);
+
+    // Drums are a bank of their own
+    REQUIRE(route(128, 0, presetIndex) == 1);
+    REQUIRE(presetIndex == 1);
+
+    // Nowhere to go, so the channel keeps its font
+    REQUIRE(route(0, 9, presetIndex) == -1);
+    REQUIRE(presetIndex == -1);
+    REQUIRE(samples_route_program(0, [](size_t) { return 0; }, presetIndex) == -1);
+}
+
+TEST_CASE("Samples.CacheHash", "[Samples]")
+{
+    // A file laid out as info, samples, hydra, described as the index would
+    auto hash = [](const std::string& info, const std::string& samples, const std::string& hydra) {
+        const auto data = info + samples + hydra;
+        SF2MappedFile file;
+        file.pData = (const uint8_t*)data.data();
+        file.size = data.size();
+        SF2Index index;
+        index.info = SF2Chunk{ 0, info.size() };
+        index.samples = SF2Chunk{ info.size(), samples.size() };
+        index.hydra = SF2Chunk{ info.size() + samples.size(), hydra.size() };
+        return samples_cache_hash(file, index);
+    };
+
+    const auto base = hash("info", "samples", "hydra");
+    REQUIRE(base == hash("info", "samples", "hydra"));
+
+    // Edited headers or presets
+    REQUIRE(base != hash("INFO", "samples", "hydra"));
+    REQUIRE(base != hash("info", "samples", "Hydra"));
+
+    // The samples aren't read, only their size counts
+    REQUIRE(base == hash("info", "SAMPLES", "hydra"));
+    REQUIRE(base != hash("info", "samples+", "hydra"));
+}
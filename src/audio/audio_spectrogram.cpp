@@ -0,0 +1,540 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_spectrogram.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Zing
+{
+
+namespace
+{
+
+constexpr uint32_t LevelFactor = 4;
+constexpr uint32_t MaxQueuedFrames = 256;
+constexpr uint64_t FileHeaderSize = 4096;
+
+// At the start of the file; counts are rewritten as tiles are added
+struct SpectrogramFileHeader
+{
+    char magic[4] = { 'Z', 'S', 'P', 'G' };
+    uint32_t version = 1;
+    uint32_t bins = 0;
+    uint32_t rowsPerTile = 0;
+    uint32_t levels = 0;
+    uint32_t levelFactor = LevelFactor;
+    float minDb = 0.0f;
+    float maxDb = 0.0f;
+    double rowSeconds = 0.0;
+    uint32_t sampleRate = 0;
+    uint32_t tileCount = 0;
+    uint64_t usedSize = 0;
+};
+
+// Before each tile's codes, so the file can be walked without the in memory index
+struct SpectrogramTileHeader
+{
+    char magic[4] = { 'T', 'I', 'L', 'E' };
+    uint32_t level = 0;
+    uint64_t index = 0; // Of the tile within its level
+    uint32_t rows = 0; // Valid rows; less than rowsPerTile only for the last tile of a level
+    uint32_t planes = 0;
+};
+
+uint32_t spectrogram_planes(uint32_t level)
+{
+    // Level 0 rows are single spectra; min, mean and max are the same
+    return level == 0 ? 1 : 3;
+}
+
+uint64_t spectrogram_tile_bytes(const SpectrogramArchive& archive, uint32_t level)
+{
+    return uint64_t(spectrogram_planes(level)) * archive.settings.rowsPerTile * archive.settings.bins;
+}
+
+double spectrogram_level_seconds(const SpectrogramArchive& archive, uint32_t level)
+{
+    return archive.settings.rowSeconds * std::pow(double(LevelFactor), double(level));
+}
+
+bool spectrogram_map(SpectrogramArchive& archive, uint64_t size)
+{
+#ifdef _WIN32
+    if (archive.pData)
+    {
+        UnmapViewOfFile(archive.pData);
+        CloseHandle(archive.hMapping);
+        archive.pData = nullptr;
+        archive.hMapping = nullptr;
+    }
+
+    // Mapping past the end grows the file
+    auto hMapping = CreateFileMappingW(archive.hFile, nullptr, PAGE_READWRITE, DWORD(size >> 32), DWORD(size & 0xFFFFFFFF), nullptr);
+    if (!hMapping)
+    {
+        return false;
+    }
+
+    auto pData = MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    if (!pData)
+    {
+        CloseHandle(hMapping);
+        return false;
+    }
+    archive.hMapping = hMapping;
+    archive.pData = (uint8_t*)pData;
+#else
+    if (archive.pData)
+    {
+        munmap(archive.pData, size_t(archive.mappedSize));
+        archive.pData = nullptr;
+    }
+
+    if (ftruncate(archive.fd, off_t(size)) != 0)
+    {
+        return false;
+    }
+
+    auto pData = mmap(nullptr, size_t(size), PROT_READ | PROT_WRITE, MAP_SHARED, archive.fd, 0);
+    if (pData == MAP_FAILED)
+    {
+        return false;
+    }
+    archive.pData = (uint8_t*)pData;
+#endif
+    archive.mappedSize = size;
+    return true;
+}
+
+void spectrogram_unmap(SpectrogramArchive& archive)
+{
+#ifdef _WIN32
+    if (archive.pData)
+    {
+        UnmapViewOfFile(archive.pData);
+        CloseHandle(archive.hMapping);
+    }
+    if (archive.hFile)
+    {
+        // Trim the growth slack
+        LARGE_INTEGER end;
+        end.QuadPart = LONGLONG(archive.usedSize);
+        SetFilePointerEx(archive.hFile, end, nullptr, FILE_BEGIN);
+        SetEndOfFile(archive.hFile);
+        CloseHandle(archive.hFile);
+    }
+    archive.hMapping = nullptr;
+    archive.hFile = nullptr;
+#else
+    if (archive.pData)
+    {
+        munmap(archive.pData, size_t(archive.mappedSize));
+    }
+    if (archive.fd >= 0)
+    {
+        // Trim the growth slack
+        if (ftruncate(archive.fd, off_t(archive.usedSize)) != 0)
+        {
+            LOG(ERR, "Could not trim spectrogram archive: " << archive.path.string());
+        }
+        close(archive.fd);
+    }
+    archive.fd = -1;
+#endif
+    archive.pData = nullptr;
+    archive.mappedSize = 0;
+}
+
+void spectrogram_write_header(SpectrogramArchive& archive)
+{
+    SpectrogramFileHeader header;
+    header.bins = archive.settings.bins;
+    header.rowsPerTile = archive.settings.rowsPerTile;
+    header.levels = archive.settings.levels;
+    header.minDb = archive.settings.minDb;
+    header.maxDb = archive.settings.maxDb;
+    header.rowSeconds = archive.settings.rowSeconds;
+    header.sampleRate = archive.sampleRate;
+    for (auto& level : archive.levels)
+    {
+        header.tileCount += uint32_t(level.tiles.size());
+    }
+    header.usedSize = archive.usedSize;
+    memcpy(archive.pData, &header, sizeof(header));
+}
+
+// Moves a level's partial tile to the file; call with the mutex held
+bool spectrogram_write_tile(SpectrogramArchive& archive, uint32_t levelIndex, uint32_t rows)
+{
+    auto& level = archive.levels[levelIndex];
+    const auto bytes = spectrogram_tile_bytes(archive, levelIndex);
+    const auto needed = archive.usedSize + sizeof(SpectrogramTileHeader) + bytes;
+    if (needed > archive.mappedSize)
+    {
+        // Grow by half again, at least a megabyte and at most 256MB a time
+        auto size = archive.mappedSize;
+        while (size < needed)
+        {
+            size += std::clamp<uint64_t>(size / 2, 1ull << 20, 256ull << 20);
+        }
+        if (!spectrogram_map(archive, size))
+        {
+            LOG(ERR, "Could not grow spectrogram archive: " << archive.path.string());
+            return false;
+        }
+    }
+
+    SpectrogramTileHeader tile;
+    tile.level = levelIndex;
+    tile.index = level.tiles.size();
+    tile.rows = rows;
+    tile.planes = spectrogram_planes(levelIndex);
+    memcpy(archive.pData + archive.usedSize, &tile, sizeof(tile));
+
+    const auto offset = archive.usedSize + sizeof(SpectrogramTileHeader);
+    memcpy(archive.pData + offset, level.partial.data(), size_t(bytes));
+    level.tiles.push_back(offset);
+    archive.usedSize = offset + bytes;
+
+    std::fill(level.partial.begin(), level.partial.end(), uint8_t(0));
+    spectrogram_write_header(archive);
+    return true;
+}
+
+// Adds a finished row to a level and passes it up; call with the mutex held
+void spectrogram_add_row(SpectrogramArchive& archive, uint32_t levelIndex, const float* pMinDb, const float* pPower, const float* pMaxDb)
+{
+    auto& settings = archive.settings;
+    auto& level = archive.levels[levelIndex];
+    const auto bins = settings.bins;
+    const auto planeBytes = size_t(settings.rowsPerTile) * bins;
+    const auto row = size_t(level.rows % settings.rowsPerTile);
+    const auto scale = 255.0f / (settings.maxDb - settings.minDb);
+
+    auto encode = [&](float db) {
+        return uint8_t(std::clamp((db - settings.minDb) * scale + 0.5f, 0.0f, 255.0f));
+    };
+
+    // Plane order: mean, then min and max above level 0
+    auto pMean = level.partial.data() + row * bins;
+    for (uint32_t bin = 0; bin < bins; bin++)
+    {
+        pMean[bin] = encode(10.0f * std::log10(std::max(pPower[bin], 1e-20f)));
+    }
+    if (spectrogram_planes(levelIndex) > 1)
+    {
+        auto pMin = pMean + planeBytes;
+        auto pMax = pMin + planeBytes;
+        for (uint32_t bin = 0; bin < bins; bin++)
+        {
+            pMin[bin] = encode(pMinDb[bin]);
+            pMax[bin] = encode(pMaxDb[bin]);
+        }
+    }
+
+    level.rows++;
+    if (level.rows % settings.rowsPerTile == 0)
+    {
+        spectrogram_write_tile(archive, levelIndex, settings.rowsPerTile);
+    }
+
+    if (levelIndex + 1 >= archive.levels.size())
+    {
+        return;
+    }
+
+    auto& above = archive.levels[levelIndex + 1];
+    for (uint32_t bin = 0; bin < bins; bin++)
+    {
+        above.powerSum[bin] += pPower[bin];
+        above.minDb[bin] = above.inputs == 0 ? pMinDb[bin] : std::min(above.minDb[bin], pMinDb[bin]);
+        above.maxDb[bin] = above.inputs == 0 ? pMaxDb[bin] : std::max(above.maxDb[bin], pMaxDb[bin]);
+    }
+
+    if (++above.inputs == LevelFactor)
+    {
+        for (auto& power : above.powerSum)
+        {
+            power /= float(LevelFactor);
+        }
+        spectrogram_add_row(archive, levelIndex + 1, above.minDb.data(), above.powerSum.data(), above.maxDb.data());
+        std::fill(above.powerSum.begin(), above.powerSum.end(), 0.0f);
+        above.inputs = 0;
+    }
+}
+
+// Averages a spectrum into the level 0 row, finishing it once rowSeconds have gone in
+void spectrogram_process(SpectrogramArchive& archive, const SpectrogramFrame& frame)
+{
+    const auto bins = archive.settings.bins;
+    const auto count = uint32_t(frame.power.size());
+    if (count < bins)
+    {
+        return;
+    }
+
+    // Bins fold down as in the waterfall, keeping the axis linear
+    for (uint32_t bin = 0; bin < bins; bin++)
+    {
+        const auto start = uint32_t(uint64_t(bin) * count / bins);
+        const auto end = std::max(start + 1, uint32_t(uint64_t(bin + 1) * count / bins));
+        float sum = 0.0f;
+        for (uint32_t i = start; i < end; i++)
+        {
+            sum += frame.power[i];
+        }
+        archive.rowPower[bin] += sum / float(end - start);
+    }
+    archive.rowSpectra++;
+    archive.rowTime += frame.seconds;
+
+    if (archive.rowTime < archive.settings.rowSeconds)
+    {
+        return;
+    }
+
+    // Carry the remainder over so rows keep to time on average
+    archive.rowTime = std::min(archive.rowTime - archive.settings.rowSeconds, archive.settings.rowSeconds);
+    for (uint32_t bin = 0; bin < bins; bin++)
+    {
+        archive.rowPower[bin] /= float(archive.rowSpectra);
+        archive.rowDb[bin] = 10.0f * std::log10(std::max(archive.rowPower[bin], 1e-20f));
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(archive.mutex);
+        spectrogram_add_row(archive, 0, archive.rowDb.data(), archive.rowPower.data(), archive.rowDb.data());
+    }
+
+    std::fill(archive.rowPower.begin(), archive.rowPower.end(), 0.0f);
+    archive.rowSpectra = 0;
+}
+
+// Codes of one row of a level: from its tile in the file, or from the partial tile
+const uint8_t* spectrogram_row_codes(const SpectrogramArchive& archive, uint32_t levelIndex, uint64_t row, uint32_t plane)
+{
+    auto& level = archive.levels[levelIndex];
+    const auto tile = row / archive.settings.rowsPerTile;
+    const auto offset = (size_t(plane) * archive.settings.rowsPerTile + size_t(row % archive.settings.rowsPerTile)) * archive.settings.bins;
+    if (tile < level.tiles.size())
+    {
+        return archive.pData + level.tiles[tile] + offset;
+    }
+    return level.partial.data() + offset;
+}
+
+} // namespace
+
+bool spectrogram_start(SpectrogramArchive& archive, const fs::path& path, const SpectrogramSettings& settings, uint32_t sampleRate)
+{
+    spectrogram_stop(archive);
+
+    archive.path = path;
+    archive.settings = settings;
+    archive.settings.bins = std::max(1u, settings.bins);
+    archive.settings.rowsPerTile = std::max(1u, settings.rowsPerTile);
+    archive.settings.levels = std::clamp(settings.levels, 1u, 16u);
+    archive.settings.rowSeconds = std::max(settings.rowSeconds, 1e-3);
+    archive.sampleRate = sampleRate;
+
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+#ifdef _WIN32
+    auto hFile = CreateFileW(path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        LOG(ERR, "Could not create spectrogram archive: " << path.string());
+        return false;
+    }
+    archive.hFile = hFile;
+#else
+    archive.fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (archive.fd < 0)
+    {
+        LOG(ERR, "Could not create spectrogram archive: " << path.string());
+        return false;
+    }
+#endif
+
+    archive.usedSize = FileHeaderSize;
+    if (!spectrogram_map(archive, FileHeaderSize + 16 * (sizeof(SpectrogramTileHeader) + spectrogram_tile_bytes(archive, 0))))
+    {
+        LOG(ERR, "Could not map spectrogram archive: " << path.string());
+        spectrogram_unmap(archive);
+        return false;
+    }
+
+    const auto bins = archive.settings.bins;
+    archive.levels.assign(archive.settings.levels, SpectrogramLevel{});
+    for (uint32_t level = 0; level < archive.settings.levels; level++)
+    {
+        auto& l = archive.levels[level];
+        l.partial.assign(size_t(spectrogram_tile_bytes(archive, level)), 0);
+        l.powerSum.assign(bins, 0.0f);
+        l.minDb.assign(bins, 0.0f);
+        l.maxDb.assign(bins, 0.0f);
+    }
+    spectrogram_write_header(archive);
+
+    archive.rowPower.assign(bins, 0.0f);
+    archive.rowDb.assign(bins, 0.0f);
+    archive.rowSpectra = 0;
+    archive.rowTime = 0.0;
+    archive.droppedFrames = 0;
+
+    auto pArchive = &archive;
+    archive.quitThread = false;
+    archive.running = true;
+    archive.thread = std::thread([pArchive]() {
+        TRACE_NAME_THREAD(Spectrogram);
+        const auto wakeUpDelta = std::chrono::milliseconds(1);
+        for (;;)
+        {
+            std::shared_ptr<SpectrogramFrame> spFrame;
+            if (!pArchive->frames.try_dequeue(spFrame))
+            {
+                // Drain before quitting
+                if (pArchive->quitThread.load())
+                {
+                    break;
+                }
+                std::this_thread::sleep_for(wakeUpDelta);
+                continue;
+            }
+
+            TRACE_SCOPE(Spectrogram_Row);
+            spectrogram_process(*pArchive, *spFrame);
+            pArchive->spareFrames.enqueue(spFrame);
+        }
+    });
+    return true;
+}
+
+void spectrogram_stop(SpectrogramArchive& archive)
+{
+    if (!archive.running)
+    {
+        return;
+    }
+
+    archive.quitThread = true;
+    archive.thread.join();
+    archive.running = false;
+
+    // Keep the partly filled tiles too; their headers say how many rows are valid
+    std::lock_guard<std::mutex> lock(archive.mutex);
+    for (uint32_t level = 0; level < archive.levels.size(); level++)
+    {
+        const auto rows = uint32_t(archive.levels[level].rows % archive.settings.rowsPerTile);
+        if (rows != 0)
+        {
+            spectrogram_write_tile(archive, level, rows);
+        }
+    }
+    spectrogram_unmap(archive);
+    archive.levels.clear();
+}
+
+void spectrogram_push(SpectrogramArchive& archive, const float* pPower, uint32_t count, double seconds)
+{
+    if (!archive.running)
+    {
+        return;
+    }
+
+    if (archive.frames.size_approx() >= MaxQueuedFrames)
+    {
+        archive.droppedFrames++;
+        return;
+    }
+
+    std::shared_ptr<SpectrogramFrame> spFrame;
+    if (!archive.spareFrames.try_dequeue(spFrame))
+    {
+        spFrame = std::make_shared<SpectrogramFrame>();
+    }
+    spFrame->power.assign(pPower, pPower + count);
+    spFrame->seconds = seconds;
+    archive.frames.enqueue(spFrame);
+}
+
+double spectrogram_duration(SpectrogramArchive& archive)
+{
+    std::lock_guard<std::mutex> lock(archive.mutex);
+    if (archive.levels.empty())
+    {
+        return 0.0;
+    }
+    return double(archive.levels[0].rows) * archive.settings.rowSeconds;
+}
+
+uint32_t spectrogram_read(SpectrogramArchive& archive, double startSeconds, double endSeconds, uint32_t maxRows, SpectrogramView view, std::vector<float>& outDb, double* pRowSeconds)
+{
+    TRACE_SCOPE(Spectrogram_Read);
+
+    std::lock_guard<std::mutex> lock(archive.mutex);
+    outDb.clear();
+    if (archive.levels.empty() || endSeconds <= startSeconds || maxRows == 0)
+    {
+        return 0;
+    }
+
+    // The coarsest level that still gives maxRows rows over the span
+    const auto span = endSeconds - startSeconds;
+    uint32_t levelIndex = 0;
+    for (uint32_t level = uint32_t(archive.levels.size()); level-- > 1;)
+    {
+        if (span / spectrogram_level_seconds(archive, level) >= double(maxRows))
+        {
+            levelIndex = level;
+            break;
+        }
+    }
+
+    const auto& level = archive.levels[levelIndex];
+    const auto rowSeconds = spectrogram_level_seconds(archive, levelIndex);
+    const auto first = uint64_t(std::max(0.0, std::floor(startSeconds / rowSeconds)));
+    const auto last = std::min(level.rows, uint64_t(std::max(0.0, std::ceil(endSeconds / rowSeconds))));
+    if (pRowSeconds)
+    {
+        *pRowSeconds = rowSeconds;
+    }
+    if (last <= first)
+    {
+        return 0;
+    }
+
+    uint32_t plane = 0;
+    if (levelIndex > 0)
+    {
+        plane = view == SpectrogramView::Min ? 1 : view == SpectrogramView::Max ? 2 : 0;
+    }
+
+    const auto bins = archive.settings.bins;
+    const auto step = (archive.settings.maxDb - archive.settings.minDb) / 255.0f;
+    const auto rows = uint32_t(last - first);
+    outDb.resize(size_t(rows) * bins);
+
+    auto pOut = outDb.data();
+    for (uint64_t row = last; row-- > first;)
+    {
+        auto pCodes = spectrogram_row_codes(archive, levelIndex, row, plane);
+        for (uint32_t bin = 0; bin < bins; bin++)
+        {
+            *pOut++ = archive.settings.minDb + float(pCodes[bin]) * step;
+        }
+    }
+    return rows;
+}
+
+} // namespace Zing
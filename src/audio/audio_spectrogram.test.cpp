@@ -0,0 +1,137 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_spectrogram.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+constexpr uint32_t TestBins = 64;
+constexpr uint32_t TestRows = 32;
+constexpr double TestRowSeconds = 0.1;
+
+// Small tiles, so most rows are read back from the file rather than the partial tile
+SpectrogramSettings test_settings()
+{
+    SpectrogramSettings settings;
+    settings.bins = TestBins;
+    settings.rowsPerTile = 4;
+    settings.levels = 3;
+    settings.rowSeconds = TestRowSeconds;
+    return settings;
+}
+
+// Levels stepping across the code range, with a little past each end, moving a little each row
+float test_level_db(uint32_t row, uint32_t bin)
+{
+    return -165.0f + 190.0f * float(bin) / float(TestBins - 1) + float(row % 4) * 1.5f;
+}
+
+float test_clamp_db(float db)
+{
+    const auto settings = test_settings();
+    return std::clamp(db, settings.minDb, settings.maxDb);
+}
+
+float test_step_db()
+{
+    const auto settings = test_settings();
+    return (settings.maxDb - settings.minDb) / 255.0f;
+}
+
+// Records the test rows, one spectrum per row, and waits for the writer thread to take them all in
+bool test_record(SpectrogramArchive& archive, const fs::path& path)
+{
+    if (!spectrogram_start(archive, path, test_settings(), 48000))
+    {
+        return false;
+    }
+
+    std::vector<float> power(TestBins);
+    for (uint32_t row = 0; row < TestRows; row++)
+    {
+        for (uint32_t bin = 0; bin < TestBins; bin++)
+        {
+            power[bin] = std::pow(10.0f, test_level_db(row, bin) / 10.0f);
+        }
+        spectrogram_push(archive, power.data(), TestBins, TestRowSeconds);
+    }
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (spectrogram_duration(archive) < TestRows * TestRowSeconds - 1e-6 && std::chrono::steady_clock::now() < end)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return archive.droppedFrames == 0;
+}
+
+} // namespace
+
+TEST_CASE("Spectrogram.RoundTrip", "[Spectrogram]")
+{
+    const auto path = fs::temp_directory_path() / "zing_test.zspg";
+    auto spArchive = std::make_unique<SpectrogramArchive>();
+    REQUIRE(test_record(*spArchive, path));
+    REQUIRE(spectrogram_duration(*spArchive) == Approx(TestRows * TestRowSeconds));
+
+    // Level 0, newest first, each value within half a code of what went in
+    std::vector<float> outDb;
+    double rowSeconds = 0.0;
+    REQUIRE(spectrogram_read(*spArchive, 0.0, TestRows * TestRowSeconds, 1000, SpectrogramView::Mean, outDb, &rowSeconds) == TestRows);
+    REQUIRE(rowSeconds == Approx(TestRowSeconds));
+    for (uint32_t y = 0; y < TestRows; y++)
+    {
+        const auto row = TestRows - 1 - y;
+        for (uint32_t bin = 0; bin < TestBins; bin++)
+        {
+            const auto expected = test_clamp_db(test_level_db(row, bin));
+            REQUIRE(outDb[y * TestBins + bin] == Approx(expected).margin(test_step_db() * 0.5f + 1e-3f));
+        }
+    }
+
+    spectrogram_stop(*spArchive);
+    fs::remove(path);
+}
+
+TEST_CASE("Spectrogram.Pyramid", "[Spectrogram]")
+{
+    const auto path = fs::temp_directory_path() / "zing_test_pyramid.zspg";
+    auto spArchive = std::make_unique<SpectrogramArchive>();
+    REQUIRE(test_record(*spArchive, path));
+
+    // Asking for 8 rows over the whole span picks level 1, where each row is 4 of level 0
+    constexpr uint32_t Rows = TestRows / 4;
+    std::vector<float> minDb, meanDb, maxDb;
+    double rowSeconds = 0.0;
+    REQUIRE(spectrogram_read(*spArchive, 0.0, TestRows * TestRowSeconds, Rows, SpectrogramView::Min, minDb, &rowSeconds) == Rows);
+    REQUIRE(rowSeconds == Approx(TestRowSeconds * 4));
+    REQUIRE(spectrogram_read(*spArchive, 0.0, TestRows * TestRowSeconds, Rows, SpectrogramView::Mean, meanDb) == Rows);
+    REQUIRE(spectrogram_read(*spArchive, 0.0, TestRows * TestRowSeconds, Rows, SpectrogramView::Max, maxDb) == Rows);
+
+    const auto margin = test_step_db() * 0.5f + 1e-3f;
+    for (uint32_t y = 0; y < Rows; y++)
+    {
+        const auto first = (Rows - 1 - y) * 4;
+        for (uint32_t bin = 0; bin < TestBins; bin++)
+        {
+            // The rows below rise 1.5dB at a time, so the first is the quietest and the last the loudest
+            double power = 0.0;
+            for (uint32_t row = first; row < first + 4; row++)
+            {
+                power += std::pow(10.0, test_level_db(row, bin) / 10.0) / 4.0;
+            }
+            const auto index = y * TestBins + bin;
+            REQUIRE(minDb[index] == Approx(test_clamp_db(test_level_db(first, bin))).margin(margin));
+            REQUIRE(maxDb[index] == Approx(test_clamp_db(test_level_db(first + 3, bin))).margin(margin));
+            REQUIRE(meanDb[index] == Approx(test_clamp_db(float(10.0 * std::log10(power)))).margin(margin));
+            REQUIRE(minDb[index] <= meanDb[index]);
+            REQUIRE(meanDb[index] <= maxDb[index]);
+        }
+    }
+
+    spectrogram_stop(*spArchive);
+    fs::remove(path);
+}
@@ -0,0 +1,552 @@
+#include <zing/pch.h>
+
+#include <condition_variable>
+#include <limits>
+#include <map>
+
+#include <zing/audio/audio_stretch.h>
+
+#include <dr_wav.h>
+
+namespace Zing
+{
+
+namespace
+{
+
+struct StretchRun
+{
+    StretchJob& job;
+    StretchSettings settings;
+
+    uint32_t channels = 0;
+    uint32_t sampleRate = 0;
+    uint64_t inputFrames = 0;
+    uint64_t outputFrames = 0;
+
+    uint32_t window = 0;
+    uint32_t hop = 0; // Output frames between module frames; segments start on this grid
+    uint32_t runIn = 0; // Output frames rendered and dropped before a segment's first frame
+    uint32_t crossfade = 0;
+    uint32_t maxLag = 0; // Segments render this much extra either side, to line up with their neighbour
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    uint32_t nextSegment = 0;
+    uint32_t written = 0;
+    uint32_t maxInFlight = 2;
+    std::map<uint32_t, std::vector<float>> complete; // Interleaved
+    bool failed = false;
+
+    explicit StretchRun(StretchJob& j)
+        : job(j)
+    {
+    }
+};
+
+int64_t stretch_floor(int64_t value, int64_t grid)
+{
+    return value >= 0 ? (value / grid) * grid : -((-value + grid - 1) / grid) * grid;
+}
+
+// Output frames a segment contributes, not counting the crossfade into it
+uint64_t stretch_segment_frames(const StretchRun& run, uint32_t segment)
+{
+    const auto length = uint64_t(run.settings.segmentFrames);
+    return std::min(run.outputFrames, (segment + 1) * length) - segment * length;
+}
+
+// Output frames [begin, end) that segment s renders; after the first, a segment starts a crossfade early
+void stretch_segment_range(const StretchRun& run, uint32_t segment, int64_t& begin, int64_t& end)
+{
+    const auto length = int64_t(run.settings.segmentFrames);
+    begin = segment == 0 ? 0 : segment * length - run.crossfade - run.maxLag;
+    end = segment * length + int64_t(stretch_segment_frames(run, segment)) + run.maxLag;
+}
+
+// Where an output frame sits in the input
+double stretch_input_position(const StretchRun& run, double outputFrame)
+{
+    return outputFrame / run.settings.stretch;
+}
+
+// One channel through paulstretch; the table starts at input frame 'first'
+void stretch_render_paul(StretchRun& run, sp_data* sp, sp_ftbl* ft, int64_t first, int64_t runStart, int64_t begin, int64_t end, float* pOut)
+{
+    sp_paulstretch* p;
+    sp_paulstretch_create(&p);
+    sp_paulstretch_init(sp, p, ft, (run.window + 0.5f) / sp->sr, run.settings.stretch);
+
+    const double half = double(p->half_windowsize);
+    for (int64_t t = runStart; t < end; t++)
+    {
+        // Each window covers a window of output, centred on the matching input
+        if (p->counter == 0)
+        {
+            p->start_pos = SPFLOAT(std::max(0.0, stretch_input_position(run, t + half) - half - first));
+        }
+
+        SPFLOAT out = 0.0f;
+        sp_paulstretch_compute(sp, p, nullptr, &out);
+        if (t >= begin)
+        {
+            pOut[(t - begin) * run.channels] = out;
+        }
+    }
+    sp_paulstretch_destroy(&p);
+}
+
+void stretch_render_mincer(StretchRun& run, sp_data* sp, sp_ftbl* ft, int64_t first, int64_t runStart, int64_t begin, int64_t end, float* pOut)
+{
+    sp_mincer* p;
+    sp_mincer_create(&p);
+    sp_mincer_init(sp, p, ft, int(run.window));
+    p->pitch = run.settings.pitch;
+    p->lock = run.settings.phaseLock ? 1.0f : 0.0f;
+
+    const auto hsize = double(p->hsize);
+    const double centre = run.window * 0.5;
+    for (int64_t t = runStart; t < end; t++)
+    {
+        // The module snaps its read position down to the hop, so do it here, on a grid shared by every
+        // segment ('first' is a multiple of the hop), and hand it the middle of the hop
+        if (p->cnt == p->hsize)
+        {
+            const auto position = stretch_input_position(run, t + centre) - centre * run.settings.pitch - first;
+            const auto snapped = std::max(hsize, std::floor(position / hsize) * hsize);
+            p->time = SPFLOAT((snapped + hsize * 0.5) / sp->sr);
+        }
+
+        SPFLOAT out = 0.0f;
+        sp_mincer_compute(sp, p, nullptr, &out);
+        if (t >= begin)
+        {
+            pOut[(t - begin) * run.channels] = out;
+        }
+    }
+    sp_mincer_destroy(&p);
+}
+
+bool stretch_render_segment(StretchRun& run, drwav& wav, uint32_t segment, std::vector<float>& input, std::vector<float>& table, std::vector<float>& output)
+{
+    int64_t begin, end;
+    stretch_segment_range(run, segment, begin, end);
+    const auto runStart = stretch_floor(begin - int64_t(run.runIn), run.hop);
+
+    // The input the module can reach, with a window to spare either side
+    const auto reach = int64_t(std::ceil((run.window + run.hop) * std::max(1.0f, run.settings.pitch))) + run.hop;
+    const auto first = stretch_floor(int64_t(std::floor(stretch_input_position(run, double(runStart)))) - reach, run.hop);
+    const auto last = int64_t(std::ceil(stretch_input_position(run, double(end)))) + reach;
+
+    // Paulstretch wraps its reads, so the table ends with a window of silence
+    const auto tableFrames = uint64_t(last - first) + run.window;
+    input.assign(tableFrames * run.channels, 0.0f);
+
+    const auto readFirst = std::max<int64_t>(first, 0);
+    const auto readLast = std::min<int64_t>(last, int64_t(run.inputFrames));
+    if (readLast > readFirst)
+    {
+        if (!drwav_seek_to_pcm_frame(&wav, uint64_t(readFirst)))
+        {
+            return false;
+        }
+        drwav_read_pcm_frames_f32(&wav, uint64_t(readLast - readFirst), input.data() + (readFirst - first) * run.channels);
+    }
+
+    output.assign(size_t(end - begin) * run.channels, 0.0f);
+    table.resize(tableFrames);
+
+    sp_data* sp;
+    sp_create(&sp);
+    sp->sr = int(run.sampleRate);
+
+    for (uint32_t channel = 0; channel < run.channels; channel++)
+    {
+        if (run.job.cancel.load(std::memory_order_relaxed))
+        {
+            break;
+        }
+
+        for (uint64_t frame = 0; frame < tableFrames; frame++)
+        {
+            table[frame] = input[frame * run.channels + channel];
+        }
+
+        sp_ftbl* ft;
+        sp_ftbl_bind(sp, &ft, table.data(), tableFrames);
+
+        // Paulstretch randomises phases; a fixed seed per segment and channel keeps a render repeatable
+        sp_srand(sp, segment * 16 + channel + 1);
+
+        if (run.settings.method == StretchMethod::PaulStretch)
+        {
+            stretch_render_paul(run, sp, ft, first, runStart, begin, end, output.data() + channel);
+        }
+        else
+        {
+            stretch_render_mincer(run, sp, ft, first, runStart, begin, end, output.data() + channel);
+        }
+        sp_ftbl_destroy(&ft);
+    }
+
+    sp_destroy(&sp);
+    return true;
+}
+
+void stretch_worker(StretchRun& run)
+{
+    TRACE_NAME_THREAD(StretchWorker);
+
+    drwav wav;
+    const bool opened = drwav_init_file(&wav, run.job.input.string().c_str());
+
+    std::vector<float> input;
+    std::vector<float> table;
+    for (;;)
+    {
+        uint32_t segment;
+        {
+            std::unique_lock<std::mutex> lock(run.mutex);
+            run.wake.wait(lock, [&]() {
+                return run.failed || run.job.cancel || run.nextSegment >= run.job.segments || run.nextSegment < run.written + run.maxInFlight;
+            });
+            if (run.failed || run.job.cancel || run.nextSegment >= run.job.segments)
+            {
+                break;
+            }
+            segment = run.nextSegment++;
+        }
+
+        std::vector<float> output;
+        const bool rendered = opened && stretch_render_segment(run, wav, segment, input, table, output);
+
+        std::lock_guard<std::mutex> lock(run.mutex);
+        if (!rendered)
+        {
+            run.failed = true;
+        }
+        run.complete[segment] = std::move(output);
+        run.wake.notify_all();
+    }
+
+    if (opened)
+    {
+        drwav_uninit(&wav);
+    }
+}
+
+bool stretch_write(drwav& wav, const float* pFrames, uint64_t frames)
+{
+    return frames == 0 || drwav_write_pcm_frames(&wav, frames, pFrames) == frames;
+}
+
+// The offset into 'frames' (up to 2 * maxLag) that best continues 'tail', and how alike they are there
+uint32_t stretch_align(const StretchRun& run, const std::vector<float>& tail, const std::vector<float>& frames, float& correlation)
+{
+    const auto channels = run.channels;
+    const auto crossfade = run.crossfade;
+    auto mono = [&](const std::vector<float>& source, uint32_t count) {
+        std::vector<float> sum(count, 0.0f);
+        for (uint32_t frame = 0; frame < count; frame++)
+        {
+            for (uint32_t channel = 0; channel < channels; channel++)
+            {
+                sum[frame] += source[size_t(frame) * channels + channel];
+            }
+        }
+        return sum;
+    };
+    const auto before = mono(tail, crossfade);
+    const auto after = mono(frames, crossfade + run.maxLag * 2);
+
+    double tailEnergy = 0.0;
+    double energy = 0.0;
+    for (uint32_t frame = 0; frame < crossfade; frame++)
+    {
+        tailEnergy += double(before[frame]) * before[frame];
+        energy += double(after[frame]) * after[frame];
+    }
+
+    uint32_t best = run.maxLag;
+    double bestScore = -std::numeric_limits<double>::max();
+    double bestProduct = 0.0;
+    double bestEnergy = 0.0;
+    for (uint32_t lag = 0; lag <= run.maxLag * 2; lag++)
+    {
+        if (lag > 0)
+        {
+            energy += double(after[lag + crossfade - 1]) * after[lag + crossfade - 1] - double(after[lag - 1]) * after[lag - 1];
+        }
+
+        float product = 0.0f;
+        for (uint32_t frame = 0; frame < crossfade; frame++)
+        {
+            product += before[frame] * after[lag + frame];
+        }
+
+        const auto score = product / std::sqrt(std::max(energy, 1e-12));
+        if (score > bestScore)
+        {
+            best = lag;
+            bestScore = score;
+            bestProduct = product;
+            bestEnergy = energy;
+        }
+    }
+
+    correlation = float(std::clamp(bestProduct / std::sqrt(tailEnergy * bestEnergy + 1e-24), 0.0, 1.0));
+    return best;
+}
+
+// Joins the segments in order as they complete
+bool stretch_write_segments(StretchRun& run, drwav& out)
+{
+    const auto channels = run.channels;
+    const auto crossfade = run.crossfade;
+
+    std::vector<float> tail;
+    std::vector<float> fade(size_t(crossfade) * channels);
+    for (uint32_t segment = 0; segment < run.job.segments; segment++)
+    {
+        std::vector<float> frames;
+        {
+            std::unique_lock<std::mutex> lock(run.mutex);
+            run.wake.wait(lock, [&]() {
+                return run.failed || run.job.cancel || run.complete.count(segment) != 0;
+            });
+            if (run.failed || run.job.cancel)
+            {
+                return false;
+            }
+            frames = std::move(run.complete[segment]);
+            run.complete.erase(segment);
+        }
+
+        uint64_t from = 0;
+        if (segment > 0)
+        {
+            // Line the segment up with the one before and fade to keep the power steady: a linear fade
+            // where they match, equal power where they are unrelated (paulstretch)
+            float correlation = 0.0f;
+            from = stretch_align(run, tail, frames, correlation);
+            for (uint32_t frame = 0; frame < crossfade; frame++)
+            {
+                const auto fadeIn = 0.5f - 0.5f * std::cos(glm::pi<float>() * (frame + 0.5f) / float(crossfade));
+                const auto fadeOut = 1.0f - fadeIn;
+                const auto scale = 1.0f / std::sqrt(fadeIn * fadeIn + fadeOut * fadeOut + 2.0f * fadeIn * fadeOut * correlation);
+                for (uint32_t channel = 0; channel < channels; channel++)
+                {
+                    const auto index = size_t(frame) * channels + channel;
+                    fade[index] = (tail[index] * fadeOut + frames[(from + frame) * channels + channel] * fadeIn) * scale;
+                }
+            }
+            if (!stretch_write(out, fade.data(), crossfade))
+            {
+                return false;
+            }
+            from += crossfade;
+        }
+
+        // Hold back the end of every segment but the last, to fade into the next one
+        const bool final = segment + 1 == run.job.segments;
+        const auto to = from + stretch_segment_frames(run, segment) - (final ? 0 : crossfade);
+        if (!stretch_write(out, frames.data() + from * channels, to - from))
+        {
+            return false;
+        }
+        if (!final)
+        {
+            tail.assign(frames.begin() + to * channels, frames.begin() + (to + crossfade) * channels);
+        }
+
+        std::lock_guard<std::mutex> lock(run.mutex);
+        run.written = segment + 1;
+        run.job.segmentsWritten.store(run.written, std::memory_order_relaxed);
+        run.wake.notify_all();
+    }
+    return true;
+}
+
+void stretch_fail(StretchJob& job, const std::string& error)
+{
+    LOG(ERR, error);
+    job.error = error;
+    job.state.store(StretchJobState::Failed, std::memory_order_release);
+}
+
+void stretch_run(StretchJob& job)
+{
+    TRACE_NAME_THREAD(Stretch);
+
+    StretchRun run(job);
+    run.settings = job.settings;
+    auto& settings = run.settings;
+    settings.stretch = std::clamp(settings.stretch, 0.01f, 10000.0f);
+    settings.pitch = std::clamp(settings.pitch, 0.25f, 4.0f);
+    settings.windowSize = std::max(settings.windowSize, 64u);
+    settings.segmentFrames = std::max(settings.segmentFrames, 4096u);
+
+    {
+        drwav wav;
+        if (!drwav_init_file(&wav, job.input.string().c_str()))
+        {
+            stretch_fail(job, "Failed to open stretch input: " + job.input.string());
+            return;
+        }
+        run.channels = wav.channels;
+        run.sampleRate = wav.sampleRate;
+        run.inputFrames = wav.totalPCMFrameCount;
+        drwav_uninit(&wav);
+    }
+
+    if (settings.method == StretchMethod::Mincer)
+    {
+        run.window = 1;
+        while (run.window < settings.windowSize)
+        {
+            run.window <<= 1;
+        }
+        run.hop = run.window / 4;
+    }
+    else
+    {
+        run.window = settings.windowSize & ~1u;
+        run.hop = run.window / 2;
+    }
+
+    // Long enough for the overlap and, for the vocoder, the phases to settle
+    run.runIn = run.window * 2;
+    run.crossfade = std::max(1u, std::min(settings.crossfadeFrames, settings.segmentFrames / 2));
+
+    // The vocoder's phases depend on where it started, so neighbouring segments can be out of step;
+    // paulstretch phases are random anyway
+    run.maxLag = settings.method == StretchMethod::Mincer ? run.window / 2 : 0;
+    run.outputFrames = uint64_t(std::llround(double(run.inputFrames) * settings.stretch));
+    job.segments = uint32_t((run.outputFrames + settings.segmentFrames - 1) / settings.segmentFrames);
+
+    drwav_data_format format;
+    format.container = drwav_container_riff;
+    format.format = DR_WAVE_FORMAT_IEEE_FLOAT;
+    format.channels = run.channels;
+    format.sampleRate = run.sampleRate;
+    format.bitsPerSample = 32;
+
+    drwav out;
+    if (!drwav_init_file_write(&out, job.output.string().c_str(), &format))
+    {
+        stretch_fail(job, "Failed to open stretch output: " + job.output.string());
+        return;
+    }
+
+    auto threadCount = settings.threads;
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threadCount = std::max(1u, std::min(threadCount, job.segments.load()));
+    run.maxInFlight = threadCount * 2;
+
+    LOG(DBG, "Stretch: " << job.input.string() << ", " << run.inputFrames << " to " << run.outputFrames << " frames, " << job.segments << " segments on " << threadCount << " threads");
+
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        workers.emplace_back([&run]() {
+            stretch_worker(run);
+        });
+    }
+
+    const bool written = stretch_write_segments(run, out);
+    {
+        std::lock_guard<std::mutex> lock(run.mutex);
+        if (!written)
+        {
+            run.failed = true;
+        }
+        run.wake.notify_all();
+    }
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    drwav_uninit(&out);
+
+    if (written)
+    {
+        job.state.store(StretchJobState::Done, std::memory_order_release);
+        return;
+    }
+
+    std::error_code ec;
+    fs::remove(job.output, ec);
+    if (job.cancel)
+    {
+        job.state.store(StretchJobState::Cancelled, std::memory_order_release);
+    }
+    else
+    {
+        stretch_fail(job, "Failed to stretch: " + job.input.string());
+    }
+}
+
+} // namespace
+
+bool stretch_start(StretchJob& job, const fs::path& input, const fs::path& output, const StretchSettings& settings)
+{
+    if (job.thread.joinable())
+    {
+        return false;
+    }
+
+    job.settings = settings;
+    job.input = input;
+    job.output = output;
+    job.cancel = false;
+    job.segments = 0;
+    job.segmentsWritten = 0;
+    job.error.clear();
+    job.state = StretchJobState::Running;
+
+    job.thread = std::thread([&job]() {
+        stretch_run(job);
+    });
+    return true;
+}
+
+float stretch_progress(const StretchJob& job)
+{
+    switch (job.state.load(std::memory_order_acquire))
+    {
+    case StretchJobState::Done:
+        return 1.0f;
+    case StretchJobState::Running:
+    {
+        const auto segments = job.segments.load(std::memory_order_relaxed);
+        return segments ? float(job.segmentsWritten.load(std::memory_order_relaxed)) / float(segments) : 0.0f;
+    }
+    default:
+        return 0.0f;
+    }
+}
+
+void stretch_cancel(StretchJob& job)
+{
+    job.cancel = true;
+}
+
+bool stretch_wait(StretchJob& job)
+{
+    if (job.thread.joinable())
+    {
+        job.thread.join();
+    }
+    return job.state == StretchJobState::Done;
+}
+
+bool stretch_file(const fs::path& input, const fs::path& output, const StretchSettings& settings)
+{
+    StretchJob job;
+    return stretch_start(job, input, output, settings) && stretch_wait(job);
+}
+
+} // namespace Zing
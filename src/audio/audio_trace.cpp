@@ -0,0 +1,384 @@
+#include <zing/pch.h>
+
+#include <fstream>
+
+#include <zing/audio/audio_trace.h>
+
+namespace Zing
+{
+
+namespace
+{
+
+using namespace std::chrono;
+
+constexpr uint32_t TraceEventsPerThread = 1 << 16;
+
+struct TraceEvent
+{
+    const char* pName;
+    int64_t startNs;
+    int64_t endNs;
+};
+
+struct TraceThread
+{
+    uint32_t id = 0;
+    std::string name; // Under the state mutex
+    bool active = true; // Under the state mutex; cleared when the thread exits, so the slot can be reused
+    const char* pLastName = nullptr; // Owner only; skips renaming to the same literal
+
+    // Made when a capture starts and kept for the life of the program, so the owner never sees it move
+    std::unique_ptr<TraceEvent[]> spEvents;
+    std::atomic<TraceEvent*> pEvents = nullptr;
+
+    // Capture generation in the top 32 bits, events written in the bottom; published after each event.
+    // A thread finding an older generation starts its buffer again.
+    std::atomic<uint64_t> written = 0;
+    std::atomic<uint32_t> dropped = 0;
+};
+
+struct TraceState
+{
+    std::mutex mutex; // Guards the thread list, names and the last file
+    std::vector<std::unique_ptr<TraceThread>> threads;
+
+    std::atomic_bool capturing = false;
+    std::atomic<uint32_t> generation = 0;
+    steady_clock::time_point captureStart; // Set before capturing is
+
+    std::filesystem::path path;
+    std::filesystem::path lastFile;
+
+    std::mutex captureMutex; // Guards starting and joining the capture thread
+    std::thread thread;
+    std::atomic_bool quitThread = false;
+
+    ~TraceState()
+    {
+        if (thread.joinable())
+        {
+            quitThread = true;
+            thread.join();
+        }
+    }
+};
+
+TraceState& trace_state()
+{
+    static TraceState state;
+    return state;
+}
+
+thread_local TraceThread* tlsThread = nullptr;
+
+// Hands the thread's slot back when it exits; threads such as the analysis ones come and go with each
+// audio reset, and would otherwise each keep a buffer
+struct TraceThreadRelease
+{
+    ~TraceThreadRelease()
+    {
+        if (tlsThread)
+        {
+            std::lock_guard<std::mutex> lock(trace_state().mutex);
+            tlsThread->active = false;
+        }
+    }
+};
+thread_local TraceThreadRelease tlsRelease;
+
+TraceThread* trace_register()
+{
+    auto& state = trace_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+
+    TraceThread* pThread = nullptr;
+    for (auto& spThread : state.threads)
+    {
+        if (!spThread->active)
+        {
+            pThread = spThread.get();
+            break;
+        }
+    }
+
+    if (!pThread)
+    {
+        state.threads.push_back(std::make_unique<TraceThread>());
+        pThread = state.threads.back().get();
+        pThread->id = uint32_t(state.threads.size());
+    }
+
+    pThread->active = true;
+    pThread->name = fmt::format("Thread {}", pThread->id);
+    pThread->pLastName = nullptr;
+
+    (void)&tlsRelease; // Constructs the thread's release
+    tlsThread = pThread;
+    return pThread;
+}
+
+void trace_record(const char* pName, uint32_t generation, steady_clock::time_point start, steady_clock::time_point end)
+{
+    auto& state = trace_state();
+    auto pThread = tlsThread;
+    if (!pThread || state.generation.load(std::memory_order_acquire) != generation)
+    {
+        return;
+    }
+
+    auto pEvents = pThread->pEvents.load(std::memory_order_acquire);
+    if (!pEvents)
+    {
+        return;
+    }
+
+    const auto written = pThread->written.load(std::memory_order_relaxed);
+    const auto count = uint32_t(written >> 32) == generation ? uint32_t(written) : 0u;
+    if (count >= TraceEventsPerThread)
+    {
+        pThread->dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    pEvents[count] = TraceEvent{ pName, duration_cast<nanoseconds>(start.time_since_epoch()).count(), duration_cast<nanoseconds>(end.time_since_epoch()).count() };
+    pThread->written.store((uint64_t(generation) << 32) | (count + 1), std::memory_order_release);
+}
+
+void trace_escape(std::string& out, const std::string& text)
+{
+    for (auto c : text)
+    {
+        if (c == '"' || c == '\\')
+        {
+            out += '\\';
+        }
+        if (uint8_t(c) >= 0x20)
+        {
+            out += c;
+        }
+    }
+}
+
+// What the writer needs of a thread, taken under the state mutex
+struct TraceThreadSnapshot
+{
+    uint32_t id = 0;
+    std::string name;
+    const TraceEvent* pEvents = nullptr;
+    uint32_t count = 0;
+    uint32_t dropped = 0;
+};
+
+// Capture thread; after the capture has stopped.
+// Only the thread list is read under the mutex; the events are formatted and written after, so
+// registering and naming threads, and the UI asking for the last file, never wait on the file.
+// The buffers can't be reused until the next capture, which joins this thread first.
+void trace_write(TraceState& state)
+{
+    PROFILE_SCOPE(trace_write);
+
+    std::vector<TraceThreadSnapshot> threads;
+    std::filesystem::path path;
+    int64_t originNs = 0;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        const auto generation = state.generation.load();
+        originNs = duration_cast<nanoseconds>(state.captureStart.time_since_epoch()).count();
+        path = state.path;
+
+        threads.reserve(state.threads.size());
+        for (auto& spThread : state.threads)
+        {
+            auto pEvents = spThread->pEvents.load(std::memory_order_acquire);
+            const auto written = spThread->written.load(std::memory_order_acquire);
+            const auto count = (pEvents && uint32_t(written >> 32) == generation) ? uint32_t(written) : 0u;
+            if (count != 0)
+            {
+                threads.push_back(TraceThreadSnapshot{ spThread->id, spThread->name, pEvents, count, spThread->dropped.load() });
+            }
+        }
+    }
+
+    std::string json;
+    json.reserve(1 << 20);
+    json += "{\"traceEvents\":[\n";
+    json += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Zing\"}}";
+
+    uint64_t events = 0;
+    uint64_t dropped = 0;
+    for (auto& thread : threads)
+    {
+        json += ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":";
+        json += std::to_string(thread.id);
+        json += ",\"args\":{\"name\":\"";
+        trace_escape(json, thread.name);
+        json += "\"}}";
+
+        // Microseconds, as the format expects; 3 decimals keeps the nanoseconds
+        for (uint32_t index = 0; index < thread.count; index++)
+        {
+            const auto& event = thread.pEvents[index];
+            json += fmt::format(",\n{{\"name\":\"{}\",\"cat\":\"zing\",\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+                event.pName, thread.id, double(event.startNs - originNs) / 1000.0, double(event.endNs - event.startNs) / 1000.0);
+        }
+        events += thread.count;
+        dropped += thread.dropped;
+    }
+
+    json += fmt::format("\n],\"displayTimeUnit\":\"ms\",\"otherData\":{{\"events\":{},\"dropped\":{}}}}}\n", events, dropped);
+
+    std::error_code ec;
+    fs::create_directories(path.parent_path(), ec);
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out)
+    {
+        LOG(ERR, "Failed to write trace: " << path.string());
+        return;
+    }
+    out.write(json.data(), std::streamsize(json.size()));
+    out.close();
+
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        state.lastFile = path;
+    }
+
+    LOG(INFO, "Trace: " << events << " events from " << threads.size() << " threads, " << dropped << " dropped: " << path.string());
+}
+
+} // namespace
+
+TraceScope::TraceScope(const char* pName)
+    : pName(pName)
+    , generation(0)
+{
+    auto& state = trace_state();
+    if (!state.capturing.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    // A thread first seen during a capture is given a buffer from the next one
+    if (!tlsThread)
+    {
+        trace_register();
+        return;
+    }
+
+    generation = state.generation.load(std::memory_order_relaxed);
+    start = steady_clock::now();
+}
+
+TraceScope::~TraceScope()
+{
+    if (generation != 0)
+    {
+        trace_record(pName, generation, start, steady_clock::now());
+    }
+}
+
+void trace_name_thread(const char* pName)
+{
+    auto pThread = tlsThread;
+    if (pThread && pThread->pLastName == pName)
+    {
+        return;
+    }
+
+    if (!pThread)
+    {
+        pThread = trace_register();
+    }
+
+    auto& state = trace_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    pThread->name = pName;
+    pThread->pLastName = pName;
+}
+
+bool trace_capture(const std::filesystem::path& path, double seconds)
+{
+    auto& state = trace_state();
+    std::lock_guard<std::mutex> captureLock(state.captureMutex);
+    if (state.capturing)
+    {
+        return false;
+    }
+
+    // The last capture has written itself by now, or is just about to
+    if (state.thread.joinable())
+    {
+        state.thread.join();
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    for (auto& spThread : state.threads)
+    {
+        if (!spThread->spEvents)
+        {
+            spThread->spEvents = std::make_unique<TraceEvent[]>(TraceEventsPerThread);
+            spThread->pEvents.store(spThread->spEvents.get(), std::memory_order_release);
+        }
+        spThread->dropped = 0;
+    }
+
+    state.path = path;
+    state.quitThread = false;
+    state.captureStart = steady_clock::now();
+    state.generation++;
+    state.capturing.store(true, std::memory_order_release);
+
+    auto pState = &state;
+    state.thread = std::thread([pState, seconds]() {
+        PROFILE_NAME_THREAD(Trace);
+        const auto end = steady_clock::now() + duration_cast<steady_clock::duration>(duration<double>(seconds));
+        const auto wakeUpDelta = std::chrono::milliseconds(10);
+        while (!pState->quitThread.load() && steady_clock::now() < end)
+        {
+            std::this_thread::sleep_for(wakeUpDelta);
+        }
+
+        pState->capturing.store(false, std::memory_order_release);
+        trace_write(*pState);
+    });
+
+    LOG(INFO, "Trace capture started: " << seconds << "s");
+    return true;
+}
+
+void trace_stop()
+{
+    auto& state = trace_state();
+    std::lock_guard<std::mutex> captureLock(state.captureMutex);
+    if (state.thread.joinable())
+    {
+        state.quitThread = true;
+        state.thread.join();
+    }
+}
+
+bool trace_capturing()
+{
+    return trace_state().capturing.load();
+}
+
+std::filesystem::path trace_last_file()
+{
+    auto& state = trace_state();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.lastFile;
+}
+
+std::filesystem::path trace_default_path()
+{
+    char stamp[32];
+    auto now = std::time(nullptr);
+    std::strftime(stamp, sizeof(stamp), "%Y%m%d_%H%M%S", std::localtime(&now));
+
+    std::error_code ec;
+    return fs::temp_directory_path(ec) / "zing" / fmt::format("trace_{}.json", stamp);
+}
+
+} // namespace Zing
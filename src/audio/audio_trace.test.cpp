@@ -0,0 +1,124 @@
+#include <zing/pch.h>
+
+#include <fstream>
+#include <sstream>
+
+#include <zing/audio/audio_trace.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+std::string test_read(const fs::path& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    std::ostringstream str;
+    str << in.rdbuf();
+    return str.str();
+}
+
+size_t test_count(const std::string& text, const std::string& find)
+{
+    size_t count = 0;
+    for (auto pos = text.find(find); pos != std::string::npos; pos = text.find(find, pos + find.size()))
+    {
+        count++;
+    }
+    return count;
+}
+
+// Brackets and braces pair up, outside of strings
+bool test_balanced(const std::string& json)
+{
+    std::vector<char> open;
+    bool inString = false;
+    for (size_t i = 0; i < json.size(); i++)
+    {
+        const auto c = json[i];
+        if (inString)
+        {
+            if (c == '\\')
+            {
+                i++;
+            }
+            else if (c == '"')
+            {
+                inString = false;
+            }
+            continue;
+        }
+
+        if (c == '"')
+        {
+            inString = true;
+        }
+        else if (c == '{' || c == '[')
+        {
+            open.push_back(c);
+        }
+        else if (c == '}' || c == ']')
+        {
+            if (open.empty() || open.back() != (c == '}' ? '{' : '['))
+            {
+                return false;
+            }
+            open.pop_back();
+        }
+    }
+    return open.empty() && !inString;
+}
+
+} // namespace
+
+TEST_CASE("Trace.Capture", "[Trace]")
+{
+    const auto path = fs::temp_directory_path() / "zing_test_trace.json";
+    fs::remove(path);
+
+    // Only threads known before the capture get a buffer
+    trace_name_thread("Test \"Main\"");
+    {
+        TraceScope scope("test_before");
+    }
+
+    REQUIRE(trace_capture(path, 60.0));
+    REQUIRE(trace_capturing());
+    REQUIRE(!trace_capture(path, 60.0));
+    for (int i = 0; i < 10; i++)
+    {
+        TraceScope outer("test_outer");
+        TraceScope inner("test_inner");
+    }
+    trace_stop();
+    REQUIRE(!trace_capturing());
+    REQUIRE(trace_last_file() == path);
+
+    {
+        TraceScope scope("test_after");
+    }
+
+    const auto json = test_read(path);
+    REQUIRE(json.find("{\"traceEvents\":[") == 0);
+    REQUIRE(test_balanced(json));
+
+    // The process, then the thread by its escaped name, then its complete events
+    REQUIRE(test_count(json, "\"ph\":\"M\"") >= 2);
+    REQUIRE(json.find("\"name\":\"process_name\"") != std::string::npos);
+    REQUIRE(json.find("\"args\":{\"name\":\"Test \\\"Main\\\"\"}") != std::string::npos);
+    REQUIRE(test_count(json, "\"name\":\"test_outer\",\"cat\":\"zing\",\"ph\":\"X\"") == 10);
+    REQUIRE(test_count(json, "\"name\":\"test_inner\",\"cat\":\"zing\",\"ph\":\"X\"") == 10);
+    REQUIRE(json.find("test_before") == std::string::npos);
+    REQUIRE(json.find("test_after") == std::string::npos);
+    REQUIRE(json.find("\"otherData\":{\"events\":") != std::string::npos);
+    REQUIRE(json.find("\"dropped\":0}}") != std::string::npos);
+
+    // Times are in microseconds from the start of the capture
+    const auto ts = json.find("\"ts\":");
+    REQUIRE(ts != std::string::npos);
+    REQUIRE(std::stod(json.substr(ts + 5)) >= 0.0);
+
+    fs::remove(path);
+}
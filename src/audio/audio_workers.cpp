@@ -0,0 +1,184 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_workers.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define WORKERS_PAUSE() _mm_pause()
+#else
+#define WORKERS_PAUSE() std::this_thread::yield()
+#endif
+
+namespace Zing
+{
+
+namespace
+{
+
+constexpr uint64_t WorkJobBits = 16;
+constexpr uint64_t WorkJobMask = (1ull << WorkJobBits) - 1;
+
+// Work comes every audio block, so a short spin catches it without a wake up; past this
+// the thread blocks until the work word changes
+constexpr uint32_t WorkSpins = 2048;
+
+inline uint32_t work_generation(uint64_t work)
+{
+    return uint32_t(work >> (WorkJobBits * 2));
+}
+
+inline uint32_t work_jobs(uint64_t work)
+{
+    return uint32_t((work >> WorkJobBits) & WorkJobMask);
+}
+
+inline uint32_t work_next(uint64_t work)
+{
+    return uint32_t(work & WorkJobMask);
+}
+
+// Claim and run jobs for the given generation until there are none left.
+// The claim is a CAS on the whole work word, so a worker that wakes late can never
+// take a job from a later run with the state of an earlier one.
+void audio_workers_drain(AudioWorkerPool& pool, uint32_t generation)
+{
+    auto current = pool.work.load(std::memory_order_acquire);
+    for (;;)
+    {
+        if (work_generation(current) != generation || work_next(current) >= work_jobs(current))
+        {
+            return;
+        }
+
+        if (!pool.work.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            continue;
+        }
+
+        // The run can't complete until we report back, so these are stable
+        auto pfnWork = pool.pfnWork.load(std::memory_order_relaxed);
+        auto pUser = pool.pUser.load(std::memory_order_relaxed);
+        pfnWork(pUser, work_next(current));
+
+        // The last job wakes the thread that started the run, if it stopped spinning
+        if (pool.jobsDone.fetch_add(1, std::memory_order_release) + 1 == work_jobs(current))
+        {
+            pool.jobsDone.notify_one();
+        }
+        current = pool.work.load(std::memory_order_acquire);
+    }
+}
+
+void audio_workers_thread(AudioWorkerPool& pool)
+{
+    TRACE_NAME_THREAD(AudioWorker);
+
+    uint32_t lastGeneration = work_generation(pool.work.load(std::memory_order_acquire));
+    uint32_t spins = 0;
+
+    while (!pool.quit.load(std::memory_order_relaxed))
+    {
+        const auto work = pool.work.load(std::memory_order_acquire);
+        const auto generation = work_generation(work);
+        if (generation != lastGeneration)
+        {
+            lastGeneration = generation;
+            audio_workers_drain(pool, generation);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < WorkSpins)
+        {
+            WORKERS_PAUSE();
+            continue;
+        }
+
+        // Claims change the word too, so this can wake before the next run; it just loops round
+        spins = 0;
+        pool.work.wait(work, std::memory_order_acquire);
+    }
+}
+
+} // namespace
+
+void audio_workers_start(AudioWorkerPool& pool, uint32_t threadCount)
+{
+    audio_workers_stop(pool);
+
+    pool.quit = false;
+    for (uint32_t i = 0; i < threadCount; i++)
+    {
+        pool.threads.emplace_back([&pool]() {
+            audio_workers_thread(pool);
+        });
+    }
+}
+
+void audio_workers_stop(AudioWorkerPool& pool)
+{
+    // A new generation with no jobs wakes the workers to see the quit flag
+    pool.quit = true;
+    pool.work.fetch_add(1ull << (WorkJobBits * 2), std::memory_order_release);
+    pool.work.notify_all();
+    for (auto& thread : pool.threads)
+    {
+        thread.join();
+    }
+    pool.threads.clear();
+}
+
+uint32_t audio_workers_count(const AudioWorkerPool& pool)
+{
+    return uint32_t(pool.threads.size()) + 1;
+}
+
+void audio_workers_run(AudioWorkerPool& pool, uint32_t jobs, fnAudioWork pfnWork, void* pUser)
+{
+    if (jobs == 0)
+    {
+        return;
+    }
+
+    assert(jobs <= WorkJobMask);
+
+    // No one to share with
+    if (pool.threads.empty() || jobs == 1)
+    {
+        for (uint32_t job = 0; job < jobs; job++)
+        {
+            pfnWork(pUser, job);
+        }
+        return;
+    }
+
+    pool.pfnWork.store(pfnWork, std::memory_order_relaxed);
+    pool.pUser.store(pUser, std::memory_order_relaxed);
+    pool.jobsDone.store(0, std::memory_order_relaxed);
+
+    const uint32_t generation = work_generation(pool.work.load(std::memory_order_relaxed)) + 1;
+    pool.work.store((uint64_t(generation) << (WorkJobBits * 2)) | (uint64_t(jobs) << WorkJobBits), std::memory_order_release);
+    pool.work.notify_all();
+
+    // Help out, then wait for any jobs still in flight on the workers; they are already running,
+    // so a short spin usually sees them finish
+    audio_workers_drain(pool, generation);
+    uint32_t spins = 0;
+    for (;;)
+    {
+        const auto done = pool.jobsDone.load(std::memory_order_acquire);
+        if (done >= jobs)
+        {
+            break;
+        }
+
+        if (++spins < WorkSpins)
+        {
+            WORKERS_PAUSE();
+            continue;
+        }
+        pool.jobsDone.wait(done, std::memory_order_acquire);
+    }
+}
+
+} // namespace Zing
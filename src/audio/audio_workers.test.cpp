@@ -0,0 +1,86 @@
+#include <zing/pch.h>
+
+#include <zing/audio/audio_workers.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+constexpr uint32_t TestMaxJobs = 64;
+
+struct TestWork
+{
+    std::array<std::atomic<uint32_t>, TestMaxJobs> runs{};
+    std::atomic<uint32_t> total = 0;
+};
+
+void test_job(void* pUser, uint32_t job)
+{
+    auto& work = *(TestWork*)pUser;
+    work.runs[job].fetch_add(1, std::memory_order_relaxed);
+    work.total.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Every job in [0, jobs) ran exactly once, and nothing else did
+bool test_run(AudioWorkerPool& pool, uint32_t jobs)
+{
+    TestWork work;
+    audio_workers_run(pool, jobs, test_job, &work);
+    for (uint32_t job = 0; job < TestMaxJobs; job++)
+    {
+        if (work.runs[job].load() != (job < jobs ? 1u : 0u))
+        {
+            return false;
+        }
+    }
+    return work.total.load() == jobs;
+}
+
+} // namespace
+
+TEST_CASE("Workers.RunOnce", "[Workers]")
+{
+    for (uint32_t threads : { 0u, 1u, 2u, 3u, 7u })
+    {
+        AudioWorkerPool pool;
+        audio_workers_start(pool, threads);
+        REQUIRE(audio_workers_count(pool) == threads + 1);
+
+        // Back to back runs of every size, so workers wake late into later runs
+        for (uint32_t repeat = 0; repeat < 50; repeat++)
+        {
+            for (uint32_t jobs : { 0u, 1u, 2u, 3u, 8u, 17u, TestMaxJobs })
+            {
+                REQUIRE(test_run(pool, jobs));
+            }
+        }
+        audio_workers_stop(pool);
+        REQUIRE(pool.threads.empty());
+    }
+}
+
+TEST_CASE("Workers.Idle", "[Workers]")
+{
+    AudioWorkerPool pool;
+    audio_workers_start(pool, 3);
+
+    // Long enough for the workers to stop spinning and block; a run still wakes them
+    for (uint32_t repeat = 0; repeat < 5; repeat++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        REQUIRE(test_run(pool, 16));
+    }
+
+    // A restart drops the old threads and still runs everything
+    audio_workers_start(pool, 2);
+    REQUIRE(audio_workers_count(pool) == 3);
+    REQUIRE(test_run(pool, 9));
+
+    // Stopping blocked workers doesn't hang, and the pool still runs jobs on the caller
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    audio_workers_stop(pool);
+    REQUIRE(test_run(pool, 5));
+}
@@ -4,45 +4,104 @@
 #include <zing/audio/audio.h>
 #include <zing/audio/waterfall.h>
 
+#include <implot.h>
+
 using namespace Zing;
 using namespace Zest;
 
+namespace
+{
+
+// The recorded span up to now, at about one row per pixel, newest at the top
+void draw_waterfall_history(SpectrogramArchive& archive, const Waterfall& wf, float maxHz, float plotHeight)
+{
+    auto& ctx = GetAudioContext();
+    static std::vector<float> rowsDb;
+
+    const auto end = spectrogram_duration(archive);
+    const auto start = std::max(0.0, end - double(ctx.audioAnalysisSettings.archiveViewSeconds));
+    const auto rows = spectrogram_read(archive, start, end, uint32_t(std::max(plotHeight, 1.0f)), SpectrogramView(ctx.audioAnalysisSettings.archiveView), rowsDb);
+    if (rows == 0)
+    {
+        return;
+    }
+
+    if (ImPlot::BeginPlot("History", ImVec2(-1, plotHeight), ImPlotFlags_NoLegend | ImPlotFlags_NoFrame | ImPlotFlags_NoMenus | ImPlotFlags_NoMouseText | ImPlotFlags_NoInputs | ImPlotFlags_NoTitle))
+    {
+        ImPlot::SetupAxes("", "", ImPlotAxisFlags_NoLabel, ImPlotAxisFlags_Lock | ImPlotAxisFlags_NoLabel | ImPlotAxisFlags_NoTickLabels);
+        ImPlot::SetupAxisLimits(ImAxis_X1, 0.0, maxHz, ImPlotCond_Always);
+        ImPlot::SetupAxisLimits(ImAxis_Y1, 0.0, 1.0, ImPlotCond_Always);
+
+        ImPlot::PushColormap(ImPlotColormap_Jet);
+        ImPlot::PlotHeatmap("##history", rowsDb.data(), int(rows), wf.bins, Waterfall_FloorDb(wf), Waterfall_CeilDb(wf), nullptr, ImPlotPoint(0.0, 0.0), ImPlotPoint(maxHz, 1.0));
+        ImPlot::PopColormap();
+        ImPlot::EndPlot();
+    }
+}
+
+// What the plot reads, copied under the waterfall lock so the plot itself can be drawn without it.
+// Only the rows committed since the last frame are copied, so the analysis thread is held up for a row or two.
+void draw_waterfall_copy(Waterfall& view, const Waterfall& wf)
+{
+    Waterfall_CopySettings(view, wf);
+    Waterfall_CopyRows(view, wf);
+}
+
+} // namespace
+
 void draw_waterfall()
 {
-    PROFILE_SCOPE(draw_waterfall)
+    TRACE_SCOPE(draw_waterfall);
     auto& ctx = GetAudioContext();
-    auto& wf = Waterfall_Get();
+    auto& shared = Waterfall_Get();
+
+    if (!ctx.audioAnalysisSettings.waterfallEnabled)
+    {
+        return;
+    }
 
-    for (auto [Id, pAnalysis] : ctx.analysisChannels)
+    // The rows are built on the analysis threads; here the shared controls are handed over and the
+    // finished rows copied out, then drawn without the lock, one plot per input channel sharing the height
+    static std::map<ChannelId, Waterfall> views;
+    auto fallRows = 50;
+    auto inputs = std::count_if(ctx.analysisChannels.begin(), ctx.analysisChannels.end(), [](const auto& entry) {
+        return entry.first.first == Channel_In;
+    });
+    const auto plotHeight = std::max(100.0f, float(fallRows * 10) / float(std::max<ptrdiff_t>(inputs, 1)));
+
+    for (auto& [Id, pAnalysis] : ctx.analysisChannels)
     {
-        if (Id.first != Channel_In || Id.second != 0)
+        if (Id.first != Channel_In)
         {
-            // Only show first input channel
             continue;
         }
 
-        if (!pAnalysis->uiDataCache)
+        auto& wf = views[Id];
         {
-            continue;
+            std::lock_guard<std::mutex> lock(pAnalysis->waterfallMutex);
+            Waterfall_CopySettings(pAnalysis->waterfall, shared);
+            draw_waterfall_copy(wf, pAnalysis->waterfall);
         }
 
-        const auto& spectrumBuckets = pAnalysis->uiDataCache->spectrumBuckets;
-        if (!spectrumBuckets.empty())
+        if (wf.bins <= 0)
         {
-            auto bucketCount = spectrumBuckets.size();
-            auto sampleCount = ctx.audioDeviceSettings.sampleRate * 0.5f;
-            sampleCount /= float(spectrumBuckets.size());
-
-            auto fallRows = 50;
-            if (wf.bins != int(bucketCount))
-            {
-                Waterfall_Init(wf, int(bucketCount), fallRows);
-            }
+            continue;
+        }
 
+        ImGui::PushID(int(Id.second));
 
-            Waterfall_AccumulateMag(wf, spectrumBuckets.data(), int(bucketCount));
+        const auto markerX = wf.markerX;
+        Waterfall_DrawPlot(wf, "Waterfall", pAnalysis->channel.sampleRate * 0.5f, ImVec2(-1, plotHeight));
+        if (wf.markerX != markerX)
+        {
+            shared.markerX = wf.markerX;
+        }
 
-            Waterfall_DrawPlot(wf, "Waterfall", float(bucketCount * sampleCount), ImVec2(-1, float(fallRows * 10)));
+        if (pAnalysis->spArchive && int(pAnalysis->spArchive->settings.bins) == wf.bins)
+        {
+            draw_waterfall_history(*pAnalysis->spArchive, wf, pAnalysis->channel.sampleRate * 0.5f, plotHeight);
         }
+
+        ImGui::PopID();
     }
 }
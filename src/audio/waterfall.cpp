@@ -4,6 +4,7 @@
 #include <algorithm>
 #include <cmath>
 #include <cstring>
+#include <limits>
 
 #include <imgui.h>
 #include <implot.h>
@@ -20,6 +21,96 @@ inline float Clamp(float v, float lo, float hi) {
     return std::max(lo, std::min(hi, v));
 }
 
+// Quantised codes per dB for the storage
+inline float StoreScale(WaterfallStorage storage) {
+    const float span = WaterfallStoreMaxDb - WaterfallStoreMinDb;
+    switch (storage) {
+    case WaterfallStorage::UInt16: return 65535.0f / span;
+    case WaterfallStorage::UInt8: return 255.0f / span;
+    default: return 1.0f;
+    }
+}
+
+template <typename T>
+void QuantiseLine(T* dst, const float* lineDb, int bins, float scale) {
+    const float maxCode = float(std::numeric_limits<T>::max());
+    for (int i = 0; i < bins; ++i) {
+        const float code = (lineDb[i] - WaterfallStoreMinDb) * scale + 0.5f;
+        dst[i] = T(Clamp(code, 0.0f, maxCode));
+    }
+}
+
+template <typename T>
+void DequantiseLine(float* dst, const T* src, int bins, float scale) {
+    const float invScale = 1.0f / scale;
+    for (int i = 0; i < bins; ++i) {
+        dst[i] = WaterfallStoreMinDb + float(src[i]) * invScale;
+    }
+}
+
+// Read a ring row back as dB
+void ReadRowDb(const Waterfall& wf, int ringRow, float* dst) {
+    const size_t offset = size_t(ringRow) * size_t(wf.bins);
+    switch (wf.storage) {
+    case WaterfallStorage::UInt16:
+        DequantiseLine(dst, wf.ring16.data() + offset, wf.bins, StoreScale(wf.storage));
+        break;
+    case WaterfallStorage::UInt8:
+        DequantiseLine(dst, wf.ring8.data() + offset, wf.bins, StoreScale(wf.storage));
+        break;
+    default:
+        std::memcpy(dst, wf.ringDb.data() + offset, size_t(wf.bins) * sizeof(float));
+        break;
+    }
+}
+
+// Size the ring for the storage, empty; unused forms are freed.
+// Empty rows hold the lowest storable value, so they always draw at the bottom of the scale.
+void AllocateRing(Waterfall& wf) {
+    const size_t count = size_t(wf.rows) * size_t(wf.bins);
+    std::vector<float>().swap(wf.ringDb);
+    std::vector<uint16_t>().swap(wf.ring16);
+    std::vector<uint8_t>().swap(wf.ring8);
+    switch (wf.storage) {
+    case WaterfallStorage::UInt16: wf.ring16.assign(count, 0); break;
+    case WaterfallStorage::UInt8: wf.ring8.assign(count, 0); break;
+    default: wf.ringDb.assign(count, std::numeric_limits<float>::lowest()); break;
+    }
+    wf.commits++;
+    wf.clears++;
+}
+
+template <typename T>
+void CopyRing(std::vector<T>& dst, const std::vector<T>& src, const Waterfall& wf, uint64_t newRows) {
+    if (newRows >= uint64_t(wf.rows) || dst.size() != src.size()) {
+        dst = src;
+        return;
+    }
+
+    // The ring is written backwards, so the new rows run forwards from the newest
+    const size_t bins = size_t(wf.bins);
+    for (uint64_t i = 0; i < newRows; ++i) {
+        const size_t row = size_t((wf.head + 1 + int(i)) % wf.rows);
+        std::memcpy(dst.data() + row * bins, src.data() + row * bins, bins * sizeof(T));
+    }
+}
+
+// Draw the ring newest-first: from the newest row to the end of the ring, then from the start of the
+// ring up to the newest row. Row 0 of a heatmap is drawn at bounds max.y.
+template <typename T>
+void PlotRing(const Waterfall& wf, const T* ring, double scaleMin, double scaleMax, double x0, double x1, double yMin, double yMax) {
+    const int newest = (wf.head + 1) % wf.rows;
+    const int firstRows = wf.rows - newest;
+    const double split = yMax - (yMax - yMin) * double(firstRows) / double(wf.rows);
+
+    ImPlot::PlotHeatmap("##wf", ring + size_t(newest) * size_t(wf.bins), firstRows, wf.bins,
+        scaleMin, scaleMax, nullptr, ImPlotPoint(x0, split), ImPlotPoint(x1, yMax));
+    if (newest > 0) {
+        ImPlot::PlotHeatmap("##wf_wrap", ring, newest, wf.bins,
+            scaleMin, scaleMax, nullptr, ImPlotPoint(x0, yMin), ImPlotPoint(x1, split));
+    }
+}
+
 // Estimate noise floor from a dB line: mean of bottom 20% bins.
 // IMPORTANT: must not scramble the stored line.
 float EstimateNoiseDb_BottomMean(const float* lineDb, int bins) {
@@ -34,6 +125,70 @@ float EstimateNoiseDb_BottomMean(const float* lineDb, int bins) {
     return sum / float(k);
 }
 
+// The same estimate from a histogram of the line: walk the buckets up from the quietest until a fifth of
+// the bins are covered. Only the last bucket is approximated, by its own mean.
+constexpr float NoiseHistMinDb = -200.0f; // ToDb_FromPower's floor
+constexpr float NoiseHistMaxDb = 40.0f;
+constexpr float NoiseHistBucketsPerDb = 2.0f;
+constexpr int NoiseHistBuckets = int((NoiseHistMaxDb - NoiseHistMinDb) * NoiseHistBucketsPerDb);
+
+float EstimateNoiseDb_Histogram(Waterfall& wf, const float* lineDb, int bins) {
+    if (wf.noiseHistCount.size() != size_t(NoiseHistBuckets)) {
+        wf.noiseHistCount.resize(size_t(NoiseHistBuckets));
+        wf.noiseHistSum.resize(size_t(NoiseHistBuckets));
+    }
+    std::fill(wf.noiseHistCount.begin(), wf.noiseHistCount.end(), 0u);
+    std::fill(wf.noiseHistSum.begin(), wf.noiseHistSum.end(), 0.0f);
+
+    uint32_t* counts = wf.noiseHistCount.data();
+    float* sums = wf.noiseHistSum.data();
+    for (int i = 0; i < bins; ++i) {
+        const float db = lineDb[i];
+        const int bucket = std::clamp(int((db - NoiseHistMinDb) * NoiseHistBucketsPerDb), 0, NoiseHistBuckets - 1);
+        counts[bucket]++;
+        sums[bucket] += db;
+    }
+
+    const uint32_t k = uint32_t(std::max(1, bins / 5));
+    uint32_t taken = 0;
+    float sum = 0.0f;
+    for (int bucket = 0; bucket < NoiseHistBuckets && taken < k; ++bucket) {
+        const uint32_t count = counts[bucket];
+        if (count == 0) continue;
+        if (taken + count <= k) {
+            sum += sums[bucket];
+            taken += count;
+        } else {
+            sum += sums[bucket] * float(k - taken) / float(count);
+            taken = k;
+        }
+    }
+    return sum / float(k);
+}
+
+// Mean or median of the counted window, kept sorted as rows come and go
+float ReduceNoiseWindowSorted(const std::vector<float>& sorted, bool useMedian) {
+    if (sorted.empty()) return -120.0f;
+    if (!useMedian) {
+        float sum = 0.0f;
+        for (float v : sorted) sum += v;
+        return sum / float(sorted.size());
+    }
+
+    const size_t mid = sorted.size() / 2;
+    if (sorted.size() % 2 == 1)
+        return sorted[mid];
+    return 0.5f * (sorted[mid - 1] + sorted[mid]);
+}
+
+void SortedReplace(std::vector<float>& sorted, const float* outgoing, float incoming) {
+    if (outgoing) {
+        auto it = std::lower_bound(sorted.begin(), sorted.end(), *outgoing);
+        if (it != sorted.end()) sorted.erase(it);
+    }
+    sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), incoming), incoming);
+}
+
 float ReduceNoiseWindowSpan(const float* data, int count, bool useMedian) {
     if (!data || count <= 0) return -120.0f;
     if (!useMedian) {
@@ -59,22 +214,30 @@ float ReduceNoiseWindowSpan(const float* data, int count, bool useMedian) {
 void PushLineDb(Waterfall& wf, const float* lineDb) {
     // Update auto noise estimate unless user says "nope"
     if (!wf.manualFloor && !wf.lockNoiseFloor) {
-        const float noiseNow = EstimateNoiseDb_BottomMean(lineDb, wf.bins);
+        const bool streaming = wf.noiseMethod == WaterfallNoiseMethod::Histogram;
+        const float noiseNow = streaming ? EstimateNoiseDb_Histogram(wf, lineDb, wf.bins) : EstimateNoiseDb_BottomMean(lineDb, wf.bins);
         if (wf.noiseWindowN < 1) wf.noiseWindowN = 1;
         if ((int)wf.noiseWinDb.size() != wf.noiseWindowN) {
             wf.noiseWinDb.assign(size_t(wf.noiseWindowN), noiseNow);
             wf.noiseWinHead = 0;
             wf.noiseWinCount = 0;
+            wf.noiseWinSorted.clear();
+            wf.noiseWinSorted.reserve(size_t(wf.noiseWindowN));
         }
+
+        // The sorted copy is kept whichever method is in use, so switching needs no reset
         if (wf.noiseWinCount < wf.noiseWindowN) {
+            SortedReplace(wf.noiseWinSorted, nullptr, noiseNow);
             wf.noiseWinDb[size_t(wf.noiseWinCount++)] = noiseNow;
         } else {
+            SortedReplace(wf.noiseWinSorted, &wf.noiseWinDb[size_t(wf.noiseWinHead)], noiseNow);
             wf.noiseWinDb[size_t(wf.noiseWinHead)] = noiseNow;
             wf.noiseWinHead = (wf.noiseWinHead + 1) % wf.noiseWindowN;
         }
 
         const int noiseCount = std::max(1, wf.noiseWinCount);
-        const float noiseAvg = ReduceNoiseWindowSpan(wf.noiseWinDb.data(), noiseCount, wf.useMedianNoise);
+        const float noiseAvg = streaming ? ReduceNoiseWindowSorted(wf.noiseWinSorted, wf.useMedianNoise)
+                                         : ReduceNoiseWindowSpan(wf.noiseWinDb.data(), noiseCount, wf.useMedianNoise);
         if (wf.noiseWinCount < wf.noiseWindowN) {
             // Bootstrap to a reasonable starting floor while window fills.
             wf.emaNoiseDb = noiseAvg;
@@ -84,12 +247,46 @@ void PushLineDb(Waterfall& wf, const float* lineDb) {
         }
     }
 
-    // Store ordered line
-    float* dst = wf.ringDb.data() + size_t(wf.head) * size_t(wf.bins);
-    std::memcpy(dst, lineDb, size_t(wf.bins) * sizeof(float));
+    // Store the line, stepping backwards through the ring
+    const size_t offset = size_t(wf.head) * size_t(wf.bins);
+    switch (wf.storage) {
+    case WaterfallStorage::UInt16:
+        QuantiseLine(wf.ring16.data() + offset, lineDb, wf.bins, StoreScale(wf.storage));
+        break;
+    case WaterfallStorage::UInt8:
+        QuantiseLine(wf.ring8.data() + offset, lineDb, wf.bins, StoreScale(wf.storage));
+        break;
+    default:
+        std::memcpy(wf.ringDb.data() + offset, lineDb, size_t(wf.bins) * sizeof(float));
+        break;
+    }
 
-    wf.head = (wf.head + 1) % wf.rows;
+    wf.head = (wf.head - 1 + wf.rows) % wf.rows;
     wf.rowsWritten = std::min(wf.rowsWritten + 1, wf.rows);
+    wf.commits++;
+}
+
+// Turn the accumulated power into a row once accumulateN spectra are in
+void CommitAccumulated(Waterfall& wf) {
+    if (wf.accCount < wf.accumulateN)
+        return;
+
+    // Average power -> dB(power)
+    static thread_local std::vector<float> lineDb;
+    lineDb.resize(size_t(wf.bins));
+
+    const float invN = 1.0f / float(wf.accCount);
+    for (int i = 0; i < wf.bins; ++i) {
+        const float pAvg = wf.accPowerSum[i] * invN;
+        lineDb[i] = ToDb_FromPower(pAvg);
+    }
+
+    // reset accumulator
+    std::fill(wf.accPowerSum.begin(), wf.accPowerSum.end(), 0.0f);
+    wf.accCount = 0;
+
+    // commit
+    PushLineDb(wf, lineDb.data());
 }
 
 } // namespace
@@ -103,8 +300,8 @@ void Waterfall_Init(Waterfall& wf, int bins, int rows) {
     wf.emaNoiseDb = -90.0f;
     wf.lockedNoiseDb = wf.emaNoiseDb;
 
-    wf.ringDb.assign(size_t(wf.rows) * size_t(wf.bins), -120.0f);
-    wf.uploadDb.assign(wf.ringDb.size(), -120.0f);
+    AllocateRing(wf);
+    std::vector<float>().swap(wf.uploadDb);
 
     wf.accumulateN = std::max(1, wf.accumulateN);
     wf.accCount = 0;
@@ -114,6 +311,8 @@ void Waterfall_Init(Waterfall& wf, int bins, int rows) {
     wf.noiseWinHead = 0;
     wf.noiseWinCount = 0;
     wf.noiseWinDb.assign(size_t(wf.noiseWindowN), wf.emaNoiseDb);
+    wf.noiseWinSorted.clear();
+    wf.noiseWinSorted.reserve(size_t(wf.noiseWindowN));
 }
 
 void Waterfall_Reset(Waterfall& wf) {
@@ -122,8 +321,7 @@ void Waterfall_Reset(Waterfall& wf) {
     wf.emaNoiseDb = -90.0f;
     wf.lockedNoiseDb = wf.emaNoiseDb;
 
-    std::fill(wf.ringDb.begin(), wf.ringDb.end(), -120.0f);
-    std::fill(wf.uploadDb.begin(), wf.uploadDb.end(), -120.0f);
+    AllocateRing(wf);
 
     wf.accCount = 0;
     std::fill(wf.accPowerSum.begin(), wf.accPowerSum.end(), 0.0f);
@@ -132,6 +330,14 @@ void Waterfall_Reset(Waterfall& wf) {
     wf.noiseWinHead = 0;
     wf.noiseWinCount = 0;
     wf.noiseWinDb.assign(size_t(wf.noiseWindowN), wf.emaNoiseDb);
+    wf.noiseWinSorted.clear();
+    wf.noiseWinSorted.reserve(size_t(wf.noiseWindowN));
+}
+
+void Waterfall_SetStorage(Waterfall& wf, WaterfallStorage storage) {
+    if (wf.storage == storage) return;
+    wf.storage = storage;
+    Waterfall_Reset(wf);
 }
 
 void Waterfall_AccumulateMag(Waterfall& wf, const float* spectrumMag, int spectrumCount) {
@@ -151,52 +357,106 @@ void Waterfall_AccumulateMag(Waterfall& wf, const float* spectrumMag, int spectr
     }
 
     wf.accCount++;
-    if (wf.accCount < wf.accumulateN)
-        return;
+    CommitAccumulated(wf);
+}
 
-    // Average power -> dB(power)
-    static thread_local std::vector<float> lineDb;
-    lineDb.resize(size_t(wf.bins));
+void Waterfall_AccumulatePower(Waterfall& wf, const float* spectrumPower, int spectrumCount) {
+    if (!wf.enabled) return;
+    if (wf.bins <= 0 || wf.rows <= 0) return;
+    if (!spectrumPower) return;
+    if (spectrumCount < wf.bins) return;
 
-    const float invN = 1.0f / float(wf.accCount);
+    wf.accumulateN = std::max(1, wf.accumulateN);
+    if ((int)wf.accPowerSum.size() != wf.bins)
+        wf.accPowerSum.assign(size_t(wf.bins), 0.0f);
+
+    // Each row bin averages the spectrum bins that fall in it, so the axis stays linear in frequency
     for (int i = 0; i < wf.bins; ++i) {
-        const float pAvg = wf.accPowerSum[i] * invN;
-        lineDb[i] = ToDb_FromPower(pAvg);
+        const int start = int(int64_t(i) * spectrumCount / wf.bins);
+        const int end = std::max(start + 1, int(int64_t(i + 1) * spectrumCount / wf.bins));
+        float sum = 0.0f;
+        for (int j = start; j < end; ++j) sum += spectrumPower[j];
+        wf.accPowerSum[i] += sum / float(end - start);
     }
 
-    // reset accumulator
-    std::fill(wf.accPowerSum.begin(), wf.accPowerSum.end(), 0.0f);
-    wf.accCount = 0;
+    wf.accCount++;
+    CommitAccumulated(wf);
+}
 
-    // commit
-    PushLineDb(wf, lineDb.data());
+void Waterfall_CopySettings(Waterfall& dst, const Waterfall& src) {
+    if (dst.resetRequests != src.resetRequests) {
+        dst.resetRequests = src.resetRequests;
+        Waterfall_Reset(dst);
+    }
+    if (src.lockNoiseFloor && !dst.lockNoiseFloor) {
+        // Lock this waterfall's own estimate, as the shared one isn't tracking anything
+        dst.lockedNoiseDb = dst.emaNoiseDb;
+    }
+    Waterfall_SetStorage(dst, src.storage);
+
+    dst.accumulateN = src.accumulateN;
+    dst.adapt = src.adapt;
+    dst.rangeDb = src.rangeDb;
+    dst.floorOffsetDb = src.floorOffsetDb;
+    dst.lockNoiseFloor = src.lockNoiseFloor;
+    dst.manualFloor = src.manualFloor;
+    dst.manualFloorDb = src.manualFloorDb;
+    dst.enabled = src.enabled;
+    dst.noiseWindowN = src.noiseWindowN;
+    dst.useMedianNoise = src.useMedianNoise;
+    dst.noiseMethod = src.noiseMethod;
+    dst.markerX = src.markerX;
+    dst.markerWidthHz = src.markerWidthHz;
+}
+
+void Waterfall_CopyRows(Waterfall& dst, const Waterfall& src) {
+    const bool whole = dst.bins != src.bins || dst.rows != src.rows || dst.storage != src.storage || dst.clears != src.clears;
+    const uint64_t newRows = whole ? ~0ull : src.commits - dst.commits;
+    if (whole) {
+        dst.bins = src.bins;
+        dst.rows = src.rows;
+        dst.storage = src.storage;
+        dst.clears = src.clears;
+        if (src.storage != WaterfallStorage::Float32) std::vector<float>().swap(dst.ringDb);
+        if (src.storage != WaterfallStorage::UInt16) std::vector<uint16_t>().swap(dst.ring16);
+        if (src.storage != WaterfallStorage::UInt8) std::vector<uint8_t>().swap(dst.ring8);
+    }
+
+    if (newRows != 0) {
+        switch (src.storage) {
+        case WaterfallStorage::UInt16: CopyRing(dst.ring16, src.ring16, src, newRows); break;
+        case WaterfallStorage::UInt8: CopyRing(dst.ring8, src.ring8, src, newRows); break;
+        default: CopyRing(dst.ringDb, src.ringDb, src, newRows); break;
+        }
+    }
+
+    dst.head = src.head;
+    dst.rowsWritten = src.rowsWritten;
+    dst.commits = src.commits;
+    dst.emaNoiseDb = src.emaNoiseDb;
+    dst.lockedNoiseDb = src.lockedNoiseDb;
 }
 
 void Waterfall_BuildUpload(Waterfall& wf) {
     if (wf.bins <= 0 || wf.rows <= 0) return;
-    if (wf.uploadDb.size() != wf.ringDb.size())
-        wf.uploadDb.resize(wf.ringDb.size());
 
-    // Newest row starts at top and moves downward as rows arrive.
-    if (wf.rowsWritten <= 0) {
-        const float fill = Waterfall_FloorDb(wf);
-        std::fill(wf.uploadDb.begin(), wf.uploadDb.end(), fill);
+    // Only the unwritten rows depend on the floor
+    const float fill = Waterfall_FloorDb(wf);
+    const size_t count = size_t(wf.rows) * size_t(wf.bins);
+    if (wf.uploadDb.size() == count && wf.uploadCommits == wf.commits && (wf.rowsWritten == wf.rows || wf.uploadFloorDb == fill))
         return;
-    }
 
-    const int newestRow = (wf.head - 1 + wf.rows) % wf.rows;
-    for (int y = 0; y < wf.rows; ++y) {
-        const float* src = nullptr;
-        if (y < wf.rowsWritten) {
-            const int ringRow = (newestRow - y + wf.rows) % wf.rows;
-            src = wf.ringDb.data() + size_t(ringRow) * size_t(wf.bins);
-        }
+    wf.uploadDb.resize(count);
+    wf.uploadCommits = wf.commits;
+    wf.uploadFloorDb = fill;
 
+    // Newest row starts at top and moves downward as rows arrive.
+    const int newestRow = (wf.head + 1) % wf.rows;
+    for (int y = 0; y < wf.rows; ++y) {
         float* dst = wf.uploadDb.data() + size_t(y) * size_t(wf.bins);
-        if (src) {
-            std::memcpy(dst, src, size_t(wf.bins) * sizeof(float));
+        if (y < wf.rowsWritten) {
+            ReadRowDb(wf, (newestRow + y) % wf.rows, dst);
         } else {
-            const float fill = Waterfall_FloorDb(wf);
             std::fill(dst, dst + wf.bins, fill);
         }
     }
@@ -227,6 +487,16 @@ void Waterfall_DrawControls(Waterfall& wf) {
     ImGui::SliderInt("WF Noise Window (rows)", &wf.noiseWindowN, 1, 64);
     ImGui::Checkbox("WF Noise Median", &wf.useMedianNoise);
 
+    int noiseMethod = int(wf.noiseMethod);
+    if (ImGui::Combo("WF Noise Method", &noiseMethod, "Exact\0Histogram\0")) {
+        wf.noiseMethod = WaterfallNoiseMethod(noiseMethod);
+    }
+
+    int storage = int(wf.storage);
+    if (ImGui::Combo("WF Storage", &storage, "Float\0UInt16\0UInt8\0")) {
+        Waterfall_SetStorage(wf, WaterfallStorage(storage));
+    }
+
     if (ImGui::Checkbox("WF Lock Noise", &wf.lockNoiseFloor)) {
         if (wf.lockNoiseFloor) {
             // lock current auto estimate as baseline
@@ -240,6 +510,7 @@ void Waterfall_DrawControls(Waterfall& wf) {
     }
 
     if (ImGui::Button("WF Reset")) {
+        wf.resetRequests++;
         Waterfall_Reset(wf);
     }
 
@@ -252,8 +523,6 @@ void Waterfall_DrawPlot(Waterfall& wf, const char* plotTitle, float maxHz, ImVec
     if (!wf.enabled) return;
     if (wf.bins <= 0 || wf.rows <= 0) return;
 
-    Waterfall_BuildUpload(wf);
-
     const float plotWidth = plotSize.x > 0.0f ? plotSize.x : ImGui::GetContentRegionAvail().x;
     const float plotHeight = plotSize.y > 0.0f ? plotSize.y : ImGui::GetContentRegionAvail().y;
 
@@ -288,16 +557,22 @@ void Waterfall_DrawPlot(Waterfall& wf, const char* plotTitle, float maxHz, ImVec
         ImPlot::PushColormap(ImPlotColormap_Jet);
 
         ImPlot::PushPlotClipRect();
-        ImPlot::PlotHeatmap(
-            "##wf",
-            wf.uploadDb.data(),
-            wf.rows, wf.bins,
-            Waterfall_FloorDb(wf),
-            Waterfall_CeilDb(wf),
-            nullptr,
-            ImPlotPoint(x0, limits.Y.Min),
-            ImPlotPoint(x1, limits.Y.Max)
-        );
+        // Straight from the ring; quantised rings are drawn in their codes with the scale to match
+        const double scale = StoreScale(wf.storage);
+        const double offset = wf.storage == WaterfallStorage::Float32 ? 0.0 : WaterfallStoreMinDb;
+        const double scaleMin = (Waterfall_FloorDb(wf) - offset) * scale;
+        const double scaleMax = (Waterfall_CeilDb(wf) - offset) * scale;
+        switch (wf.storage) {
+        case WaterfallStorage::UInt16:
+            PlotRing(wf, wf.ring16.data(), scaleMin, scaleMax, x0, x1, limits.Y.Min, limits.Y.Max);
+            break;
+        case WaterfallStorage::UInt8:
+            PlotRing(wf, wf.ring8.data(), scaleMin, scaleMax, x0, x1, limits.Y.Min, limits.Y.Max);
+            break;
+        default:
+            PlotRing(wf, wf.ringDb.data(), scaleMin, scaleMax, x0, x1, limits.Y.Min, limits.Y.Max);
+            break;
+        }
 
         const ImPlotPoint rectMin(markerValue - markerHalfHz, limits.Y.Min);
         const ImPlotPoint rectMax(markerValue + markerHalfHz, limits.Y.Max);
@@ -0,0 +1,270 @@
+#include <zing/pch.h>
+
+#include <numeric>
+
+#include <zing/audio/waterfall.h>
+
+#include "catch.hpp"
+
+namespace
+{
+
+constexpr int TestBins = 256;
+constexpr int TestRows = 4;
+
+// One row of levels stepping evenly across the stored range, with a little past each end
+std::vector<float> test_levels()
+{
+    std::vector<float> levels(TestBins);
+    for (int i = 0; i < TestBins; i++)
+    {
+        levels[i] = WaterfallStoreMinDb - 5.0f + (WaterfallStoreMaxDb - WaterfallStoreMinDb + 10.0f) * float(i) / float(TestBins - 1);
+    }
+    return levels;
+}
+
+std::vector<float> test_power(const std::vector<float>& levelsDb)
+{
+    std::vector<float> power(levelsDb.size());
+    for (size_t i = 0; i < levelsDb.size(); i++)
+    {
+        power[i] = std::pow(10.0f, levelsDb[i] / 10.0f);
+    }
+    return power;
+}
+
+void test_init(Waterfall& wf, WaterfallStorage storage)
+{
+    wf.accumulateN = 1;
+    Waterfall_Init(wf, TestBins, TestRows);
+    Waterfall_SetStorage(wf, storage);
+}
+
+// Row y of the flat copy, newest first
+const float* test_row(Waterfall& wf, int y)
+{
+    Waterfall_BuildUpload(wf);
+    return wf.uploadDb.data() + size_t(y) * TestBins;
+}
+
+void test_round_trip(WaterfallStorage storage, float stepDb)
+{
+    Waterfall wf;
+    test_init(wf, storage);
+
+    const auto levels = test_levels();
+    const auto power = test_power(levels);
+    Waterfall_AccumulatePower(wf, power.data(), TestBins);
+
+    // Rounded to the nearest step, clamped to the stored range; the float dB conversion adds a little
+    auto pRow = test_row(wf, 0);
+    for (int i = 0; i < TestBins; i++)
+    {
+        const auto expected = std::clamp(levels[i], WaterfallStoreMinDb, WaterfallStoreMaxDb);
+        REQUIRE(pRow[i] == Approx(expected).margin(stepDb * 0.5f + 1e-3f));
+        REQUIRE(pRow[i] >= WaterfallStoreMinDb);
+        REQUIRE(pRow[i] <= WaterfallStoreMaxDb + 1e-3f);
+    }
+}
+
+} // namespace
+
+TEST_CASE("Waterfall.Float32", "[Waterfall]")
+{
+    Waterfall wf;
+    test_init(wf, WaterfallStorage::Float32);
+
+    const auto levels = test_levels();
+    const auto power = test_power(levels);
+    Waterfall_AccumulatePower(wf, power.data(), TestBins);
+
+    // Not quantised, so not clamped either
+    auto pRow = test_row(wf, 0);
+    for (int i = 0; i < TestBins; i++)
+    {
+        REQUIRE(pRow[i] == Approx(levels[i]).margin(1e-3));
+    }
+}
+
+TEST_CASE("Waterfall.QuantiseUInt16", "[Waterfall]")
+{
+    test_round_trip(WaterfallStorage::UInt16, (WaterfallStoreMaxDb - WaterfallStoreMinDb) / 65535.0f);
+}
+
+TEST_CASE("Waterfall.QuantiseUInt8", "[Waterfall]")
+{
+    test_round_trip(WaterfallStorage::UInt8, (WaterfallStoreMaxDb - WaterfallStoreMinDb) / 255.0f);
+}
+
+TEST_CASE("Waterfall.Clamp", "[Waterfall]")
+{
+    // Silence is far below the stored range, and reads back as its minimum
+    for (auto storage : { WaterfallStorage::UInt16, WaterfallStorage::UInt8 })
+    {
+        Waterfall wf;
+        test_init(wf, storage);
+
+        std::vector<float> power(TestBins, 0.0f);
+        power[1] = 1e6f;
+        Waterfall_AccumulatePower(wf, power.data(), TestBins);
+
+        auto pRow = test_row(wf, 0);
+        REQUIRE(pRow[0] == WaterfallStoreMinDb);
+        REQUIRE(pRow[1] == Approx(WaterfallStoreMaxDb).margin(1e-3));
+    }
+}
+
+TEST_CASE("Waterfall.RowOrder", "[Waterfall]")
+{
+    for (auto storage : { WaterfallStorage::Float32, WaterfallStorage::UInt16, WaterfallStorage::UInt8 })
+    {
+        Waterfall wf;
+        test_init(wf, storage);
+
+        // Rows not yet written sit at the floor
+        const std::vector<float> rowDb = { -100.0f, -60.0f, -20.0f, 0.0f, -40.0f, -80.0f };
+        Waterfall_AccumulatePower(wf, test_power(std::vector<float>(TestBins, rowDb[0])).data(), TestBins);
+        REQUIRE(test_row(wf, 0)[0] == Approx(rowDb[0]).margin(0.5));
+        REQUIRE(test_row(wf, 1)[0] == Waterfall_FloorDb(wf));
+
+        // Newest first, and the oldest drop off once the ring is full
+        for (size_t row = 1; row < rowDb.size(); row++)
+        {
+            Waterfall_AccumulatePower(wf, test_power(std::vector<float>(TestBins, rowDb[row])).data(), TestBins);
+        }
+        REQUIRE(wf.rowsWritten == TestRows);
+        for (int y = 0; y < TestRows; y++)
+        {
+            const auto expected = rowDb[rowDb.size() - 1 - size_t(y)];
+            REQUIRE(test_row(wf, y)[0] == Approx(expected).margin(0.5));
+            REQUIRE(test_row(wf, y)[TestBins - 1] == Approx(expected).margin(0.5));
+        }
+
+        // Changing the storage clears the history
+        Waterfall_SetStorage(wf, storage == WaterfallStorage::UInt8 ? WaterfallStorage::Float32 : WaterfallStorage::UInt8);
+        REQUIRE(wf.rowsWritten == 0);
+    }
+}
+
+TEST_CASE("Waterfall.Accumulate", "[Waterfall]")
+{
+    Waterfall wf;
+    wf.accumulateN = 2;
+    Waterfall_Init(wf, TestBins, TestRows);
+
+    // Power averages over accumulateN spectra before a row commits
+    Waterfall_AccumulatePower(wf, std::vector<float>(TestBins, 1.0f).data(), TestBins);
+    REQUIRE(wf.rowsWritten == 0);
+    Waterfall_AccumulatePower(wf, std::vector<float>(TestBins, 3.0f).data(), TestBins);
+    REQUIRE(wf.rowsWritten == 1);
+    REQUIRE(test_row(wf, 0)[0] == Approx(10.0f * std::log10(2.0f)).margin(1e-4));
+
+    // A longer spectrum averages its neighbouring bins into each row bin
+    std::vector<float> power(TestBins * 2);
+    for (int i = 0; i < TestBins * 2; i++)
+    {
+        power[i] = i % 2 ? 3.0f : 1.0f;
+    }
+    Waterfall_AccumulatePower(wf, power.data(), TestBins * 2);
+    Waterfall_AccumulatePower(wf, power.data(), TestBins * 2);
+    REQUIRE(wf.rowsWritten == 2);
+    auto pRow = test_row(wf, 0);
+    for (int i = 0; i < TestBins; i++)
+    {
+        REQUIRE(pRow[i] == Approx(10.0f * std::log10(2.0f)).margin(1e-4));
+    }
+}
+
+TEST_CASE("Waterfall.CopyRows", "[Waterfall]")
+{
+    for (auto storage : { WaterfallStorage::Float32, WaterfallStorage::UInt16, WaterfallStorage::UInt8 })
+    {
+        Waterfall wf;
+        test_init(wf, storage);
+        Waterfall view;
+
+        // Copies after no rows, a few, enough to wrap, and more than the ring holds
+        uint32_t row = 0;
+        for (uint32_t newRows : { 0u, 1u, 3u, 2u, 5u, 9u, 1u })
+        {
+            for (uint32_t i = 0; i < newRows; i++, row++)
+            {
+                Waterfall_AccumulatePower(wf, test_power(std::vector<float>(TestBins, -120.0f + float(row) * 7.0f)).data(), TestBins);
+            }
+
+            Waterfall_CopyRows(view, wf);
+            REQUIRE(view.head == wf.head);
+            REQUIRE(view.rowsWritten == wf.rowsWritten);
+            REQUIRE(view.emaNoiseDb == wf.emaNoiseDb);
+            REQUIRE(view.ringDb == wf.ringDb);
+            REQUIRE(view.ring16 == wf.ring16);
+            REQUIRE(view.ring8 == wf.ring8);
+        }
+
+        // A reset empties the view too, even though rows have been committed since
+        Waterfall_Reset(wf);
+        Waterfall_AccumulatePower(wf, test_power(std::vector<float>(TestBins, -10.0f)).data(), TestBins);
+        Waterfall_CopyRows(view, wf);
+        REQUIRE(view.rowsWritten == 1);
+        REQUIRE(view.ringDb == wf.ringDb);
+        REQUIRE(view.ring16 == wf.ring16);
+        REQUIRE(view.ring8 == wf.ring8);
+    }
+}
+
+TEST_CASE("Waterfall.NoiseFloor", "[Waterfall]")
+{
+    // A noise floor spread over -110..-90 dB under half the bins, strong tones over the rest
+    std::vector<float> rowDb(TestBins);
+    for (int i = 0; i < TestBins; i++)
+    {
+        rowDb[i] = i % 2 ? -20.0f - float(i % 7) : -110.0f + 20.0f * float(i) / float(TestBins - 1);
+    }
+
+    // The floor is the mean of the quietest fifth of the bins
+    auto sorted = rowDb;
+    std::sort(sorted.begin(), sorted.end());
+    const auto quietest = size_t(TestBins / 5);
+    const auto expected = std::accumulate(sorted.begin(), sorted.begin() + quietest, 0.0f) / float(quietest);
+
+    // The histogram only approximates its last bucket, so is within a bucket of the exact estimate
+    for (auto method : { WaterfallNoiseMethod::Exact, WaterfallNoiseMethod::Histogram })
+    {
+        Waterfall wf;
+        wf.noiseMethod = method;
+        wf.noiseWindowN = 4;
+        wf.adapt = 0.5f;
+        wf.floorOffsetDb = 0.0f;
+        test_init(wf, WaterfallStorage::Float32);
+
+        const auto power = test_power(rowDb);
+        Waterfall_AccumulatePower(wf, power.data(), TestBins);
+        REQUIRE(wf.emaNoiseDb == Approx(expected).margin(method == WaterfallNoiseMethod::Exact ? 1e-3 : 0.5));
+        REQUIRE(Waterfall_FloorDb(wf) == wf.emaNoiseDb);
+
+        // Follows the window's median straight away while it fills
+        const auto quiet = test_power(std::vector<float>(TestBins, -130.0f));
+        Waterfall_AccumulatePower(wf, quiet.data(), TestBins);
+        Waterfall_AccumulatePower(wf, quiet.data(), TestBins);
+        REQUIRE(wf.emaNoiseDb == Approx(-130.0f).margin(1e-3));
+
+        // Once full, moves towards the window's median by 'adapt' a row; louder rows push the oldest out,
+        // so the median goes -130, -90, -50 and the floor half way each time
+        Waterfall_AccumulatePower(wf, quiet.data(), TestBins);
+        REQUIRE(wf.emaNoiseDb == Approx(-130.0f).margin(1e-3));
+        const auto loud = test_power(std::vector<float>(TestBins, -50.0f));
+        for (auto floorDb : { -130.0f, -110.0f, -80.0f })
+        {
+            Waterfall_AccumulatePower(wf, loud.data(), TestBins);
+            REQUIRE(wf.emaNoiseDb == Approx(floorDb).margin(1e-3));
+        }
+
+        // A locked floor stays where it was locked, whatever comes in
+        wf.lockNoiseFloor = true;
+        wf.lockedNoiseDb = wf.emaNoiseDb;
+        const auto locked = wf.emaNoiseDb;
+        Waterfall_AccumulatePower(wf, loud.data(), TestBins);
+        REQUIRE(wf.emaNoiseDb == locked);
+        REQUIRE(Waterfall_FloorDb(wf) == locked);
+    }
+}
@@ -1,5 +1,4 @@
-#define TSF_IMPLEMENTATION
-#include <tsf/tsf.h>
+// The tsf implementation is built in audio_samples.cpp, where the voice renderer can reach it
    
 //#define TML_IMPLEMENTATION
 //#include <tsf/tml.h>
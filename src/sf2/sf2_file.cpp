@@ -0,0 +1,255 @@
+#include <zing/pch.h>
+
+#include <zing/sf2/sf2_file.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Zing
+{
+
+namespace
+{
+
+// RIFF is little endian; read unaligned fields through memcpy
+template <typename T>
+T sf2_read(const uint8_t* p)
+{
+    T val;
+    memcpy(&val, p, sizeof(T));
+    return val;
+}
+
+bool sf2_fourcc(const uint8_t* p, const char* id)
+{
+    return memcmp(p, id, 4) == 0;
+}
+
+// Size of a phdr record in the file
+constexpr uint64_t PresetHeaderSize = 38;
+
+void sf2_read_presets(const SF2MappedFile& file, const SF2Chunk& chunk, SF2Index& index)
+{
+    // The last record is the terminal 'EOP' entry
+    auto count = chunk.size / PresetHeaderSize;
+    if (count < 2)
+    {
+        return;
+    }
+
+    index.presets.resize(count - 1);
+    for (uint64_t i = 0; i < count - 1; i++)
+    {
+        auto p = file.pData + chunk.offset + i * PresetHeaderSize;
+        auto& header = index.presets[i];
+
+        // Names are zero padded, but not always zero terminated
+        auto pName = (const char*)p;
+        header.name.assign(pName, strnlen(pName, 20));
+        header.preset = sf2_read<uint16_t>(p + 20);
+        header.bank = sf2_read<uint16_t>(p + 22);
+    }
+}
+
+} // namespace
+
+bool sf2_map_file(const fs::path& path, SF2MappedFile& file)
+{
+    sf2_unmap_file(file);
+
+#ifdef _WIN32
+    auto hFile = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (hFile == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    auto hMapping = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!hMapping)
+    {
+        CloseHandle(hFile);
+        return false;
+    }
+
+    auto pData = MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!pData)
+    {
+        CloseHandle(hMapping);
+        CloseHandle(hFile);
+        return false;
+    }
+
+    file.hFile = hFile;
+    file.hMapping = hMapping;
+    file.pData = (const uint8_t*)pData;
+    file.size = uint64_t(size.QuadPart);
+#else
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    auto pData = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (pData == MAP_FAILED)
+    {
+        close(fd);
+        return false;
+    }
+
+    file.fd = fd;
+    file.pData = (const uint8_t*)pData;
+    file.size = uint64_t(st.st_size);
+#endif
+    return true;
+}
+
+void sf2_unmap_file(SF2MappedFile& file)
+{
+    if (!file.pData)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    UnmapViewOfFile(file.pData);
+    CloseHandle(file.hMapping);
+    CloseHandle(file.hFile);
+    file.hMapping = nullptr;
+    file.hFile = nullptr;
+#else
+    munmap((void*)file.pData, size_t(file.size));
+    close(file.fd);
+    file.fd = -1;
+#endif
+    file.pData = nullptr;
+    file.size = 0;
+}
+
+void sf2_advise(const SF2MappedFile& file, const SF2Chunk& range, SF2Access access)
+{
+    if (!file.pData || range.size == 0 || range.offset + range.size > file.size)
+    {
+        return;
+    }
+
+#ifdef _WIN32
+    // Windows only has a prefetch hint
+    if (access == SF2Access::WillNeed || access == SF2Access::Sequential)
+    {
+        WIN32_MEMORY_RANGE_ENTRY entry;
+        entry.VirtualAddress = (void*)(file.pData + range.offset);
+        entry.NumberOfBytes = size_t(range.size);
+        PrefetchVirtualMemory(GetCurrentProcess(), 1, &entry, 0);
+    }
+#else
+    // madvise wants a page aligned start
+    static const uint64_t pageSize = uint64_t(sysconf(_SC_PAGESIZE));
+    auto start = range.offset & ~(pageSize - 1);
+    auto size = range.offset + range.size - start;
+
+    int advice = MADV_NORMAL;
+    switch (access)
+    {
+    case SF2Access::Sequential:
+        advice = MADV_SEQUENTIAL;
+        break;
+    case SF2Access::WillNeed:
+        advice = MADV_WILLNEED;
+        break;
+    case SF2Access::DontNeed:
+        advice = MADV_DONTNEED;
+        break;
+    default:
+        break;
+    }
+    madvise((void*)(file.pData + start), size_t(size), advice);
+#endif
+}
+
+bool sf2_read_index(const SF2MappedFile& file, SF2Index& index)
+{
+    index = SF2Index{};
+
+    auto p = file.pData;
+    if (!p || file.size < 12 || !sf2_fourcc(p, "RIFF") || !sf2_fourcc(p + 8, "sfbk"))
+    {
+        return false;
+    }
+
+    auto riffEnd = std::min(file.size, uint64_t(sf2_read<uint32_t>(p + 4)) + 8);
+
+    // Top level is a list of LIST chunks: INFO, sdta, pdta
+    uint64_t offset = 12;
+    while (offset + 12 <= riffEnd)
+    {
+        auto listSize = uint64_t(sf2_read<uint32_t>(p + offset + 4));
+        auto listEnd = std::min(riffEnd, offset + 8 + listSize);
+        if (!sf2_fourcc(p + offset, "LIST"))
+        {
+            offset = listEnd + (listSize & 1);
+            continue;
+        }
+
+        auto pListType = p + offset + 8;
+        if (sf2_fourcc(pListType, "INFO"))
+        {
+            index.info = SF2Chunk{ offset + 12, listEnd - offset - 12 };
+        }
+        else if (sf2_fourcc(pListType, "pdta"))
+        {
+            index.hydra = SF2Chunk{ offset + 12, listEnd - offset - 12 };
+        }
+
+        // Sub chunks of the list
+        uint64_t chunkOffset = offset + 12;
+        while (chunkOffset + 8 <= listEnd)
+        {
+            auto chunkSize = uint64_t(sf2_read<uint32_t>(p + chunkOffset + 4));
+            auto chunk = SF2Chunk{ chunkOffset + 8, std::min(chunkSize, listEnd - chunkOffset - 8) };
+
+            if (sf2_fourcc(p + chunkOffset, "smpl"))
+            {
+                index.samples = chunk;
+            }
+            else if (sf2_fourcc(p + chunkOffset, "sm24"))
+            {
+                index.samples24 = chunk;
+            }
+            else if (sf2_fourcc(p + chunkOffset, "phdr"))
+            {
+                sf2_read_presets(file, chunk, index);
+            }
+
+            chunkOffset += 8 + chunkSize + (chunkSize & 1);
+        }
+
+        offset = listEnd + (listSize & 1);
+    }
+
+    return index.hydra.size != 0 && index.samples.size != 0;
+}
+
+} // namespace Zing
@@ -0,0 +1,139 @@
+#include <zing/pch.h>
+
+#include <fstream>
+
+#include <zing/sf2/sf2_file.h>
+
+#include "catch.hpp"
+
+using namespace Zing;
+
+namespace
+{
+
+void test_put(std::string& out, const void* pData, size_t size)
+{
+    out.append((const char*)pData, size);
+}
+
+void test_put_u16(std::string& out, uint16_t val)
+{
+    test_put(out, &val, sizeof(val));
+}
+
+void test_put_u32(std::string& out, uint32_t val)
+{
+    test_put(out, &val, sizeof(val));
+}
+
+// A chunk, padded to an even size as RIFF requires
+std::string test_chunk(const char* id, const std::string& data)
+{
+    std::string out(id, 4);
+    test_put_u32(out, uint32_t(data.size()));
+    out += data;
+    if (data.size() & 1)
+    {
+        out += '\0';
+    }
+    return out;
+}
+
+std::string test_list(const char* type, const std::string& chunks)
+{
+    return test_chunk("LIST", std::string(type, 4) + chunks);
+}
+
+// A 38 byte phdr record
+std::string test_preset_header(const char* name, uint16_t preset, uint16_t bank)
+{
+    std::string out(20, '\0');
+    memcpy(out.data(), name, std::min(strlen(name), size_t(20)));
+    test_put_u16(out, preset);
+    test_put_u16(out, bank);
+    out.append(14, '\0');
+    return out;
+}
+
+// The RIFF layout of a soundfont, with only the chunks the index reads filled in
+std::string test_font(const std::string& samples)
+{
+    auto info = test_chunk("ifil", std::string("\2\0\1\0", 4)) + test_chunk("INAM", "Test");
+    auto phdr = test_preset_header("Piano", 0, 0) + test_preset_header("Twenty Characters!!!", 1, 128) + test_preset_header("EOP", 0, 0);
+    auto riff = std::string("sfbk", 4) +
+        test_list("INFO", info) +
+        test_list("sdta", test_chunk("smpl", samples)) +
+        test_list("pdta", test_chunk("phdr", phdr) + test_chunk("pbag", std::string(4, '\0')));
+    return test_chunk("RIFF", riff);
+}
+
+fs::path test_write(const std::string& name, const std::string& data)
+{
+    const auto path = fs::temp_directory_path() / name;
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(data.data(), std::streamsize(data.size()));
+    return path;
+}
+
+} // namespace
+
+TEST_CASE("SF2.Index", "[SF2]")
+{
+    std::string samples;
+    for (int16_t i = 0; i < 100; i++)
+    {
+        test_put_u16(samples, uint16_t(i * 300));
+    }
+    const auto path = test_write("zing_test_index.sf2", test_font(samples));
+
+    SF2MappedFile file;
+    REQUIRE(sf2_map_file(path, file));
+    SF2Index index;
+    REQUIRE(sf2_read_index(file, index));
+
+    // The chunks point into the mapping without anything being copied
+    REQUIRE(index.samples.size == samples.size());
+    REQUIRE(memcmp(file.pData + index.samples.offset, samples.data(), samples.size()) == 0);
+    REQUIRE(index.samples24.size == 0);
+    REQUIRE(memcmp(file.pData + index.info.offset, "ifil", 4) == 0);
+    REQUIRE(memcmp(file.pData + index.hydra.offset, "phdr", 4) == 0);
+    REQUIRE(index.hydra.offset + index.hydra.size == file.size);
+
+    // Every preset but the terminal record, with names that fill the field cut at 20 characters
+    REQUIRE(index.presets.size() == 2);
+    REQUIRE(index.presets[0].name == "Piano");
+    REQUIRE(index.presets[0].preset == 0);
+    REQUIRE(index.presets[0].bank == 0);
+    REQUIRE(index.presets[1].name == "Twenty Characters!!!");
+    REQUIRE(index.presets[1].preset == 1);
+    REQUIRE(index.presets[1].bank == 128);
+
+    sf2_unmap_file(file);
+    REQUIRE(file.pData == nullptr);
+    fs::remove(path);
+}
+
+TEST_CASE("SF2.NotAFont", "[SF2]")
+{
+    // Another RIFF file
+    auto wave = test_font("ab");
+    memcpy(wave.data() + 8, "WAVE", 4);
+
+    // Cut off before the sample data
+    auto truncated = test_font(std::string(64, '\0'));
+    truncated.resize(60);
+
+    for (const auto& data : { wave, truncated })
+    {
+        const auto path = test_write("zing_test_not_font.sf2", data);
+        SF2MappedFile file;
+        REQUIRE(sf2_map_file(path, file));
+        SF2Index index;
+        REQUIRE(!sf2_read_index(file, index));
+        sf2_unmap_file(file);
+        fs::remove(path);
+    }
+
+    SF2MappedFile file;
+    REQUIRE(!sf2_map_file(fs::temp_directory_path() / "zing_test_missing.sf2", file));
+}
@@ -0,0 +1,196 @@
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <new>
+#include <thread>
+
+#include "wavetable_bank.h"
+
+#include <earlevel/el_wavetable_utils.h>
+
+namespace AudioUtils
+{
+
+namespace
+{
+
+constexpr uint64_t WaveTableBlockFloats = 1024 * 1024;
+constexpr uint64_t WaveTableAlignFloats = 16; // 64 bytes
+
+float* wave_table_bank_alloc(WaveTableBank& bank, uint64_t count)
+{
+    count = (count + WaveTableAlignFloats - 1) & ~(WaveTableAlignFloats - 1);
+    if (bank.blocks.empty() || bank.blockUsed + count > bank.blockSize)
+    {
+        auto size = std::max(count, WaveTableBlockFloats);
+        bank.blocks.emplace_back((float*)::operator new[](size * sizeof(float), std::align_val_t(WaveTableAlignFloats * sizeof(float))));
+        bank.blockSize = size;
+        bank.blockUsed = 0;
+    }
+
+    auto p = bank.blocks.back().get() + bank.blockUsed;
+    bank.blockUsed += count;
+    return p;
+}
+
+WaveTableMips& wave_table_bank_add(WaveTableBank& bank, WaveTableType type, uint32_t size)
+{
+    auto& mips = bank.mips.emplace_back();
+    mips.type = type;
+    mips.size = size;
+    bank.lookup[std::make_pair(type, size)] = WaveTableHandle{ &mips };
+    return mips;
+}
+
+// Spectrum of the naive table; DC is kept so the positive shapes stay positive
+void wave_table_bank_spectrum(const WaveTableMips& mips, Earlevel::WaveSpectrum& spectrum)
+{
+    WaveTable naive;
+    wave_table_create(naive, mips.type, 0.0f, mips.size);
+    Earlevel::waveSpectrum(naive.data.data(), int(mips.size), spectrum, true);
+}
+
+uint32_t wave_table_bank_level_count(const Earlevel::WaveSpectrum& spectrum)
+{
+    return std::min(uint32_t(Earlevel::spectrumTableCount(spectrum)), WaveTableMaxLevels);
+}
+
+uint64_t wave_table_bank_level_floats(uint32_t size)
+{
+    return (uint64_t(size) + WaveTableGuardSamples + WaveTableAlignFloats - 1) & ~(WaveTableAlignFloats - 1);
+}
+
+// Levels are one octave apart, as Earlevel::fillTables makes them, at unity gain so they match the naive table
+void wave_table_bank_fill(WaveTableMips& mips, const Earlevel::WaveSpectrum& spectrum, float* pStorage)
+{
+    mips.levelCount = wave_table_bank_level_count(spectrum);
+    for (uint32_t index = 0; index < mips.levelCount; index++)
+    {
+        auto pData = pStorage + index * wave_table_bank_level_floats(mips.size);
+        Earlevel::spectrumTable(spectrum, int(index), 1.0f, pData, int(WaveTableGuardSamples));
+
+        auto& level = mips.levels[index];
+        level.pData = pData;
+        level.size = mips.size;
+        level.topFreq = float(Earlevel::spectrumTableTop(spectrum, int(index)));
+    }
+
+    // The last table covers everything above it
+    mips.levels[mips.levelCount - 1].topFreq = 1.0f;
+}
+
+template <typename F>
+void wave_table_parallel_for(size_t count, uint32_t threadCount, F&& fn)
+{
+    std::atomic<size_t> next = 0;
+    auto worker = [&]() {
+        for (size_t index = next++; index < count; index = next++)
+        {
+            fn(index);
+        }
+    };
+
+    threadCount = uint32_t(std::min(size_t(threadCount), count));
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+} // namespace
+
+void WaveTableBank::AlignedDelete::operator()(float* p) const
+{
+    ::operator delete[](p, std::align_val_t(WaveTableAlignFloats * sizeof(float)));
+}
+
+WaveTableBank& wave_table_bank()
+{
+    static WaveTableBank bank;
+    return bank;
+}
+
+WaveTableHandle wave_table_bank_get(WaveTableBank& bank, WaveTableType type, uint32_t size)
+{
+    assert(size >= 2 && (size & (size - 1)) == 0);
+
+    std::lock_guard<std::mutex> lock(bank.buildMutex);
+    auto key = std::make_pair(type, size);
+    auto itr = bank.lookup.find(key);
+    if (itr != bank.lookup.end())
+    {
+        return itr->second;
+    }
+
+    auto& mips = wave_table_bank_add(bank, type, size);
+
+    Earlevel::WaveSpectrum spectrum;
+    wave_table_bank_spectrum(mips, spectrum);
+    auto pStorage = wave_table_bank_alloc(bank, wave_table_bank_level_count(spectrum) * wave_table_bank_level_floats(size));
+    wave_table_bank_fill(mips, spectrum, pStorage);
+
+    return bank.lookup[key];
+}
+
+void wave_table_bank_prepare(WaveTableBank& bank, const std::vector<std::pair<WaveTableType, uint32_t>>& shapes, uint32_t threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    std::lock_guard<std::mutex> lock(bank.buildMutex);
+
+    std::vector<WaveTableMips*> build;
+    for (auto& [type, size] : shapes)
+    {
+        assert(size >= 2 && (size & (size - 1)) == 0);
+        if (bank.lookup.find(std::make_pair(type, size)) == bank.lookup.end())
+        {
+            build.push_back(&wave_table_bank_add(bank, type, size));
+        }
+    }
+
+    // Spectra first, so the storage for every level is known before anything is written
+    std::vector<Earlevel::WaveSpectrum> spectra(build.size());
+    wave_table_parallel_for(build.size(), threadCount, [&](size_t index) {
+        wave_table_bank_spectrum(*build[index], spectra[index]);
+    });
+
+    uint64_t total = 0;
+    for (size_t index = 0; index < build.size(); index++)
+    {
+        total += wave_table_bank_level_count(spectra[index]) * wave_table_bank_level_floats(build[index]->size);
+    }
+
+    auto pStorage = total ? wave_table_bank_alloc(bank, total) : nullptr;
+    std::vector<float*> storage(build.size());
+    for (size_t index = 0; index < build.size(); index++)
+    {
+        storage[index] = pStorage;
+        pStorage += wave_table_bank_level_count(spectra[index]) * wave_table_bank_level_floats(build[index]->size);
+    }
+
+    wave_table_parallel_for(build.size(), threadCount, [&](size_t index) {
+        wave_table_bank_fill(*build[index], spectra[index], storage[index]);
+    });
+}
+
+void wave_table_bank_destroy(WaveTableBank& bank)
+{
+    std::lock_guard<std::mutex> lock(bank.buildMutex);
+    bank.lookup.clear();
+    bank.mips.clear();
+    bank.blocks.clear();
+    bank.blockUsed = 0;
+    bank.blockSize = 0;
+}
+
+} // namespace AudioUtils
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "wavetable.h"
+
+namespace AudioUtils
+{
+
+// Tables carry copies of their first few samples past the end, so readers can interpolate without wrapping
+constexpr uint32_t WaveTableGuardSamples = 4;
+constexpr uint32_t WaveTableMaxLevels = 16;
+
+// One band limited copy of a wave, good for playback up to topFreq (normalized, cycles per sample)
+struct WaveTableLevel
+{
+    const float* pData = nullptr;
+    uint32_t size = 0;
+    float topFreq = 0.0f;
+};
+
+// Levels go from full bandwidth to a single harmonic, one octave apart
+struct WaveTableMips
+{
+    WaveTableType type = WaveTableType::Sine;
+    uint32_t size = 0;
+    uint32_t levelCount = 0;
+    WaveTableLevel levels[WaveTableMaxLevels];
+};
+
+// A handle stays valid for the life of the bank, and the tables behind it never change
+struct WaveTableHandle
+{
+    const WaveTableMips* pMips = nullptr;
+};
+
+// Builds each (shape, size) once and keeps the tables in large aligned blocks which are never moved
+// or freed until the bank goes; oscillators share them read only, without locking.
+struct WaveTableBank
+{
+    struct AlignedDelete
+    {
+        void operator()(float* p) const;
+    };
+
+    std::mutex buildMutex;
+    std::vector<std::unique_ptr<float[], AlignedDelete>> blocks;
+    uint64_t blockUsed = 0;
+    uint64_t blockSize = 0;
+
+    std::deque<WaveTableMips> mips;
+    std::map<std::pair<WaveTableType, uint32_t>, WaveTableHandle> lookup;
+};
+
+// The bank shared by everything in the process
+WaveTableBank& wave_table_bank();
+
+// Returns the tables for a shape, building them on first use; size must be a power of 2
+WaveTableHandle wave_table_bank_get(WaveTableBank& bank, WaveTableType type, uint32_t size);
+
+// Build many shapes at once across threads (0 = all cores), into a single block
+void wave_table_bank_prepare(WaveTableBank& bank, const std::vector<std::pair<WaveTableType, uint32_t>>& shapes, uint32_t threadCount = 0);
+void wave_table_bank_destroy(WaveTableBank& bank);
+
+// The level to use for a normalized frequency
+inline uint32_t wave_table_level(const WaveTableMips& mips, float freq)
+{
+    uint32_t level = 0;
+    while (level < mips.levelCount - 1 && freq >= mips.levels[level].topFreq)
+    {
+        level++;
+    }
+    return level;
+}
+
+} // namespace AudioUtils
@@ -0,0 +1,194 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#include "wavetable_osc.h"
+
+#include <earlevel/el_wavetable.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define WAVETABLE_OSC_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace AudioUtils
+{
+
+namespace
+{
+
+constexpr double PhaseScale = 4294967296.0; // 2^32
+constexpr float FracScale = 1.0f / 8388608.0f; // 2^-23
+
+uint32_t wave_table_osc_log2(uint32_t size)
+{
+    uint32_t bits = 0;
+    while ((1u << bits) < size)
+    {
+        bits++;
+    }
+    return bits;
+}
+
+// One voice, accumulated into the outputs
+void wave_table_osc_render_voice(const WaveTableLevel& level, uint32_t& phase, uint32_t increment, float gainLeft, float gainRight, float* pLeft, float* pRight, uint32_t frames)
+{
+    const auto bits = wave_table_osc_log2(level.size);
+    const auto shift = 32 - bits;
+    const auto pData = level.pData;
+
+    uint32_t p = phase;
+    uint32_t frame = 0;
+
+#ifdef WAVETABLE_OSC_SSE2
+    // Four consecutive frames of the voice per vector, so the sum into the output stays vertical
+    const auto vShift = _mm_cvtsi32_si128(int(shift));
+    const auto vBits = _mm_cvtsi32_si128(int(bits));
+    const auto vFracScale = _mm_set1_ps(FracScale);
+    const auto vGainLeft = _mm_set1_ps(gainLeft);
+    const auto vGainRight = _mm_set1_ps(gainRight);
+    const auto vStep = _mm_set1_epi32(int(increment * 4));
+    auto vPhase = _mm_set_epi32(int(p + increment * 3), int(p + increment * 2), int(p + increment), int(p));
+
+    alignas(16) int32_t index[4];
+    for (; frame + 4 <= frames; frame += 4)
+    {
+        _mm_store_si128((__m128i*)index, _mm_srl_epi32(vPhase, vShift));
+
+        // The bits below the index, as a 23 bit fraction
+        auto vFrac = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(_mm_sll_epi32(vPhase, vBits), 9)), vFracScale);
+
+        // No gather in SSE2; the guard sample makes index + 1 safe
+        auto vS0 = _mm_set_ps(pData[index[3]], pData[index[2]], pData[index[1]], pData[index[0]]);
+        auto vS1 = _mm_set_ps(pData[index[3] + 1], pData[index[2] + 1], pData[index[1] + 1], pData[index[0] + 1]);
+        auto vSample = _mm_add_ps(vS0, _mm_mul_ps(_mm_sub_ps(vS1, vS0), vFrac));
+
+        if (pRight)
+        {
+            _mm_storeu_ps(pLeft + frame, _mm_add_ps(_mm_loadu_ps(pLeft + frame), _mm_mul_ps(vSample, vGainLeft)));
+            _mm_storeu_ps(pRight + frame, _mm_add_ps(_mm_loadu_ps(pRight + frame), _mm_mul_ps(vSample, vGainRight)));
+        }
+        else
+        {
+            _mm_storeu_ps(pLeft + frame, _mm_add_ps(_mm_loadu_ps(pLeft + frame), _mm_mul_ps(vSample, vGainLeft)));
+        }
+
+        vPhase = _mm_add_epi32(vPhase, vStep);
+    }
+    p += increment * frame;
+#endif
+
+    for (; frame < frames; frame++)
+    {
+        const auto i = p >> shift;
+        const auto frac = float((p << bits) >> 9) * FracScale;
+        const auto s0 = pData[i];
+        const auto sample = s0 + (pData[i + 1] - s0) * frac;
+
+        pLeft[frame] += sample * gainLeft;
+        if (pRight)
+        {
+            pRight[frame] += sample * gainRight;
+        }
+        p += increment;
+    }
+
+    phase = p;
+}
+
+} // namespace
+
+void wave_table_osc_init(WaveTableOscBlock& block, const WaveTableMips& mips, uint32_t voiceCount)
+{
+    assert(mips.levelCount > 0);
+
+    block = WaveTableOscBlock{};
+    block.mips = mips;
+    block.voiceCount = std::min(voiceCount, WaveTableOscMaxVoices);
+    for (uint32_t voice = 0; voice < block.voiceCount; voice++)
+    {
+        block.gainLeft[voice] = block.gainRight[voice] = 1.0f;
+    }
+}
+
+bool wave_table_osc_init(WaveTableOscBlock& block, const Earlevel::WaveTableOsc& osc, uint32_t voiceCount)
+{
+    WaveTableMips mips;
+    auto pTables = osc.GetTables();
+    for (int table = 0; table < osc.GetNumTables() && mips.levelCount < WaveTableMaxLevels; table++)
+    {
+        // The fixed point phase needs power of 2 tables
+        const auto len = uint32_t(pTables[table].waveTableLen);
+        if (len < 2 || (len & (len - 1)) != 0)
+        {
+            return false;
+        }
+
+        auto& level = mips.levels[mips.levelCount++];
+        level.pData = pTables[table].waveTable;
+        level.size = len;
+        level.topFreq = float(pTables[table].topFreq);
+    }
+
+    if (mips.levelCount == 0)
+    {
+        return false;
+    }
+
+    mips.size = mips.levels[0].size;
+    wave_table_osc_init(block, mips, voiceCount);
+    return true;
+}
+
+void wave_table_osc_set_frequency(WaveTableOscBlock& block, uint32_t voice, double normalizedFreq)
+{
+    if (voice < block.voiceCount)
+    {
+        block.increment[voice] = uint32_t(std::clamp(normalizedFreq, 0.0, 0.5) * PhaseScale);
+    }
+}
+
+void wave_table_osc_set_unison(WaveTableOscBlock& block, double normalizedFreq, float detuneCents, float spread, uint32_t seed)
+{
+    const auto voices = block.voiceCount;
+    if (voices == 0)
+    {
+        return;
+    }
+
+    // Keep the stack at roughly the level of one voice
+    const float level = 1.0f / std::sqrt(float(voices));
+
+    uint32_t random = seed * 1664525u + 1013904223u;
+    for (uint32_t voice = 0; voice < voices; voice++)
+    {
+        const float t = voices > 1 ? (2.0f * float(voice) / float(voices - 1) - 1.0f) : 0.0f;
+        wave_table_osc_set_frequency(block, voice, normalizedFreq * std::pow(2.0, double(t * detuneCents) / 1200.0));
+
+        // Alternate sides so neighbouring detunes don't bunch up in one channel
+        const float pan = ((voice & 1) ? -t : t) * std::clamp(spread, 0.0f, 1.0f);
+        block.gainLeft[voice] = level * std::min(1.0f, 1.0f - pan);
+        block.gainRight[voice] = level * std::min(1.0f, 1.0f + pan);
+
+        random = random * 1664525u + 1013904223u;
+        block.phase[voice] = random;
+    }
+}
+
+void wave_table_osc_render(WaveTableOscBlock& block, float* pLeft, float* pRight, uint32_t frames)
+{
+    for (uint32_t voice = 0; voice < block.voiceCount; voice++)
+    {
+        const auto& level = block.mips.levels[wave_table_level(block.mips, float(block.increment[voice] / PhaseScale))];
+
+        auto gainLeft = block.gainLeft[voice];
+        auto gainRight = block.gainRight[voice];
+        if (!pRight)
+        {
+            gainLeft = (gainLeft + gainRight) * 0.5f;
+        }
+        wave_table_osc_render_voice(level, block.phase[voice], block.increment[voice], gainLeft, gainRight, pLeft, pRight, frames);
+    }
+}
+
+} // namespace AudioUtils
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#include "wavetable_bank.h"
+
+namespace Earlevel
+{
+class WaveTableOsc;
+}
+
+namespace AudioUtils
+{
+
+constexpr uint32_t WaveTableOscMaxVoices = 16;
+
+// A block of up to 16 wavetable voices, such as a unison stack, rendered together.
+// Phase is 32 bit fixed point, so the wrap is free and the table index is a shift; tables must be a
+// power of 2 long and carry at least one guard sample (bank tables and Earlevel tables both do).
+// The band limited level is picked once per voice per block.
+struct WaveTableOscBlock
+{
+    WaveTableMips mips;
+    uint32_t voiceCount = 0;
+
+    alignas(16) uint32_t phase[WaveTableOscMaxVoices] = {};
+    alignas(16) uint32_t increment[WaveTableOscMaxVoices] = {};
+    alignas(16) float gainLeft[WaveTableOscMaxVoices] = {};
+    alignas(16) float gainRight[WaveTableOscMaxVoices] = {};
+};
+
+void wave_table_osc_init(WaveTableOscBlock& block, const WaveTableMips& mips, uint32_t voiceCount);
+
+// Share the tables of an Earlevel oscillator; nothing is copied, so the oscillator must outlive the block
+bool wave_table_osc_init(WaveTableOscBlock& block, const Earlevel::WaveTableOsc& osc, uint32_t voiceCount);
+
+void wave_table_osc_set_frequency(WaveTableOscBlock& block, uint32_t voice, double normalizedFreq);
+
+// Spread the voices evenly over +/- detuneCents around the frequency, and pan them across the stereo
+// field by spread (0 is all centre, 1 is hard left to hard right). Phases start scattered.
+void wave_table_osc_set_unison(WaveTableOscBlock& block, double normalizedFreq, float detuneCents, float spread, uint32_t seed = 0);
+
+// Adds the voices into the outputs; pRight may be null for a mono sum of both gains
+void wave_table_osc_render(WaveTableOscBlock& block, float* pLeft, float* pRight, uint32_t frames);
+
+} // namespace AudioUtils